@@ -37,12 +37,31 @@ int wmain(int argc, wchar_t *argv[])
 	OvumArgs args = { 0 };
 	ParseCommandLine(argc - 1, argv + 1, args);
 
-	VMStartParams vm;
+	VMStartParams vm = { 0 };
 	vm.argc = argc - args.argOffset - 1;
 	vm.argv = (const wchar_t**)(argv + args.argOffset + 1);
 	vm.modulePath  = args.modulePath;
 	vm.startupFile = args.startupFile;
 	vm.verbose     = args.verbose;
+	vm.compactGen1 = args.compactGen1;
+
+	vm.gen0Size                = args.gen0Size;
+	vm.adaptiveGen0            = args.adaptiveGen0;
+	vm.gen1DeadObjectThreshold = args.gen1Threshold;
+	vm.largeObjectSize         = args.largeObjectSize;
+	vm.callStackSize           = args.callStackSize;
+	vm.gcWorkerCount           = args.gcWorkerCount;
+
+	vm.jit          = args.jit;
+	vm.jitThreshold = args.jitThreshold;
+
+	vm.sampleFile     = args.sampleFile;
+	vm.sampleInterval = args.sampleInterval;
+
+	vm.lazyMethodBodies     = args.lazyBodies;
+	vm.methodCacheDirectory = args.methodCacheDir;
+	vm.preinitializeMethods = args.preinit;
+	vm.backgroundMethodInit = args.backgroundInit;
 
 	return VM_Start(&vm);
 }
@@ -71,6 +90,125 @@ void ParseCommandLine(int argc, wchar_t *argv[], OvumArgs &args)
 					CommandParseError("/v can only occur once");
 				args.verbose = true;
 			}
+			else if (wcscmp(arg + 1, L"compact") == 0)
+			{
+				if (args.compactGen1)
+					CommandParseError("/compact can only occur once");
+				args.compactGen1 = true;
+			}
+			else if (wcscmp(arg + 1, L"gen0") == 0)
+			{
+				if (args.gen0Size)
+					CommandParseError("/gen0 can only occur once");
+				args.gen0Size = ParseSizeArgument(L"/gen0", i, argc, argv);
+			}
+			else if (wcscmp(arg + 1, L"adaptive-gen0") == 0)
+			{
+				if (args.adaptiveGen0)
+					CommandParseError("/adaptive-gen0 can only occur once");
+				args.adaptiveGen0 = true;
+			}
+			else if (wcscmp(arg + 1, L"gen1-threshold") == 0)
+			{
+				if (args.gen1Threshold)
+					CommandParseError("/gen1-threshold can only occur once");
+				args.gen1Threshold = ParseSizeArgument(L"/gen1-threshold", i, argc, argv);
+			}
+			else if (wcscmp(arg + 1, L"loh") == 0)
+			{
+				if (args.largeObjectSize)
+					CommandParseError("/loh can only occur once");
+				args.largeObjectSize = ParseSizeArgument(L"/loh", i, argc, argv);
+			}
+			else if (wcscmp(arg + 1, L"stack") == 0)
+			{
+				if (args.callStackSize)
+					CommandParseError("/stack can only occur once");
+				args.callStackSize = ParseSizeArgument(L"/stack", i, argc, argv);
+			}
+			else if (wcscmp(arg + 1, L"gc-workers") == 0)
+			{
+				if (args.gcWorkerCount)
+					CommandParseError("/gc-workers can only occur once");
+				if (i >= argc - 1)
+					CommandParseError("Expected a number after /gc-workers");
+
+				const wchar_t *value = argv[++i];
+				wchar_t *end;
+				unsigned long count = wcstoul(value, &end, 10);
+				// Zero is not valid here either; the VM interprets it as "use the default".
+				if (end == value || *end != L'\0' || count == 0 || count > UINT32_MAX)
+					CommandParseError("Invalid number of GC workers: ", value);
+				args.gcWorkerCount = (uint32_t)count;
+			}
+			else if (wcscmp(arg + 1, L"jit") == 0)
+			{
+				if (args.jit)
+					CommandParseError("/jit can only occur once");
+				args.jit = true;
+			}
+			else if (wcscmp(arg + 1, L"jit-threshold") == 0)
+			{
+				if (args.jitThreshold)
+					CommandParseError("/jit-threshold can only occur once");
+				if (i >= argc - 1)
+					CommandParseError("Expected a number after /jit-threshold");
+
+				const wchar_t *value = argv[++i];
+				wchar_t *end;
+				unsigned long count = wcstoul(value, &end, 10);
+				if (end == value || *end != L'\0' || count == 0 || count > UINT32_MAX)
+					CommandParseError("Invalid JIT threshold: ", value);
+				args.jitThreshold = (uint32_t)count;
+			}
+			else if (wcscmp(arg + 1, L"sample") == 0)
+			{
+				if (args.sampleFile)
+					CommandParseError("/sample can only occur once");
+				if (i >= argc - 1)
+					CommandParseError("/sample must be followed by the name of a file");
+				args.sampleFile = argv[++i];
+			}
+			else if (wcscmp(arg + 1, L"sample-interval") == 0)
+			{
+				if (args.sampleInterval)
+					CommandParseError("/sample-interval can only occur once");
+				if (i >= argc - 1)
+					CommandParseError("Expected a number after /sample-interval");
+
+				const wchar_t *value = argv[++i];
+				wchar_t *end;
+				unsigned long interval = wcstoul(value, &end, 10);
+				if (end == value || *end != L'\0' || interval == 0 || interval > UINT32_MAX)
+					CommandParseError("Invalid sample interval: ", value);
+				args.sampleInterval = (uint32_t)interval;
+			}
+			else if (wcscmp(arg + 1, L"lazy-bodies") == 0)
+			{
+				if (args.lazyBodies)
+					CommandParseError("/lazy-bodies can only occur once");
+				args.lazyBodies = true;
+			}
+			else if (wcscmp(arg + 1, L"method-cache") == 0)
+			{
+				if (args.methodCacheDir)
+					CommandParseError("/method-cache can only occur once");
+				if (i >= argc - 1)
+					CommandParseError("/method-cache must be followed by the name of a directory");
+				args.methodCacheDir = argv[++i];
+			}
+			else if (wcscmp(arg + 1, L"preinit") == 0)
+			{
+				if (args.preinit)
+					CommandParseError("/preinit can only occur once");
+				args.preinit = true;
+			}
+			else if (wcscmp(arg + 1, L"background-init") == 0)
+			{
+				if (args.backgroundInit)
+					CommandParseError("/background-init can only occur once");
+				args.backgroundInit = true;
+			}
 			else
 				CommandParseError("Invalid argument: ", arg);
 		}
@@ -99,6 +237,36 @@ void ParseCommandLine(int argc, wchar_t *argv[], OvumArgs &args)
 	}
 }
 
+size_t ParseSizeArgument(const wchar_t *name, int &i, int argc, wchar_t *argv[])
+{
+	// Sizes are given in bytes, optionally followed by K (kilobytes) or M
+	// (megabytes). Zero is not a valid size, as the VM interprets it as
+	// "use the default".
+	if (i >= argc - 1)
+		CommandParseError("Expected a size after ", name);
+
+	const wchar_t *value = argv[++i];
+	wchar_t *end;
+	unsigned long long size = wcstoull(value, &end, 10);
+
+	unsigned long long multiplier = 1;
+	if (*end == L'k' || *end == L'K')
+	{
+		multiplier = 1024;
+		end++;
+	}
+	else if (*end == L'm' || *end == L'M')
+	{
+		multiplier = 1024 * 1024;
+		end++;
+	}
+
+	if (end == value || *end != L'\0' || size == 0 || size > SIZE_MAX / multiplier)
+		CommandParseError("Invalid size: ", value);
+
+	return (size_t)(size * multiplier);
+}
+
 void CommandParseError(const char *message, const wchar_t *extra)
 {
 	HANDLE stdOut = GetStdHandle(STD_OUTPUT_HANDLE);
@@ -164,6 +332,100 @@ void PrintUsageAndExit()
 	wprintf(L"        Hosted program output begins after '<<< Begin program output >>>'.\n");
 	wprintf(L"        Mnemonic: v for verbose.\n");
 
+	SetConsoleTextAttribute(stdOut, CNSL_YELLOW);
+	wprintf(L"    /compact\n");
+	SetConsoleTextAttribute(stdOut, CNSL_GRAY);
+	wprintf(L"        If present, the garbage collector may move long-lived objects in order to\n");
+	wprintf(L"        reduce memory fragmentation. Pinned objects are never moved.\n");
+
+	wprintf(L"\n    Sizes are in bytes, and may be suffixed with K (kilobytes) or M (megabytes).\n");
+
+	SetConsoleTextAttribute(stdOut, CNSL_YELLOW);
+	wprintf(L"    /gen0 <size>\n");
+	SetConsoleTextAttribute(stdOut, CNSL_GRAY);
+	wprintf(L"        The size of generation 0, where new objects are allocated. Default: 1536K.\n");
+
+	SetConsoleTextAttribute(stdOut, CNSL_YELLOW);
+	wprintf(L"    /adaptive-gen0\n");
+	SetConsoleTextAttribute(stdOut, CNSL_GRAY);
+	wprintf(L"        If present, generation 0 grows when many objects survive a collection, and\n");
+	wprintf(L"        shrinks when few do. /gen0 then specifies the initial size.\n");
+
+	SetConsoleTextAttribute(stdOut, CNSL_YELLOW);
+	wprintf(L"    /gen1-threshold <size>\n");
+	SetConsoleTextAttribute(stdOut, CNSL_GRAY);
+	wprintf(L"        How much generation 1 may grow before it is collected. Default: 768K.\n");
+
+	SetConsoleTextAttribute(stdOut, CNSL_YELLOW);
+	wprintf(L"    /loh <size>\n");
+	SetConsoleTextAttribute(stdOut, CNSL_GRAY);
+	wprintf(L"        Objects larger than this are allocated in the large object heap. Must be at\n");
+	wprintf(L"        most half the size of generation 0. Default: 85K.\n");
+
+	SetConsoleTextAttribute(stdOut, CNSL_YELLOW);
+	wprintf(L"    /stack <size>\n");
+	SetConsoleTextAttribute(stdOut, CNSL_GRAY);
+	wprintf(L"        The size of the managed call stack. Default: 4M.\n");
+
+	SetConsoleTextAttribute(stdOut, CNSL_YELLOW);
+	wprintf(L"    /gc-workers <count>\n");
+	SetConsoleTextAttribute(stdOut, CNSL_GRAY);
+	wprintf(L"        The number of threads that mark live objects during garbage collection.\n");
+	wprintf(L"        Use 1 to mark on a single thread. Default: the number of processors.\n");
+
+	SetConsoleTextAttribute(stdOut, CNSL_YELLOW);
+	wprintf(L"    /jit\n");
+	SetConsoleTextAttribute(stdOut, CNSL_GRAY);
+	wprintf(L"        If present, methods that are called often are compiled to native code.\n");
+	wprintf(L"        Only available in 64-bit builds of the VM.\n");
+
+	SetConsoleTextAttribute(stdOut, CNSL_YELLOW);
+	wprintf(L"    /jit-threshold <count>\n");
+	SetConsoleTextAttribute(stdOut, CNSL_GRAY);
+	wprintf(L"        The number of calls after which a method is compiled, if /jit is present.\n");
+	wprintf(L"        Default: 1000.\n");
+
+	SetConsoleTextAttribute(stdOut, CNSL_YELLOW);
+	wprintf(L"    /sample <file>\n");
+	SetConsoleTextAttribute(stdOut, CNSL_GRAY);
+	wprintf(L"        If present, the VM samples the managed call stack while the program runs,\n");
+	wprintf(L"        and writes the samples to the file in the collapsed stack format, which\n");
+	wprintf(L"        flame graph tools such as flamegraph.pl can read.\n");
+
+	SetConsoleTextAttribute(stdOut, CNSL_YELLOW);
+	wprintf(L"    /sample-interval <ms>\n");
+	SetConsoleTextAttribute(stdOut, CNSL_GRAY);
+	wprintf(L"        The time between samples in milliseconds, if /sample is present. Default: 10.\n");
+
+	SetConsoleTextAttribute(stdOut, CNSL_YELLOW);
+	wprintf(L"    /lazy-bodies\n");
+	SetConsoleTextAttribute(stdOut, CNSL_GRAY);
+	wprintf(L"        If present, the bytecode of each method is read from its module file the\n");
+	wprintf(L"        first time the method is called, instead of when the module is loaded.\n");
+	wprintf(L"        This speeds up startup when a program uses little of each module.\n");
+
+	SetConsoleTextAttribute(stdOut, CNSL_YELLOW);
+	wprintf(L"    /method-cache <dir>\n");
+	SetConsoleTextAttribute(stdOut, CNSL_GRAY);
+	wprintf(L"        If present, initialized method bodies are saved in the directory when the\n");
+	wprintf(L"        program ends, and reused by later runs as long as the modules have not\n");
+	wprintf(L"        changed. The directory must exist.\n");
+
+	SetConsoleTextAttribute(stdOut, CNSL_YELLOW);
+	wprintf(L"    /preinit\n");
+	SetConsoleTextAttribute(stdOut, CNSL_GRAY);
+	wprintf(L"        If present, the program is not run. Instead, every method in the startup\n");
+	wprintf(L"        module and its dependencies is initialized and saved in the method cache,\n");
+	wprintf(L"        so that later runs never have to initialize a method. Requires\n");
+	wprintf(L"        /method-cache.\n");
+
+	SetConsoleTextAttribute(stdOut, CNSL_YELLOW);
+	wprintf(L"    /background-init\n");
+	SetConsoleTextAttribute(stdOut, CNSL_GRAY);
+	wprintf(L"        If present, methods are initialized on a background thread before they are\n");
+	wprintf(L"        called, starting with the main method and following the methods that it\n");
+	wprintf(L"        calls.\n");
+
 	SetConsoleTextAttribute(stdOut, cbuf.wAttributes);
 	exit(0);
 }
@@ -22,12 +22,35 @@ typedef struct OvumArgs_S
 	wchar_t *startupFile; // The startup file
 
 	bool verbose; // -v: Adds extra verbosity to the VM during startup and shutdown
+
+	bool compactGen1; // -compact: Allows the GC to compact generation 1
+
+	// GC and execution engine tuning. Zero means "use the VM's default".
+	size_t gen0Size; // -gen0 <size>: The (initial) size of generation 0
+	bool adaptiveGen0; // -adaptive-gen0: Resize gen0 based on its survival rate
+	size_t gen1Threshold; // -gen1-threshold <size>: Gen1 growth that triggers a full collection
+	size_t largeObjectSize; // -loh <size>: Objects larger than this go in the large object heap
+	size_t callStackSize; // -stack <size>: The size of the managed call stack
+	uint32_t gcWorkerCount; // -gc-workers <count>: The number of parallel marking threads
+
+	bool jit; // -jit: Compiles frequently called methods to native code
+	uint32_t jitThreshold; // -jit-threshold <count>: The number of calls before a method is compiled
+
+	wchar_t *sampleFile; // -sample <file>: Samples the call stack and writes the results to this file
+	uint32_t sampleInterval; // -sample-interval <ms>: The time between samples
+
+	bool lazyBodies; // -lazy-bodies: Reads method bodies when methods are first called
+	wchar_t *methodCacheDir; // -method-cache <dir>: Keeps initialized method bodies in this directory
+	bool preinit; // -preinit: Fills the method cache instead of running the program
+	bool backgroundInit; // -background-init: Initializes methods on a background thread
 } OvumArgs;
 
 void ParseCommandLine(int argc, wchar_t *argv[], OvumArgs &args);
 
 void CommandParseError(const char *message, const wchar_t *extra = nullptr);
 
+size_t ParseSizeArgument(const wchar_t *name, int &i, int argc, wchar_t *argv[]);
+
 void PrintUsageAndExit();
 
 void GetStartupFile(const wchar_t *path, wchar_t *buf, size_t bufSize);
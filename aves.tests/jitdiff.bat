@@ -0,0 +1,31 @@
+@echo off
+
+rem Runs the tests with and without the JIT compiler, and compares the output.
+rem With a threshold of 1, every method that the JIT supports is compiled on
+rem its first call, so any difference points to a bug in the compiled code.
+
+rem Path to Ovum. The JIT compiler only targets x64, so both runs use the x64
+rem build. The aves.dll next to aves.ovm in the library folder must be the x64
+rem build too.
+set OVUM="%OSP%\Ovum\x64\Release\Ovum.exe"
+
+if [%1]==[skip-build] (
+	set SKIPBUILD=1
+) else (
+	set SKIPBUILD=0
+)
+
+if %SKIPBUILD%==0 (
+	echo [!] Compiling aves.tests...
+	call build.bat
+)
+
+if %ERRORLEVEL%==0 (
+	echo [!] Running tests in the interpreter
+	%OVUM% /L "%LIB%" aves.tests.ovm > interpreter.out 2>&1
+
+	echo [!] Running tests with /jit
+	%OVUM% /jit /jit-threshold 1 /L "%LIB%" aves.tests.ovm > jit.out 2>&1
+
+	fc interpreter.out jit.out
+)
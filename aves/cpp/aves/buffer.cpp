@@ -25,16 +25,24 @@ AVES_API BEGIN_NATIVE_FUNCTION(aves_Buffer_new)
 
 	Buffer *buf = THISV.Get<Buffer>();
 
-	buf->size = (size_t)size64;
-	if (buf->size > 0)
+	size_t size = (size_t)size64;
+	buf->size = size;
+	if (size > 0)
 	{
-		CHECKED_MEM(buf->bytes = new(std::nothrow) uint8_t[buf->size]);
+		uint8_t *bytes;
+		CHECKED_MEM(bytes = new(std::nothrow) uint8_t[size]);
+		buf->bytes = bytes;
 		// If the size is particularly large, the zeroing operation may take a
 		// large amount of time. We enter an unmanaged region so the GC can run
-		// if it really needs to.
+		// if it really needs to. The GC may move the buffer in the meantime,
+		// so buf must not be used after this point.
 		VM_EnterUnmanagedRegion(thread);
-		memset(buf->bytes, 0, buf->size);
+		memset(bytes, 0, size);
 		VM_LeaveUnmanagedRegion(thread);
+
+		// Let the GC know how much memory the buffer is holding on to, so
+		// that it can collect dead buffers in a timely fashion.
+		GC_AddMemoryPressure(thread, size);
 	}
 }
 END_NATIVE_FUNCTION
@@ -375,8 +383,11 @@ AVES_API NATIVE_FUNCTION(aves_Buffer_copyInternal)
 void aves_Buffer_finalize(void *basePtr)
 {
 	Buffer *buf = reinterpret_cast<Buffer*>(basePtr);
+	if (buf->bytes)
+		GC_RemoveMemoryPressure(nullptr, buf->size);
 	buf->size = 0;
-	free(buf->bytes);
+	delete[] buf->bytes;
+	buf->bytes = nullptr;
 }
 
 AVES_API uint8_t *aves_Buffer_getDataPointer(Value *buffer, size_t *bufferSize)
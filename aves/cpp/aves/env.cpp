@@ -123,3 +123,9 @@ AVES_API NATIVE_FUNCTION(aves_Env_get_tickCount)
 #endif
 	RETURN_SUCCESS;
 }
+
+AVES_API NATIVE_FUNCTION(aves_Env_printProfile)
+{
+	VM_PushBool(thread, VM_PrintProfile(thread));
+	RETURN_SUCCESS;
+}
@@ -15,4 +15,6 @@ AVES_API NATIVE_FUNCTION(aves_Env_get_stackTrace);
 
 AVES_API NATIVE_FUNCTION(aves_Env_get_tickCount);
 
+AVES_API NATIVE_FUNCTION(aves_Env_printProfile);
+
 #endif // AVES__ENV_H
@@ -14,6 +14,7 @@ AVES_API int OVUM_CDECL aves_Error_init(TypeHandle type)
 	CHECKED(Type_AddNativeField(type, offsetof(ErrorInst, stackTrace), NativeFieldType::STRING));
 	CHECKED(Type_AddNativeField(type, offsetof(ErrorInst, innerError), NativeFieldType::VALUE));
 	CHECKED(Type_AddNativeField(type, offsetof(ErrorInst, data),       NativeFieldType::VALUE));
+	CHECKED(Type_AddNativeField(type, offsetof(ErrorInst, rawStackTrace), NativeFieldType::GC_ARRAY));
 
 retStatus__:
 	return status__;
@@ -48,15 +49,16 @@ AVES_API NATIVE_FUNCTION(aves_Error_get_message)
 	VM_PushString(thread, err->message);
 	RETURN_SUCCESS;
 }
-AVES_API NATIVE_FUNCTION(aves_Error_get_stackTrace)
+AVES_API BEGIN_NATIVE_FUNCTION(aves_Error_get_stackTrace)
 {
-	ErrorInst *err = THISV.v.error;
-	if (err->stackTrace == nullptr)
+	String *stackTrace;
+	CHECKED(VM_GetErrorStackTrace(thread, THISP, &stackTrace));
+	if (stackTrace == nullptr)
 		VM_PushNull(thread);
 	else
-		VM_PushString(thread, err->stackTrace);
-	RETURN_SUCCESS;
+		VM_PushString(thread, stackTrace);
 }
+END_NATIVE_FUNCTION
 AVES_API NATIVE_FUNCTION(aves_Error_get_innerError)
 {
 	ErrorInst *err = THISV.v.error;
@@ -6,12 +6,24 @@ AVES_API NATIVE_FUNCTION(aves_GC_get_collectCount)
 	RETURN_SUCCESS;
 }
 
+AVES_API NATIVE_FUNCTION(aves_GC_get_memoryPressure)
+{
+	VM_PushInt(thread, (int64_t)GC_GetMemoryPressure(thread));
+	RETURN_SUCCESS;
+}
+
 AVES_API NATIVE_FUNCTION(aves_GC_collect)
 {
 	GC_Collect(thread);
 	RETURN_SUCCESS;
 }
 
+AVES_API NATIVE_FUNCTION(aves_GC_waitForPendingFinalizers)
+{
+	GC_WaitForPendingFinalizers(thread);
+	RETURN_SUCCESS;
+}
+
 AVES_API NATIVE_FUNCTION(aves_GC_getGeneration)
 {
 	VM_PushInt(thread, GC_GetGeneration(args));
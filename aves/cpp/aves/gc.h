@@ -5,8 +5,12 @@
 
 AVES_API NATIVE_FUNCTION(aves_GC_get_collectCount);
 
+AVES_API NATIVE_FUNCTION(aves_GC_get_memoryPressure);
+
 AVES_API NATIVE_FUNCTION(aves_GC_collect);
 
+AVES_API NATIVE_FUNCTION(aves_GC_waitForPendingFinalizers);
+
 AVES_API NATIVE_FUNCTION(aves_GC_getGeneration);
 
 #endif // AVES__GC_H
@@ -0,0 +1,11 @@
+@echo off
+
+rem Usage: build.bat <benchmark>
+rem Compiles <benchmark>.osp into <benchmark>.ovm.
+
+rem Path to the compiler
+set OSPC="%OSP%\Osprey\bin\Release\Osprey.exe"
+rem Path to the library folder
+set LIB=%OSP%\lib
+
+%OSPC% /libpath "%LIB%" /main benchmarks.%1.main /out %1.ovm %1.osp
@@ -0,0 +1,24 @@
+@echo off
+
+rem Usage: run.bat [skip-build] <benchmark> [arguments...]
+
+rem Path to Ovum
+set OVUM="%OSP%\Ovum\Release\Ovum.exe"
+
+if [%1]==[skip-build] (
+	set SKIPBUILD=1
+	shift
+) else (
+	set SKIPBUILD=0
+)
+
+set BENCHMARK=%1
+
+if %SKIPBUILD%==0 (
+	echo [!] Compiling %BENCHMARK%...
+	call build.bat %BENCHMARK%
+)
+
+if %ERRORLEVEL%==0 (
+	%OVUM% /L "%LIB%" %BENCHMARK%.ovm %2 %3 %4 %5
+)
@@ -0,0 +1,42 @@
+@echo off
+
+rem Usage: startup.bat [skip-build] [runs]
+rem Starts Ovum with startup.ovm [runs] times (default 20) with method bodies
+rem read eagerly, then as many times with /lazy-bodies, and prints the average
+rem time per run for each.
+
+rem Path to Ovum
+set OVUM=%OSP%\Ovum\Release\Ovum.exe
+rem Path to the library folder
+set LIB=%OSP%\lib
+
+if [%1]==[skip-build] (
+	set SKIPBUILD=1
+	shift
+) else (
+	set SKIPBUILD=0
+)
+
+if [%1]==[] (
+	set RUNS=20
+) else (
+	set RUNS=%1
+)
+
+if %SKIPBUILD%==0 (
+	echo [!] Compiling startup...
+	call build.bat startup
+	if errorlevel 1 exit /b 1
+)
+
+echo Startup benchmark, hello world with aves, average of %RUNS% runs
+call :measure eager ""
+call :measure lazy "/lazy-bodies"
+exit /b 0
+
+rem Usage: call :measure <name> <flags>
+:measure
+powershell -NoProfile -Command ^
+	"$t = Measure-Command { for ($i = 0; $i -lt %RUNS%; $i++) { & '%OVUM%' %~2 /L '%LIB%' startup.ovm | Out-Null } };" ^
+	"'{0,-6} {1,8:F1} ms' -f '%1', ($t.TotalMilliseconds / %RUNS%)"
+exit /b 0
@@ -69,6 +69,7 @@
 #define OVUM_ERROR_DIVIDE_BY_ZERO   9  /* Integer division by zero. */
 #define OVUM_ERROR_INTERRUPTED     10  /* The thread was interrupted while waiting for a blocking operation. */
 #define OVUM_ERROR_WRONG_THREAD    11  /* Attempting an operation on the wrong thread, such as leaving a mutex that the caller isn't in. */
+#define OVUM_ERROR_INVALID_PARAMS  12  /* The VM was started with invalid parameters (see VMStartParams). */
 #define OVUM_ERROR_BUSY           (-1) /* A semaphore, mutex or similar value is entered by another thread. */
 
 // Handle types. The OVUM_HANDLES_DEFINED macro lets these
@@ -246,9 +247,15 @@ struct ListInst_S
 struct ErrorInst_S
 {
 	String *message;
+	// The formatted stack trace. This is null until the stack trace is first
+	// requested; use VM_GetErrorStackTrace to read it.
 	String *stackTrace;
 	Value innerError;
 	Value data;
+	// The raw stack trace recorded when the error was thrown, which is turned
+	// into stackTrace on demand. This is a GC-allocated array, and is private
+	// to the VM.
+	void *rawStackTrace;
 };
 
 struct MethodInst_S
@@ -272,6 +279,11 @@ OVUM_API void VM_PrintLn(String *str);
 OVUM_API void VM_PrintErr(String *str);
 OVUM_API void VM_PrintErrLn(String *str);
 
+// Prints a report of the instructions and methods that have been executed so
+// far to stderr. Returns false without printing anything if the VM was built
+// without profiling support.
+OVUM_API bool VM_PrintProfile(ThreadHandle thread);
+
 OVUM_API size_t VM_GetArgCount(ThreadHandle thread);
 OVUM_API size_t VM_GetArgs(ThreadHandle thread, size_t destLength, String *dest[]);
 OVUM_API size_t VM_GetArgValues(ThreadHandle thread, size_t destLength, Value dest[]);
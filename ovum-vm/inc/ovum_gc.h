@@ -90,22 +90,67 @@ OVUM_API int GC_AllocValueArray(ThreadHandle thread, size_t length, Value **outp
 // which helps the GC better schedule garbage collection.
 // NOTE: Consumers of this method MUST take care to remove EXACTLY as much memory
 // pressure as they add, or the GC will experience performance problems.
+//
+// If the pressure added since the last full collection exceeds a threshold,
+// this function runs a full collection before it returns. The collection may
+// move objects, so any pointers into managed objects that the caller holds
+// must be re-read afterwards (from the stack or from a StaticRef).
 OVUM_API void GC_AddMemoryPressure(ThreadHandle thread, size_t size);
 
 // Informs the GC that a certain amount of unmanaged memory has been released,
 // which helps the GC better schedule garbage collection.
 // NOTE: Consumers of this method MUST take care to remove EXACTLY as much memory
 // pressure as they add, or the GC will experience performance problems.
+//
+// Finalizers do not receive a thread handle. When this function is called from
+// a finalizer, the thread should be null.
 OVUM_API void GC_RemoveMemoryPressure(ThreadHandle thread, size_t size);
 
+// Gets the total amount of unmanaged memory that has been reported to the GC
+// through GC_AddMemoryPressure and not yet removed.
+OVUM_API size_t GC_GetMemoryPressure(ThreadHandle thread);
+
 OVUM_API Value *GC_AddStaticReference(ThreadHandle thread, Value *initialValue);
 
+// Informs the GC that a managed reference has been written directly into a field
+// of a GC-managed object through a raw pointer, rather than with WriteReference.
+// Native code must call this after such a write, unless the object belongs to a
+// type with native fields or a reference walker (those are always examined).
+//
+// Parameters:
+//   thread:
+//     The current thread.
+//   instance:
+//     The instance whose field was written to.
+//   value:
+//     The value that was written.
+OVUM_API void GC_WriteBarrier(ThreadHandle thread, void *instance, Value *value);
+
 // Forces an immediate garbage collection.
 OVUM_API void GC_Collect(ThreadHandle thread);
 
+// Blocks until the finalizers of every object that the GC has found to be
+// dead have run. Finalizers run on a separate thread after each collection;
+// call this after GC_Collect to make sure that the unmanaged resources of
+// dead objects have been released.
+OVUM_API void GC_WaitForPendingFinalizers(ThreadHandle thread);
+
 // Gets the number of times garbage collection has occurred.
 OVUM_API uint32_t GC_GetCollectCount(ThreadHandle thread);
 
+// Gets the number of times generation 1 has been compacted. This is always zero
+// unless gen1 compaction was enabled when the VM was started.
+OVUM_API uint32_t GC_GetCompactionCount(ThreadHandle thread);
+
+// Gets the total number of times any thread has had to refill its allocation
+// buffer. Small objects are allocated from a thread-local buffer without locking;
+// a refill requires the GC's allocation lock.
+OVUM_API uint32_t GC_GetAllocBufferRefillCount(ThreadHandle thread);
+
+// Gets the number of times the specified thread has had to refill its allocation
+// buffer.
+OVUM_API uint32_t GC_GetThreadAllocBufferRefillCount(ThreadHandle thread);
+
 OVUM_API int GC_GetGeneration(Value *value);
 
 OVUM_API uint32_t GC_GetObjectHashCode(Value *value);
@@ -23,6 +23,62 @@ typedef struct VMStartParams_S
 	const pathchar_t *modulePath;
 	// Make the VM be more explicit about what it's doing during startup.
 	bool verbose;
+	// Allow the GC to move generation 1 objects in order to reduce memory
+	// fragmentation. Pinned objects are never moved.
+	bool compactGen1;
+
+	// The remaining fields tune the GC and the execution engine. For each size,
+	// a value of zero means "use the default". Sizes are in bytes. VM_Start
+	// fails with OVUM_ERROR_INVALID_PARAMS if a value is out of range.
+
+	// The size of generation 0, where new objects are allocated.
+	size_t gen0Size;
+	// If true, the GC grows or shrinks generation 0 depending on how much of it
+	// survives each collection. In that case, gen0Size is the initial size.
+	bool adaptiveGen0;
+	// The amount by which generation 1 may grow before the GC collects it.
+	size_t gen1DeadObjectThreshold;
+	// Objects larger than this are allocated in the large object heap. This
+	// can be at most half of gen0Size.
+	size_t largeObjectSize;
+	// The size of the managed call stack.
+	size_t callStackSize;
+	// The number of threads that take part in the GC's mark phase, including
+	// the thread that runs the cycle. Zero means one per processor; 1 means
+	// marking is done serially, without any extra threads.
+	uint32_t gcWorkerCount;
+	// Compile frequently called methods to native code. This is only available
+	// on x86-64; elsewhere, VM_Start fails with OVUM_ERROR_INVALID_PARAMS.
+	bool jit;
+	// The number of calls after which a method is compiled, if jit is true.
+	uint32_t jitThreshold;
+	// If not null, the VM samples the managed call stack at regular intervals
+	// while the program runs, and writes the samples to this file when it ends.
+	// The file uses the collapsed stack format, which flame graph tools accept.
+	const pathchar_t *sampleFile;
+	// The time between samples, in milliseconds, if sampleFile is set.
+	uint32_t sampleInterval;
+	// Read the bytecode of each method from its module file the first time
+	// the method is called, rather than when the module is loaded. This makes
+	// startup faster for programs that only use a small part of each module,
+	// at the cost of keeping module files open while the program runs.
+	bool lazyMethodBodies;
+	// If not null, the VM keeps the initialized bodies of methods in this
+	// directory, and reuses them the next time the same modules are loaded.
+	// This saves the VM from having to initialize every method again on each
+	// run. The directory must exist.
+	const pathchar_t *methodCacheDirectory;
+	// Instead of running the program, initialize every method in the startup
+	// module and the modules it depends on, and write the results to the
+	// method cache. Later runs then load every method from the cache. This
+	// requires methodCacheDirectory to be set. Methods that fail to initialize
+	// are reported and skipped, and VM_Start then returns OVUM_ERROR_METHOD_INIT.
+	bool preinitializeMethods;
+	// Initialize methods on a background thread before they are called,
+	// starting with the main method and following the methods that each
+	// initialized method refers to. The managed thread then rarely has to
+	// wait for a method to be initialized.
+	bool backgroundMethodInit;
 } VMStartParams;
 
 OVUM_API int VM_Start(VMStartParams *params);
@@ -5,6 +5,8 @@
 
 OVUM_API int32_t String_GetHashCode(String *str);
 OVUM_API int32_t String_GetHashCodeSubstr(const String *str, size_t index, size_t count);
+// Computes the hash code that a String with the specified characters would have.
+OVUM_API int32_t String_GetHashCodeOfChars(size_t length, const ovchar_t *chars);
 
 OVUM_API bool String_Equals(const String *a, const String *b);
 OVUM_API bool String_EqualsIgnoreCase(const String *a, const String *b);
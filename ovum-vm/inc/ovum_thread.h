@@ -305,6 +305,22 @@ OVUM_API void VM_Sleep(ThreadHandle thread, unsigned int milliseconds);
 // functions that are included are those invoked by the VM.
 OVUM_API String *VM_GetStackTrace(ThreadHandle thread);
 
+// Gets the stack trace of an aves.Error. When an error is thrown, the VM only
+// records which methods were on the call stack; the stack trace is formatted
+// the first time this function is called for the error, and then cached.
+//
+// Parameters:
+//   thread:
+//     The current thread.
+//   error:
+//     The aves.Error whose stack trace to get.
+//   result:
+//     Receives the stack trace, or null if the error has never been thrown.
+// Returns:
+//   OVUM_SUCCESS, or OVUM_ERROR_NO_MEMORY if the stack trace could not be
+//   formatted.
+OVUM_API int VM_GetErrorStackTrace(ThreadHandle thread, Value *error, String **result);
+
 // Gets the current depth of the call stack; that is, the number
 // of stack frames currently on the call stack.
 //
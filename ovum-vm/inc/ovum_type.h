@@ -180,6 +180,10 @@ typedef int (OVUM_CDECL *ReferenceVisitor)(void *cbState, size_t count, Value *v
 // from the ReferenceWalker, and the callback must not be called again. If the
 // ReferenceWalker call succeeds, it must return OVUM_SUCCESS.
 //
+// The GC may call a ReferenceWalker from several threads at the same time, for
+// different objects. The ReferenceWalker must not modify the object or any
+// shared state; simply reading the object's fields is always safe.
+//
 // Parameters:
 //   basePtr:
 //     The base of the fields for a value of the type that implements
@@ -217,6 +221,12 @@ typedef int (OVUM_CDECL *ReferenceWalker)(void *basePtr, ReferenceVisitor callba
 // the offset of the finalizing type, and may therefore differ from
 // Value.instance.
 //
+// Finalizers run on a separate finalizer thread, some time after the
+// GC cycle that found the object to be dead. They may run concurrently
+// with managed code, and with the finalizers of other objects. Managed
+// references in the instance may refer to objects that have already been
+// released, and must not be examined.
+//
 // NOTE: Finalizers do not have access to the managed runtime. Do not
 // attempt to access the managed runtime from a finalizer. Do not try
 // to allocate any managed memory during a finalizer. Doing either
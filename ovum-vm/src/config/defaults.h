@@ -7,21 +7,109 @@ namespace ovum
 
 namespace config
 {
+	// Most of the sizes and thresholds below are only defaults, used when the
+	// corresponding VMStartParams field is zero. Those fields are validated
+	// against the MIN/MAX values in VM::ValidateStartParams().
 	class Defaults
 	{
 	public:
 		// The size of the (pre-allocated) generation 0 chunk.
+		// Configurable through VMStartParams::gen0Size.
 		// (1.5 MB)
 		static const size_t GEN0_SIZE = 1536 * 1024;
+		// (256 kB)
+		static const size_t GEN0_MIN_SIZE = 256 * 1024;
+		// (256 MB)
+		static const size_t GEN0_MAX_SIZE = 256 * 1024 * 1024;
+
+		// When gen0 sizing is adaptive (VMStartParams::adaptiveGen0), gen0 is
+		// doubled in size after a cycle in which at least this percentage of
+		// it survived. The idea is to give objects more time to die before
+		// they are promoted to gen1.
+		static const size_t GEN0_GROW_SURVIVAL_RATE = 25;
+		// When gen0 sizing is adaptive, gen0 is halved in size after a cycle
+		// in which at most this percentage of it survived. A smaller gen0 is
+		// friendlier to the CPU cache.
+		static const size_t GEN0_SHRINK_SURVIVAL_RATE = 5;
+
+		// Objects larger than this (including the GCObject header) are allocated
+		// in the large object heap rather than in gen0. The size must be at most
+		// half the size of gen0.
+		// Configurable through VMStartParams::largeObjectSize.
+		// (85 kB)
+		static const size_t LARGE_OBJECT_SIZE = 87040;
+		// (32 kB)
+		static const size_t LARGE_OBJECT_MIN_SIZE = 32 * 1024;
+
+		// The size of each thread-local allocation buffer, which is carved out
+		// of generation 0. Threads allocate small objects from their buffer
+		// without taking the GC's allocation lock.
+		// (32 kB)
+		static const size_t ALLOC_BUFFER_SIZE = 32 * 1024;
 
 		// The maximum amount of garbage allowed in generation 1 before the GC
 		// forces it to be collected.
+		// Configurable through VMStartParams::gen1DeadObjectThreshold.
 		// (768 kB)
 		static const size_t GEN1_DEAD_OBJECT_THRESHOLD = 768 * 1024;
+		// (64 kB)
+		static const size_t GEN1_DEAD_OBJECT_MIN_THRESHOLD = 64 * 1024;
+		// (1 GB)
+		static const size_t GEN1_DEAD_OBJECT_MAX_THRESHOLD = 1024 * 1024 * 1024;
+
+		// The amount of unmanaged memory that may be reported to the GC (through
+		// GC_AddMemoryPressure) since the last full cycle before the GC forces a
+		// full cycle, even if no managed memory is being allocated.
+		// (16 MB)
+		static const size_t MEMORY_PRESSURE_THRESHOLD = 16 * 1024 * 1024;
+
+		// If gen1 compaction is enabled, generation 1 is compacted at the end of
+		// a full cycle when at least this percentage of the memory occupied by
+		// gen1 regions could be returned to the OS by compacting.
+		static const size_t GEN1_COMPACTION_THRESHOLD = 25;
+
+		// Generation 1 is never compacted while its regions take up less than
+		// this amount of memory.
+		// (2 MB)
+		static const size_t GEN1_COMPACTION_MIN_SIZE = 2048 * 1024;
+
+		// The maximum number of threads that can take part in the mark phase.
+		// By default, the GC uses one per processor, up to this limit.
+		// Configurable through VMStartParams::gcWorkerCount.
+		static const uint32_t GC_MAX_WORKER_COUNT = 64;
+
+		// Marking only continues in parallel once the mark stack holds at least
+		// this many objects. Below that, there is not enough work to go around,
+		// and waking up the workers would cost more time than it saves.
+		static const size_t PARALLEL_MARK_MIN_OBJECTS = 128;
 
 		// The size of the managed call stack.
+		// Configurable through VMStartParams::callStackSize.
 		// (4 MB)
 		static const size_t CALL_STACK_SIZE = 4096 * 1024;
+		// (64 kB)
+		static const size_t CALL_STACK_MIN_SIZE = 64 * 1024;
+		// (1 GB)
+		static const size_t CALL_STACK_MAX_SIZE = 1024 * 1024 * 1024;
+
+		// When the JIT compiler is enabled, a method overload is compiled once
+		// it has been called this many times.
+		// Configurable through VMStartParams::jitThreshold.
+		static const uint32_t JIT_THRESHOLD = 1000;
+
+		// When the sampling profiler is enabled, the time between samples, in
+		// milliseconds.
+		// Configurable through VMStartParams::sampleInterval.
+		static const uint32_t SAMPLE_INTERVAL = 10;
+
+		// Module strings are allocated in chunks of this size. Strings larger
+		// than a quarter of a chunk are allocated separately.
+		// (64 kB)
+		static const size_t MODULE_STRING_CHUNK_SIZE = 64 * 1024;
+
+		// The JIT compiler allocates executable memory in chunks of this size.
+		// (256 kB)
+		static const size_t JIT_CODE_CHUNK_SIZE = 256 * 1024;
 	};
 } // namespace ovum::config
 
@@ -0,0 +1,385 @@
+#include "backgroundinitializer.h"
+#include "methodinitializer.h"
+#include "methodbuilder.h"
+#include "thread.h"
+#include "../object/method.h"
+#include "../module/module.h"
+#include "../debug/debugsymbols.h"
+
+namespace ovum
+{
+
+Box<BackgroundInitializer> BackgroundInitializer::New(VM *vm)
+{
+	Box<BackgroundInitializer> result(new(std::nothrow) BackgroundInitializer(vm));
+	return std::move(result);
+}
+
+BackgroundInitializer::BackgroundInitializer(VM *vm) :
+	vm(vm),
+	thread(),
+	threadRunning(false),
+	queue(),
+	queued(),
+	stopping(false),
+	workSignal(0),
+	initLock(4000),
+	prepared(),
+	failed(),
+	initializedCount(0)
+{ }
+
+BackgroundInitializer::~BackgroundInitializer()
+{
+	Stop();
+}
+
+bool BackgroundInitializer::Start(MethodOverload *mainMethod)
+{
+	if (threadRunning)
+		return true;
+
+	Enqueue(mainMethod);
+
+	if (!os::ThreadStart(&thread, ThreadMain, this))
+		return false;
+	threadRunning = true;
+	return true;
+}
+
+void BackgroundInitializer::Stop()
+{
+	if (!threadRunning)
+		return;
+
+	queueLock.Enter();
+	stopping = true;
+	queueLock.Leave();
+
+	workSignal.Leave();
+	os::ThreadJoin(&thread);
+	threadRunning = false;
+}
+
+int BackgroundInitializer::InitializeMethod(Thread *const thread, MethodOverload *method)
+{
+	instr::MethodBuilder builder;
+	std::vector<instr::PointerArgument> pointers;
+
+	initLock.Enter();
+
+	// The background thread may have finished the method while we were
+	// waiting for the lock.
+	if (method->IsInitialized())
+	{
+		initLock.Leave();
+		RETURN_SUCCESS;
+	}
+
+	auto preparedMethod = prepared.find(method);
+	if (preparedMethod != prepared.end())
+	{
+		const std::vector<Type*> &types = preparedMethod->second;
+		for (size_t i = 0; i < types.size(); i++)
+			builder.AddTypeToInitialize(types[i]);
+		prepared.erase(preparedMethod);
+	}
+	else
+	{
+		auto failedMethod = failed.find(method);
+		if (failedMethod != failed.end())
+		{
+			// Report the error now, just as if the method had been
+			// initialized on this thread.
+			vm->PrintMethodInitException(failedMethod->second);
+			abort();
+		}
+
+		if (method->HasDeferredBody())
+		{
+			int r = method->group->declModule->ReadDeferredMethodBody(method);
+			if (r != OVUM_SUCCESS)
+			{
+				initLock.Leave();
+				return r;
+			}
+		}
+
+		MethodInitializer initer(vm);
+		initer.InitializeBody(method, builder, &pointers);
+	}
+
+	method->SetInitialized();
+	initLock.Leave();
+
+	EnqueueTargets(pointers);
+
+	int r = OVUM_SUCCESS;
+	if (builder.GetTypeCount() > 0)
+		r = thread->CallStaticConstructors(builder);
+	return r;
+}
+
+void BackgroundInitializer::Enqueue(MethodOverload *method)
+{
+	if (method->IsAbstract() || method->IsNative())
+		return;
+
+	queueLock.Enter();
+
+	bool signal = false;
+	try
+	{
+		if (!stopping && queued.insert(method).second)
+		{
+			signal = queue.empty();
+			queue.push_back(method);
+		}
+	}
+	catch (std::bad_alloc&)
+	{
+		// The method is simply not initialized in the background. If it was
+		// added to queued, it is never queued again either.
+		signal = false;
+	}
+
+	queueLock.Leave();
+
+	if (signal)
+		workSignal.Leave();
+}
+
+void BackgroundInitializer::EnqueueTargets(const std::vector<instr::PointerArgument> &pointers)
+{
+	for (size_t i = 0; i < pointers.size(); i++)
+	{
+		const instr::PointerArgument &ptr = pointers[i];
+		switch (ptr.kind)
+		{
+		case instr::PointerArgument::OVERLOAD:
+			Enqueue(const_cast<MethodOverload*>(
+				static_cast<const MethodOverload*>(ptr.target)
+			));
+			break;
+		case instr::PointerArgument::METHOD:
+			{
+				// The overload is chosen at runtime, so queue all of them.
+				const Method *method = static_cast<const Method*>(ptr.target);
+				for (size_t o = 0; o < method->overloadCount; o++)
+					Enqueue(method->overloads + o);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+void BackgroundInitializer::InitializeInBackground(MethodOverload *method)
+{
+	instr::MethodBuilder builder;
+	std::vector<instr::PointerArgument> pointers;
+	std::vector<size_t> offsets;
+
+	initLock.Enter();
+
+	if (method->IsInitialized() ||
+		method->HasDeferredBody() ||
+		prepared.find(method) != prepared.end() ||
+		failed.find(method) != failed.end())
+	{
+		initLock.Leave();
+		return;
+	}
+
+	bool success = false;
+	try
+	{
+		// MethodParser replaces the try block and debug symbol offsets with
+		// instruction indexes long before the body is replaced, so they are
+		// saved in case initialization fails. The entry in prepared is also
+		// allocated up front, so that nothing can fail once the body has been
+		// replaced.
+		SaveOffsets(method, offsets);
+		auto preparedMethod = prepared.insert(std::make_pair(method, std::vector<Type*>())).first;
+
+		try
+		{
+			MethodInitializer initer(vm);
+			initer.InitializeBodyOrThrow(method, builder, &pointers);
+			success = true;
+		}
+		catch (MethodInitException &e)
+		{
+			prepared.erase(preparedMethod);
+			RestoreOffsets(method, offsets);
+			failed.insert(std::make_pair(method, e));
+		}
+		catch (std::bad_alloc&)
+		{
+			prepared.erase(preparedMethod);
+			throw;
+		}
+
+		if (success)
+		{
+			if (builder.GetTypeCount() == 0)
+			{
+				prepared.erase(preparedMethod);
+				method->SetInitialized();
+			}
+			else
+			{
+				builder.TakeTypesToInitialize(preparedMethod->second);
+			}
+			initializedCount++;
+		}
+	}
+	catch (std::bad_alloc&)
+	{
+		// Out of memory. The method is not recorded anywhere, so the managed
+		// thread initializes it as usual when it first calls it.
+		if (offsets.size() == GetOffsetCount(method))
+			RestoreOffsets(method, offsets);
+	}
+
+	initLock.Leave();
+
+	if (success)
+		EnqueueTargets(pointers);
+}
+
+size_t BackgroundInitializer::GetOffsetCount(const MethodOverload *method)
+{
+	size_t count = 0;
+	for (size_t t = 0; t < method->tryBlockCount; t++)
+	{
+		const TryBlock &tryBlock = method->tryBlocks[t];
+		count += 2;
+		if (tryBlock.kind == TryKind::CATCH)
+			count += 2 * tryBlock.catches.count;
+		else
+			count += 2;
+	}
+
+	if (method->debugSymbols)
+		count += 2 * method->debugSymbols->GetSymbolCount();
+
+	return count;
+}
+
+void BackgroundInitializer::SaveOffsets(const MethodOverload *method, std::vector<size_t> &offsets)
+{
+	offsets.reserve(GetOffsetCount(method));
+
+	for (size_t t = 0; t < method->tryBlockCount; t++)
+	{
+		const TryBlock &tryBlock = method->tryBlocks[t];
+		offsets.push_back(tryBlock.tryStart);
+		offsets.push_back(tryBlock.tryEnd);
+
+		switch (tryBlock.kind)
+		{
+		case TryKind::CATCH:
+			for (size_t c = 0; c < tryBlock.catches.count; c++)
+			{
+				const CatchBlock &catchBlock = tryBlock.catches.blocks[c];
+				offsets.push_back(catchBlock.catchStart);
+				offsets.push_back(catchBlock.catchEnd);
+			}
+			break;
+		case TryKind::FINALLY:
+		case TryKind::FAULT: // uses finallyBlock
+			offsets.push_back(tryBlock.finallyBlock.finallyStart);
+			offsets.push_back(tryBlock.finallyBlock.finallyEnd);
+			break;
+		}
+	}
+
+	if (method->debugSymbols)
+	{
+		debug::OverloadSymbols *debug = method->debugSymbols;
+		size_t debugSymbolCount = debug->GetSymbolCount();
+		for (size_t i = 0; i < debugSymbolCount; i++)
+		{
+			const debug::DebugSymbol &sym = debug->GetSymbol(i);
+			offsets.push_back(sym.startOffset);
+			offsets.push_back(sym.endOffset);
+		}
+	}
+}
+
+void BackgroundInitializer::RestoreOffsets(MethodOverload *method, const std::vector<size_t> &offsets)
+{
+	const size_t *offset = offsets.data();
+
+	for (size_t t = 0; t < method->tryBlockCount; t++)
+	{
+		TryBlock &tryBlock = method->tryBlocks[t];
+		tryBlock.tryStart = *offset++;
+		tryBlock.tryEnd = *offset++;
+
+		switch (tryBlock.kind)
+		{
+		case TryKind::CATCH:
+			for (size_t c = 0; c < tryBlock.catches.count; c++)
+			{
+				CatchBlock &catchBlock = tryBlock.catches.blocks[c];
+				catchBlock.catchStart = *offset++;
+				catchBlock.catchEnd = *offset++;
+			}
+			break;
+		case TryKind::FINALLY:
+		case TryKind::FAULT: // uses finallyBlock
+			tryBlock.finallyBlock.finallyStart = *offset++;
+			tryBlock.finallyBlock.finallyEnd = *offset++;
+			break;
+		}
+	}
+
+	if (method->debugSymbols)
+	{
+		debug::OverloadSymbols *debug = method->debugSymbols;
+		size_t debugSymbolCount = debug->GetSymbolCount();
+		for (size_t i = 0; i < debugSymbolCount; i++)
+		{
+			debug::DebugSymbol &sym = debug->GetSymbol(i);
+			sym.startOffset = (uint32_t)*offset++;
+			sym.endOffset = (uint32_t)*offset++;
+		}
+	}
+}
+
+void BackgroundInitializer::ThreadMain(void *state)
+{
+	BackgroundInitializer *self = reinterpret_cast<BackgroundInitializer*>(state);
+
+	VM::vmKey.Set(self->vm);
+
+	while (true)
+	{
+		self->workSignal.Enter();
+
+		while (true)
+		{
+			self->queueLock.Enter();
+			if (self->stopping)
+			{
+				self->queueLock.Leave();
+				return;
+			}
+			if (self->queue.empty())
+			{
+				self->queueLock.Leave();
+				break;
+			}
+			MethodOverload *method = self->queue.front();
+			self->queue.pop_front();
+			self->queueLock.Leave();
+
+			self->InitializeInBackground(method);
+		}
+	}
+}
+
+} // namespace ovum
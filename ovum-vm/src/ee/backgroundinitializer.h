@@ -0,0 +1,135 @@
+#pragma once
+
+#include "../vm.h"
+#include "methodinitexception.h"
+#include "../threading/sync.h"
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace ovum
+{
+
+// The background initializer initializes methods on a separate thread before
+// they are called, so that the managed thread usually finds a method already
+// initialized the first time it calls it. It starts with the main method, and
+// follows every method that an initialized body refers to, whether that body
+// was initialized in the background or by the managed thread.
+//
+// Method initialization shares state between methods (the method cache, the
+// RefSignaturePool, and the try blocks of the overload being initialized), so
+// it is done under a single lock, by whichever thread gets there first. The
+// managed thread does not take the lock when it calls a method that is already
+// initialized: MethodOverload::SetInitialized() publishes the body, and
+// MethodOverload::IsInitialized() makes it visible.
+//
+// Speculative initialization must not change what the program does:
+//  * Static constructors only run on the managed thread. If a method depends
+//    on a static constructor that has not run yet, the background thread does
+//    not mark the method as initialized. The managed thread runs the static
+//    constructors when it first calls the method, just as if it had
+//    initialized the method itself.
+//  * If a method fails to initialize, the error is kept, and reported when
+//    the managed thread first calls the method. Methods that are never called
+//    are never reported. If the background thread runs out of memory, the
+//    method is left as it was, and the managed thread initializes it.
+//  * Method bodies that have not been read yet (see VMStartParams::
+//    lazyMethodBodies) are left to the managed thread, since a malformed body
+//    aborts the process.
+class BackgroundInitializer
+{
+public:
+	// Creates a background initializer for the specified VM. The thread does
+	// not run until Start() is called.
+	OVUM_NOINLINE static Box<BackgroundInitializer> New(VM *vm);
+
+	// Stops the thread, if it is running.
+	~BackgroundInitializer();
+
+	// Starts the background thread, and queues the specified method to be
+	// initialized first. Returns true on success.
+	bool Start(MethodOverload *mainMethod);
+
+	// Stops the background thread, and waits for it to terminate. Methods that
+	// are still queued are not initialized.
+	void Stop();
+
+	// Initializes a method on the managed thread, which is about to call it.
+	// If the method has already been initialized in the background, this only
+	// runs the static constructors it depends on. Thread::InitializeMethod()
+	// calls this instead of using a MethodInitializer directly.
+	int InitializeMethod(Thread *const thread, MethodOverload *method);
+
+	// Gets the number of methods that have been initialized by the background
+	// thread.
+	inline size_t GetInitializedCount() const
+	{
+		return initializedCount;
+	}
+
+private:
+	VM *vm;
+
+	os::NativeThread thread;
+	// True if thread refers to a running thread.
+	bool threadRunning;
+
+	// Protects queue, queued and stopping.
+	SpinLock queueLock;
+
+	// Methods waiting to be initialized in the background.
+	std::deque<MethodOverload*> queue;
+	// Every method that has ever been queued, so that each method is only
+	// queued once.
+	std::unordered_set<MethodOverload*> queued;
+
+	// True when the thread should exit.
+	bool stopping;
+
+	// Incremented when the queue becomes non-empty, or when the thread should
+	// exit.
+	Semaphore workSignal;
+
+	// Held by any thread that initializes a method. Protects everything below.
+	CriticalSection initLock;
+
+	// Methods that have been initialized in the background, but which depend
+	// on static constructors that had not run at the time. These methods are
+	// not marked as initialized; instead, the types whose static constructors
+	// must be run are kept here.
+	std::unordered_map<MethodOverload*, std::vector<Type*>> prepared;
+
+	// Methods that failed to initialize in the background.
+	std::unordered_map<MethodOverload*, MethodInitException> failed;
+
+	// The number of methods initialized in the background.
+	size_t initializedCount;
+
+	BackgroundInitializer(VM *vm);
+
+	// Queues a method, unless it has been queued before.
+	void Enqueue(MethodOverload *method);
+
+	// Queues every method that an initialized method body refers to.
+	void EnqueueTargets(const std::vector<instr::PointerArgument> &pointers);
+
+	// Initializes a method on the background thread, if nothing else has. If
+	// there is not enough memory, the method is left to the managed thread.
+	void InitializeInBackground(MethodOverload *method);
+
+	// Gets the number of offsets in the try blocks and debug symbols of the
+	// specified overload.
+	static size_t GetOffsetCount(const MethodOverload *method);
+	// Saves the offsets in the try blocks and debug symbols of an overload
+	// that has not been initialized, so that they can be restored if its
+	// initialization fails.
+	static void SaveOffsets(const MethodOverload *method, std::vector<size_t> &offsets);
+	static void RestoreOffsets(MethodOverload *method, const std::vector<size_t> &offsets);
+
+	static void ThreadMain(void *state);
+
+	OVUM_DISABLE_COPY_AND_ASSIGN(BackgroundInitializer);
+};
+
+} // namespace ovum
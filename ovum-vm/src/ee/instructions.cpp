@@ -120,18 +120,21 @@ namespace instr
 	void LoadString::WriteArguments(MethodBuffer &buffer, MethodBuilder &builder) const
 	{
 		oa::LocalAndValue<String*> args = { target, value };
+		buffer.AddPointer(offsetof(oa::LocalAndValue<String*>, value), value);
 		buffer.Write(args, oa::LOCAL_AND_VALUE<String*>::SIZE);
 	}
 
 	void LoadEnumValue::WriteArguments(MethodBuffer &buffer, MethodBuilder &builder) const
 	{
 		oa::LoadEnum args = { target, type, value };
+		buffer.AddPointer(offsetof(oa::LoadEnum, type), type);
 		buffer.Write(args, oa::LOAD_ENUM_SIZE);
 	}
 
 	void NewObject::WriteArguments(MethodBuffer &buffer, MethodBuilder &builder) const
 	{
 		oa::NewObject args = { this->args, target, argCount, type };
+		buffer.AddPointer(offsetof(oa::NewObject, type), type);
 		buffer.Write(args, oa::NEW_OBJECT_SIZE);
 	}
 
@@ -150,48 +153,59 @@ namespace instr
 	void LoadStaticFunction::WriteArguments(MethodBuffer &buffer, MethodBuilder &builder) const
 	{
 		oa::LocalAndValue<Method*> args = { target, method };
+		buffer.AddPointer(offsetof(oa::LocalAndValue<Method*>, value), method);
 		buffer.Write(args, oa::LOCAL_AND_VALUE<Method*>::SIZE);
 	}
 
 	void LoadTypeToken::WriteArguments(MethodBuffer &buffer, MethodBuilder &builder) const
 	{
 		oa::LocalAndValue<Type*> args = { target, type };
+		buffer.AddPointer(offsetof(oa::LocalAndValue<Type*>, value), type);
 		buffer.Write(args, oa::LOCAL_AND_VALUE<Type*>::SIZE);
 	}
 
 	void LoadMember::WriteArguments(MethodBuffer &buffer, MethodBuilder &builder) const
 	{
-		oa::TwoLocalsAndValue<String*> args = { instance, output, member };
-		buffer.Write(args, oa::TWO_LOCALS_AND_VALUE<String*>::SIZE);
+		buffer.AddPointer(offsetof(oa::LoadMember, member), member);
+		oa::LoadMember *args = buffer.Emplace<oa::LoadMember>(oa::LOAD_MEMBER_SIZE);
+		args->source = instance;
+		args->dest = output;
+		args->member = member;
 	}
 
 	void StoreMember::WriteArguments(MethodBuffer &buffer, MethodBuilder &builder) const
 	{
-		oa::LocalAndValue<String*> args = { this->args, member };
-		buffer.Write(args, oa::LOCAL_AND_VALUE<String*>::SIZE);
+		buffer.AddPointer(offsetof(oa::StoreMember, member), member);
+		oa::StoreMember *args = buffer.Emplace<oa::StoreMember>(oa::STORE_MEMBER_SIZE);
+		args->args = this->args;
+		args->member = member;
 	}
 
 	void LoadField::WriteArguments(MethodBuffer &buffer, MethodBuilder &builder) const
 	{
 		oa::TwoLocalsAndValue<Field*> args = { instance, output, field };
+		buffer.AddPointer(offsetof(oa::TwoLocalsAndValue<Field*>, value), field);
 		buffer.Write(args, oa::TWO_LOCALS_AND_VALUE<Field*>::SIZE);
 	}
 
 	void StoreField::WriteArguments(MethodBuffer &buffer, MethodBuilder &builder) const
 	{
 		oa::LocalAndValue<Field*> args = { this->args, field };
+		buffer.AddPointer(offsetof(oa::LocalAndValue<Field*>, value), field);
 		buffer.Write(args, oa::LOCAL_AND_VALUE<Field*>::SIZE);
 	}
 
 	void LoadStaticField::WriteArguments(MethodBuffer &buffer, MethodBuilder &builder) const
 	{
 		oa::LocalAndValue<Field*> args = { target, field };
+		buffer.AddPointer(offsetof(oa::LocalAndValue<Field*>, value), field);
 		buffer.Write(args, oa::LOCAL_AND_VALUE<Field*>::SIZE);
 	}
 
 	void StoreStaticField::WriteArguments(MethodBuffer &buffer, MethodBuilder &builder) const
 	{
 		oa::LocalAndValue<Field*> args = { value, field };
+		buffer.AddPointer(offsetof(oa::LocalAndValue<Field*>, value), field);
 		buffer.Write(args, oa::LOCAL_AND_VALUE<Field*>::SIZE);
 	}
 
@@ -225,6 +239,7 @@ namespace instr
 		if (refSignature)
 		{
 			oa::CallRef args = { this->args, output, argCount, refSignature };
+			buffer.AddRefSignature(offsetof(oa::CallRef, refSignature), refSignature);
 			buffer.Write(args, oa::CALL_REF_SIZE);
 		}
 		else
@@ -238,19 +253,23 @@ namespace instr
 	{
 		if (refSignature)
 		{
-			oa::CallMemberRef args = {
-				this->args,
-				output,
-				argCount,
-				refSignature,
-				member,
-			};
-			buffer.Write(args, oa::CALL_MEMBER_REF_SIZE);
+			buffer.AddRefSignature(offsetof(oa::CallMemberRef, refSignature), refSignature);
+			buffer.AddPointer(offsetof(oa::CallMemberRef, member), member);
+			oa::CallMemberRef *args = buffer.Emplace<oa::CallMemberRef>(oa::CALL_MEMBER_REF_SIZE);
+			args->args = this->args;
+			args->dest = output;
+			args->argc = argCount;
+			args->refSignature = refSignature;
+			args->member = member;
 		}
 		else
 		{
-			oa::CallMember args = { this->args, output, argCount, member };
-			buffer.Write(args, oa::CALL_MEMBER_SIZE);
+			buffer.AddPointer(offsetof(oa::CallMember, member), member);
+			oa::CallMember *args = buffer.Emplace<oa::CallMember>(oa::CALL_MEMBER_SIZE);
+			args->args = this->args;
+			args->dest = output;
+			args->argc = argCount;
+			args->member = member;
 		}
 	}
 
@@ -258,6 +277,7 @@ namespace instr
 	{
 		// The scall instruction does NOT include the instance in its argCount.
 		oa::StaticCall args = { this->args, output, argCount, method };
+		buffer.AddPointer(offsetof(oa::StaticCall, method), method);
 		buffer.Write(args, oa::STATIC_CALL_SIZE);
 	}
 
@@ -270,6 +290,7 @@ namespace instr
 	void StaticApply::WriteArguments(MethodBuffer &buffer, MethodBuilder &builder) const
 	{
 		oa::TwoLocalsAndValue<Method*> args = { this->args, output, method };
+		buffer.AddPointer(offsetof(oa::TwoLocalsAndValue<Method*>, value), method);
 		buffer.Write(args, oa::TWO_LOCALS_AND_VALUE<Method*>::SIZE);
 	}
 
@@ -288,6 +309,7 @@ namespace instr
 	void BranchIfType::WriteArguments(MethodBuffer &buffer, MethodBuilder &builder) const
 	{
 		oa::BranchIfType args = { value, builder.GetJumpOffset(target.index, this), type };
+		buffer.AddPointer(offsetof(oa::BranchIfType, type), type);
 		buffer.Write(args, oa::BRANCH_IF_TYPE_SIZE);
 	}
 
@@ -349,20 +371,36 @@ namespace instr
 	void LoadMemberRef::WriteArguments(MethodBuffer &buffer, MethodBuilder &builder) const
 	{
 		oa::LocalAndValue<String*> args = { instance, member };
+		buffer.AddPointer(offsetof(oa::LocalAndValue<String*>, value), member);
 		buffer.Write(args, oa::LOCAL_AND_VALUE<String*>::SIZE);
 	}
 
 	void LoadFieldRef::WriteArguments(MethodBuffer &buffer, MethodBuilder &builder) const
 	{
 		oa::LocalAndValue<Field*> args = { instance, field };
+		buffer.AddPointer(offsetof(oa::LocalAndValue<Field*>, value), field);
 		buffer.Write(args, oa::LOCAL_AND_VALUE<Field*>::SIZE);
 	}
 
 	void LoadStaticFieldRef::WriteArguments(MethodBuffer &buffer, MethodBuilder &builder) const
 	{
 		oa::SingleValue<Field*> args = { field };
+		buffer.AddPointer(offsetof(oa::SingleValue<Field*>, value), field);
 		buffer.Write(args, oa::SINGLE_VALUE<Field*>::SIZE);
 	}
+
+	void LoadLocalField::WriteArguments(MethodBuffer &buffer, MethodBuilder &builder) const
+	{
+		oa::TwoLocalsAndValue<Field*> args = { instance, output, field };
+		buffer.AddPointer(offsetof(oa::TwoLocalsAndValue<Field*>, value), field);
+		buffer.Write(args, oa::TWO_LOCALS_AND_VALUE<Field*>::SIZE);
+	}
+
+	void OperatorConstant::WriteArguments(MethodBuffer &buffer, MethodBuilder &builder) const
+	{
+		oa::OperatorConstant args = { this->args, output, op, left, value };
+		buffer.Write(args, oa::OPERATOR_CONSTANT_SIZE);
+	}
 } // namespace instr
 
 } // namespace ovum
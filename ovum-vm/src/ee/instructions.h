@@ -693,7 +693,7 @@ namespace instr
 
 		inline virtual size_t GetArgsSize() const
 		{
-			return oa::TWO_LOCALS_AND_VALUE<String*>::SIZE;
+			return oa::LOAD_MEMBER_SIZE;
 		}
 
 		inline virtual StackChange GetStackChange() const
@@ -731,7 +731,7 @@ namespace instr
 
 		inline virtual size_t GetArgsSize() const
 		{
-			return oa::LOCAL_AND_VALUE<String*>::SIZE;
+			return oa::STORE_MEMBER_SIZE;
 		}
 
 		inline virtual StackChange GetStackChange() const { return StackChange(2, 0); }
@@ -1635,6 +1635,93 @@ namespace instr
 	protected:
 		virtual void WriteArguments(MethodBuffer &buffer, MethodBuilder &builder) const;
 	};
+
+	// Superinstructions are created by MethodInitializer::FuseInstructions(),
+	// after the inputs and outputs of every instruction have been decided, so
+	// they never need to update them.
+
+	// ldloc + ldfld
+	class LoadLocalField : public Instruction
+	{
+	public:
+		LocalOffset instance; // never on the stack
+		LocalOffset output;
+		Field *field;
+
+		inline LoadLocalField(LocalOffset instance, LocalOffset output, Field *field, bool isOnStack) :
+			Instruction(InstrFlags::NONE, isOnStack ? OPI_LDLOCFLD_S : OPI_LDLOCFLD_L),
+			instance(instance),
+			output(output),
+			field(field)
+		{ }
+
+		inline virtual size_t GetArgsSize() const
+		{
+			return oa::TWO_LOCALS_AND_VALUE<Field*>::SIZE;
+		}
+
+		inline virtual StackChange GetStackChange() const
+		{
+			return StackChange(0, opcode & 1);
+		}
+
+	protected:
+		virtual void WriteArguments(MethodBuffer &buffer, MethodBuilder &builder) const;
+	};
+
+	// ldc.i + binary operator, optionally preceded by ldloc
+	class OperatorConstant : public Instruction
+	{
+	public:
+		LocalOffset args;
+		LocalOffset output;
+		Operator op;
+		LocalOffset left; // only used if leftIsLocal
+		int64_t value;
+
+		inline OperatorConstant(
+			LocalOffset args,
+			LocalOffset output,
+			Operator op,
+			bool leftIsLocal,
+			LocalOffset left,
+			int64_t value,
+			bool isOnStack
+		) :
+			Instruction(InstrFlags::NONE, GetOpcode(leftIsLocal, isOnStack)),
+			args(args),
+			output(output),
+			op(op),
+			left(left),
+			value(value)
+		{ }
+
+		inline bool IsLeftLocal() const
+		{
+			return opcode == OPI_OPERLC_L || opcode == OPI_OPERLC_S;
+		}
+
+		inline virtual size_t GetArgsSize() const
+		{
+			return oa::OPERATOR_CONSTANT_SIZE;
+		}
+
+		inline virtual StackChange GetStackChange() const
+		{
+			return StackChange(IsLeftLocal() ? 0 : 1, opcode & 1);
+		}
+
+	protected:
+		virtual void WriteArguments(MethodBuffer &buffer, MethodBuilder &builder) const;
+
+	private:
+		inline static IntermediateOpcode GetOpcode(bool leftIsLocal, bool isOnStack)
+		{
+			if (leftIsLocal)
+				return isOnStack ? OPI_OPERLC_S : OPI_OPERLC_L;
+			return isOnStack ? OPI_OPERSC_S : OPI_OPERSC_L;
+		}
+	};
 } // namespace instr
 
 } // namespace ovum
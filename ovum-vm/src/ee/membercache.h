@@ -0,0 +1,111 @@
+#pragma once
+
+#include "../vm.h"
+#include <atomic>
+
+namespace ovum
+{
+
+// A MemberCache is an inline cache for a single dynamic member access, that
+// is, an ldmem, stmem or callmem instruction. The cache is stored in the
+// instruction's arguments, and remembers the member that was found for each
+// of the last few receiver types.
+//
+// Member lookup has to walk the receiver's base type chain, performing a hash
+// lookup and an accessibility check at each level. The result only depends on
+// the receiver type, the member name and the method that contains the access,
+// and the last two are fixed for a given instruction. Hence, the receiver type
+// alone is a sufficient cache key. Most instructions only ever see one type,
+// which is why the first entry is always checked first: a hit costs a single
+// pointer comparison. The remaining entries handle polymorphic accesses. When
+// all entries are taken, the access is megamorphic and further lookups go
+// through Type::FindMember.
+//
+// Instruction arguments are read-only to the interpreter, so the cache field
+// of an argument struct is always declared mutable.
+//
+// The same instruction can be executed by several threads at once. Entries are
+// nonetheless written without a lock: an entry is claimed by atomically
+// setting its type, after which the member is published; readers ignore
+// entries whose member has not been published yet. Entries are never
+// overwritten, so once a reader has found a member, it stays valid.
+//
+// For callmem, the entry also caches the method overload that was resolved
+// for the instruction's argument count and ref signature, if the member is a
+// method. (The argument count and ref signature are also fixed for a given
+// instruction.)
+class MemberCache
+{
+public:
+	static const size_t ENTRY_COUNT = 4;
+
+	struct Entry
+	{
+		// The receiver type. Null if the entry has not been claimed.
+		std::atomic<Type*> type;
+		// The member that was found in the type. This is null if the entry
+		// has been claimed, but the member has not yet been published.
+		std::atomic<Member*> member;
+		// The overload that was resolved from member, if it is a method.
+		// Only used by callmem.
+		std::atomic<MethodOverload*> overload;
+	};
+
+	inline MemberCache()
+	{
+		for (size_t i = 0; i < ENTRY_COUNT; i++)
+		{
+			Entry &entry = entries[i];
+			entry.type.store(nullptr, std::memory_order_relaxed);
+			entry.member.store(nullptr, std::memory_order_relaxed);
+			entry.overload.store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	// Finds the entry for the specified receiver type. If there is no such
+	// entry, or its member has not been published yet, returns null.
+	inline Entry *Find(Type *type)
+	{
+		for (size_t i = 0; i < ENTRY_COUNT; i++)
+		{
+			Entry *entry = entries + i;
+			Type *entryType = entry->type.load(std::memory_order_acquire);
+			if (entryType == type)
+			{
+				if (entry->member.load(std::memory_order_acquire) == nullptr)
+					return nullptr;
+				return entry;
+			}
+			if (entryType == nullptr)
+				// Entries are claimed in order, so there are no more.
+				break;
+		}
+		return nullptr;
+	}
+
+	// Adds an entry for the specified receiver type. Returns the new entry,
+	// or null if the cache is full or another thread has added the type.
+	inline Entry *Add(Type *type, Member *member)
+	{
+		for (size_t i = 0; i < ENTRY_COUNT; i++)
+		{
+			Entry *entry = entries + i;
+			Type *expected = nullptr;
+			if (entry->type.compare_exchange_strong(expected, type))
+			{
+				entry->member.store(member, std::memory_order_release);
+				return entry;
+			}
+			if (expected == type)
+				break;
+		}
+		return nullptr;
+	}
+
+private:
+	Entry entries[ENTRY_COUNT];
+
+	OVUM_DISABLE_COPY_AND_ASSIGN(MemberCache);
+};
+
+} // namespace ovum
@@ -2,6 +2,7 @@
 #include "thread.opcodes.h"
 #include "../object/type.h"
 #include "../ee/instructions.h"
+#include "../ee/refsignature.h"
 #include "../debug/debugsymbols.h"
 
 namespace ovum
@@ -260,9 +261,10 @@ namespace instr
 		typesToInitialize.push_back(type);
 	}
 
-	MethodBuffer::MethodBuffer(size_t size) :
+	MethodBuffer::MethodBuffer(size_t size, std::vector<PointerArgument> *pointers) :
 		current(nullptr),
-		buffer()
+		buffer(),
+		pointers(pointers)
 	{
 		buffer.reset(new uint8_t[size]);
 		current = buffer.get();
@@ -270,6 +272,14 @@ namespace instr
 
 	MethodBuffer::~MethodBuffer()
 	{ }
+
+	void MethodBuffer::AddRefSignature(size_t argOffset, uint32_t refSignature)
+	{
+		// Short signatures are the bit field itself, and mean the same thing
+		// in every process.
+		if (RefSignature::IsLong(refSignature))
+			AddPointer(argOffset, PointerArgument::LONG_REF_SIGNATURE, nullptr);
+	}
 } // namespace instr
 
 } // namespace ovum
@@ -48,6 +48,13 @@ namespace instr
 			return typesToInitialize[index];
 		}
 
+		// Moves the types whose static constructors must be run into the
+		// specified vector, which should be empty. Does not allocate memory.
+		inline void TakeTypesToInitialize(std::vector<Type*> &types)
+		{
+			types.swap(typesToInitialize);
+		}
+
 		uint32_t GetOriginalOffset(size_t index) const;
 
 		size_t GetOriginalSize(size_t index) const;
@@ -134,10 +141,36 @@ namespace instr
 		void PerformRemovalsInternal(size_t newIndices[], MethodOverload *method);
 	};
 
+	// A pointer to a type, method, field or string that an instruction has
+	// written into an initialized method body. Such pointers are only valid
+	// in the current process; the method cache replaces them with tokens.
+	struct PointerArgument
+	{
+		enum Kind : uint32_t
+		{
+			TYPE,
+			METHOD,
+			OVERLOAD,
+			FIELD,
+			STRING,
+			// Not a pointer, but a long ref signature, which is an index into
+			// the RefSignaturePool and is just as specific to the process.
+			LONG_REF_SIGNATURE,
+		};
+
+		// The offset of the pointer from the start of the method body.
+		size_t offset;
+		Kind kind;
+		const void *target;
+	};
+
 	class MethodBuffer
 	{
 	public:
-		explicit MethodBuffer(size_t size);
+		// Creates a buffer of the specified size. If pointers is not null,
+		// instructions add a PointerArgument to it for each pointer they write
+		// (see AddPointer()).
+		MethodBuffer(size_t size, std::vector<PointerArgument> *pointers);
 
 		~MethodBuffer();
 
@@ -169,6 +202,17 @@ namespace instr
 			current += size;
 		}
 
+		// Constructs a value of the specified type at the current buffer offset,
+		// and increments the buffer offset by the specified amount. This is used
+		// instead of Write() for argument types that cannot be copied.
+		template<class T>
+		inline T *Emplace(size_t size)
+		{
+			T *result = new(current) T();
+			current += size;
+			return result;
+		}
+
 		inline void AlignTo(size_t alignment)
 		{
 			uintptr_t offset = (uintptr_t)current % (uintptr_t)alignment;
@@ -176,11 +220,53 @@ namespace instr
 				current += alignment - offset;
 		}
 
+		// Records that the instruction arguments about to be written contain
+		// a pointer at the specified offset (relative to the current buffer
+		// offset). This must be called before the arguments are written.
+		inline void AddPointer(size_t argOffset, Type *type)
+		{
+			AddPointer(argOffset, PointerArgument::TYPE, type);
+		}
+		inline void AddPointer(size_t argOffset, Method *method)
+		{
+			AddPointer(argOffset, PointerArgument::METHOD, method);
+		}
+		inline void AddPointer(size_t argOffset, MethodOverload *overload)
+		{
+			AddPointer(argOffset, PointerArgument::OVERLOAD, overload);
+		}
+		inline void AddPointer(size_t argOffset, Field *field)
+		{
+			AddPointer(argOffset, PointerArgument::FIELD, field);
+		}
+		inline void AddPointer(size_t argOffset, String *string)
+		{
+			AddPointer(argOffset, PointerArgument::STRING, string);
+		}
+
+		// Records a ref signature written at the specified offset (relative to
+		// the current buffer offset). Only long ref signatures are recorded.
+		void AddRefSignature(size_t argOffset, uint32_t refSignature);
+
 	private:
 		OVUM_DISABLE_COPY_AND_ASSIGN(MethodBuffer);
 
 		uint8_t *current;
 		Box<uint8_t[]> buffer;
+		std::vector<PointerArgument> *pointers;
+
+		inline void AddPointer(size_t argOffset, PointerArgument::Kind kind, const void *target)
+		{
+			if (pointers)
+			{
+				PointerArgument ptr = {
+					(size_t)(current - buffer.get()) + argOffset,
+					kind,
+					target
+				};
+				pointers->push_back(ptr);
+			}
+		}
 	};
 } // namespace instr
 
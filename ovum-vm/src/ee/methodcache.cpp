@@ -0,0 +1,710 @@
+#include "methodcache.h"
+#include "thread.opcodes.h"
+#include "refsignature.h"
+#include "../object/type.h"
+#include "../object/field.h"
+#include "../object/method.h"
+#include "../module/module.h"
+#include "../debug/debugsymbols.h"
+#include <cstring>
+
+namespace mf = ovum::module_file;
+
+namespace ovum
+{
+
+const char MethodCache::MAGIC[4] = { 'O', 'V', 'M', 'C' };
+
+Box<MethodCache> MethodCache::New(Module *module, const PathName &directory)
+{
+	Box<MethodCache> result(new(std::nothrow) MethodCache(module, directory));
+	if (!result)
+		return nullptr;
+
+	if (!result->HashModuleFile())
+		return nullptr;
+
+	result->ReadCacheFile();
+	return std::move(result);
+}
+
+MethodCache::MethodCache(Module *module, const PathName &directory) :
+	module(module),
+	fileName(directory),
+	contentHash(0),
+	entries(),
+	entryCount(0),
+	entryIndex(),
+	tokens(),
+	hitCount(0),
+	addedCount(0)
+{
+	fileName.Join(module->GetName());
+	fileName.Append(OVUM_PATH(".ovmc"));
+}
+
+bool MethodCache::HashModuleFile()
+{
+	os::FileHandle file;
+	os::FileStatus status = os::OpenFile(
+		module->GetFileName().GetDataPointer(),
+		os::FILE_OPEN,
+		os::FILE_ACCESS_READ,
+		os::FILE_SHARE_READ,
+		&file
+	);
+	if (status != os::FILE_OK)
+		return false;
+
+	// FNV-1a offset basis
+	uint64_t hash = 14695981039346656037ull;
+
+	const size_t BUFFER_SIZE = 64 * 1024;
+	Box<uint8_t[]> buffer(new(std::nothrow) uint8_t[BUFFER_SIZE]);
+	if (!buffer)
+	{
+		os::CloseFile(&file);
+		return false;
+	}
+
+	size_t bytesRead;
+	while ((status = os::ReadFile(&file, BUFFER_SIZE, buffer.get(), &bytesRead)) == os::FILE_OK &&
+		bytesRead > 0)
+		hash = Hash(hash, buffer.get(), bytesRead);
+	os::CloseFile(&file);
+
+	if (status != os::FILE_OK && status != os::FILE_EOF)
+		return false;
+
+	// The initialized bodies also depend on the members of every module that
+	// this module refers to. Those modules were opened first, so their hashes
+	// are already known.
+	for (size_t i = 0; i < module->moduleRefs.GetLength(); i++)
+	{
+		MethodCache *refCache = module->moduleRefs[i]->GetMethodCache();
+		uint64_t refHash = refCache ? refCache->contentHash : 0;
+		hash = Hash(hash, &refHash, sizeof(uint64_t));
+	}
+
+	contentHash = hash;
+	return true;
+}
+
+void MethodCache::ReadCacheFile()
+{
+	os::FileHandle file;
+	os::FileStatus status = os::OpenFile(
+		fileName.GetDataPointer(),
+		os::FILE_OPEN,
+		os::FILE_ACCESS_READ,
+		os::FILE_SHARE_READ,
+		&file
+	);
+	if (status != os::FILE_OK)
+		// Most likely, there is no cache file yet.
+		return;
+
+	FileHeader header;
+	int64_t fileSize;
+	size_t bytesRead;
+	bool valid =
+		os::SeekFile(&file, 0, os::FILE_SEEK_END, &fileSize) == os::FILE_OK &&
+		fileSize >= (int64_t)sizeof(FileHeader) &&
+		fileSize - sizeof(FileHeader) <= UINT32_MAX &&
+		os::SeekFile(&file, 0, os::FILE_SEEK_START, nullptr) == os::FILE_OK &&
+		os::ReadFile(&file, sizeof(FileHeader), &header, &bytesRead) == os::FILE_OK &&
+		bytesRead == sizeof(FileHeader);
+
+	// If the module or any of its dependencies has changed since the cache
+	// was written, the entries are useless. They are overwritten when the
+	// cache is saved.
+	valid = valid &&
+		memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 &&
+		header.formatVersion == FORMAT_VERSION &&
+		header.vmVersion == VM_VERSION &&
+		header.instructionSetHash == GetInstructionSetHash() &&
+		header.pointerSize == sizeof(void*) &&
+		header.contentHash == contentHash;
+
+	if (valid)
+	{
+		size_t entriesSize = (size_t)fileSize - sizeof(FileHeader);
+		try
+		{
+			entries.resize(entriesSize);
+			valid = entriesSize == 0 ||
+				(os::ReadFile(&file, entriesSize, entries.data(), &bytesRead) == os::FILE_OK &&
+				bytesRead == entriesSize);
+			entryCount = header.entryCount;
+			valid = valid && IndexEntries();
+		}
+		catch (std::exception&)
+		{
+			valid = false;
+		}
+	}
+
+	if (!valid)
+	{
+		entries.clear();
+		entryIndex.clear();
+		entryCount = 0;
+	}
+
+	os::CloseFile(&file);
+}
+
+bool MethodCache::IndexEntries()
+{
+	size_t offset = 0;
+	for (uint32_t i = 0; i < entryCount; i++)
+	{
+		if (entries.size() - offset < sizeof(EntryHeader))
+			return false;
+
+		const EntryHeader *header = reinterpret_cast<const EntryHeader*>(entries.data() + offset);
+		if (header->size != GetEntrySize(header) ||
+			entries.size() - offset < header->size)
+			return false;
+
+		entryIndex[GetEntryKey(header->methodToken, header->overloadIndex)] = offset;
+		offset += header->size;
+	}
+
+	return offset == entries.size();
+}
+
+bool MethodCache::LoadMethod(
+	MethodOverload *overload,
+	instr::MethodBuilder &builder,
+	std::vector<instr::PointerArgument> *resolvedPointers
+)
+{
+	if (entryIndex.empty())
+		return false;
+
+	Method *method = overload->group;
+	Token methodToken;
+	if (!GetToken(method, methodToken))
+		return false;
+
+	uint32_t overloadIndex = (uint32_t)(overload - method->overloads);
+	auto entry = entryIndex.find(GetEntryKey(methodToken, overloadIndex));
+	if (entry == entryIndex.end())
+		return false;
+
+	const EntryHeader *header = reinterpret_cast<const EntryHeader*>(entries.data() + entry->second);
+	const uint8_t *bodyData = reinterpret_cast<const uint8_t*>(header + 1);
+	const Pointer *pointers = reinterpret_cast<const Pointer*>(
+		bodyData + OVUM_ALIGN_TO(header->bodySize, sizeof(uint32_t))
+	);
+	const uint32_t *tryOffsets = reinterpret_cast<const uint32_t*>(pointers + header->pointerCount);
+	const uint32_t *debugOffsets = tryOffsets + header->tryOffsetCount;
+
+	// The try blocks and debug symbols must have the same shape as when the
+	// method was cached. Debug symbols are loaded from a separate file, which
+	// may have appeared or disappeared since then.
+	size_t debugSymbolCount = overload->debugSymbols ? overload->debugSymbols->GetSymbolCount() : 0;
+	if (header->tryOffsetCount != GetTryOffsetCount(overload) ||
+		header->debugSymbolCount != debugSymbolCount)
+		return false;
+
+	// Resolve catch types before anything is modified, so that the overload
+	// can still be initialized normally if one of them is missing.
+	for (size_t t = 0; t < overload->tryBlockCount; t++)
+	{
+		TryBlock &tryBlock = overload->tryBlocks[t];
+		if (tryBlock.kind != TryKind::CATCH)
+			continue;
+
+		for (size_t c = 0; c < tryBlock.catches.count; c++)
+		{
+			CatchBlock &catchBlock = tryBlock.catches.blocks[c];
+			if (catchBlock.caughtType == nullptr)
+			{
+				catchBlock.caughtType = module->FindType(catchBlock.caughtTypeId);
+				if (catchBlock.caughtType == nullptr)
+					return false;
+			}
+		}
+	}
+
+	Box<uint8_t[]> body(new uint8_t[header->bodySize]);
+	CopyMemoryT(body.get(), bodyData, header->bodySize);
+
+	std::vector<Type*> staticCtorTypes;
+	for (uint32_t i = 0; i < header->pointerCount; i++)
+	{
+		const Pointer &pointer = pointers[i];
+		if (header->bodySize < sizeof(void*) ||
+			pointer.offset > header->bodySize - sizeof(void*))
+			return false;
+
+		void *target;
+		if (!ResolvePointer(pointer, target))
+			return false;
+
+		*reinterpret_cast<void**>(body.get() + pointer.offset) = target;
+
+		// Only the static field instructions refer to static fields. When the
+		// method was first initialized, their declaring types were passed to
+		// MethodBuilder::AddTypeToInitialize() for the same reason.
+		if (pointer.kind == instr::PointerArgument::FIELD)
+		{
+			Field *field = static_cast<Field*>(target);
+			if (field->IsStatic())
+				staticCtorTypes.push_back(field->declType);
+		}
+	}
+
+	// Anything that allocates memory must also be done before the overload is
+	// updated, so that the overload is left untouched if it fails.
+	if (resolvedPointers)
+	{
+		for (uint32_t i = 0; i < header->pointerCount; i++)
+		{
+			const Pointer &pointer = pointers[i];
+			instr::PointerArgument ptr = {
+				pointer.offset,
+				static_cast<instr::PointerArgument::Kind>(pointer.kind),
+				*reinterpret_cast<void**>(body.get() + pointer.offset)
+			};
+			resolvedPointers->push_back(ptr);
+		}
+	}
+
+	for (size_t i = 0; i < staticCtorTypes.size(); i++)
+		builder.AddTypeToInitialize(staticCtorTypes[i]);
+
+	// Everything has been verified; now the overload can be updated.
+
+	delete[] overload->entry;
+	overload->entry = body.release();
+	overload->length = header->bodySize;
+
+	const uint32_t *tryOffset = tryOffsets;
+	for (size_t t = 0; t < overload->tryBlockCount; t++)
+	{
+		TryBlock &tryBlock = overload->tryBlocks[t];
+		tryBlock.tryStart = *tryOffset++;
+		tryBlock.tryEnd = *tryOffset++;
+
+		switch (tryBlock.kind)
+		{
+		case TryKind::CATCH:
+			for (size_t c = 0; c < tryBlock.catches.count; c++)
+			{
+				CatchBlock &catchBlock = tryBlock.catches.blocks[c];
+				catchBlock.catchStart = *tryOffset++;
+				catchBlock.catchEnd = *tryOffset++;
+			}
+			break;
+		case TryKind::FINALLY:
+		case TryKind::FAULT: // uses finallyBlock
+			tryBlock.finallyBlock.finallyStart = *tryOffset++;
+			tryBlock.finallyBlock.finallyEnd = *tryOffset++;
+			break;
+		}
+	}
+
+	for (size_t i = 0; i < debugSymbolCount; i++)
+	{
+		debug::DebugSymbol &sym = overload->debugSymbols->GetSymbol(i);
+		sym.startOffset = debugOffsets[2 * i];
+		sym.endOffset = debugOffsets[2 * i + 1];
+	}
+
+	hitCount++;
+	return true;
+}
+
+void MethodCache::AddMethod(
+	MethodOverload *overload,
+	const std::vector<instr::PointerArgument> &pointers
+)
+{
+	Method *method = overload->group;
+	Token methodToken;
+	if (!GetToken(method, methodToken))
+		return;
+
+	uint32_t overloadIndex = (uint32_t)(overload - method->overloads);
+	uint64_t key = GetEntryKey(methodToken, overloadIndex);
+	if (entryIndex.find(key) != entryIndex.end())
+		return;
+
+	EntryHeader header;
+	header.methodToken = methodToken;
+	header.overloadIndex = overloadIndex;
+	header.bodySize = (uint32_t)overload->length;
+	header.pointerCount = (uint32_t)pointers.size();
+	header.tryOffsetCount = (uint32_t)GetTryOffsetCount(overload);
+	header.debugSymbolCount = overload->debugSymbols
+		? (uint32_t)overload->debugSymbols->GetSymbolCount()
+		: 0;
+	header.size = (uint32_t)GetEntrySize(&header);
+
+	// Convert the pointers to tokens first, since the method cannot be cached
+	// if any of them fails.
+	std::vector<Pointer> cachedPointers;
+	try
+	{
+		cachedPointers.resize(pointers.size());
+	}
+	catch (std::bad_alloc&)
+	{
+		return;
+	}
+	for (size_t i = 0; i < pointers.size(); i++)
+	{
+		const instr::PointerArgument &ptr = pointers[i];
+		Pointer &cached = cachedPointers[i];
+		cached.offset = (uint32_t)ptr.offset;
+		cached.kind = ptr.kind;
+		cached.overloadIndex = 0;
+
+		switch (ptr.kind)
+		{
+		case instr::PointerArgument::OVERLOAD:
+			{
+				const MethodOverload *target = static_cast<const MethodOverload*>(ptr.target);
+				if (!GetToken(target->group, cached.token))
+					return;
+				cached.overloadIndex = (uint32_t)(target - target->group->overloads);
+			}
+			break;
+		case instr::PointerArgument::LONG_REF_SIGNATURE:
+			// The signature's index is only valid in this process.
+			return;
+		default:
+			if (!GetToken(ptr.target, cached.token))
+				return;
+			break;
+		}
+	}
+
+	// The overload has already been updated, so running out of memory here
+	// must not stop it from being used. It is simply left out of the cache.
+	size_t offset = entries.size();
+	try
+	{
+		entries.resize(offset + header.size);
+		entryIndex[key] = offset;
+	}
+	catch (std::bad_alloc&)
+	{
+		entries.resize(offset);
+		return;
+	}
+	uint8_t *output = entries.data() + offset;
+
+	CopyMemoryT(output, reinterpret_cast<const uint8_t*>(&header), sizeof(EntryHeader));
+	output += sizeof(EntryHeader);
+
+	CopyMemoryT(output, overload->entry, overload->length);
+	output += OVUM_ALIGN_TO(overload->length, sizeof(uint32_t));
+
+	if (!cachedPointers.empty())
+		CopyMemoryT(output, reinterpret_cast<const uint8_t*>(cachedPointers.data()), cachedPointers.size() * sizeof(Pointer));
+	output += cachedPointers.size() * sizeof(Pointer);
+
+	uint32_t *offsets = reinterpret_cast<uint32_t*>(output);
+	for (size_t t = 0; t < overload->tryBlockCount; t++)
+	{
+		TryBlock &tryBlock = overload->tryBlocks[t];
+		*offsets++ = (uint32_t)tryBlock.tryStart;
+		*offsets++ = (uint32_t)tryBlock.tryEnd;
+
+		switch (tryBlock.kind)
+		{
+		case TryKind::CATCH:
+			for (size_t c = 0; c < tryBlock.catches.count; c++)
+			{
+				CatchBlock &catchBlock = tryBlock.catches.blocks[c];
+				*offsets++ = (uint32_t)catchBlock.catchStart;
+				*offsets++ = (uint32_t)catchBlock.catchEnd;
+			}
+			break;
+		case TryKind::FINALLY:
+		case TryKind::FAULT: // uses finallyBlock
+			*offsets++ = (uint32_t)tryBlock.finallyBlock.finallyStart;
+			*offsets++ = (uint32_t)tryBlock.finallyBlock.finallyEnd;
+			break;
+		}
+	}
+
+	for (uint32_t i = 0; i < header.debugSymbolCount; i++)
+	{
+		debug::DebugSymbol &sym = overload->debugSymbols->GetSymbol(i);
+		*offsets++ = sym.startOffset;
+		*offsets++ = sym.endOffset;
+	}
+
+	entryCount++;
+	addedCount++;
+}
+
+bool MethodCache::Save()
+{
+	if (addedCount == 0)
+		return true;
+
+	os::FileHandle file;
+	os::FileStatus status = os::OpenFile(
+		fileName.GetDataPointer(),
+		os::FILE_CREATE,
+		os::FILE_ACCESS_WRITE,
+		os::FILE_SHARE_NONE,
+		&file
+	);
+	if (status != os::FILE_OK)
+		return false;
+
+	FileHeader header;
+	CopyMemoryT(header.magic, MAGIC, sizeof(MAGIC));
+	header.formatVersion = FORMAT_VERSION;
+	header.vmVersion = VM_VERSION;
+	header.instructionSetHash = GetInstructionSetHash();
+	header.pointerSize = sizeof(void*);
+	header.entryCount = entryCount;
+	header.contentHash = contentHash;
+
+	size_t bytesWritten;
+	bool success =
+		os::WriteFile(&file, sizeof(FileHeader), &header, &bytesWritten) == os::FILE_OK &&
+		os::WriteFile(&file, entries.size(), entries.data(), &bytesWritten) == os::FILE_OK;
+
+	os::CloseFile(&file);
+	return success;
+}
+
+void MethodCache::InitTokens()
+{
+	AddTokens(module->types, mf::TOKEN_TYPEDEF);
+	AddTokens(module->typeRefs, mf::TOKEN_TYPEREF);
+	AddTokens(module->methods, mf::TOKEN_METHODDEF);
+	AddTokens(module->methodRefs, mf::TOKEN_METHODREF);
+	AddTokens(module->functions, mf::TOKEN_FUNCTIONDEF);
+	AddTokens(module->functionRefs, mf::TOKEN_FUNCTIONREF);
+	AddTokens(module->fields, mf::TOKEN_FIELDDEF);
+	AddTokens(module->fieldRefs, mf::TOKEN_FIELDREF);
+	AddTokens(module->strings, mf::TOKEN_STRING);
+}
+
+template<class T>
+void MethodCache::AddTokens(const MemberTable<T> &table, Token tokenKind)
+{
+	for (size_t i = 0; i < table.GetLength(); i++)
+	{
+		void *item = GetAddress(table[i]);
+		// Strings are interned, so the same string may occur more than once.
+		// Any of its tokens will do.
+		if (item != nullptr)
+			tokens.insert(std::make_pair(item, tokenKind | (Token)(i + 1)));
+	}
+}
+
+bool MethodCache::GetToken(const void *target, Token &result)
+{
+	if (tokens.empty())
+		InitTokens();
+
+	auto token = tokens.find(target);
+	if (token == tokens.end())
+		return false;
+
+	result = token->second;
+	return true;
+}
+
+void *MethodCache::FindMember(Token token) const
+{
+	switch (token & mf::TOKEN_KIND_MASK)
+	{
+	case mf::TOKEN_TYPEDEF:     return FindMember(module->types, token);
+	case mf::TOKEN_TYPEREF:     return FindMember(module->typeRefs, token);
+	case mf::TOKEN_METHODDEF:   return FindMember(module->methods, token);
+	case mf::TOKEN_METHODREF:   return FindMember(module->methodRefs, token);
+	case mf::TOKEN_FUNCTIONDEF: return FindMember(module->functions, token);
+	case mf::TOKEN_FUNCTIONREF: return FindMember(module->functionRefs, token);
+	case mf::TOKEN_FIELDDEF:    return FindMember(module->fields, token);
+	case mf::TOKEN_FIELDREF:    return FindMember(module->fieldRefs, token);
+	case mf::TOKEN_STRING:      return FindMember(module->strings, token);
+	default:                    return nullptr;
+	}
+}
+
+template<class T>
+void *MethodCache::FindMember(const MemberTable<T> &table, Token token)
+{
+	size_t index = (size_t)(token & mf::TOKEN_INDEX_MASK);
+	if (index == 0 || index > table.GetLength())
+		return nullptr;
+	return GetAddress(table[index - 1]);
+}
+
+bool MethodCache::ResolvePointer(const Pointer &pointer, void *&result) const
+{
+	Token kind = pointer.token & mf::TOKEN_KIND_MASK;
+	bool kindMatches;
+	switch (pointer.kind)
+	{
+	case instr::PointerArgument::TYPE:
+		kindMatches = kind == mf::TOKEN_TYPEDEF || kind == mf::TOKEN_TYPEREF;
+		break;
+	case instr::PointerArgument::METHOD:
+	case instr::PointerArgument::OVERLOAD:
+		kindMatches =
+			kind == mf::TOKEN_METHODDEF || kind == mf::TOKEN_METHODREF ||
+			kind == mf::TOKEN_FUNCTIONDEF || kind == mf::TOKEN_FUNCTIONREF;
+		break;
+	case instr::PointerArgument::FIELD:
+		kindMatches = kind == mf::TOKEN_FIELDDEF || kind == mf::TOKEN_FIELDREF;
+		break;
+	case instr::PointerArgument::STRING:
+		kindMatches = kind == mf::TOKEN_STRING;
+		break;
+	default:
+		kindMatches = false;
+		break;
+	}
+	if (!kindMatches)
+		return false;
+
+	result = FindMember(pointer.token);
+	if (result == nullptr)
+		return false;
+
+	if (pointer.kind == instr::PointerArgument::OVERLOAD)
+	{
+		Method *method = static_cast<Method*>(result);
+		if (pointer.overloadIndex >= method->overloadCount)
+			return false;
+		result = method->overloads + pointer.overloadIndex;
+	}
+
+	return true;
+}
+
+size_t MethodCache::GetTryOffsetCount(MethodOverload *overload)
+{
+	size_t count = 0;
+	for (size_t t = 0; t < overload->tryBlockCount; t++)
+	{
+		TryBlock &tryBlock = overload->tryBlocks[t];
+		count += 4; // tryStart, tryEnd, and a pair of handler offsets
+		if (tryBlock.kind == TryKind::CATCH)
+			count += 2 * (tryBlock.catches.count - 1);
+	}
+	return count;
+}
+
+size_t MethodCache::GetEntrySize(const EntryHeader *header)
+{
+	return sizeof(EntryHeader) +
+		OVUM_ALIGN_TO((size_t)header->bodySize, sizeof(uint32_t)) +
+		header->pointerCount * sizeof(Pointer) +
+		(header->tryOffsetCount + 2 * (size_t)header->debugSymbolCount) * sizeof(uint32_t);
+}
+
+uint64_t MethodCache::Hash(uint64_t hash, const void *data, size_t size)
+{
+	// FNV-1a
+	const uint8_t *bytes = reinterpret_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	return hash;
+}
+
+uint32_t MethodCache::GetInstructionSetHash()
+{
+	namespace oa = ovum::opcode_args;
+
+	// Every intermediate opcode, in declaration order. A new opcode must be
+	// added here too, or caches written before it was added are still read.
+	static const IntermediateOpcode opcodes[] = {
+		OPI_RET, OPI_RETNULL, OPI_NOP, OPI_POP, OPI_MVLOC_LL, OPI_MVLOC_SL,
+		OPI_MVLOC_LS, OPI_MVLOC_SS, OPI_LDNULL_L, OPI_LDNULL_S, OPI_LDFALSE_L,
+		OPI_LDFALSE_S, OPI_LDTRUE_L, OPI_LDTRUE_S, OPI_LDC_I_L, OPI_LDC_I_S,
+		OPI_LDC_U_L, OPI_LDC_U_S, OPI_LDC_R_L, OPI_LDC_R_S, OPI_LDSTR_L,
+		OPI_LDSTR_S, OPI_LDARGC_L, OPI_LDARGC_S, OPI_LDENUM_L, OPI_LDENUM_S,
+		OPI_NEWOBJ_L, OPI_NEWOBJ_S, OPI_LIST_L, OPI_LIST_S, OPI_HASH_L,
+		OPI_HASH_S, OPI_LDFLD_L, OPI_LDFLD_S, OPI_LDSFLD_L, OPI_LDSFLD_S,
+		OPI_LDMEM_L, OPI_LDMEM_S, OPI_LDITER_L, OPI_LDITER_S, OPI_LDTYPE_L,
+		OPI_LDTYPE_S, OPI_LDIDX_L, OPI_LDIDX_S, OPI_LDSFN_L, OPI_LDSFN_S,
+		OPI_LDTYPETKN_L, OPI_LDTYPETKN_S, OPI_CALL_L, OPI_CALL_S, OPI_SCALL_L,
+		OPI_SCALL_S, OPI_APPLY_L, OPI_APPLY_S, OPI_SAPPLY_L, OPI_SAPPLY_S,
+		OPI_BR, OPI_LEAVE, OPI_BRNULL_L, OPI_BRNULL_S, OPI_BRINST_L,
+		OPI_BRINST_S, OPI_BRFALSE_L, OPI_BRFALSE_S, OPI_BRTRUE_L, OPI_BRTRUE_S,
+		OPI_BRTYPE_L, OPI_BRTYPE_S, OPI_SWITCH_L, OPI_SWITCH_S, OPI_BRREF,
+		OPI_BRNREF, OPI_OPERATOR_L, OPI_OPERATOR_S, OPI_EQ_L, OPI_EQ_S,
+		OPI_CMP_L, OPI_CMP_S, OPI_LT_L, OPI_LT_S, OPI_GT_L, OPI_GT_S, OPI_LTE_L,
+		OPI_LTE_S, OPI_GTE_L, OPI_GTE_S, OPI_CONCAT_L, OPI_CONCAT_S,
+		OPI_CALLMEM_L, OPI_CALLMEM_S, OPI_STSFLD_L, OPI_STSFLD_S, OPI_STFLD,
+		OPI_STMEM, OPI_STIDX, OPI_THROW, OPI_RETHROW, OPI_ENDFINALLY,
+		OPI_LDFLDFAST_L, OPI_LDFLDFAST_S, OPI_STFLDFAST, OPI_BREQ, OPI_BRNEQ,
+		OPI_BRLT, OPI_BRGT, OPI_BRLTE, OPI_BRGTE, OPI_BRNLT, OPI_BRNGT,
+		OPI_BRNLTE, OPI_BRNGTE, OPI_LDLOCREF, OPI_LDMEMREF_L, OPI_LDMEMREF_S,
+		OPI_LDFLDREF_L, OPI_LDFLDREF_S, OPI_LDSFLDREF, OPI_MVLOC_RL,
+		OPI_MVLOC_RS, OPI_MVLOC_LR, OPI_MVLOC_SR, OPI_CALLR_L, OPI_CALLR_S,
+		OPI_CALLMEMR_L, OPI_CALLMEMR_S, OPI_LDLOCFLD_L, OPI_LDLOCFLD_S,
+		OPI_OPERSC_L, OPI_OPERSC_S, OPI_OPERLC_L, OPI_OPERLC_S, OPI_UNARYOP_L,
+		OPI_UNARYOP_S
+	};
+
+	// The sizes of the opcode and of every kind of instruction argument.
+	const size_t argumentSizes[] = {
+		oa::ALIGNMENT,
+		OVUM_ALIGN_TO(sizeof(IntermediateOpcode), oa::ALIGNMENT),
+		oa::ONE_LOCAL_SIZE,
+		oa::TWO_LOCALS_SIZE,
+		oa::LOCAL_AND_VALUE<int32_t>::SIZE,
+		oa::LOCAL_AND_VALUE<uint32_t>::SIZE,
+		oa::LOCAL_AND_VALUE<int64_t>::SIZE,
+		oa::LOCAL_AND_VALUE<uint64_t>::SIZE,
+		oa::LOCAL_AND_VALUE<double>::SIZE,
+		oa::LOCAL_AND_VALUE<size_t>::SIZE,
+		oa::LOCAL_AND_VALUE<ovlocals_t>::SIZE,
+		oa::LOCAL_AND_VALUE<String*>::SIZE,
+		oa::LOCAL_AND_VALUE<Type*>::SIZE,
+		oa::LOCAL_AND_VALUE<Field*>::SIZE,
+		oa::LOCAL_AND_VALUE<Method*>::SIZE,
+		oa::TWO_LOCALS_AND_VALUE<uint32_t>::SIZE,
+		oa::TWO_LOCALS_AND_VALUE<ovlocals_t>::SIZE,
+		oa::TWO_LOCALS_AND_VALUE<Field*>::SIZE,
+		oa::TWO_LOCALS_AND_VALUE<Method*>::SIZE,
+		oa::TWO_LOCALS_AND_VALUE<Operator>::SIZE,
+		oa::SINGLE_VALUE<Field*>::SIZE,
+		oa::LOAD_MEMBER_SIZE,
+		oa::STORE_MEMBER_SIZE,
+		oa::LOAD_ENUM_SIZE,
+		oa::NEW_OBJECT_SIZE,
+		oa::CALL_SIZE,
+		oa::STATIC_CALL_SIZE,
+		oa::CALL_MEMBER_SIZE,
+		oa::CALL_REF_SIZE,
+		oa::CALL_MEMBER_REF_SIZE,
+		oa::OPERATOR_CONSTANT_SIZE,
+		oa::BRANCH_SIZE,
+		oa::CONDITIONAL_BRANCH_SIZE,
+		oa::BRANCH_IF_TYPE_SIZE,
+		oa::SWITCH_SIZE(1)
+	};
+
+	// FNV-1a offset basis
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < sizeof(opcodes) / sizeof(opcodes[0]); i++)
+	{
+		uint32_t opcode = (uint32_t)opcodes[i];
+		hash = Hash(hash, &opcode, sizeof(uint32_t));
+	}
+	for (size_t i = 0; i < sizeof(argumentSizes) / sizeof(argumentSizes[0]); i++)
+	{
+		uint32_t size = (uint32_t)argumentSizes[i];
+		hash = Hash(hash, &size, sizeof(uint32_t));
+	}
+
+	return (uint32_t)(hash ^ (hash >> 32));
+}
+
+} // namespace ovum
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "../vm.h"
+#include "methodbuilder.h"
+#include "../module/modulefile.h"
+#include "../module/membertable.h"
+#include "../util/pathname.h"
+#include <unordered_map>
+#include <vector>
+
+namespace ovum
+{
+
+// The method cache stores the initialized bodies of a module's methods on disk,
+// so that later runs of the same program can skip method initialization. Each
+// module has its own cache file, which is named after the module and stored in
+// the directory given by VMStartParams::methodCacheDirectory.
+//
+// An initialized method body contains pointers to types, methods, fields and
+// strings, which are at different addresses in each run. When a body is added
+// to the cache, each such pointer is replaced by the token that refers to the
+// same member in the module (see MethodBuffer::AddPointer()). When the body is
+// loaded, the tokens are resolved again. Inline caches in the body are empty,
+// because the body is copied before it runs.
+//
+// A cache file is only used if the module file, and every module it depends on,
+// is byte for byte the same as when the cache was written. This is verified by
+// a hash of the module file, combined with the hashes of its dependencies. The
+// cache must also have been written by a VM with the same version and the same
+// instruction set, since bodies contain opcodes and instruction arguments as
+// they are laid out in memory (see GetInstructionSetHash()).
+//
+// Methods are added to the cache as they are initialized, and the cache file is
+// written by Save() when the program ends.
+class MethodCache
+{
+public:
+	// Creates a method cache for a module that has just been loaded, and reads
+	// the module's cache file if it exists and is up to date. Returns null if
+	// there is not enough memory, or if the module file could not be read.
+	//   module:
+	//     The module whose methods are cached. All of its module references
+	//     must be resolved already.
+	//   directory:
+	//     The directory that contains cache files.
+	OVUM_NOINLINE static Box<MethodCache> New(Module *module, const PathName &directory);
+
+	// Gets a hash of the contents of the module file and all of its
+	// dependencies.
+	inline uint64_t GetContentHash() const
+	{
+		return contentHash;
+	}
+
+	// Gets the number of methods that have been initialized from the cache.
+	inline size_t GetHitCount() const
+	{
+		return hitCount;
+	}
+
+	// Gets the number of methods that have been added to the cache.
+	inline size_t GetAddedCount() const
+	{
+		return addedCount;
+	}
+
+	// Initializes a method overload from the cache, if it is there. On success,
+	// the overload's body, try blocks and debug symbols are updated just as if
+	// MethodInitializer had initialized it, and the declaring types of static
+	// fields that the method uses are added to the builder, so that their
+	// static constructors can be run. As with MethodInitializer::InitializeBody(),
+	// the overload is not marked as initialized.
+	//
+	// If resolvedPointers is not null, it receives the pointers in the body.
+	//
+	// Returns true if the overload was initialized. If this returns false or
+	// throws std::bad_alloc, the overload has not been modified.
+	bool LoadMethod(
+		MethodOverload *overload,
+		instr::MethodBuilder &builder,
+		std::vector<instr::PointerArgument> *resolvedPointers
+	);
+
+	// Adds an overload to the cache. This must be called right after the
+	// overload is initialized, before it runs. If the body cannot be cached,
+	// or there is not enough memory to add it, nothing happens.
+	//   overload:
+	//     The newly initialized overload.
+	//   pointers:
+	//     The pointers that were written into the overload's body.
+	void AddMethod(
+		MethodOverload *overload,
+		const std::vector<instr::PointerArgument> &pointers
+	);
+
+	// Writes the cache file, if any methods have been added to the cache.
+	// Returns true on success.
+	bool Save();
+
+private:
+	// Each cache file begins with this header, followed by entryCount entries.
+	struct FileHeader
+	{
+		char magic[4];
+		uint32_t formatVersion;
+		// VM_VERSION and GetInstructionSetHash() of the VM that wrote the
+		// cache.
+		uint32_t vmVersion;
+		uint32_t instructionSetHash;
+		// sizeof(void*), since bodies are not portable between 32-bit and
+		// 64-bit builds of the VM.
+		uint32_t pointerSize;
+		uint32_t entryCount;
+		uint64_t contentHash;
+	};
+
+	// Each entry begins with this header, followed by, in order:
+	//   * The method body, padded to a multiple of 4 bytes;
+	//   * pointerCount Pointers;
+	//   * tryOffsetCount try block offsets (uint32_t), in the order that
+	//     MethodInitializer::FinalizeTryBlockOffsets() updates them; and
+	//   * debugSymbolCount pairs of debug symbol offsets (uint32_t).
+	struct EntryHeader
+	{
+		// The total size of the entry, in bytes, including this header.
+		uint32_t size;
+		Token methodToken;
+		uint32_t overloadIndex;
+		uint32_t bodySize;
+		uint32_t pointerCount;
+		uint32_t tryOffsetCount;
+		uint32_t debugSymbolCount;
+	};
+
+	struct Pointer
+	{
+		uint32_t offset;
+		uint32_t kind; // instr::PointerArgument::Kind
+		Token token;
+		// For PointerArgument::OVERLOAD, the index of the overload within its
+		// method; otherwise, zero.
+		uint32_t overloadIndex;
+	};
+
+	static const char MAGIC[4];
+	// Increment this whenever the format of initialized method bodies changes.
+	static const uint32_t FORMAT_VERSION = 2;
+
+	Module *module;
+	PathName fileName;
+	uint64_t contentHash;
+
+	// The entries of the cache file, followed by entries that have been added
+	// since the file was read.
+	std::vector<uint8_t> entries;
+	uint32_t entryCount;
+
+	// Maps method token and overload index to the offset of the entry within
+	// entries.
+	std::unordered_map<uint64_t, size_t> entryIndex;
+
+	// Maps members and strings in the module's tables to their tokens. This
+	// is populated the first time it is needed.
+	std::unordered_map<const void*, Token> tokens;
+
+	size_t hitCount;
+	size_t addedCount;
+
+	MethodCache(Module *module, const PathName &directory);
+
+	bool HashModuleFile();
+
+	void ReadCacheFile();
+
+	bool IndexEntries();
+
+	void InitTokens();
+
+	bool GetToken(const void *target, Token &result);
+
+	template<class T>
+	void AddTokens(const MemberTable<T> &table, Token tokenKind);
+
+	void *FindMember(Token token) const;
+
+	template<class T>
+	static void *FindMember(const MemberTable<T> &table, Token token);
+
+	bool ResolvePointer(const Pointer &pointer, void *&result) const;
+
+	template<class T>
+	static inline void *GetAddress(const Box<T> &item)
+	{
+		return item.get();
+	}
+
+	template<class T>
+	static inline void *GetAddress(T *item)
+	{
+		return item;
+	}
+
+	static size_t GetTryOffsetCount(MethodOverload *overload);
+
+	static size_t GetEntrySize(const EntryHeader *header);
+
+	static uint64_t Hash(uint64_t hash, const void *data, size_t size);
+
+	// Computes a hash of the values of the intermediate opcodes and the sizes
+	// of their arguments. Bodies written by a VM whose instruction set hashes
+	// differently cannot be read.
+	static uint32_t GetInstructionSetHash();
+
+	static inline uint64_t GetEntryKey(Token methodToken, uint32_t overloadIndex)
+	{
+		return (uint64_t)methodToken << 32 | overloadIndex;
+	}
+
+	OVUM_DISABLE_COPY_AND_ASSIGN(MethodCache);
+};
+
+} // namespace ovum
@@ -3,6 +3,7 @@
 #include "methodbuilder.h"
 #include "methodparser.h"
 #include "methodinitexception.h"
+#include "methodcache.h"
 #include "refsignature.h"
 #include "../object/type.h"
 #include "../object/field.h"
@@ -272,46 +273,83 @@ public:
 
 int MethodInitializer::Initialize(MethodOverload *method, Thread *const thread)
 {
-	using namespace instr;
+	instr::MethodBuilder builder;
+	InitializeBody(method, builder, nullptr);
+	method->SetInitialized();
 
-	OVUM_ASSERT(!method->IsInitialized());
-	this->method = method;
+	int r = OVUM_SUCCESS;
+	if (builder.GetTypeCount() > 0)
+		r = thread->CallStaticConstructors(builder);
+	return r;
+}
 
-	MethodBuilder builder;
+void MethodInitializer::InitializeBody(
+	MethodOverload *method,
+	instr::MethodBuilder &builder,
+	std::vector<instr::PointerArgument> *pointers
+)
+{
 	try
 	{
-		// First, initialize all the instructions based on the original bytecode
-		ReadInstructions(builder);
-
-		// And now, we assign each instruction input and output offsets,
-		// as appropriate. This step may also rewrite the method somewhat,
-		// removing instructions for optimisation purposes and changing
-		// some LocalOffsets from stack offsets to locals.
-		if (method->maxStack <= SmallStackManager::MaxStack)
-		{
-			SmallStackManager stack(vm->GetRefSignaturePool());
-			CalculateStackHeights(builder, stack);
-		}
-		else
-		{
-			LargeStackManager stack(method->maxStack, vm->GetRefSignaturePool());
-			CalculateStackHeights(builder, stack);
-		}
-
-		WriteInitializedBody(builder);
-		FinalizeTryBlockOffsets(builder);
-		FinalizeDebugSymbolOffsets(builder);
+		InitializeBodyOrThrow(method, builder, pointers);
 	}
 	catch (MethodInitException &e)
 	{
 		vm->PrintMethodInitException(e);
 		abort();
 	}
+}
 
-	int r = OVUM_SUCCESS;
-	if (builder.GetTypeCount() > 0)
-		r = thread->CallStaticConstructors(builder);
-	return r;
+void MethodInitializer::InitializeBodyOrThrow(
+	MethodOverload *method,
+	instr::MethodBuilder &builder,
+	std::vector<instr::PointerArgument> *pointers
+)
+{
+	using namespace instr;
+
+	OVUM_ASSERT(!method->IsInitialized());
+	this->method = method;
+
+	// If the method was initialized in an earlier run of the program, its
+	// body may be in the method cache.
+	MethodCache *cache = method->group->declModule->GetMethodCache();
+	if (cache && cache->LoadMethod(method, builder, pointers))
+		return;
+
+	// The method cache needs the pointers even if the caller does not.
+	std::vector<PointerArgument> cachePointers;
+	if (cache && !pointers)
+		pointers = &cachePointers;
+
+	// First, initialize all the instructions based on the original bytecode
+	ReadInstructions(builder);
+
+	// And now, we assign each instruction input and output offsets,
+	// as appropriate. This step may also rewrite the method somewhat,
+	// removing instructions for optimisation purposes and changing
+	// some LocalOffsets from stack offsets to locals.
+	if (method->maxStack <= SmallStackManager::MaxStack)
+	{
+		SmallStackManager stack(vm->GetRefSignaturePool());
+		CalculateStackHeights(builder, stack);
+	}
+	else
+	{
+		LargeStackManager stack(method->maxStack, vm->GetRefSignaturePool());
+		CalculateStackHeights(builder, stack);
+	}
+
+	// Now that every instruction knows where its inputs and outputs are,
+	// common sequences of instructions can be replaced by superinstructions.
+	FuseInstructions(builder);
+
+	WriteInitializedBody(builder, pointers);
+	FinalizeTryBlockOffsets(builder);
+	FinalizeDebugSymbolOffsets(builder);
+
+	if (cache)
+		cache->AddMethod(method, *pointers);
 }
 
 /*** Step 1: Reading the instructions ***/
@@ -685,14 +723,230 @@ IntermediateOpcode MethodInitializer::GetBranchComparisonOpcode(
 	return result;
 }
 
-/*** Step 3: Result writing & finalization ***/
+/*** Step 3: Superinstructions ***/
+
+// Superinstructions save the interpreter a dispatch for each instruction that
+// they replace, and often a round trip through the evaluation stack. The
+// sequences below were picked because they are among the most common pairs and
+// triples of instructions in typical Osprey code: field access on a local
+// (usually 'this'), and arithmetic with a small constant, such as i + 1.
+const MethodInitializer::FusionRule MethodInitializer::fusionRules[] = {
+	{ 3, FuseLocalOperatorConstant },
+	{ 2, FuseLoadLocalField },
+	{ 2, FuseOperatorConstant },
+};
+
+const size_t MethodInitializer::fusionRuleCount =
+	sizeof(MethodInitializer::fusionRules) / sizeof(MethodInitializer::fusionRules[0]);
+
+void MethodInitializer::FuseInstructions(instr::MethodBuilder &builder)
+{
+	using namespace instr;
+
+	std::vector<bool> barriers;
+	FindFusionBarriers(builder, barriers);
+
+	bool anyFused = false;
+	size_t length = builder.GetLength();
+	for (size_t i = 0; i < length; i++)
+	{
+		for (size_t r = 0; r < fusionRuleCount; r++)
+		{
+			const FusionRule &rule = fusionRules[r];
+			if (i + rule.length > length)
+				continue;
+
+			// The first instruction may be a branch target (and so on), since
+			// the superinstruction takes its place. The others must not be.
+			Instruction *instrs[MAX_FUSION_LENGTH];
+			bool canFuse = true;
+			for (size_t k = 0; k < rule.length; k++)
+			{
+				if (k > 0 && barriers[i + k])
+				{
+					canFuse = false;
+					break;
+				}
+				instrs[k] = builder[i + k];
+			}
+			if (!canFuse)
+				continue;
+
+			Box<Instruction> superinstr = rule.fuse(instrs);
+			if (superinstr)
+			{
+				// This also deletes the first of the old instructions.
+				builder.SetInstruction(i, std::move(superinstr));
+				for (size_t k = 1; k < rule.length; k++)
+					builder.MarkForRemoval(i + k);
+				i += rule.length - 1;
+				anyFused = true;
+				break;
+			}
+		}
+	}
+
+	if (anyFused)
+		builder.PerformRemovals(method);
+}
+
+void MethodInitializer::FindFusionBarriers(instr::MethodBuilder &builder, std::vector<bool> &barriers)
+{
+	using namespace instr;
+
+	// The HAS_INCOMING_BRANCHES flag cannot be relied upon here: when an
+	// instruction with incoming branches is removed, its branches go to the
+	// next instruction instead, which does not get the flag.
+	barriers.assign(builder.GetLength() + 1, false);
+
+	for (size_t i = 0; i < builder.GetLength(); i++)
+	{
+		Instruction *instr = builder[i];
+		if (instr->IsBranch())
+		{
+			barriers[static_cast<Branch*>(instr)->target.index] = true;
+		}
+		else if (instr->IsSwitch())
+		{
+			Switch *sw = static_cast<Switch*>(instr);
+			for (size_t t = 0; t < sw->targetCount; t++)
+				barriers[sw->targets[t].index] = true;
+		}
+	}
+
+	// A superinstruction must not straddle the boundary of a protected region,
+	// or an error thrown by the second half would be handled by the wrong block.
+	for (size_t t = 0; t < method->tryBlockCount; t++)
+	{
+		TryBlock &tryBlock = method->tryBlocks[t];
+		barriers[tryBlock.tryStart] = true;
+		barriers[tryBlock.tryEnd] = true;
 
-void MethodInitializer::WriteInitializedBody(instr::MethodBuilder &builder)
+		switch (tryBlock.kind)
+		{
+		case TryKind::CATCH:
+			for (size_t c = 0; c < tryBlock.catches.count; c++)
+			{
+				CatchBlock &catchBlock = tryBlock.catches.blocks[c];
+				barriers[catchBlock.catchStart] = true;
+				barriers[catchBlock.catchEnd] = true;
+			}
+			break;
+		case TryKind::FINALLY:
+		case TryKind::FAULT: // uses finallyBlock
+			barriers[tryBlock.finallyBlock.finallyStart] = true;
+			barriers[tryBlock.finallyBlock.finallyEnd] = true;
+			break;
+		}
+	}
+
+	// Nor the boundary of a debug symbol, so that stack traces still point at
+	// the right line of source code.
+	if (method->debugSymbols)
+	{
+		debug::OverloadSymbols *debug = method->debugSymbols;
+		size_t debugSymbolCount = debug->GetSymbolCount();
+		for (size_t i = 0; i < debugSymbolCount; i++)
+		{
+			debug::DebugSymbol &sym = debug->GetSymbol(i);
+			barriers[sym.startOffset] = true;
+			barriers[sym.endOffset] = true;
+		}
+	}
+}
+
+Box<instr::Instruction> MethodInitializer::FuseLoadLocalField(instr::Instruction *const instrs[])
+{
+	using namespace instr;
+
+	// ldloc  x       =>  ldlocfld x, f
+	// ldfld  f
+	if (instrs[0]->opcode != OPI_MVLOC_LS || !instrs[0]->IsLoadLocal())
+		return nullptr;
+	if (instrs[1]->opcode != OPI_LDFLD_L && instrs[1]->opcode != OPI_LDFLD_S)
+		return nullptr;
+
+	LoadLocal *ldloc = static_cast<LoadLocal*>(instrs[0]);
+	LoadField *ldfld = static_cast<LoadField*>(instrs[1]);
+	if (ldfld->instance.GetOffset() != ldloc->target.GetOffset())
+		return nullptr;
+
+	return Box<Instruction>(new LoadLocalField(
+		ldloc->source,
+		ldfld->output,
+		ldfld->field,
+		ldfld->opcode == OPI_LDFLD_S
+	));
+}
+
+Box<instr::Instruction> MethodInitializer::FuseOperatorConstant(instr::Instruction *const instrs[])
+{
+	using namespace instr;
+
+	// ldc.i  c       =>  operator.sc op, c
+	// operator op
+	if (instrs[0]->opcode != OPI_LDC_I_S)
+		return nullptr;
+	if (instrs[1]->opcode != OPI_OPERATOR_L && instrs[1]->opcode != OPI_OPERATOR_S)
+		return nullptr;
+
+	LoadInt *ldc = static_cast<LoadInt*>(instrs[0]);
+	ExecOperator *op = static_cast<ExecOperator*>(instrs[1]);
+	if (ldc->target.GetOffset() != op->args.GetOffset() + (int32_t)sizeof(Value))
+		return nullptr;
+
+	return Box<Instruction>(new OperatorConstant(
+		op->args,
+		op->output,
+		op->op,
+		false, LocalOffset(),
+		ldc->value,
+		op->opcode == OPI_OPERATOR_S
+	));
+}
+
+Box<instr::Instruction> MethodInitializer::FuseLocalOperatorConstant(instr::Instruction *const instrs[])
+{
+	using namespace instr;
+
+	// ldloc  x       =>  operator.lc x, op, c
+	// ldc.i  c
+	// operator op
+	// This includes increments and decrements (x = x + 1), where the result
+	// of the operator has already been redirected to x.
+	if (instrs[0]->opcode != OPI_MVLOC_LS || !instrs[0]->IsLoadLocal())
+		return nullptr;
+
+	Box<Instruction> fused = FuseOperatorConstant(instrs + 1);
+	if (!fused)
+		return nullptr;
+
+	LoadLocal *ldloc = static_cast<LoadLocal*>(instrs[0]);
+	OperatorConstant *op = static_cast<OperatorConstant*>(fused.get());
+	if (ldloc->target.GetOffset() != op->args.GetOffset())
+		return nullptr;
+
+	return Box<Instruction>(new OperatorConstant(
+		op->args,
+		op->output,
+		op->op,
+		true, ldloc->source,
+		op->value,
+		op->opcode == OPI_OPERSC_S
+	));
+}
+
+/*** Step 4: Result writing & finalization ***/
+
+void MethodInitializer::WriteInitializedBody(
+	instr::MethodBuilder &builder,
+	std::vector<instr::PointerArgument> *pointers
+)
 {
 	using namespace instr;
 
 	// Let's allocate a buffer for the output, yay!
-	MethodBuffer buffer(builder.GetByteSize());
+	MethodBuffer buffer(builder.GetByteSize(), pointers);
 	for (size_t i = 0; i < builder.GetLength(); i++)
 	{
 		Instruction *instr = builder[i];
@@ -705,7 +959,6 @@ void MethodInitializer::WriteInitializedBody(instr::MethodBuilder &builder)
 	delete[] method->entry;
 	method->entry  = buffer.Release();
 	method->length = builder.GetByteSize();
-	method->flags |= OverloadFlags::INITED;
 }
 
 void MethodInitializer::FinalizeTryBlockOffsets(instr::MethodBuilder &builder)
@@ -17,6 +17,29 @@ public:
 
 	int Initialize(MethodOverload *method, Thread *const thread);
 
+	// Initializes a method overload without running the static constructors
+	// that it depends on, and without marking it as initialized. The caller
+	// must call MethodOverload::SetInitialized() afterwards. The types whose
+	// static constructors must be run before the method is called are added
+	// to the builder. If the method is invalid, an error is printed and the
+	// process is aborted.
+	//   pointers:
+	//     If not null, receives the types, methods, fields and strings that
+	//     the initialized body refers to.
+	void InitializeBody(
+		MethodOverload *method,
+		instr::MethodBuilder &builder,
+		std::vector<instr::PointerArgument> *pointers
+	);
+
+	// Like InitializeBody(), but throws a MethodInitException if the method
+	// is invalid. The overload must not be initialized again afterwards.
+	void InitializeBodyOrThrow(
+		MethodOverload *method,
+		instr::MethodBuilder &builder,
+		std::vector<instr::PointerArgument> *pointers
+	);
+
 private:
 	OVUM_DISABLE_COPY_AND_ASSIGN(MethodInitializer);
 
@@ -53,7 +76,41 @@ private:
 		IntermediateOpcode comparisonOpc
 	);
 
-	void WriteInitializedBody(instr::MethodBuilder &builder);
+	// A rule for FuseInstructions(), which replaces a sequence of instructions
+	// with a single superinstruction.
+	struct FusionRule
+	{
+		// The number of consecutive instructions that the rule replaces.
+		size_t length;
+		// Returns the superinstruction that replaces instrs[0] through
+		// instrs[length - 1], or null if they do not match the rule.
+		Box<instr::Instruction> (*fuse)(instr::Instruction *const instrs[]);
+	};
+
+	static const size_t MAX_FUSION_LENGTH = 3;
+	// The rules are tried in order at each instruction, and the first one
+	// that matches is used.
+	static const FusionRule fusionRules[];
+	static const size_t fusionRuleCount;
+
+	void FuseInstructions(instr::MethodBuilder &builder);
+
+	// Finds the instructions that cannot be fused with the instruction before
+	// them, because something other than that instruction refers to them.
+	void FindFusionBarriers(instr::MethodBuilder &builder, std::vector<bool> &barriers);
+
+	static Box<instr::Instruction> FuseLoadLocalField(instr::Instruction *const instrs[]);
+
+	static Box<instr::Instruction> FuseOperatorConstant(instr::Instruction *const instrs[]);
+
+	static Box<instr::Instruction> FuseLocalOperatorConstant(instr::Instruction *const instrs[]);
+
+	// Writes the initialized method body. If pointers is not null, it receives
+	// the location of every pointer in the body (see MethodCache).
+	void WriteInitializedBody(
+		instr::MethodBuilder &builder,
+		std::vector<instr::PointerArgument> *pointers
+	);
 
 	void FinalizeTryBlockOffsets(instr::MethodBuilder &builder);
 
@@ -0,0 +1,315 @@
+#include "profiler.h"
+
+#if OVUM_PROFILING
+
+#include "vm.h"
+#include "thread.opcodes.h"
+#include "../object/type.h"
+#include "../object/method.h"
+#include <algorithm>
+#include <utility>
+
+namespace ovum
+{
+
+Box<Profiler> Profiler::New()
+{
+	Box<Profiler> result(new(std::nothrow) Profiler());
+	if (!result)
+		return nullptr;
+
+	result->opcodeCounts = Box<uint64_t[]>(new(std::nothrow) uint64_t[OPCODE_COUNT]());
+	if (!result->opcodeCounts)
+		return nullptr;
+
+	result->pairCounts = Box<uint64_t[]>(new(std::nothrow) uint64_t[OPCODE_COUNT * OPCODE_COUNT]());
+	if (!result->pairCounts)
+		return nullptr;
+
+	return std::move(result);
+}
+
+Profiler::Profiler() :
+	opcodeCounts(),
+	pairCounts(),
+	lastOpcode(OPI_NOP),
+	methods()
+{ }
+
+void Profiler::MethodEntered(MethodOverload *method)
+{
+	MethodProfile &profile = method->profile;
+	if (profile.callCount == 0)
+		methods.push_back(method);
+	profile.callCount++;
+
+	if (profile.depth++ == 0)
+		profile.enterTicks = os::GetClockTicks();
+}
+
+void Profiler::MethodLeft(MethodOverload *method)
+{
+	MethodProfile &profile = method->profile;
+	OVUM_ASSERT(profile.depth > 0);
+
+	if (--profile.depth == 0)
+		profile.ticks += os::GetClockTicks() - profile.enterTicks;
+}
+
+void Profiler::PrintReport(bool jitEnabled)
+{
+	uint64_t total = 0;
+	for (size_t i = 0; i < OPCODE_COUNT; i++)
+		total += opcodeCounts[i];
+
+	fwprintf(stderr, L"<<< Begin profile >>>\n");
+	if (jitEnabled)
+		fwprintf(stderr, L"Note: instructions in JIT-compiled code are not counted.\n");
+	fwprintf(stderr, L"Instructions executed: %llu\n", (unsigned long long)total);
+
+	PrintOpcodes(total);
+	PrintPairs(total);
+	PrintMethods();
+
+	fwprintf(stderr, L"<<< End profile >>>\n");
+}
+
+void Profiler::PrintOpcodes(uint64_t total)
+{
+	std::vector<size_t> opcodes;
+	for (size_t i = 0; i < OPCODE_COUNT; i++)
+		if (opcodeCounts[i] != 0)
+			opcodes.push_back(i);
+
+	std::sort(opcodes.begin(), opcodes.end(), [this](size_t a, size_t b) {
+		return opcodeCounts[a] > opcodeCounts[b];
+	});
+
+	fwprintf(stderr, L"\nOpcodes:\n");
+	fwprintf(stderr, L"%16ls %7ls  %ls\n", L"count", L"%", L"opcode");
+	for (size_t i = 0; i < opcodes.size(); i++)
+	{
+		uint64_t count = opcodeCounts[opcodes[i]];
+		fwprintf(stderr, L"%16llu %6.2f%%  %ls\n",
+			(unsigned long long)count,
+			100.0 * count / total,
+			GetOpcodeName(opcodes[i]));
+	}
+}
+
+void Profiler::PrintPairs(uint64_t total)
+{
+	std::vector<size_t> pairs;
+	for (size_t i = 0; i < OPCODE_COUNT * OPCODE_COUNT; i++)
+		if (pairCounts[i] != 0)
+			pairs.push_back(i);
+
+	size_t count = std::min(pairs.size(), REPORT_LIMIT);
+	std::partial_sort(pairs.begin(), pairs.begin() + count, pairs.end(), [this](size_t a, size_t b) {
+		return pairCounts[a] > pairCounts[b];
+	});
+
+	fwprintf(stderr, L"\nOpcode pairs (top %u of %u):\n", (unsigned int)count, (unsigned int)pairs.size());
+	fwprintf(stderr, L"%16ls %7ls  %ls\n", L"count", L"%", L"opcodes");
+	for (size_t i = 0; i < count; i++)
+	{
+		size_t pair = pairs[i];
+		fwprintf(stderr, L"%16llu %6.2f%%  %ls, %ls\n",
+			(unsigned long long)pairCounts[pair],
+			100.0 * pairCounts[pair] / total,
+			GetOpcodeName(pair / OPCODE_COUNT),
+			GetOpcodeName(pair % OPCODE_COUNT));
+	}
+}
+
+void Profiler::PrintMethods()
+{
+	// Methods that are still running (such as the main method, when the report
+	// is requested by managed code) are timed up to now.
+	uint64_t now = os::GetClockTicks();
+	std::vector<std::pair<uint64_t, MethodOverload*>> sorted;
+	sorted.reserve(methods.size());
+	for (size_t i = 0; i < methods.size(); i++)
+	{
+		const MethodProfile &profile = methods[i]->profile;
+		uint64_t ticks = profile.ticks;
+		if (profile.depth > 0)
+			ticks += now - profile.enterTicks;
+		sorted.push_back(std::make_pair(ticks, methods[i]));
+	}
+
+	size_t count = std::min(sorted.size(), REPORT_LIMIT);
+	std::partial_sort(sorted.begin(), sorted.begin() + count, sorted.end(),
+		[](const std::pair<uint64_t, MethodOverload*> &a, const std::pair<uint64_t, MethodOverload*> &b) {
+			return a.first > b.first;
+		});
+
+	double ticksPerMs = os::GetClockFrequency() / 1000.0;
+
+	fwprintf(stderr, L"\nMethods by total time (top %u of %u):\n", (unsigned int)count, (unsigned int)sorted.size());
+	fwprintf(stderr, L"%16ls %12ls  %ls\n", L"calls", L"time (ms)", L"method");
+	for (size_t i = 0; i < count; i++)
+	{
+		MethodOverload *method = sorted[i].second;
+		fwprintf(stderr, L"%16llu %12.3f  ",
+			(unsigned long long)method->profile.callCount,
+			sorted[i].first / ticksPerMs);
+		if (method->declType)
+			VM::PrintfErr(L"%ls.", method->declType->fullName);
+		VM::PrintErr(method->group->name);
+		fwprintf(stderr, L"(%u params)%ls\n",
+			(unsigned int)method->paramCount,
+			method->IsNative() ? L" [native]" : L"");
+	}
+}
+
+const wchar_t *Profiler::GetOpcodeName(size_t opcode)
+{
+#define N(opc) L ## #opc
+	// Indexed by IntermediateOpcode. Gaps in the opcode values are null.
+	static const wchar_t *const names[] = {
+		N(OPI_RET),         // 0x00
+		N(OPI_RETNULL),     // 0x01
+		N(OPI_NOP),         // 0x02
+		N(OPI_POP),         // 0x03
+		N(OPI_MVLOC_LL),    // 0x04
+		N(OPI_MVLOC_SL),    // 0x05
+		N(OPI_MVLOC_LS),    // 0x06
+		N(OPI_MVLOC_SS),    // 0x07
+		N(OPI_LDNULL_L),    // 0x08
+		N(OPI_LDNULL_S),    // 0x09
+		N(OPI_LDFALSE_L),   // 0x0a
+		N(OPI_LDFALSE_S),   // 0x0b
+		N(OPI_LDTRUE_L),    // 0x0c
+		N(OPI_LDTRUE_S),    // 0x0d
+		N(OPI_LDC_I_L),     // 0x0e
+		N(OPI_LDC_I_S),     // 0x0f
+		N(OPI_LDC_U_L),     // 0x10
+		N(OPI_LDC_U_S),     // 0x11
+		N(OPI_LDC_R_L),     // 0x12
+		N(OPI_LDC_R_S),     // 0x13
+		N(OPI_LDSTR_L),     // 0x14
+		N(OPI_LDSTR_S),     // 0x15
+		N(OPI_LDARGC_L),    // 0x16
+		N(OPI_LDARGC_S),    // 0x17
+		N(OPI_LDENUM_L),    // 0x18
+		N(OPI_LDENUM_S),    // 0x19
+		N(OPI_NEWOBJ_L),    // 0x1a
+		N(OPI_NEWOBJ_S),    // 0x1b
+		N(OPI_LIST_L),      // 0x1c
+		N(OPI_LIST_S),      // 0x1d
+		N(OPI_HASH_L),      // 0x1e
+		N(OPI_HASH_S),      // 0x1f
+		N(OPI_LDFLD_L),     // 0x20
+		N(OPI_LDFLD_S),     // 0x21
+		N(OPI_LDSFLD_L),    // 0x22
+		N(OPI_LDSFLD_S),    // 0x23
+		N(OPI_LDMEM_L),     // 0x24
+		N(OPI_LDMEM_S),     // 0x25
+		N(OPI_LDITER_L),    // 0x26
+		N(OPI_LDITER_S),    // 0x27
+		N(OPI_LDTYPE_L),    // 0x28
+		N(OPI_LDTYPE_S),    // 0x29
+		N(OPI_LDIDX_L),     // 0x2a
+		N(OPI_LDIDX_S),     // 0x2b
+		N(OPI_LDSFN_L),     // 0x2c
+		N(OPI_LDSFN_S),     // 0x2d
+		N(OPI_LDTYPETKN_L), // 0x2e
+		N(OPI_LDTYPETKN_S), // 0x2f
+		N(OPI_CALL_L),      // 0x30
+		N(OPI_CALL_S),      // 0x31
+		N(OPI_SCALL_L),     // 0x32
+		N(OPI_SCALL_S),     // 0x33
+		N(OPI_APPLY_L),     // 0x34
+		N(OPI_APPLY_S),     // 0x35
+		N(OPI_SAPPLY_L),    // 0x36
+		N(OPI_SAPPLY_S),    // 0x37
+		N(OPI_BR),          // 0x38
+		N(OPI_LEAVE),       // 0x39
+		N(OPI_BRNULL_L),    // 0x3a
+		N(OPI_BRNULL_S),    // 0x3b
+		N(OPI_BRINST_L),    // 0x3c
+		N(OPI_BRINST_S),    // 0x3d
+		N(OPI_BRFALSE_L),   // 0x3e
+		N(OPI_BRFALSE_S),   // 0x3f
+		N(OPI_BRTRUE_L),    // 0x40
+		N(OPI_BRTRUE_S),    // 0x41
+		N(OPI_BRTYPE_L),    // 0x42
+		N(OPI_BRTYPE_S),    // 0x43
+		N(OPI_SWITCH_L),    // 0x44
+		N(OPI_SWITCH_S),    // 0x45
+		N(OPI_BRREF),       // 0x46
+		N(OPI_BRNREF),      // 0x47
+		N(OPI_OPERATOR_L),  // 0x48
+		N(OPI_OPERATOR_S),  // 0x49
+		N(OPI_EQ_L),        // 0x4a
+		N(OPI_EQ_S),        // 0x4b
+		N(OPI_CMP_L),       // 0x4c
+		N(OPI_CMP_S),       // 0x4d
+		N(OPI_LT_L),        // 0x4e
+		N(OPI_LT_S),        // 0x4f
+		N(OPI_GT_L),        // 0x50
+		N(OPI_GT_S),        // 0x51
+		N(OPI_LTE_L),       // 0x52
+		N(OPI_LTE_S),       // 0x53
+		N(OPI_GTE_L),       // 0x54
+		N(OPI_GTE_S),       // 0x55
+		N(OPI_CONCAT_L),    // 0x56
+		N(OPI_CONCAT_S),    // 0x57
+		N(OPI_CALLMEM_L),   // 0x58
+		N(OPI_CALLMEM_S),   // 0x59
+		N(OPI_STSFLD_L),    // 0x5a
+		N(OPI_STSFLD_S),    // 0x5b
+		N(OPI_STFLD),       // 0x5c
+		N(OPI_STMEM),       // 0x5d
+		N(OPI_STIDX),       // 0x5e
+		N(OPI_THROW),       // 0x5f
+		N(OPI_RETHROW),     // 0x60
+		N(OPI_ENDFINALLY),  // 0x61
+		N(OPI_LDFLDFAST_L), // 0x62
+		N(OPI_LDFLDFAST_S), // 0x63
+		N(OPI_STFLDFAST),   // 0x64
+		N(OPI_BREQ),        // 0x65
+		N(OPI_BRNEQ),       // 0x66
+		N(OPI_BRLT),        // 0x67
+		N(OPI_BRGT),        // 0x68
+		N(OPI_BRLTE),       // 0x69
+		N(OPI_BRGTE),       // 0x6a
+		N(OPI_LDLOCREF),    // 0x6b
+		N(OPI_LDMEMREF_L),  // 0x6c
+		N(OPI_LDMEMREF_S),  // 0x6d
+		N(OPI_LDFLDREF_L),  // 0x6e
+		N(OPI_LDFLDREF_S),  // 0x6f
+		N(OPI_LDSFLDREF),   // 0x70
+		nullptr,            // 0x71
+		N(OPI_MVLOC_RL),    // 0x72
+		N(OPI_MVLOC_RS),    // 0x73
+		N(OPI_MVLOC_LR),    // 0x74
+		N(OPI_MVLOC_SR),    // 0x75
+		N(OPI_CALLR_L),     // 0x76
+		N(OPI_CALLR_S),     // 0x77
+		N(OPI_CALLMEMR_L),  // 0x78
+		N(OPI_CALLMEMR_S),  // 0x79
+		N(OPI_LDLOCFLD_L),  // 0x7a
+		N(OPI_LDLOCFLD_S),  // 0x7b
+		N(OPI_OPERSC_L),    // 0x7c
+		N(OPI_OPERSC_S),    // 0x7d
+		N(OPI_OPERLC_L),    // 0x7e
+		N(OPI_OPERLC_S),    // 0x7f
+		N(OPI_UNARYOP_L),   // 0x80
+		N(OPI_UNARYOP_S)    // 0x81
+	};
+	static_assert(
+		sizeof(names) / sizeof(names[0]) == OPI_UNARYOP_S + 1,
+		"names does not match IntermediateOpcode"
+	);
+#undef N
+
+	if (opcode < sizeof(names) / sizeof(names[0]) && names[opcode] != nullptr)
+		return names[opcode];
+	return L"(invalid)";
+}
+
+} // namespace ovum
+
+#endif // OVUM_PROFILING
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "../vm.h"
+#include <vector>
+
+// The profiler counts how many times each intermediate instruction is executed
+// by Thread::Evaluate(), and how many times each pair of instructions executes
+// back to back. It also counts calls to each method overload, and measures the
+// time spent in them. The VM prints a report to stderr when the program ends,
+// and managed code can ask for one at any time through VM_PrintProfile().
+//
+// Profiling is a compile-time option. Define OVUM_PROFILING as 1 to build a
+// VM that profiles everything it runs. Otherwise, none of the counting code is
+// compiled, and the profiler does not exist.
+#ifndef OVUM_PROFILING
+# define OVUM_PROFILING 0
+#endif
+
+// Evaluates the argument only when profiling is enabled. Use this to record
+// profiling events in code that is compiled either way.
+#if OVUM_PROFILING
+# define OVUM_PROFILE(expr) (expr)
+#else
+# define OVUM_PROFILE(expr) ((void)0)
+#endif
+
+namespace ovum
+{
+
+// Profiling data for a single method overload. Each MethodOverload has one of
+// these when profiling is enabled.
+struct MethodProfile
+{
+	// The number of times the overload has been called.
+	uint64_t callCount;
+	// The total time spent in the overload, in os::GetClockTicks() ticks,
+	// including the time spent in methods that it called.
+	uint64_t ticks;
+	// The time at which the outermost active invocation of the overload began.
+	uint64_t enterTicks;
+	// The number of active invocations of the overload. Time is only measured
+	// for the outermost one, so that recursive calls are not counted twice.
+	uint32_t depth;
+
+	inline MethodProfile() :
+		callCount(0),
+		ticks(0),
+		enterTicks(0),
+		depth(0)
+	{ }
+};
+
+#if OVUM_PROFILING
+
+// The profiler is not synchronized. Only one managed thread ever runs bytecode
+// or calls method overloads, so there is no contention to worry about.
+class Profiler
+{
+public:
+	// Intermediate opcodes are read from a single byte, so this covers every
+	// value that Thread::Evaluate() can dispatch on.
+	static const size_t OPCODE_COUNT = 256;
+
+	// The maximum number of opcode pairs and method overloads that are listed
+	// in a report. Every opcode that has been executed is always listed.
+	static const size_t REPORT_LIMIT = 50;
+
+	OVUM_NOINLINE static Box<Profiler> New();
+
+	// Records the execution of an instruction.
+	inline void InstructionExecuted(uint8_t opcode)
+	{
+		opcodeCounts[opcode]++;
+		pairCounts[(size_t)lastOpcode * OPCODE_COUNT + opcode]++;
+		lastOpcode = opcode;
+	}
+
+	// Records that a method overload has been called. This must be followed by
+	// a call to MethodLeft() when the method returns, or its stack frame is
+	// otherwise removed.
+	void MethodEntered(MethodOverload *method);
+
+	// Records that a method overload has returned.
+	void MethodLeft(MethodOverload *method);
+
+	// Prints a report of everything that has been recorded so far to stderr,
+	// sorted by execution count or time.
+	//   jitEnabled:
+	//     True if the JIT compiler is enabled. Instructions in compiled code
+	//     are not counted, which the report points out.
+	void PrintReport(bool jitEnabled);
+
+private:
+	// The number of times each opcode has been executed.
+	Box<uint64_t[]> opcodeCounts;
+	// The number of times each opcode has been executed directly after each
+	// other opcode, indexed by [previous * OPCODE_COUNT + current].
+	Box<uint64_t[]> pairCounts;
+	// The previously executed opcode. Pairs that span calls and returns are
+	// counted too, as that is the order in which the instructions ran.
+	uint8_t lastOpcode;
+
+	// Every method overload that has been called at least once.
+	std::vector<MethodOverload*> methods;
+
+	Profiler();
+
+	void PrintOpcodes(uint64_t total);
+
+	void PrintPairs(uint64_t total);
+
+	void PrintMethods();
+
+	static const wchar_t *GetOpcodeName(size_t opcode);
+};
+
+#endif // OVUM_PROFILING
+
+} // namespace ovum
@@ -82,12 +82,15 @@ bool LongRefSignature::Equals(const LongRefSignature &other) const
 
 uint32_t RefSignaturePool::Add(LongRefSignature *signature, bool &isNew)
 {
+	lock.Enter();
+
 	size_t i = 0;
 	while (i < signatures.size())
 	{
 		auto &item = signatures[i];
 		if (item->Equals(*signature))
 		{
+			lock.Leave();
 			isNew = false;
 			return i | RefSignature::SignatureKindMask;
 		}
@@ -95,7 +98,17 @@ uint32_t RefSignaturePool::Add(LongRefSignature *signature, bool &isNew)
 	}
 
 	// Take ownership of the signature
-	signatures.push_back(Box<LongRefSignature>(signature));
+	try
+	{
+		signatures.push_back(Box<LongRefSignature>(signature));
+	}
+	catch (std::bad_alloc&)
+	{
+		lock.Leave();
+		throw;
+	}
+
+	lock.Leave();
 	isNew = true;
 	return i | RefSignature::SignatureKindMask;
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../vm.h"
+#include "../threading/sync.h"
 #include <vector>
 
 /*\
@@ -67,6 +68,13 @@ public:
 
 	bool IsParamRef(ovlocals_t index) const;
 
+	// Determines whether a signature is long, in which case it is an index
+	// into a RefSignaturePool rather than a bit field.
+	static inline bool IsLong(uint32_t signature)
+	{
+		return (signature & SignatureKindMask) == SignatureKindMask;
+	}
+
 private:
 	OVUM_DISABLE_COPY_AND_ASSIGN(RefSignature);
 
@@ -119,6 +127,9 @@ private:
 	friend class RefSignature;
 };
 
+// Signatures may be added by the background initializer while the managed
+// thread looks them up, so the pool is protected by a lock. Long signatures
+// are rare, and the lock is only held while the vector is accessed.
 class RefSignaturePool
 {
 public:
@@ -129,7 +140,10 @@ public:
 
 	const LongRefSignature *Get(ovlocals_t index) const
 	{
-		return signatures[index].get();
+		lock.Enter();
+		const LongRefSignature *result = signatures[index].get();
+		lock.Leave();
+		return result;
 	}
 
 	uint32_t Add(LongRefSignature *signature, bool &isNew);
@@ -137,6 +151,8 @@ public:
 private:
 	OVUM_DISABLE_COPY_AND_ASSIGN(RefSignaturePool);
 
+	mutable SpinLock lock;
+
 	std::vector<Box<LongRefSignature>> signatures;
 };
 
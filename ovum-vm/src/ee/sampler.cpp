@@ -0,0 +1,249 @@
+#include "sampler.h"
+#include "thread.h"
+#include "../object/type.h"
+#include "../object/method.h"
+#include "../debug/debugsymbols.h"
+#include "../unicode/utf8encoder.h"
+#include "../util/stringbuffer.h"
+#include <exception>
+
+namespace ovum
+{
+
+Box<Sampler> Sampler::New(Thread *thread, uint32_t interval)
+{
+	Box<Sampler> result(new(std::nothrow) Sampler(thread, interval));
+	return std::move(result);
+}
+
+Sampler::Sampler(Thread *thread, uint32_t interval) :
+	thread(thread),
+	interval(interval),
+	timerThread(),
+	timerRunning(false),
+	stopping(false),
+	tickCount(0),
+	sampledTickCount(0),
+	stacks(),
+	sampleCount(0),
+	currentStack()
+{ }
+
+Sampler::~Sampler()
+{
+	Stop();
+}
+
+bool Sampler::Start()
+{
+	OVUM_ASSERT(!timerRunning);
+
+	stopping.store(false, std::memory_order_relaxed);
+	if (!os::ThreadStart(&timerThread, TimerMain, this))
+		return false;
+	timerRunning = true;
+
+	return true;
+}
+
+void Sampler::Stop()
+{
+	if (!timerRunning)
+		return;
+
+	stopping.store(true, std::memory_order_release);
+	os::ThreadJoin(&timerThread);
+	timerRunning = false;
+}
+
+void Sampler::TimerMain(void *state)
+{
+	Sampler *self = reinterpret_cast<Sampler*>(state);
+
+	while (true)
+	{
+		os::Sleep(self->interval);
+		if (self->stopping.load(std::memory_order_acquire))
+			break;
+		self->tickCount.fetch_add(1, std::memory_order_relaxed);
+		self->thread->PleaseTakeSample();
+	}
+}
+
+void Sampler::RecordSample(Thread *thread)
+{
+	const StackFrame *frame = thread->GetCurrentFrame();
+	const void *ip = thread->GetInstructionPointer();
+
+	// Every tick since the last sample was spent in the current call stack, as
+	// far as we can tell.
+	uint64_t ticks = tickCount.load(std::memory_order_relaxed);
+	uint64_t weight = ticks - sampledTickCount;
+	sampledTickCount = ticks;
+	if (weight == 0)
+		return;
+
+	lock.Enter();
+
+	try
+	{
+		currentStack.clear();
+
+		// The first stack frame has no method; see Thread::PushFirstStackFrame().
+		while (frame && frame->method)
+		{
+			SampleFrame sampleFrame;
+			sampleFrame.method = frame->method;
+			sampleFrame.line = GetLineNumber(frame->method, ip);
+			currentStack.push_back(sampleFrame);
+
+			ip = frame->prevInstr;
+			frame = frame->prevFrame;
+		}
+
+		if (!currentStack.empty())
+		{
+			stacks[currentStack] += weight;
+			sampleCount += weight;
+		}
+	}
+	catch (std::exception&)
+	{
+		// Not enough memory to record the sample. Drop it; the profile is
+		// statistical anyway.
+	}
+
+	lock.Leave();
+}
+
+int32_t Sampler::GetLineNumber(MethodOverload *method, const void *ip)
+{
+	if (method->IsNative() || method->debugSymbols == nullptr)
+		return 0;
+
+	uint32_t offset = (uint32_t)((const uint8_t*)ip - method->entry);
+	debug::DebugSymbol *sym = method->debugSymbols->FindSymbol(offset);
+	if (sym == nullptr)
+		return 0;
+
+	return sym->startLocation.lineNumber;
+}
+
+bool Sampler::WriteCollapsedStacks(const pathchar_t *fileName)
+{
+	os::FileHandle file;
+	os::FileStatus status = os::OpenFile(
+		fileName,
+		os::FILE_CREATE,
+		os::FILE_ACCESS_WRITE,
+		os::FILE_SHARE_READ,
+		&file
+	);
+	if (status != os::FILE_OK)
+		return false;
+
+	bool success = true;
+	lock.Enter();
+	try
+	{
+		StringBuffer buf;
+		for (StackMap::const_iterator i = stacks.begin(); i != stacks.end(); ++i)
+		{
+			const Stack &stack = i->first;
+
+			buf.Clear();
+			// The stack is stored innermost frame first, but the collapsed
+			// format puts the outermost frame first.
+			for (size_t f = stack.size(); f > 0; f--)
+			{
+				if (f < stack.size())
+					buf.Append(';');
+				AppendFrame(buf, stack[f - 1]);
+			}
+
+			buf.Append(' ');
+			AppendNumber(buf, i->second);
+			buf.Append('\n');
+
+			if (!WriteBuffer(&file, buf))
+			{
+				success = false;
+				break;
+			}
+		}
+	}
+	catch (std::exception&)
+	{
+		success = false;
+	}
+	lock.Leave();
+
+	os::CloseFile(&file);
+	return success;
+}
+
+void Sampler::AppendFrame(StringBuffer &buf, const SampleFrame &frame)
+{
+	Method *group = frame.method->group;
+
+	// Global functions already have a fully qualified name.
+	if (group->declType != nullptr)
+	{
+		buf.Append(group->declType->fullName);
+		buf.Append('.');
+	}
+	buf.Append(group->name);
+
+	if (frame.line != 0)
+	{
+		buf.Append(':');
+		AppendNumber(buf, (uint64_t)frame.line);
+	}
+}
+
+void Sampler::AppendNumber(StringBuffer &buf, uint64_t number)
+{
+	// Enough for the largest uint64_t
+	const size_t BUFFER_SIZE = 20;
+
+	ovchar_t digits[BUFFER_SIZE];
+	ovchar_t *chp = digits + BUFFER_SIZE;
+
+	do
+	{
+		*--chp = (ovchar_t)'0' + number % 10;
+	} while (number /= 10);
+
+	buf.Append(digits + BUFFER_SIZE - chp, chp);
+}
+
+bool Sampler::WriteBuffer(os::FileHandle *file, StringBuffer &buf)
+{
+	const size_t BUFFER_SIZE = 512;
+	char utf8[BUFFER_SIZE];
+
+	Utf8Encoder encoder(utf8, BUFFER_SIZE, buf.GetDataPointer(), buf.GetLength());
+	size_t byteCount;
+	while ((byteCount = encoder.GetNextBytes()) != 0)
+	{
+		size_t bytesWritten;
+		if (os::WriteFile(file, byteCount, utf8, &bytesWritten) != os::FILE_OK)
+			return false;
+	}
+
+	return true;
+}
+
+size_t Sampler::StackHash::operator()(const Stack &stack) const
+{
+	// FNV-1a over the method pointers and line numbers.
+	size_t hash = (size_t)2166136261u;
+	for (size_t i = 0; i < stack.size(); i++)
+	{
+		hash = (hash ^ (size_t)stack[i].method) * 16777619u;
+		hash = (hash ^ (size_t)stack[i].line) * 16777619u;
+	}
+	return hash;
+}
+
+} // namespace ovum
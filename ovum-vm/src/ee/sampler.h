@@ -0,0 +1,136 @@
+#pragma once
+
+#include "../vm.h"
+#include "../threading/sync.h"
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
+namespace ovum
+{
+
+// The sampler is a statistical CPU profiler for managed code. A timer thread
+// wakes up at a fixed interval and asks the managed thread to take a sample,
+// in the same way that the GC asks it to suspend itself (see ThreadRequest).
+// The next time the managed thread checks for requests, it walks its stack
+// frames and passes them to RecordSample(). Identical call stacks are counted
+// together.
+//
+// Threads check for requests when they enter a method and on backward branches,
+// so loops that make no calls are sampled too. Requests do not queue up, though:
+// while the thread is busy elsewhere, for example in a long native call, the
+// timer may tick several times before the next sample is taken. The timer
+// therefore counts its ticks, and each sample is weighted by the number of ticks
+// since the previous one, so that the time is still accounted for.
+//
+// When the program ends, the VM writes the samples to a file in the collapsed
+// stack format, which flame graph tools such as flamegraph.pl can read. Each
+// line contains one call stack, from the outermost method to the innermost,
+// with frames separated by semicolons, followed by a space and the number of
+// timer ticks that stack accounts for.
+class Sampler
+{
+public:
+	// Creates a sampler for the specified thread. The timer does not run until
+	// Start() is called.
+	//   thread:
+	//     The managed thread to sample.
+	//   interval:
+	//     The time between samples, in milliseconds.
+	OVUM_NOINLINE static Box<Sampler> New(Thread *thread, uint32_t interval);
+
+	// Stops the timer, if it is running.
+	~Sampler();
+
+	// Starts the timer thread. Returns true on success.
+	bool Start();
+
+	// Stops the timer thread, and waits for it to terminate. No more samples
+	// are requested afterwards.
+	void Stop();
+
+	// Records a sample of the specified thread's current call stack. This must
+	// be called on that thread.
+	void RecordSample(Thread *thread);
+
+	// Gets the number of timer ticks that the recorded samples account for.
+	inline uint64_t GetSampleCount() const
+	{
+		return sampleCount;
+	}
+
+	// Writes the recorded samples to a file in the collapsed stack format. If
+	// the file exists, it is overwritten. Returns true on success.
+	bool WriteCollapsedStacks(const pathchar_t *fileName);
+
+private:
+	// A single stack frame in a sample. Frames are distinguished by method
+	// overload and, when debug symbols are available, by line number.
+	struct SampleFrame
+	{
+		MethodOverload *method;
+		// The line number, or zero if it is not known.
+		int32_t line;
+
+		inline bool operator==(const SampleFrame &other) const
+		{
+			return method == other.method && line == other.line;
+		}
+	};
+
+	// A sampled call stack, from the innermost frame to the outermost.
+	typedef std::vector<SampleFrame> Stack;
+
+	struct StackHash
+	{
+		size_t operator()(const Stack &stack) const;
+	};
+
+	typedef std::unordered_map<Stack, uint64_t, StackHash> StackMap;
+
+	// The thread being sampled.
+	Thread *thread;
+
+	// The time between samples, in milliseconds.
+	uint32_t interval;
+
+	os::NativeThread timerThread;
+	// True if timerThread refers to a running thread.
+	bool timerRunning;
+	// Set to true when the timer thread should exit.
+	std::atomic<bool> stopping;
+	// The number of times the timer has asked for a sample.
+	std::atomic<uint64_t> tickCount;
+	// The value of tickCount when the last sample was recorded. Only used by
+	// RecordSample().
+	uint64_t sampledTickCount;
+
+	// Protects stacks and sampleCount.
+	SpinLock lock;
+
+	// The number of timer ticks that each distinct call stack accounts for.
+	StackMap stacks;
+
+	// The total number of timer ticks in stacks.
+	uint64_t sampleCount;
+
+	// Reused by RecordSample(), so that a sample of a call stack that has been
+	// seen before does not have to allocate anything.
+	Stack currentStack;
+
+	Sampler(Thread *thread, uint32_t interval);
+
+	static void TimerMain(void *state);
+
+	static int32_t GetLineNumber(MethodOverload *method, const void *ip);
+
+	static void AppendFrame(StringBuffer &buf, const SampleFrame &frame);
+
+	static void AppendNumber(StringBuffer &buf, uint64_t number);
+
+	static bool WriteBuffer(os::FileHandle *file, StringBuffer &buf);
+
+	OVUM_DISABLE_COPY_AND_ASSIGN(Sampler);
+};
+
+} // namespace ovum
@@ -28,6 +28,18 @@ public:
 	// whether they are accessible, and when generating a stack trace,
 	// to obtain the name of the method.
 	MethodOverload *method;
+	// If the method was called by Thread::EnterMethod(), which lets the caller's
+	// Thread::Evaluate() run it without a recursive call, this is the address
+	// at which to resume the caller once the method returns. Otherwise, this
+	// field is not used.
+	uint8_t *returnInstr;
+	// If the method was called by Thread::EnterMethod(), the location that
+	// receives the return value. Otherwise, this field is not used.
+	Value *returnValue;
+	// If the method was called by Thread::EnterMethod(), true if the return
+	// value is pushed onto the caller's evaluation stack. Otherwise, this field
+	// is not used.
+	bool pushReturnValue;
 
 	inline Value *NextStackSlot()
 	{
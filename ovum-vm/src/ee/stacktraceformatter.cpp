@@ -26,23 +26,174 @@ String *StackTraceFormatter::GetStackTrace(Thread *const thread)
 
 void StackTraceFormatter::GetStackTrace(Thread *const thread, StringBuffer &buf)
 {
-	const StackFrame *frame = thread->GetCurrentFrame();
-	const void *ip = thread->GetInstructionPointer();
+	uint32_t frameCount, argumentCount;
+	CountStackTrace(thread, frameCount, argumentCount);
+
+	Box<uint8_t[]> data(new uint8_t[RawStackTrace::GetSize(frameCount, argumentCount)]);
+	RawStackTrace *stackTrace = reinterpret_cast<RawStackTrace*>(data.get());
+	stackTrace->frameCount = frameCount;
+	stackTrace->argumentCount = argumentCount;
+
+	FillStackTrace(thread, stackTrace);
+
+	FormatStackTrace(thread, buf, stackTrace);
+}
+
+int StackTraceFormatter::CaptureStackTrace(Thread *const thread, RawStackTrace **result)
+{
+	uint32_t frameCount, argumentCount;
+	CountStackTrace(thread, frameCount, argumentCount);
+
+	void *data;
+	int r = thread->GetGC()->AllocArray(
+		thread,
+		RawStackTrace::GetSize(frameCount, argumentCount),
+		1,
+		&data
+	);
+	if (r != OVUM_SUCCESS)
+		return r;
+
+	// The GC cannot have touched the stack frames, other than to update
+	// references, so the counts are still valid.
+	RawStackTrace *stackTrace = reinterpret_cast<RawStackTrace*>(data);
+	stackTrace->frameCount = frameCount;
+	stackTrace->argumentCount = argumentCount;
+
+	FillStackTrace(thread, stackTrace);
+
+	*result = stackTrace;
+	RETURN_SUCCESS;
+}
+
+String *StackTraceFormatter::FormatStackTrace(Thread *const thread, const RawStackTrace *stackTrace)
+{
+	try
+	{
+		StringBuffer buf(STRING_BUFFER_CAPACITY);
+
+		FormatStackTrace(thread, buf, stackTrace);
+
+		return buf.ToString(thread);
+	}
+	catch (std::exception&)
+	{
+		return nullptr;
+	}
+}
+
+void StackTraceFormatter::CountStackTrace(Thread *const thread, uint32_t &frameCount, uint32_t &argumentCount)
+{
+	frameCount = 0;
+	argumentCount = 0;
 
 	// The VM creates a "fake" stack frame without a method, so that arguments
 	// for the main method call can be pushed onto the stack. We don't want to
 	// include that stack frame in the trace; it doesn't have any useful info.
 
+	const StackFrame *frame = thread->GetCurrentFrame();
 	while (frame && frame->method)
 	{
-		AppendStackFrame(thread, buf, frame, ip);
+		ovlocals_t paramCount = frame->method->GetEffectiveParamCount();
+		const Value *args = reinterpret_cast<const Value*>(frame) - paramCount;
+
+		for (ovlocals_t i = 0; i < paramCount; i++)
+			argumentCount += CountArgument(thread, args + i);
+
+		frameCount++;
+		frame = frame->prevFrame;
+	}
+}
+
+uint32_t StackTraceFormatter::CountArgument(Thread *const thread, const Value *arg)
+{
+	Value argValue; // Copy, because arg is const
+	if (IS_REFERENCE(*arg))
+		ReadReference(const_cast<Value*>(arg), &argValue);
+	else
+		argValue = *arg;
+
+	// An aves.Method is followed by the type of its instance.
+	if (argValue.type != nullptr && argValue.type == thread->GetVM()->types.Method)
+		return 1 + CountArgument(thread, &argValue.v.method->instance);
+	return 1;
+}
+
+void StackTraceFormatter::FillStackTrace(Thread *const thread, RawStackTrace *stackTrace)
+{
+	RawStackFrame *output = stackTrace->GetFrames();
+	RawArgument *const firstArg = stackTrace->GetArguments();
+	RawArgument *argOutput = firstArg;
+
+	const StackFrame *frame = thread->GetCurrentFrame();
+	const void *ip = thread->GetInstructionPointer();
+
+	while (frame && frame->method)
+	{
+		MethodOverload *method = frame->method;
+
+		output->method = method;
+		output->offset = method->debugSymbols
+			? (uint32_t)((uint8_t*)ip - method->entry)
+			: 0;
+		output->firstArgument = (uint32_t)(argOutput - firstArg);
+
+		ovlocals_t paramCount = method->GetEffectiveParamCount();
+		const Value *args = reinterpret_cast<const Value*>(frame) - paramCount;
+		for (ovlocals_t i = 0; i < paramCount; i++)
+			CaptureArgument(thread, argOutput, args + i);
 
+		output++;
 		ip = frame->prevInstr;
 		frame = frame->prevFrame;
 	}
+
+	OVUM_ASSERT(output - stackTrace->GetFrames() == stackTrace->frameCount);
+	OVUM_ASSERT(argOutput - firstArg == stackTrace->argumentCount);
 }
 
-void StackTraceFormatter::AppendStackFrame(Thread *const thread, StringBuffer &buf, const StackFrame *frame, const void *ip)
+void StackTraceFormatter::CaptureArgument(Thread *const thread, RawArgument *&output, const Value *arg)
+{
+	Value argValue; // Copy, because arg is const
+	RawArgument *rawArg = output++;
+
+	if (IS_REFERENCE(*arg))
+	{
+		// If the argument is a reference, it must be dereferenced before
+		// we can make use of the type information.
+		rawArg->isRef = true;
+		ReadReference(const_cast<Value*>(arg), &argValue);
+	}
+	else
+	{
+		rawArg->isRef = false;
+		argValue = *arg;
+	}
+
+	rawArg->type = argValue.type;
+	rawArg->method = nullptr;
+
+	if (argValue.type != nullptr && argValue.type == thread->GetVM()->types.Method)
+	{
+		MethodInst *method = argValue.v.method;
+		rawArg->method = method->method;
+
+		// It should be impossible for an aves.Method to be bound to iself.
+		OVUM_ASSERT(method->instance.v.instance != argValue.v.instance);
+		CaptureArgument(thread, output, &method->instance);
+	}
+}
+
+void StackTraceFormatter::FormatStackTrace(Thread *const thread, StringBuffer &buf, const RawStackTrace *stackTrace)
+{
+	const RawStackFrame *frames = stackTrace->GetFrames();
+	const RawArgument *args = stackTrace->GetArguments();
+
+	for (uint32_t i = 0; i < stackTrace->frameCount; i++)
+		AppendStackFrame(thread, buf, frames + i, args + frames[i].firstArgument);
+}
+
+void StackTraceFormatter::AppendStackFrame(Thread *const thread, StringBuffer &buf, const RawStackFrame *frame, const RawArgument *args)
 {
 	MethodOverload *method = frame->method;
 	Method *group = method->group;
@@ -54,12 +205,12 @@ void StackTraceFormatter::AppendStackFrame(Thread *const thread, StringBuffer &b
 
 	buf.Append('(');
 
-	AppendParameters(thread, buf, frame, method);
+	AppendParameters(thread, buf, method, args);
 
 	buf.Append(')');
 
 	if (method->debugSymbols)
-		AppendSourceLocation(thread, buf, method, ip);
+		AppendSourceLocation(thread, buf, method, frame->offset);
 
 	buf.Append('\n');
 }
@@ -78,10 +229,9 @@ void StackTraceFormatter::AppendMethodName(Thread *const thread, StringBuffer &b
 	buf.Append(method->name);
 }
 
-void StackTraceFormatter::AppendParameters(Thread *const thread, StringBuffer &buf, const StackFrame *frame, MethodOverload *method)
+void StackTraceFormatter::AppendParameters(Thread *const thread, StringBuffer &buf, MethodOverload *method, const RawArgument *args)
 {
 	ovlocals_t paramCount = method->GetEffectiveParamCount();
-	const Value *args = reinterpret_cast<const Value*>(frame) - paramCount;
 
 	for (ovlocals_t i = 0; i < paramCount; i++)
 	{
@@ -95,31 +245,22 @@ void StackTraceFormatter::AppendParameters(Thread *const thread, StringBuffer &b
 
 		buf.Append(2, ": ");
 
-		AppendArgumentType(thread, buf, args + i);
+		args = AppendArgumentType(thread, buf, args);
 	}
 }
 
-void StackTraceFormatter::AppendArgumentType(Thread *const thread, StringBuffer &buf, const Value *arg)
+// Returns a pointer to the argument after 'arg', skipping past the instance
+// type of an aves.Method.
+const RawArgument *StackTraceFormatter::AppendArgumentType(Thread *const thread, StringBuffer &buf, const RawArgument *arg)
 {
-	Value argValue; // Copy, because arg is const
-
-	if (IS_REFERENCE(*arg))
-	{
-		// If the argument is a reference, it must be dereferenced before
-		// we can make use of the type information.
+	if (arg->isRef)
 		buf.Append(4, "ref ");
-		ReadReference(const_cast<Value*>(arg), &argValue);
-	}
-	else
-	{
-		argValue = *arg;
-	}
 
-	Type *type = argValue.type;
+	Type *type = arg->type;
 	if (type == nullptr)
 	{
 		buf.Append(4, "null");
-		return;
+		return arg + 1;
 	}
 
 	// To make the stack trace more readable, we only append the last component
@@ -133,26 +274,22 @@ void StackTraceFormatter::AppendArgumentType(Thread *const thread, StringBuffer
 	// Note that this is applied recursively to the instance type, which means
 	// you can end up with situations like
 	//   Method(this: Method(this: Method(...), ...), ...)
-	//
-	// It should at least be impossible for an aves.Method to be bound to iself.
-	// Otherwise, well, we'll get infinite recursion!
-	if (type == thread->GetVM()->types.Method)
+	if (arg->method != nullptr)
 	{
-		// Append some information about the instance and method group, too.
-		MethodInst *method = argValue.v.method;
-
 		buf.Append(7, "(this: ");
 
-		// It should be impossible for an aves.Method to be bound to iself.
-		OVUM_ASSERT(method->instance.v.instance != argValue.v.instance);
-		AppendArgumentType(thread, buf, &method->instance);
+		const RawArgument *next = AppendArgumentType(thread, buf, arg + 1);
 
 		buf.Append(2, ", ");
 
-		AppendShortMethodName(thread, buf, method->method);
+		AppendShortMethodName(thread, buf, arg->method);
 
 		buf.Append(')');
+
+		return next;
 	}
+
+	return arg + 1;
 }
 
 void StackTraceFormatter::AppendShortMemberName(Thread *const thread, StringBuffer &buf, String *fullName)
@@ -195,10 +332,8 @@ void StackTraceFormatter::AppendShortMethodName(Thread *const thread, StringBuff
 	}
 }
 
-void StackTraceFormatter::AppendSourceLocation(Thread *const thread, StringBuffer &buf, MethodOverload *method, const void *ip)
+void StackTraceFormatter::AppendSourceLocation(Thread *const thread, StringBuffer &buf, MethodOverload *method, uint32_t offset)
 {
-	uint32_t offset = (uint32_t)((uint8_t*)ip - method->entry);
-
 	debug::DebugSymbol *sym = method->debugSymbols->FindSymbol(offset);
 	if (sym == nullptr)
 		return;
@@ -6,6 +6,74 @@
 namespace ovum
 {
 
+// A single stack frame in a RawStackTrace.
+struct RawStackFrame
+{
+	MethodOverload *method;
+	// The offset of the current instruction within the method body. This is
+	// only set if the method has debug symbols; otherwise, it is zero.
+	uint32_t offset;
+	// The index of the frame's first argument within the raw stack trace's
+	// argument list.
+	uint32_t firstArgument;
+};
+
+// The type of an argument in a RawStackFrame. The argument itself is not kept,
+// as that would keep it alive for as long as the stack trace.
+struct RawArgument
+{
+	// The type of the argument, which is null if the argument is null.
+	Type *type;
+	// If the argument is an aves.Method, the method group it refers to. The
+	// next item in the argument list describes the method's instance.
+	Method *method;
+	// True if the argument was passed by reference.
+	bool isRef;
+};
+
+// A stack trace in its raw form: the method and instruction offset of each
+// stack frame, plus the types of the arguments to each method. This is enough
+// to format a stack trace later. A RawStackTrace is laid out in memory as the
+// header below, followed by frameCount RawStackFrames, followed in turn by
+// argumentCount RawArguments.
+//
+// A RawStackTrace contains no managed references, and can be stored in a GC-
+// allocated array (see GC::AllocArray()).
+struct RawStackTrace
+{
+	uint32_t frameCount;
+	uint32_t argumentCount;
+
+	inline RawStackFrame *GetFrames()
+	{
+		return reinterpret_cast<RawStackFrame*>(this + 1);
+	}
+
+	inline const RawStackFrame *GetFrames() const
+	{
+		return reinterpret_cast<const RawStackFrame*>(this + 1);
+	}
+
+	inline RawArgument *GetArguments()
+	{
+		return reinterpret_cast<RawArgument*>(GetFrames() + frameCount);
+	}
+
+	inline const RawArgument *GetArguments() const
+	{
+		return reinterpret_cast<const RawArgument*>(GetFrames() + frameCount);
+	}
+
+	// Gets the total size, in bytes, of a RawStackTrace with the specified
+	// number of frames and arguments.
+	static inline size_t GetSize(uint32_t frameCount, uint32_t argumentCount)
+	{
+		return sizeof(RawStackTrace) +
+			frameCount * sizeof(RawStackFrame) +
+			argumentCount * sizeof(RawArgument);
+	}
+};
+
 // Formats stack traces for a managed thread. Stack traces contain information
 // about (managed) method calls, including:
 //  * The fully qualified name of the method;
@@ -17,6 +85,10 @@ namespace ovum
 // The stack trace is usually returned as a String*, so that it can be passed to
 // client code without the need to convert, but can also be written directly to
 // a StringBuffer.
+//
+// Formatting a stack trace is fairly expensive. When an error is thrown, the
+// thread only captures a RawStackTrace, which is formatted the first time the
+// error's stack trace is requested.
 class StackTraceFormatter
 {
 	// Note: this class only has static members so far.
@@ -28,20 +100,36 @@ public:
 	// Appends a stack trace of the thread's current state to the specified string buffer.
 	static void GetStackTrace(Thread *const thread, StringBuffer &buf);
 
+	// Captures the thread's current state into a new GC-allocated RawStackTrace.
+	static int CaptureStackTrace(Thread *const thread, RawStackTrace **result);
+
+	// Returns a new String* containing the formatted version of a raw stack trace.
+	static String *FormatStackTrace(Thread *const thread, const RawStackTrace *stackTrace);
+
 private:
-	static void AppendStackFrame(Thread *const thread, StringBuffer &buf, const StackFrame *frame, const void *ip);
+	static void CountStackTrace(Thread *const thread, uint32_t &frameCount, uint32_t &argumentCount);
+
+	static uint32_t CountArgument(Thread *const thread, const Value *arg);
+
+	static void FillStackTrace(Thread *const thread, RawStackTrace *stackTrace);
+
+	static void CaptureArgument(Thread *const thread, RawArgument *&output, const Value *arg);
+
+	static void FormatStackTrace(Thread *const thread, StringBuffer &buf, const RawStackTrace *stackTrace);
+
+	static void AppendStackFrame(Thread *const thread, StringBuffer &buf, const RawStackFrame *frame, const RawArgument *args);
 
 	static void AppendMethodName(Thread *const thread, StringBuffer &buf, Method *method);
 
-	static void AppendParameters(Thread *const thread, StringBuffer &buf, const StackFrame *frame, MethodOverload *method);
+	static void AppendParameters(Thread *const thread, StringBuffer &buf, MethodOverload *method, const RawArgument *args);
 
-	static void AppendArgumentType(Thread *const thread, StringBuffer &buf, const Value *arg);
+	static const RawArgument *AppendArgumentType(Thread *const thread, StringBuffer &buf, const RawArgument *arg);
 
 	static void AppendShortMemberName(Thread *const thread, StringBuffer &buf, String *fullName);
 
 	static void AppendShortMethodName(Thread *const thread, StringBuffer &buf, Method *method);
 
-	static void AppendSourceLocation(Thread *const thread, StringBuffer &buf, MethodOverload *method, const void *ip);
+	static void AppendSourceLocation(Thread *const thread, StringBuffer &buf, MethodOverload *method, uint32_t offset);
 
 	static void AppendLineNumber(Thread *const thread, StringBuffer &buf, int32_t line);
 
@@ -1,5 +1,7 @@
 #include "thread.h"
 #include "vm.h"
+#include "profiler.h"
+#include "sampler.h"
 #include "stacktraceformatter.h"
 #include "../object/type.h"
 #include "../object/member.h"
@@ -12,7 +14,7 @@
 #include "../debug/debugsymbols.h"
 #include "../util/stringbuffer.h"
 #include "../res/staticstrings.h"
-#include "../config/defaults.h"
+#include "../jit/jit.h"
 
 namespace ovum
 {
@@ -70,9 +72,10 @@ bool Thread::Init()
 
 bool Thread::InitCallStack()
 {
+	size_t callStackSize = vm->GetCallStackSize();
 	callStack = (unsigned char*)os::VirtualAlloc(
 		nullptr,
-		config::Defaults::CALL_STACK_SIZE + 256,
+		callStackSize + 256,
 		os::VPROT_READ_WRITE
 	);
 	if (callStack == nullptr)
@@ -80,10 +83,10 @@ bool Thread::InitCallStack()
 
 	// Make sure the page following the call stack will cause an instant segfault,
 	// as a very dirty way of signalling a stack overflow.
-	os::VirtualProtect(callStack + config::Defaults::CALL_STACK_SIZE, 256, os::VPROT_NO_ACCESS);
+	os::VirtualProtect(callStack + callStackSize, 256, os::VPROT_NO_ACCESS);
 
 	// The call stack should never be swapped out.
-	os::VirtualLock(callStack, config::Defaults::CALL_STACK_SIZE);
+	os::VirtualLock(callStack, callStackSize);
 
 	// Push a "fake" stack frame onto the stack, so that we can
 	// push values onto the evaluation stack before invoking the
@@ -165,11 +168,11 @@ int Thread::InvokeMember(String *name, ovlocals_t argCount, Value *result)
 	Value *value = currentFrame->evalStack + currentFrame->stackCount - argCount - 1;
 	if (result)
 	{
-		r = InvokeMemberLL(name, argCount, value, result, 0);
+		r = InvokeMemberLL(name, argCount, value, result, 0, nullptr);
 	}
 	else
 	{
-		r = InvokeMemberLL(name, argCount, value, value, 0);
+		r = InvokeMemberLL(name, argCount, value, value, 0, nullptr);
 		if (r == OVUM_SUCCESS)
 			currentFrame->stackCount++;
 	}
@@ -266,11 +269,11 @@ int Thread::LoadMember(String *member, Value *result)
 	Value *inst = currentFrame->evalStack + currentFrame->stackCount - 1;
 	if (result)
 	{
-		r = LoadMemberLL(inst, member, result);
+		r = LoadMemberLL(inst, member, result, nullptr);
 	}
 	else
 	{
-		r = LoadMemberLL(inst, member, inst);
+		r = LoadMemberLL(inst, member, inst, nullptr);
 		if (r == OVUM_SUCCESS)
 			currentFrame->stackCount++;
 	}
@@ -280,7 +283,7 @@ int Thread::LoadMember(String *member, Value *result)
 int Thread::StoreMember(String *member)
 {
 	Value *args = currentFrame->evalStack + currentFrame->stackCount - 2;
-	return StoreMemberLL(args, member);
+	return StoreMemberLL(args, member, nullptr);
 }
 
 int Thread::LoadField(Field *field, Value *result)
@@ -403,6 +406,29 @@ String *Thread::GetStackTrace()
 	return StackTraceFormatter::GetStackTrace(this);
 }
 
+int Thread::GetErrorStackTrace(Value *error, String **result)
+{
+	ErrorInst *err = error->v.error;
+	if (err->stackTrace == nullptr && err->rawStackTrace != nullptr)
+	{
+		String *stackTrace = StackTraceFormatter::FormatStackTrace(
+			this,
+			reinterpret_cast<RawStackTrace*>(err->rawStackTrace)
+		);
+		if (stackTrace == nullptr)
+			return OVUM_ERROR_NO_MEMORY;
+
+		// Allocating the string may have moved the error.
+		err = error->v.error;
+		err->stackTrace = stackTrace;
+		// The raw stack trace is no longer needed; let the GC have it.
+		err->rawStackTrace = nullptr;
+	}
+
+	*result = err->stackTrace;
+	RETURN_SUCCESS;
+}
+
 int Thread::Throw(bool rethrow)
 {
 	if (!rethrow)
@@ -423,9 +449,17 @@ int Thread::Throw(bool rethrow)
 		}
 		currentError = error;
 
-		// Try to initialize the stack trace.
-		if (!(currentError.v.error->stackTrace = GetStackTrace()))
-			return OVUM_ERROR_NO_MEMORY;
+		// Formatting the stack trace is expensive, and many errors are caught
+		// without anyone looking at it, so just record the stack frames here.
+		RawStackTrace *rawStackTrace;
+		int r = StackTraceFormatter::CaptureStackTrace(this, &rawStackTrace);
+		if (r != OVUM_SUCCESS)
+			return r;
+
+		// Capturing the stack trace allocates memory, which may have moved
+		// the error; currentError is updated by the GC.
+		currentError.v.error->stackTrace = nullptr;
+		currentError.v.error->rawStackTrace = rawStackTrace;
 	}
 	OVUM_ASSERT(!IS_NULL(currentError));
 
@@ -552,34 +586,58 @@ void Thread::LeaveUnmanagedRegion()
 
 void Thread::HandleRequest()
 {
-	switch (pendingRequest)
+	ThreadRequest requests = pendingRequest.load(std::memory_order_acquire);
+
+	if ((requests & ThreadRequest::TAKE_SAMPLE) == ThreadRequest::TAKE_SAMPLE)
 	{
-	case ThreadRequest::SUSPEND_FOR_GC:
-		SuspendForGC();
-		break;
+		RemoveRequest(ThreadRequest::TAKE_SAMPLE);
+		if (Sampler *sampler = vm->GetSampler())
+			sampler->RecordSample(this);
 	}
+
+	if ((requests & ThreadRequest::SUSPEND_FOR_GC) == ThreadRequest::SUSPEND_FOR_GC)
+		SuspendForGC();
+}
+
+void Thread::AddRequest(ThreadRequest request)
+{
+	ThreadRequest requests = pendingRequest.load(std::memory_order_relaxed);
+	while (!pendingRequest.compare_exchange_weak(requests, requests | request))
+		;
+}
+
+void Thread::RemoveRequest(ThreadRequest request)
+{
+	ThreadRequest requests = pendingRequest.load(std::memory_order_relaxed);
+	while (!pendingRequest.compare_exchange_weak(requests, requests & static_cast<ThreadRequest>(~(int)request)))
+		;
+}
+
+void Thread::PleaseTakeSample()
+{
+	AddRequest(ThreadRequest::TAKE_SAMPLE);
 }
 
 void Thread::PleaseSuspendForGCAsap()
 {
-	pendingRequest = ThreadRequest::SUSPEND_FOR_GC;
+	AddRequest(ThreadRequest::SUSPEND_FOR_GC);
 }
 
 void Thread::EndGCSuspension()
 {
-	pendingRequest = ThreadRequest::NONE;
+	RemoveRequest(ThreadRequest::SUSPEND_FOR_GC);
 }
 
 void Thread::SuspendForGC()
 {
-	OVUM_ASSERT(pendingRequest == ThreadRequest::SUSPEND_FOR_GC);
+	OVUM_ASSERT((pendingRequest & ThreadRequest::SUSPEND_FOR_GC) == ThreadRequest::SUSPEND_FOR_GC);
 
 	state = ThreadState::SUSPENDED_BY_GC;
 	// Do nothing here. Just wait for the GC to finish.
 	gcCycleSection.Enter();
 
 	state = ThreadState::RUNNING;
-	pendingRequest = ThreadRequest::NONE;
+	RemoveRequest(ThreadRequest::SUSPEND_FOR_GC);
 	// Resume normal operations!
 	gcCycleSection.Leave();
 }
@@ -630,6 +688,8 @@ void Thread::PushStackFrame(ovlocals_t argCount, Value *args, MethodOverload *me
 	}
 
 	currentFrame = newFrame;
+
+	OVUM_PROFILE(vm->GetProfiler()->MethodEntered(method));
 }
 
 int Thread::PrepareVariadicArgs(ovlocals_t argCount, ovlocals_t paramCount, StackFrame *frame)
@@ -705,6 +765,8 @@ int Thread::InvokeMethodOverload(MethodOverload *mo, ovlocals_t argCount, Value
 			r = InitializeMethod(mo);
 			if (r != OVUM_SUCCESS) goto restore;
 		}
+		if (Jit *jit = vm->GetJit())
+			jit->MethodCalled(mo);
 
 		this->ip = mo->entry;
 		entry:
@@ -737,6 +799,7 @@ int Thread::InvokeMethodOverload(MethodOverload *mo, ovlocals_t argCount, Value
 	// restore previous stack frame
 	restore:
 	StackFrame *frame = currentFrame;
+	OVUM_PROFILE(vm->GetProfiler()->MethodLeft(mo));
 	currentFrame = frame->prevFrame;
 	this->ip = frame->prevInstr;
 	if (r == OVUM_SUCCESS)
@@ -751,7 +814,65 @@ int Thread::InvokeMethodOverload(MethodOverload *mo, ovlocals_t argCount, Value
 	return r;
 }
 
+int Thread::EnterMethod(MethodOverload *mo, ovlocals_t argCount, Value *args, Value *result, uint8_t *returnInstr, bool pushReturnValue)
+{
+	OVUM_ASSERT(!mo->IsNative());
+
+	int r;
+	if (mo->IsVariadic())
+	{
+		r = PrepareVariadicArgs(argCount, mo->paramCount, currentFrame);
+		if (r != OVUM_SUCCESS) return r;
+		argCount = mo->paramCount;
+	}
+
+	argCount += mo->instanceCount;
+
+	// Note: this updates currentFrame
+	PushStackFrame(argCount, args, mo);
+
+	if (!mo->IsInitialized())
+	{
+		r = InitializeMethod(mo);
+		if (r != OVUM_SUCCESS)
+		{
+			// Restore the previous stack frame, just like InvokeMethodOverload.
+			StackFrame *frame = currentFrame;
+			OVUM_PROFILE(vm->GetProfiler()->MethodLeft(mo));
+			currentFrame = frame->prevFrame;
+			this->ip = frame->prevInstr;
+			return r;
+		}
+	}
+
+	if (Jit *jit = vm->GetJit())
+		jit->MethodCalled(mo);
+
+	StackFrame *frame = currentFrame;
+	frame->returnInstr = returnInstr;
+	frame->returnValue = result;
+	frame->pushReturnValue = pushReturnValue;
+	this->ip = mo->entry;
+
+	// Evaluate() does this when it is entered; the method is entered here.
+	if (pendingRequest != ThreadRequest::NONE)
+		HandleRequest();
+
+	RETURN_SUCCESS;
+}
+
 int Thread::InvokeLL(ovlocals_t argCount, Value *value, Value *result, uint32_t refSignature)
+{
+	MethodOverload *mo;
+	int r = ResolveInvocationLL(argCount, value, refSignature, &mo);
+	if (r != OVUM_SUCCESS) return r;
+
+	// We've now found a method overload to invoke, omg!
+	// So let's just pass it into InvokeMethodOverload.
+	return InvokeMethodOverload(mo, argCount, value, result);
+}
+
+int Thread::ResolveInvocationLL(ovlocals_t argCount, Value *value, uint32_t refSignature, MethodOverload **result)
 {
 	if (IS_NULL(*value))
 		return ThrowNullReferenceError();
@@ -789,9 +910,9 @@ int Thread::InvokeLL(ovlocals_t argCount, Value *value, Value *result, uint32_t
 	if (refSignature != mo->refSignature &&
 		mo->VerifyRefSignature(refSignature, argCount) != -1)
 		return ThrowNoOverloadError(argCount, strings->error.IncorrectRefness);
-	// We've now found a method overload to invoke, omg!
-	// So let's just pass it into InvokeMethodOverload.
-	return InvokeMethodOverload(mo, argCount, value, result);
+
+	*result = mo;
+	RETURN_SUCCESS;
 }
 
 int Thread::InvokeApplyLL(Value *args, Value *result)
@@ -837,75 +958,81 @@ int Thread::InvokeApplyMethodLL(Method *method, Value *args, Value *result)
 	return InvokeMethodOverload(mo, argsList->length, args, result);
 }
 
-int Thread::InvokeMemberLL(String *name, ovlocals_t argCount, Value *value, Value *result, uint32_t refSignature)
+int Thread::InvokeMemberLL(String *name, ovlocals_t argCount, Value *value, Value *result, uint32_t refSignature, MemberCache *cache)
 {
-	if (IS_NULL(*value))
-		return ThrowNullReferenceError();
+	MethodOverload *mo;
+	int r = ResolveMemberInvocationLL(name, argCount, value, refSignature, cache, &mo);
+	if (r != OVUM_SUCCESS) return r;
+
+	return InvokeMethodOverload(mo, argCount, value, result);
+}
 
+int Thread::ResolveMemberInvocationLL(String *name, ovlocals_t argCount, Value *value, uint32_t refSignature, MemberCache *cache, MethodOverload **result)
+{
+	MemberCache::Entry *entry;
 	Member *member;
-	if (member = value->type->FindMember(name, currentFrame->method))
-	{
-		if (member->IsStatic())
-			return ThrowTypeError(strings->error.CannotAccessStaticMemberThroughInstance);
+	int r = FindInstanceMember(value, name, cache, &entry, &member);
+	if (r != OVUM_SUCCESS) return r;
 
-		switch (member->flags & MemberFlags::KIND_MASK)
+	switch (member->flags & MemberFlags::KIND_MASK)
+	{
+	case MemberFlags::FIELD:
+		((Field*)member)->ReadFieldUnchecked(value, value);
+		return ResolveInvocationLL(argCount, value, refSignature, result);
+	case MemberFlags::PROPERTY:
 		{
-		case MemberFlags::FIELD:
-			((Field*)member)->ReadFieldUnchecked(value, value);
-			return InvokeLL(argCount, value, result, refSignature);
-		case MemberFlags::PROPERTY:
+			Property *property = static_cast<Property*>(member);
+			if (property->defaultGetter == nullptr)
 			{
-				Property *property = static_cast<Property*>(member);
-				if (property->defaultGetter == nullptr)
-				{
-					if (property->getter == nullptr)
-						return ThrowTypeError(strings->error.CannotGetWriteOnlyProperty);
-					else
-						return ThrowNoOverloadError(0);
-				}
-				// Call the property getter!
-				// We do need to copy the instance, because the property getter
-				// would otherwise overwrite the arguments already on the stack.
-				Push(value);
-				int r = InvokeMethodOverload(
-					property->defaultGetter,
-					0,
-					currentFrame->evalStack + currentFrame->stackCount - 1,
-					value
-				);
-				if (r != OVUM_SUCCESS) return r;
-
-				// And then invoke the result of that call (which is in 'value')
-				return InvokeLL(argCount, value, result, refSignature);
+				if (property->getter == nullptr)
+					return ThrowTypeError(strings->error.CannotGetWriteOnlyProperty);
+				else
+					return ThrowNoOverloadError(0);
 			}
-		default: // method
+			// Call the property getter!
+			// We do need to copy the instance, because the property getter
+			// would otherwise overwrite the arguments already on the stack.
+			Push(value);
+			r = InvokeMethodOverload(
+				property->defaultGetter,
+				0,
+				currentFrame->evalStack + currentFrame->stackCount - 1,
+				value
+			);
+			if (r != OVUM_SUCCESS) return r;
+
+			// And then invoke the result of that call (which is in 'value')
+			return ResolveInvocationLL(argCount, value, refSignature, result);
+		}
+	default: // method
+		{
+			// The argument count and ref signature never change for a given
+			// cache, so an overload that was accepted once can be reused.
+			MethodOverload *mo = entry ? entry->overload.load(std::memory_order_acquire) : nullptr;
+			if (mo == nullptr)
 			{
-				MethodOverload *mo = ((Method*)member)->ResolveOverload(argCount);
+				mo = ((Method*)member)->ResolveOverload(argCount);
 				if (!mo)
 					return ThrowNoOverloadError(argCount);
 				if (refSignature != mo->refSignature &&
 					mo->VerifyRefSignature(refSignature, argCount) != -1)
 					return ThrowNoOverloadError(argCount, strings->error.IncorrectRefness);
-				return InvokeMethodOverload(mo, argCount, value, result);
+				if (entry)
+					entry->overload.store(mo, std::memory_order_release);
 			}
+			*result = mo;
+			RETURN_SUCCESS;
 		}
 	}
-
-	return ThrowMemberNotFoundError(name);
 }
 
-int Thread::LoadMemberLL(Value *instance, String *member, Value *result)
+int Thread::LoadMemberLL(Value *instance, String *member, Value *result, MemberCache *cache)
 {
-	if (IS_NULL(*instance))
-		return ThrowNullReferenceError();
-
-	const Member *m = instance->type->FindMember(member, currentFrame->method);
-	if (m == nullptr)
-		return ThrowMemberNotFoundError(member);
-	if (m->IsStatic())
-		return ThrowTypeError(strings->error.CannotAccessStaticMemberThroughInstance);
+	MemberCache::Entry *entry;
+	Member *m;
+	int r = FindInstanceMember(instance, member, cache, &entry, &m);
+	if (r != OVUM_SUCCESS) return r;
 
-	int r = OVUM_SUCCESS;
 	switch (m->flags & MemberFlags::KIND_MASK)
 	{
 	case MemberFlags::FIELD:
@@ -945,18 +1072,13 @@ int Thread::LoadMemberLL(Value *instance, String *member, Value *result)
 	return r;
 }
 
-int Thread::StoreMemberLL(Value *instance, String *member)
+int Thread::StoreMemberLL(Value *instance, String *member, MemberCache *cache)
 {
-	if (IS_NULL(*instance))
-		return ThrowNullReferenceError();
-
-	Member *m = instance->type->FindMember(member, currentFrame->method);
-	if (m == nullptr)
-		return ThrowMemberNotFoundError(member);
-	if (m->IsStatic())
-		return ThrowTypeError(strings->error.CannotAccessStaticMemberThroughInstance);
+	MemberCache::Entry *entry;
+	Member *m;
+	int r = FindInstanceMember(instance, member, cache, &entry, &m);
+	if (r != OVUM_SUCCESS) return r;
 
-	int r = OVUM_SUCCESS;
 	switch (m->flags & MemberFlags::KIND_MASK)
 	{
 	case MemberFlags::FIELD:
@@ -987,6 +1109,35 @@ int Thread::StoreMemberLL(Value *instance, String *member)
 	return r;
 }
 
+int Thread::FindInstanceMember(Value *instance, String *name, MemberCache *cache, MemberCache::Entry **entry, Member **result)
+{
+	if (IS_NULL(*instance))
+		return ThrowNullReferenceError();
+
+	Type *type = instance->type;
+	if (cache != nullptr)
+	{
+		MemberCache::Entry *cached = cache->Find(type);
+		if (cached != nullptr)
+		{
+			*entry = cached;
+			*result = cached->member.load(std::memory_order_relaxed);
+			RETURN_SUCCESS;
+		}
+	}
+
+	Member *member = type->FindMember(name, currentFrame->method);
+	if (member == nullptr)
+		return ThrowMemberNotFoundError(name);
+	if (member->IsStatic())
+		return ThrowTypeError(strings->error.CannotAccessStaticMemberThroughInstance);
+
+	// Only successful lookups are cached; errors are not worth optimizing.
+	*entry = cache != nullptr ? cache->Add(type, member) : nullptr;
+	*result = member;
+	RETURN_SUCCESS;
+}
+
 int Thread::LoadIndexerLL(ovlocals_t argCount, Value *args, Value *result)
 {
 	if (IS_NULL(args[0]))
@@ -1436,6 +1587,11 @@ OVUM_API String *VM_GetStackTrace(ThreadHandle thread)
 	return thread->GetStackTrace();
 }
 
+OVUM_API int VM_GetErrorStackTrace(ThreadHandle thread, Value *error, String **result)
+{
+	return thread->GetErrorStackTrace(error, result);
+}
+
 OVUM_API size_t VM_GetStackDepth(ThreadHandle thread)
 {
 	size_t depth = 0;
@@ -3,19 +3,26 @@
 #include "../vm.h"
 #include "vm.h"
 #include "stackframe.h"
+#include "membercache.h"
 #include "../threading/sync.h"
 #include "../threading/tls.h"
+#include "../gc/allocbuffer.h"
+#include <atomic>
 
 namespace ovum
 {
 
-enum class ThreadRequest
+// Requests are flags, since several can be pending at the same time.
+enum class ThreadRequest : int
 {
 	// The thread has no particular request associated with it.
-	NONE = 0,
+	NONE = 0x00,
 	// The thread should suspend for the GC as soon as it can.
-	SUSPEND_FOR_GC = 1,
+	SUSPEND_FOR_GC = 0x01,
+	// The thread should record a sample of its call stack for the Sampler.
+	TAKE_SAMPLE = 0x02,
 };
+OVUM_ENUM_OPS(ThreadRequest, int);
 
 enum class ThreadState : int
 {
@@ -92,6 +99,13 @@ public:
 		return strings;
 	}
 
+	// Gets the number of times this thread's gen0 allocation buffer has been
+	// refilled.
+	inline uint32_t GetAllocBufferRefillCount() const
+	{
+		return allocBuffer.GetRefillCount();
+	}
+
 	// Pushes a value onto the current evaluation stack.
 	//   value:
 	//     The value to push. This pointer MUST NOT be null.
@@ -438,11 +452,17 @@ public:
 	// details on the format of the result.
 	String *GetStackTrace();
 
+	// Gets the stack trace of the specified aves.Error, formatting it from the
+	// raw stack trace captured by Throw() if that has not been done already.
+	// The result is null if the error has never been thrown.
+	int GetErrorStackTrace(Value *error, String **result);
+
 	// Throws the value on top of the stack. If the value is not an aves.Error,
 	// an Error is first created, and the thrown value put in its 'data' member.
 	//
 	// The thrown Error's stack trace is initialized to the current stack trace,
-	// as returned by GetStackTrace(), unless 'rethrow' is true.
+	// unless 'rethrow' is true. Only the raw stack frames are captured here;
+	// see GetErrorStackTrace().
 	//   rethrow:
 	//     (optional) If true, rethrows 'currentError' instead of taking an error
 	//     from the evaluation stack. Rethrowing can only be performed inside a
@@ -537,11 +557,10 @@ private:
 	StackFrame *currentFrame;
 
 	// If another thread is waiting for this thread to perform a specific action, this field
-	// is set to an appropriate request.
-	//
-	// NOTE: Only one request can be active at a time. Currently this field is only used by
-	// the GC, but that may change in the future.
-	volatile ThreadRequest pendingRequest;
+	// contains the appropriate request flag. The thread checks for requests when it enters
+	// a method, and on backward branches. The field is only modified through AddRequest()
+	// and RemoveRequest().
+	std::atomic<ThreadRequest> pendingRequest;
 
 	// The managed call stack. This grows towards higher addresses as stack frames
 	// are pushed onto it.
@@ -601,6 +620,11 @@ private:
 	// the cycle.
 	CriticalSection gcCycleSection;
 
+	// The thread's gen0 allocation buffer. Small objects are allocated from
+	// this buffer without entering the GC's allocation lock. See AllocBuffer
+	// for details.
+	AllocBuffer allocBuffer;
+
 	Thread(VM *owner);
 
 	// Initializes the thread. Returns true on success.
@@ -615,6 +639,18 @@ private:
 	// If the thread has a pending request (see pendingRequest), handles it.
 	OVUM_NOINLINE void HandleRequest();
 
+	// Adds a request to pendingRequest. This can be called from any thread.
+	void AddRequest(ThreadRequest request);
+
+	// Removes a request from pendingRequest. This can be called from any thread.
+	void RemoveRequest(ThreadRequest request);
+
+	// Tells the thread to record a sample of its call stack the next time it
+	// checks for requests. The sample is passed to the VM's Sampler.
+	//
+	// This method is called by the Sampler's timer thread.
+	void PleaseTakeSample();
+
 	// Tells the thread to suspend itself as soon as possible. When the thread
 	// is in a state that permits the GC to continue, Thread::IsSuspendedForGC()
 	// will return true.
@@ -677,6 +713,13 @@ private:
 	// This method is used when entering a managed call, to execute the method.
 	// It is also used to evaluate finally blocks, which are effectively executed
 	// in their own isolated context.
+	//
+	// Calls from bytecode to bytecode do not recurse into Evaluate(). Instead,
+	// the call instruction pushes a stack frame with EnterMethod(), and the
+	// callee runs in the same loop as the caller. When the callee returns, or
+	// when an error propagates out of it, its stack frame is popped and the
+	// caller resumes. Only the stack frame that was current when Evaluate()
+	// was called makes it return.
 	int Evaluate();
 
 	// Attempts to locate an error handler (catch clause) for a managed error that
@@ -757,6 +800,34 @@ private:
 	//   <0: Pops all the arguments, including the instance (if any).
 	int InvokeMethodOverload(MethodOverload *mo, ovlocals_t argCount, Value *args, Value *result);
 
+	// Enters the specified bytecode method overload, without evaluating it.
+	// This pushes a stack frame for the method, and sets the instruction pointer
+	// to the method's entry address. This is used by Evaluate(), which goes on
+	// to evaluate the method in the same loop as the caller.
+	//
+	// Like InvokeMethodOverload(), this method assumes the caller has performed
+	// the necessary validation. The method overload must not be native.
+	//   mo:
+	//     The method overload to enter.
+	//   argCount:
+	//     The number of arguments to invoke the method overload with, EXCLUDING
+	//     the instance (if any).
+	//   args:
+	//     The arguments to pass into the method, INCLUDING the instance. This is
+	//     assumed to point to the evaluation stack.
+	//   result:
+	//     A location that receives the return value of the call, when the method
+	//     returns.
+	//   returnInstr:
+	//     The address of the instruction at which to resume the caller.
+	//   pushReturnValue:
+	//     True if the return value is pushed onto the caller's evaluation stack.
+	// Stack change:
+	//   <0: Pops all the arguments, including the instance (if any). If the
+	//       method cannot be entered, the caller's stack frame is current again
+	//       when this method returns.
+	int EnterMethod(MethodOverload *mo, ovlocals_t argCount, Value *args, Value *result, uint8_t *returnInstr, bool pushReturnValue);
+
 	// Invokes the specified value. The value to be invoked can be any invokable
 	// value, but typically an aves.Method instance.
 	//   argCount:
@@ -773,6 +844,25 @@ private:
 	//   <0: Pops all the arguments, including the value.
 	int InvokeLL(ovlocals_t argCount, Value *value, Value *result, uint32_t refSignature);
 
+	// Finds the method overload that InvokeLL() would invoke, without invoking
+	// it. The arguments are prepared for InvokeMethodOverload(), which means
+	// that the value may be replaced by the instance of an aves.Method, or be
+	// shifted off the evaluation stack. In either case, value points to the
+	// arguments to pass into the method overload afterwards.
+	//   argCount:
+	//     The total number of arguments to pass to the value, EXCLUDING the
+	//     value itself.
+	//   value:
+	//     A pointer to the value to be invoked. This is assumed to point to the
+	//     evaluation stack. The arguments, if any, immediately follow the value.
+	//   refSignature:
+	//     The ref signature of the arguments. See RefSignature for details.
+	//   result:
+	//     Receives the method overload to invoke.
+	// Stack change:
+	//   0 or -1: May shift the value off the stack.
+	int ResolveInvocationLL(ovlocals_t argCount, Value *value, uint32_t refSignature, MethodOverload **result);
+
 	// Applies a List of arguments to a value. The value to be invoked can be any
 	// invokable value, but typically an aves.Method instance.
 	//   args:
@@ -817,9 +907,35 @@ private:
 	//     A location that receives the return value of the call.
 	//   refSignature:
 	//     The ref signature of the arguments. See RefSignature for details.
+	//   cache:
+	//     The inline cache of the instruction that performs the call, or null
+	//     if the call does not come from an instruction.
 	// Stack change:
 	//   <0: Pops the arguments, including the instance.
-	int InvokeMemberLL(String *name, ovlocals_t argCount, Value *value, Value *result, uint32_t refSignature);
+	int InvokeMemberLL(String *name, ovlocals_t argCount, Value *value, Value *result, uint32_t refSignature, MemberCache *cache);
+
+	// Finds the method overload that InvokeMemberLL() would invoke, without
+	// invoking it. If the member is a field, its value is loaded; if it is a
+	// property, its getter is invoked. The arguments are then prepared for
+	// InvokeMethodOverload(), as by ResolveInvocationLL().
+	//   name:
+	//     The name of the member to invoke.
+	//   argCount:
+	//     The number of arguments to invoke the member with, EXCLUDING the
+	//     instance.
+	//   value:
+	//     The value whose member is to be invoked, immediately followed by the
+	//     arguments. This is assumed to point to the evaluation stack.
+	//   refSignature:
+	//     The ref signature of the arguments. See RefSignature for details.
+	//   cache:
+	//     The inline cache of the instruction that performs the call, or null
+	//     if the call does not come from an instruction.
+	//   result:
+	//     Receives the method overload to invoke.
+	// Stack change:
+	//   0 or -1: May shift the value off the stack.
+	int ResolveMemberInvocationLL(String *name, ovlocals_t argCount, Value *value, uint32_t refSignature, MemberCache *cache, MethodOverload **result);
 
 	// Loads the member with the specified name from a value. Any kind of member
 	// can be loaded. If the member is a property, the getter will be invoked
@@ -834,9 +950,12 @@ private:
 	//     The name of the member to load.
 	//   result:
 	//     A location that receives the member value.
+	//   cache:
+	//     The inline cache of the instruction that loads the member, or null
+	//     if the load does not come from an instruction.
 	// Stack change:
 	//   -1: Pops the instance.
-	int LoadMemberLL(Value *instance, String *member, Value *result);
+	int LoadMemberLL(Value *instance, String *member, Value *result, MemberCache *cache);
 
 	// Stores a value in the member with the specified name. Only fields and
 	// writable properties can be written to. If the member is a property, its
@@ -849,9 +968,29 @@ private:
 	//     value to be stored. This is assumed to point to the evaluation stack.
 	//   member:
 	//     The name of the member to write to.
+	//   cache:
+	//     The inline cache of the instruction that stores the member, or null
+	//     if the store does not come from an instruction.
 	// Stack change:
 	//   -2: Pops the instance and the stored value.
-	int StoreMemberLL(Value *instance, String *member);
+	int StoreMemberLL(Value *instance, String *member, MemberCache *cache);
+
+	// Finds the instance member with the specified name in a value, using an
+	// inline cache if there is one. If the value is null, or if there is no
+	// accessible member with that name, or if the member is static, an error
+	// is thrown.
+	//   instance:
+	//     The value to find a member in.
+	//   name:
+	//     The name of the member to find.
+	//   cache:
+	//     The inline cache to look in, and to add the member to. May be null.
+	//   entry:
+	//     Receives the cache entry that contains the member, or null if the
+	//     member is not in the cache (because cache is null, or it is full).
+	//   result:
+	//     Receives the member.
+	int FindInstanceMember(Value *instance, String *name, MemberCache *cache, MemberCache::Entry **entry, Member **result);
 
 	// Invokes the indexer getter of a value.
 	//   argCount:
@@ -1005,6 +1144,51 @@ private:
 	//   -2: Pops the arguments.
 	int CompareGreaterEqualsLL(Value *args, bool &result);
 
+	// Primitive fast paths! For even more speed.
+	//
+	// The standard library implements the operators of Int, UInt, Real and
+	// Boolean in native code. When both operands are of the same one of these
+	// types, the interpreter evaluates the operator inline instead of pushing
+	// a stack frame for the operator method. The results are identical to
+	// those of the operator methods. Whenever the operator method would throw
+	// an error (on overflow or division by zero, for example), or if the
+	// operands are of any other types, these methods return false and leave
+	// the stack untouched, and the caller must fall back to the general case.
+	//
+	// These methods are defined in thread.primitives.h, which is included by
+	// the interpreter loop and the JIT helpers.
+
+	// Tries to evaluate a binary operator inline.
+	//   args:
+	//     The two operands. This parameter has the same characteristics as
+	//     the 'args' parameter of InvokeOperatorLL().
+	//   op:
+	//     The operator to evaluate.
+	//   result:
+	//     A location that receives the result. This may overlap args.
+	// Stack change:
+	//   -2 if the method returns true; otherwise, 0.
+	inline bool TryPrimitiveOperator(Value *args, Operator op, Value *result);
+
+	// Tries to evaluate the '==' operator inline.
+	//   args:
+	//     The two values to compare.
+	//   result:
+	//     True if args[0] == args[1].
+	// Stack change:
+	//   -2 if the method returns true; otherwise, 0.
+	inline bool TryPrimitiveEquals(Value *args, bool &result);
+
+	// Tries to evaluate the '<=>' operator inline.
+	//   args:
+	//     The two values to compare.
+	//   result:
+	//     Less than zero, zero or greater than zero if args[0] is less than,
+	//     equal to or greater than args[1], respectively.
+	// Stack change:
+	//   -2 if the method returns true; otherwise, 0.
+	inline bool TryPrimitiveCompare(Value *args, int &result);
+
 	// Throws a TypeError with a message about an unimplemented operator.
 	//   op:
 	//     The operator that is missing.
@@ -1063,6 +1247,8 @@ private:
 	friend class VM;
 	friend class Type;
 	friend class MethodInitializer;
+	friend class JitHelpers;
+	friend class Sampler;
 	template<class Visitor>
 	friend class RootSetWalker;
 };
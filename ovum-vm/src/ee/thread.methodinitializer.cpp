@@ -1,7 +1,9 @@
 #include "../vm.h"
 #include "methodinitializer.h"
 #include "methodbuilder.h"
+#include "backgroundinitializer.h"
 #include "../object/type.h"
+#include "../module/module.h"
 
 namespace ovum
 {
@@ -10,6 +12,18 @@ int Thread::InitializeMethod(MethodOverload *method)
 {
 	OVUM_ASSERT(!method->IsInitialized());
 
+	// The background initializer may already be working on the method, so
+	// it has to coordinate the initialization.
+	if (BackgroundInitializer *background = vm->GetBackgroundInitializer())
+		return background->InitializeMethod(this, method);
+
+	if (method->HasDeferredBody())
+	{
+		int r = method->group->declModule->ReadDeferredMethodBody(method);
+		if (r != OVUM_SUCCESS)
+			return r;
+	}
+
 	MethodInitializer initer(this->vm);
 	int r = initer.Initialize(method, this);
 	return r;
@@ -1,4 +1,5 @@
 #include "thread.opcodes.h"
+#include "thread.primitives.h"
 #include "../object/type.h"
 #include "../object/member.h"
 #include "../object/field.h"
@@ -7,6 +8,9 @@
 #include "../gc/gc.h"
 #include "../gc/staticref.h"
 #include "../res/staticstrings.h"
+#include "../jit/jit.h"
+#include "profiler.h"
+#include <cmath>
 
 namespace ovum
 {
@@ -16,8 +20,98 @@ namespace ovum
 // Used in Thread::Evaluate. Semicolon intentionally missing.
 #define CHK(expr) do { if ((retCode = (expr)) != OVUM_SUCCESS) goto exitMethod; } while (0)
 
-#define TARGET(opc) case opc:
-#define NEXT_INSTR() break
+// Used in Thread::Evaluate, by instructions that invoke a method overload. A
+// native method is invoked directly. A bytecode method is entered instead (see
+// Thread::EnterMethod()): its stack frame becomes the current frame, and the
+// loop goes on to evaluate it from the dispatch label, which runs its compiled
+// code if it has any. In both cases, once the method has returned, the caller
+// continues at the instruction after the call, which begins argSize bytes after
+// ip. Semicolon intentionally missing.
+#define CALL_OVERLOAD(mo, argc, argPtr, dest, argSize, pushResult) \
+	do {                                                                          \
+		if ((mo)->IsNative())                                                     \
+		{                                                                         \
+			CHK(InvokeMethodOverload(mo, argc, argPtr, dest));                    \
+			ip += (argSize);                                                      \
+			if (pushResult)                                                       \
+				f->stackCount++;                                                  \
+		}                                                                         \
+		else                                                                      \
+		{                                                                         \
+			CHK(EnterMethod(mo, argc, argPtr, dest, ip + (argSize), pushResult)); \
+			f = currentFrame;                                                     \
+			ip = this->ip;                                                        \
+			goto dispatch;                                                        \
+		}                                                                         \
+	} while (0)
+
+// Thread::Evaluate() can dispatch instructions in one of two ways:
+//
+// * With a switch, which is portable. After each instruction, control goes
+//   back to the top of the loop, which jumps through the switch's table.
+// * Direct threading, using the labels-as-values extension of GCC and Clang.
+//   Each instruction ends by looking up the address of the next instruction's
+//   implementation in a table, and jumping straight to it. This saves a jump
+//   and a bounds check per instruction, and gives the CPU's branch predictor
+//   a separate indirect branch to learn from in each instruction.
+//
+// The switch is still used for the first instruction when threading, so that
+// the instruction implementations are written the same way in both modes.
+// Define OVUM_THREADED_DISPATCH as 0 to use the switch with GCC or Clang.
+#ifndef OVUM_THREADED_DISPATCH
+# if defined(__GNUC__)
+#  define OVUM_THREADED_DISPATCH 1
+# else
+#  define OVUM_THREADED_DISPATCH 0
+# endif
+#endif
+
+#if OVUM_THREADED_DISPATCH
+# define TARGET_LABEL(opc) L_##opc:
+# define NEXT_INSTR() goto *dispatchTable[*ip]
+#else
+# define TARGET_LABEL(opc)
+# define NEXT_INSTR() break
+#endif
+
+// The instruction pointer is kept in the local variable ip, and only written
+// back to this->ip when something may need it: when calling a method (the
+// callee's stack frame records it as the return address), when an error may
+// be thrown (FindErrorHandler() looks for try blocks around it), and when
+// allocating (the GC may produce stack traces). this->ip always points to the
+// start of the current instruction.
+#define SAVE_IP() (this->ip = ip - OPCODE_SIZE)
+
+// When profiling, every instruction is counted before it runs, whichever way
+// it was dispatched.
+#if OVUM_PROFILING
+# define PROFILE_INSTR(opc) profiler->InstructionExecuted(opc);
+#else
+# define PROFILE_INSTR(opc)
+#endif
+
+// Used at the end of a branch instruction, once ip points to the next
+// instruction. Threads check for requests (see Thread::HandleRequest()) when
+// they enter a method, but a loop that makes no calls never does that, so the
+// requests are also checked after every branch with a negative offset, taken
+// or not. Semicolon intentionally missing.
+#define CHECK_BACKWARD_BRANCH(offset) \
+	do {                                                           \
+		if ((offset) < 0 && pendingRequest != ThreadRequest::NONE) \
+		{                                                          \
+			this->ip = ip;                                         \
+			HandleRequest();                                       \
+		}                                                          \
+	} while (0)
+
+// The implementation of an instruction that may call out of the interpreter
+// loop. Saves the instruction pointer.
+#define TARGET(opc) PURE_TARGET(opc) SAVE_IP();
+// The implementation of an instruction that never calls a method, throws an
+// error or allocates memory, and which therefore does not need this->ip to be
+// up to date. An instruction that only calls out in some cases can use this,
+// and call SAVE_IP() only when it needs to.
+#define PURE_TARGET(opc) case opc: TARGET_LABEL(opc) PROFILE_INSTR(opc) ip += OPCODE_SIZE;
 
 #define SET_BOOL(ptarg, bvalue) \
 	{                                       \
@@ -54,26 +148,189 @@ int Thread::Evaluate()
 
 	int retCode;
 
-	StackFrame *const f = currentFrame;
+	// Every instruction starts with the opcode, which is always skipped.
+	static const size_t OPCODE_SIZE = OVUM_ALIGN_TO(sizeof(IntermediateOpcode), oa::ALIGNMENT);
+
+#if OVUM_THREADED_DISPATCH
+	// Indexed by IntermediateOpcode. Gaps in the opcode values are filled
+	// with L_INVALID.
+	static void *const dispatchTable[] = {
+		&&L_OPI_RET,         // 0x00
+		&&L_OPI_RETNULL,     // 0x01
+		&&L_OPI_NOP,         // 0x02
+		&&L_OPI_POP,         // 0x03
+		&&L_OPI_MVLOC_LL,    // 0x04
+		&&L_OPI_MVLOC_SL,    // 0x05
+		&&L_OPI_MVLOC_LS,    // 0x06
+		&&L_OPI_MVLOC_SS,    // 0x07
+		&&L_OPI_LDNULL_L,    // 0x08
+		&&L_OPI_LDNULL_S,    // 0x09
+		&&L_OPI_LDFALSE_L,   // 0x0a
+		&&L_OPI_LDFALSE_S,   // 0x0b
+		&&L_OPI_LDTRUE_L,    // 0x0c
+		&&L_OPI_LDTRUE_S,    // 0x0d
+		&&L_OPI_LDC_I_L,     // 0x0e
+		&&L_OPI_LDC_I_S,     // 0x0f
+		&&L_OPI_LDC_U_L,     // 0x10
+		&&L_OPI_LDC_U_S,     // 0x11
+		&&L_OPI_LDC_R_L,     // 0x12
+		&&L_OPI_LDC_R_S,     // 0x13
+		&&L_OPI_LDSTR_L,     // 0x14
+		&&L_OPI_LDSTR_S,     // 0x15
+		&&L_OPI_LDARGC_L,    // 0x16
+		&&L_OPI_LDARGC_S,    // 0x17
+		&&L_OPI_LDENUM_L,    // 0x18
+		&&L_OPI_LDENUM_S,    // 0x19
+		&&L_OPI_NEWOBJ_L,    // 0x1a
+		&&L_OPI_NEWOBJ_S,    // 0x1b
+		&&L_OPI_LIST_L,      // 0x1c
+		&&L_OPI_LIST_S,      // 0x1d
+		&&L_OPI_HASH_L,      // 0x1e
+		&&L_OPI_HASH_S,      // 0x1f
+		&&L_OPI_LDFLD_L,     // 0x20
+		&&L_OPI_LDFLD_S,     // 0x21
+		&&L_OPI_LDSFLD_L,    // 0x22
+		&&L_OPI_LDSFLD_S,    // 0x23
+		&&L_OPI_LDMEM_L,     // 0x24
+		&&L_OPI_LDMEM_S,     // 0x25
+		&&L_OPI_LDITER_L,    // 0x26
+		&&L_OPI_LDITER_S,    // 0x27
+		&&L_OPI_LDTYPE_L,    // 0x28
+		&&L_OPI_LDTYPE_S,    // 0x29
+		&&L_OPI_LDIDX_L,     // 0x2a
+		&&L_OPI_LDIDX_S,     // 0x2b
+		&&L_OPI_LDSFN_L,     // 0x2c
+		&&L_OPI_LDSFN_S,     // 0x2d
+		&&L_OPI_LDTYPETKN_L, // 0x2e
+		&&L_OPI_LDTYPETKN_S, // 0x2f
+		&&L_OPI_CALL_L,      // 0x30
+		&&L_OPI_CALL_S,      // 0x31
+		&&L_OPI_SCALL_L,     // 0x32
+		&&L_OPI_SCALL_S,     // 0x33
+		&&L_OPI_APPLY_L,     // 0x34
+		&&L_OPI_APPLY_S,     // 0x35
+		&&L_OPI_SAPPLY_L,    // 0x36
+		&&L_OPI_SAPPLY_S,    // 0x37
+		&&L_OPI_BR,          // 0x38
+		&&L_OPI_LEAVE,       // 0x39
+		&&L_OPI_BRNULL_L,    // 0x3a
+		&&L_OPI_BRNULL_S,    // 0x3b
+		&&L_OPI_BRINST_L,    // 0x3c
+		&&L_OPI_BRINST_S,    // 0x3d
+		&&L_OPI_BRFALSE_L,   // 0x3e
+		&&L_OPI_BRFALSE_S,   // 0x3f
+		&&L_OPI_BRTRUE_L,    // 0x40
+		&&L_OPI_BRTRUE_S,    // 0x41
+		&&L_OPI_BRTYPE_L,    // 0x42
+		&&L_OPI_BRTYPE_S,    // 0x43
+		&&L_OPI_SWITCH_L,    // 0x44
+		&&L_OPI_SWITCH_S,    // 0x45
+		&&L_OPI_BRREF,       // 0x46
+		&&L_OPI_BRNREF,      // 0x47
+		&&L_OPI_OPERATOR_L,  // 0x48
+		&&L_OPI_OPERATOR_S,  // 0x49
+		&&L_OPI_EQ_L,        // 0x4a
+		&&L_OPI_EQ_S,        // 0x4b
+		&&L_OPI_CMP_L,       // 0x4c
+		&&L_OPI_CMP_S,       // 0x4d
+		&&L_OPI_LT_L,        // 0x4e
+		&&L_OPI_LT_S,        // 0x4f
+		&&L_OPI_GT_L,        // 0x50
+		&&L_OPI_GT_S,        // 0x51
+		&&L_OPI_LTE_L,       // 0x52
+		&&L_OPI_LTE_S,       // 0x53
+		&&L_OPI_GTE_L,       // 0x54
+		&&L_OPI_GTE_S,       // 0x55
+		&&L_OPI_CONCAT_L,    // 0x56
+		&&L_OPI_CONCAT_S,    // 0x57
+		&&L_OPI_CALLMEM_L,   // 0x58
+		&&L_OPI_CALLMEM_S,   // 0x59
+		&&L_OPI_STSFLD_L,    // 0x5a
+		&&L_OPI_STSFLD_S,    // 0x5b
+		&&L_OPI_STFLD,       // 0x5c
+		&&L_OPI_STMEM,       // 0x5d
+		&&L_OPI_STIDX,       // 0x5e
+		&&L_OPI_THROW,       // 0x5f
+		&&L_OPI_RETHROW,     // 0x60
+		&&L_OPI_ENDFINALLY,  // 0x61
+		&&L_OPI_LDFLDFAST_L, // 0x62
+		&&L_OPI_LDFLDFAST_S, // 0x63
+		&&L_OPI_STFLDFAST,   // 0x64
+		&&L_OPI_BREQ,        // 0x65
+		&&L_OPI_BRNEQ,       // 0x66
+		&&L_OPI_BRLT,        // 0x67
+		&&L_OPI_BRGT,        // 0x68
+		&&L_OPI_BRLTE,       // 0x69
+		&&L_OPI_BRGTE,       // 0x6a
+		&&L_OPI_LDLOCREF,    // 0x6b
+		&&L_OPI_LDMEMREF_L,  // 0x6c
+		&&L_OPI_LDMEMREF_S,  // 0x6d
+		&&L_OPI_LDFLDREF_L,  // 0x6e
+		&&L_OPI_LDFLDREF_S,  // 0x6f
+		&&L_OPI_LDSFLDREF,   // 0x70
+		&&L_INVALID,         // 0x71
+		&&L_OPI_MVLOC_RL,    // 0x72
+		&&L_OPI_MVLOC_RS,    // 0x73
+		&&L_OPI_MVLOC_LR,    // 0x74
+		&&L_OPI_MVLOC_SR,    // 0x75
+		&&L_OPI_CALLR_L,     // 0x76
+		&&L_OPI_CALLR_S,     // 0x77
+		&&L_OPI_CALLMEMR_L,  // 0x78
+		&&L_OPI_CALLMEMR_S,  // 0x79
+		&&L_OPI_LDLOCFLD_L,  // 0x7a
+		&&L_OPI_LDLOCFLD_S,  // 0x7b
+		&&L_OPI_OPERSC_L,    // 0x7c
+		&&L_OPI_OPERSC_S,    // 0x7d
+		&&L_OPI_OPERLC_L,    // 0x7e
+		&&L_OPI_OPERLC_S,    // 0x7f
+		&&L_OPI_UNARYOP_L,   // 0x80
+		&&L_OPI_UNARYOP_S    // 0x81
+	};
+	static_assert(
+		sizeof(dispatchTable) / sizeof(dispatchTable[0]) == OPI_UNARYOP_S + 1,
+		"dispatchTable does not match IntermediateOpcode"
+	);
+#endif
+
+#if OVUM_PROFILING
+	Profiler *const profiler = vm->GetProfiler();
+#endif
+
+	// The stack frame of the method that is being evaluated. This changes when
+	// a bytecode method is entered (see CALL_OVERLOAD), and when it returns.
+	StackFrame *f = currentFrame;
+	// When the method of this frame returns, so does Evaluate().
+	StackFrame *const entryFrame = f;
 	// this->ip has been set to the entry address
 	uint8_t *ip = this->ip;
 
+dispatch:
+	// If the method has been compiled, run the compiled code. It returns here
+	// when it reaches an instruction that leaves the method, which is then
+	// evaluated below, or when it enters another method.
+	if (JitCode *code = f->method->jitCode.load(std::memory_order_acquire))
+	{
+		StackFrame *const jitFrame = f;
+		CHK(code->entryPoint(this, f, ip));
+		f = currentFrame;
+		ip = this->ip;
+		if (f != jitFrame)
+			goto dispatch;
+	}
+
 	while (true)
 	{
-		this->ip = ip;
 		IntermediateOpcode opc = static_cast<IntermediateOpcode>(*ip);
-		// Always skip the opcode
-		ip += OVUM_ALIGN_TO(sizeof(IntermediateOpcode), oa::ALIGNMENT);
 		switch (opc)
 		{
-		TARGET(OPI_RET)
+		PURE_TARGET(OPI_RET)
 			{
 				OVUM_ASSERT(f->stackCount == 1);
 			}
 			retCode = OVUM_SUCCESS;
 			goto ret;
 
-		TARGET(OPI_RETNULL)
+		PURE_TARGET(OPI_RETNULL)
 			{
 				OVUM_ASSERT(f->stackCount == 0);
 				f->evalStack->type = nullptr;
@@ -82,11 +339,11 @@ int Thread::Evaluate()
 			retCode = OVUM_SUCCESS;
 			goto ret;
 
-		TARGET(OPI_NOP)
+		PURE_TARGET(OPI_NOP)
 			// Really, do nothing!
 			NEXT_INSTR();
 
-		TARGET(OPI_POP)
+		PURE_TARGET(OPI_POP)
 			{
 				// pop just decrements the stack height
 				f->stackCount--;
@@ -94,14 +351,14 @@ int Thread::Evaluate()
 			NEXT_INSTR();
 
 		// mvloc
-		TARGET(OPI_MVLOC_LL) // local to local
+		PURE_TARGET(OPI_MVLOC_LL) // local to local
 			{
 				OPC_ARGS(oa::TwoLocals);
 				*args->Dest(f) = *args->Source(f);
 				ip += oa::TWO_LOCALS_SIZE;
 			}
 			NEXT_INSTR();
-		TARGET(OPI_MVLOC_SL) // stack to local
+		PURE_TARGET(OPI_MVLOC_SL) // stack to local
 			{
 				OPC_ARGS(oa::TwoLocals);
 				*args->Dest(f) = *args->Source(f);
@@ -109,7 +366,7 @@ int Thread::Evaluate()
 				f->stackCount--;
 			}
 			NEXT_INSTR();
-		TARGET(OPI_MVLOC_LS) // local to stack
+		PURE_TARGET(OPI_MVLOC_LS) // local to stack
 			{
 				OPC_ARGS(oa::TwoLocals);
 				*args->Dest(f) = *args->Source(f);
@@ -117,7 +374,7 @@ int Thread::Evaluate()
 				f->stackCount++;
 			}
 			NEXT_INSTR();
-		TARGET(OPI_MVLOC_SS) // stack to stack (shouldn't really be used!)
+		PURE_TARGET(OPI_MVLOC_SS) // stack to stack (shouldn't really be used!)
 			{
 				OPC_ARGS(oa::TwoLocals);
 				*args->Dest(f) = *args->Source(f);
@@ -126,14 +383,14 @@ int Thread::Evaluate()
 			NEXT_INSTR();
 
 		// ldnull
-		TARGET(OPI_LDNULL_L)
+		PURE_TARGET(OPI_LDNULL_L)
 			{
 				OPC_ARGS(oa::OneLocal);
 				args->Local(f)->type = nullptr;
 				ip += oa::ONE_LOCAL_SIZE;
 			}
 			NEXT_INSTR();
-		TARGET(OPI_LDNULL_S)
+		PURE_TARGET(OPI_LDNULL_S)
 			{
 				OPC_ARGS(oa::OneLocal);
 				args->Local(f)->type = nullptr;
@@ -143,14 +400,14 @@ int Thread::Evaluate()
 			NEXT_INSTR();
 
 		// ldfalse
-		TARGET(OPI_LDFALSE_L)
+		PURE_TARGET(OPI_LDFALSE_L)
 			{
 				OPC_ARGS(oa::OneLocal);
 				SET_BOOL(args->Local(f), false);
 				ip += oa::ONE_LOCAL_SIZE;
 			}
 			NEXT_INSTR();
-		TARGET(OPI_LDFALSE_S)
+		PURE_TARGET(OPI_LDFALSE_S)
 			{
 				OPC_ARGS(oa::OneLocal);
 				SET_BOOL(args->Local(f), false);
@@ -160,14 +417,14 @@ int Thread::Evaluate()
 			NEXT_INSTR();
 
 		// ldtrue
-		TARGET(OPI_LDTRUE_L)
+		PURE_TARGET(OPI_LDTRUE_L)
 			{
 				OPC_ARGS(oa::OneLocal);
 				SET_BOOL(args->Local(f), true);
 				ip += oa::ONE_LOCAL_SIZE;
 			}
 			NEXT_INSTR();
-		TARGET(OPI_LDTRUE_S)
+		PURE_TARGET(OPI_LDTRUE_S)
 			{
 				OPC_ARGS(oa::OneLocal);
 				SET_BOOL(args->Local(f), true);
@@ -177,14 +434,14 @@ int Thread::Evaluate()
 			NEXT_INSTR();
 
 		// ldc.i
-		TARGET(OPI_LDC_I_L)
+		PURE_TARGET(OPI_LDC_I_L)
 			{
 				OPC_ARGS(oa::LocalAndValue<int64_t>);
 				SET_INT(args->Local(f), args->value);
 				ip += oa::LOCAL_AND_VALUE<int64_t>::SIZE;
 			}
 			NEXT_INSTR();
-		TARGET(OPI_LDC_I_S)
+		PURE_TARGET(OPI_LDC_I_S)
 			{
 				OPC_ARGS(oa::LocalAndValue<int64_t>);
 				SET_INT(args->Local(f), args->value);
@@ -194,14 +451,14 @@ int Thread::Evaluate()
 			NEXT_INSTR();
 
 		// ldc.u
-		TARGET(OPI_LDC_U_L)
+		PURE_TARGET(OPI_LDC_U_L)
 			{
 				OPC_ARGS(oa::LocalAndValue<uint64_t>);
 				SET_UINT(args->Local(f), args->value);
 				ip += oa::LOCAL_AND_VALUE<uint64_t>::SIZE;
 			}
 			NEXT_INSTR();
-		TARGET(OPI_LDC_U_S)
+		PURE_TARGET(OPI_LDC_U_S)
 			{
 				OPC_ARGS(oa::LocalAndValue<uint64_t>);
 				SET_UINT(args->Local(f), args->value);
@@ -211,14 +468,14 @@ int Thread::Evaluate()
 			NEXT_INSTR();
 
 		// ldc.r
-		TARGET(OPI_LDC_R_L)
+		PURE_TARGET(OPI_LDC_R_L)
 			{
 				OPC_ARGS(oa::LocalAndValue<double>);
 				SET_REAL(args->Local(f), args->value);
 				ip += oa::LOCAL_AND_VALUE<double>::SIZE;
 			}
 			NEXT_INSTR();
-		TARGET(OPI_LDC_R_S)
+		PURE_TARGET(OPI_LDC_R_S)
 			{
 				OPC_ARGS(oa::LocalAndValue<double>);
 				SET_REAL(args->Local(f), args->value);
@@ -228,14 +485,14 @@ int Thread::Evaluate()
 			NEXT_INSTR();
 
 		// ldstr
-		TARGET(OPI_LDSTR_L)
+		PURE_TARGET(OPI_LDSTR_L)
 			{
 				OPC_ARGS(oa::LocalAndValue<String*>);
 				SET_STRING(args->Local(f), args->value);
 				ip += oa::LOCAL_AND_VALUE<String*>::SIZE;
 			}
 			NEXT_INSTR();
-		TARGET(OPI_LDSTR_S)
+		PURE_TARGET(OPI_LDSTR_S)
 			{
 				OPC_ARGS(oa::LocalAndValue<String*>);
 				SET_STRING(args->Local(f), args->value);
@@ -245,14 +502,14 @@ int Thread::Evaluate()
 			NEXT_INSTR();
 
 		// ldargc
-		TARGET(OPI_LDARGC_L)
+		PURE_TARGET(OPI_LDARGC_L)
 			{
 				OPC_ARGS(oa::OneLocal);
 				SET_INT(args->Local(f), f->argc);
 				ip += oa::ONE_LOCAL_SIZE;
 			}
 			NEXT_INSTR();
-		TARGET(OPI_LDARGC_S)
+		PURE_TARGET(OPI_LDARGC_S)
 			{
 				OPC_ARGS(oa::OneLocal);
 				SET_INT(args->Local(f), f->argc);
@@ -262,7 +519,7 @@ int Thread::Evaluate()
 			NEXT_INSTR();
 
 		// ldenum
-		TARGET(OPI_LDENUM_L)
+		PURE_TARGET(OPI_LDENUM_L)
 			{
 				OPC_ARGS(oa::LoadEnum);
 				Value *const dest = args->Dest(f);
@@ -271,7 +528,7 @@ int Thread::Evaluate()
 				ip += oa::LOAD_ENUM_SIZE;
 			}
 			NEXT_INSTR();
-		TARGET(OPI_LDENUM_S)
+		PURE_TARGET(OPI_LDENUM_S)
 			{
 				OPC_ARGS(oa::LoadEnum);
 				Value *const dest = args->Dest(f);
@@ -371,14 +628,14 @@ int Thread::Evaluate()
 			NEXT_INSTR();
 
 		// ldsfld
-		TARGET(OPI_LDSFLD_L)
+		PURE_TARGET(OPI_LDSFLD_L)
 			{
 				OPC_ARGS(oa::LocalAndValue<Field*>);
 				args->value->staticValue->Read(args->Local(f));
 				ip += oa::LOCAL_AND_VALUE<Field*>::SIZE;
 			}
 			NEXT_INSTR();
-		TARGET(OPI_LDSFLD_S)
+		PURE_TARGET(OPI_LDSFLD_S)
 			{
 				OPC_ARGS(oa::LocalAndValue<Field*>);
 				args->value->staticValue->Read(args->Local(f));
@@ -390,17 +647,17 @@ int Thread::Evaluate()
 		// ldmem
 		TARGET(OPI_LDMEM_L)
 			{
-				OPC_ARGS(oa::TwoLocalsAndValue<String*>);
-				CHK(LoadMemberLL(args->Source(f), args->value, args->Dest(f)));
-				ip += oa::TWO_LOCALS_AND_VALUE<String*>::SIZE;
+				OPC_ARGS(oa::LoadMember);
+				CHK(LoadMemberLL(args->Source(f), args->member, args->Dest(f), &args->cache));
+				ip += oa::LOAD_MEMBER_SIZE;
 				// LoadMemberLL pops the instance
 			}
 			NEXT_INSTR();
 		TARGET(OPI_LDMEM_S)
 			{
-				OPC_ARGS(oa::TwoLocalsAndValue<String*>);
-				CHK(LoadMemberLL(args->Source(f), args->value, args->Dest(f)));
-				ip += oa::TWO_LOCALS_AND_VALUE<String*>::SIZE;
+				OPC_ARGS(oa::LoadMember);
+				CHK(LoadMemberLL(args->Source(f), args->member, args->Dest(f), &args->cache));
+				ip += oa::LOAD_MEMBER_SIZE;
 				// LoadMemberLL pops the instance
 				f->stackCount++;
 			}
@@ -410,18 +667,19 @@ int Thread::Evaluate()
 		TARGET(OPI_LDITER_L)
 			{
 				OPC_ARGS(oa::TwoLocals);
-				CHK(InvokeMemberLL(strings->members.iter_, 0, args->Source(f), args->Dest(f), 0));
-				// InvokeMemberLL pops the instance and all 0 of the arguments
-				ip += oa::TWO_LOCALS_SIZE;
+				MethodOverload *mo;
+				CHK(ResolveMemberInvocationLL(strings->members.iter_, 0, args->Source(f), 0, nullptr, &mo));
+				// The call pops the instance and all 0 of the arguments
+				CALL_OVERLOAD(mo, 0, args->Source(f), args->Dest(f), oa::TWO_LOCALS_SIZE, false);
 			}
 			NEXT_INSTR();
 		TARGET(OPI_LDITER_S)
 			{
 				OPC_ARGS(oa::TwoLocals);
-				CHK(InvokeMemberLL(strings->members.iter_, 0, args->Source(f), args->Dest(f), 0));
-				// InvokeMemberLL pops the instance and all 0 of the arguments
-				ip += oa::TWO_LOCALS_SIZE;
-				f->stackCount++;
+				MethodOverload *mo;
+				CHK(ResolveMemberInvocationLL(strings->members.iter_, 0, args->Source(f), 0, nullptr, &mo));
+				// The call pops the instance and all 0 of the arguments
+				CALL_OVERLOAD(mo, 0, args->Source(f), args->Dest(f), oa::TWO_LOCALS_SIZE, true);
 			}
 			NEXT_INSTR();
 
@@ -522,18 +780,19 @@ int Thread::Evaluate()
 		TARGET(OPI_CALL_L)
 			{
 				OPC_ARGS(oa::Call);
-				CHK(InvokeLL(args->argc, args->Args(f), args->Dest(f), 0));
-				ip += oa::CALL_SIZE;
-				// InvokeLL pops the arguments
+				MethodOverload *mo;
+				CHK(ResolveInvocationLL(args->argc, args->Args(f), 0, &mo));
+				// The call pops the arguments
+				CALL_OVERLOAD(mo, args->argc, args->Args(f), args->Dest(f), oa::CALL_SIZE, false);
 			}
 			NEXT_INSTR();
 		TARGET(OPI_CALL_S)
 			{
 				OPC_ARGS(oa::Call);
-				CHK(InvokeLL(args->argc, args->Args(f), args->Dest(f), 0));
-				ip += oa::CALL_SIZE;
-				// InvokeLL pops the arguments
-				f->stackCount++;
+				MethodOverload *mo;
+				CHK(ResolveInvocationLL(args->argc, args->Args(f), 0, &mo));
+				// The call pops the arguments
+				CALL_OVERLOAD(mo, args->argc, args->Args(f), args->Dest(f), oa::CALL_SIZE, true);
 			}
 			NEXT_INSTR();
 
@@ -541,16 +800,13 @@ int Thread::Evaluate()
 		TARGET(OPI_SCALL_L)
 			{
 				OPC_ARGS(oa::StaticCall);
-				CHK(InvokeMethodOverload(args->method, args->argc, args->Args(f), args->Dest(f)));
-				ip += oa::STATIC_CALL_SIZE;
+				CALL_OVERLOAD(args->method, args->argc, args->Args(f), args->Dest(f), oa::STATIC_CALL_SIZE, false);
 			}
 			NEXT_INSTR();
 		TARGET(OPI_SCALL_S)
 			{
 				OPC_ARGS(oa::StaticCall);
-				CHK(InvokeMethodOverload(args->method, args->argc, args->Args(f), args->Dest(f)));
-				ip += oa::STATIC_CALL_SIZE;
-				f->stackCount++;
+				CALL_OVERLOAD(args->method, args->argc, args->Args(f), args->Dest(f), oa::STATIC_CALL_SIZE, true);
 			}
 			NEXT_INSTR();
 
@@ -593,11 +849,12 @@ int Thread::Evaluate()
 			NEXT_INSTR();
 
 		// br
-		TARGET(OPI_BR)
+		PURE_TARGET(OPI_BR)
 			{
 				OPC_ARGS(oa::Branch);
 				ip += args->offset;
 				ip += oa::BRANCH_SIZE;
+				CHECK_BACKWARD_BRANCH(args->offset);
 			}
 			NEXT_INSTR();
 
@@ -608,101 +865,112 @@ int Thread::Evaluate()
 				CHK(EvaluateLeave(f, args->offset));
 				ip += args->offset;
 				ip += oa::BRANCH_SIZE;
+				CHECK_BACKWARD_BRANCH(args->offset);
 			}
 			NEXT_INSTR();
 
 		// brnull
-		TARGET(OPI_BRNULL_L)
+		PURE_TARGET(OPI_BRNULL_L)
 			{
 				OPC_ARGS(oa::ConditionalBranch);
 				if (args->Value(f)->type == nullptr)
 					ip += args->offset;
 				ip += oa::CONDITIONAL_BRANCH_SIZE;
+				CHECK_BACKWARD_BRANCH(args->offset);
 			}
 			NEXT_INSTR();
-		TARGET(OPI_BRNULL_S)
+		PURE_TARGET(OPI_BRNULL_S)
 			{
 				OPC_ARGS(oa::ConditionalBranch);
 				if (args->Value(f)->type == nullptr)
 					ip += args->offset;
 				ip += oa::CONDITIONAL_BRANCH_SIZE;
 				f->stackCount--;
+				CHECK_BACKWARD_BRANCH(args->offset);
 			}
 			NEXT_INSTR();
 
 		// brinst
-		TARGET(OPI_BRINST_L)
+		PURE_TARGET(OPI_BRINST_L)
 			{
 				OPC_ARGS(oa::ConditionalBranch);
 				if (args->Value(f)->type != nullptr)
 					ip += args->offset;
 				ip += oa::CONDITIONAL_BRANCH_SIZE;
+				CHECK_BACKWARD_BRANCH(args->offset);
 			}
 			NEXT_INSTR();
-		TARGET(OPI_BRINST_S)
+		PURE_TARGET(OPI_BRINST_S)
 			{
 				OPC_ARGS(oa::ConditionalBranch);
 				if (args->Value(f)->type != nullptr)
 					ip += args->offset;
 				ip += oa::CONDITIONAL_BRANCH_SIZE;
 				f->stackCount--;
+				CHECK_BACKWARD_BRANCH(args->offset);
 			}
 			NEXT_INSTR();
 
 		// brfalse
-		TARGET(OPI_BRFALSE_L)
+		PURE_TARGET(OPI_BRFALSE_L)
 			{
 				OPC_ARGS(oa::ConditionalBranch);
 				if (IsFalse_(args->Value(f)))
 					ip += args->offset;
 				ip += oa::CONDITIONAL_BRANCH_SIZE;
+				CHECK_BACKWARD_BRANCH(args->offset);
 			}
 			NEXT_INSTR();
-		TARGET(OPI_BRFALSE_S)
+		PURE_TARGET(OPI_BRFALSE_S)
 			{
 				OPC_ARGS(oa::ConditionalBranch);
 				if (IsFalse_(args->Value(f)))
 					ip += args->offset;
 				ip += oa::CONDITIONAL_BRANCH_SIZE;
 				f->stackCount--;
+				CHECK_BACKWARD_BRANCH(args->offset);
 			}
 			NEXT_INSTR();
 
 		// brtrue
-		TARGET(OPI_BRTRUE_L)
+		PURE_TARGET(OPI_BRTRUE_L)
 			{
 				OPC_ARGS(oa::ConditionalBranch);
 				if (IsTrue_(args->Value(f)))
 					ip += args->offset;
 				ip += oa::CONDITIONAL_BRANCH_SIZE;
+				CHECK_BACKWARD_BRANCH(args->offset);
 			}
 			NEXT_INSTR();
-		TARGET(OPI_BRTRUE_S)
+		PURE_TARGET(OPI_BRTRUE_S)
 			{
 				OPC_ARGS(oa::ConditionalBranch);
 				if (IsTrue_(args->Value(f)))
 					ip += args->offset;
 				ip += oa::CONDITIONAL_BRANCH_SIZE;
 				f->stackCount--;
+				CHECK_BACKWARD_BRANCH(args->offset);
 			}
 			NEXT_INSTR();
 
 		// brtype
-		TARGET(OPI_BRTYPE_L)
+		PURE_TARGET(OPI_BRTYPE_L)
 			{
 				OPC_ARGS(oa::BranchIfType);
 				if (Type::ValueIsType(args->Value(f), args->type))
 					ip += args->offset;
 				ip += oa::BRANCH_IF_TYPE_SIZE;
+				CHECK_BACKWARD_BRANCH(args->offset);
 			}
 			NEXT_INSTR();
-		TARGET(OPI_BRTYPE_S)
+		PURE_TARGET(OPI_BRTYPE_S)
 			{
 				OPC_ARGS(oa::BranchIfType);
 				if (Type::ValueIsType(args->Value(f), args->type))
 					ip += args->offset;
 				ip += oa::BRANCH_IF_TYPE_SIZE;
 				f->stackCount--;
+				CHECK_BACKWARD_BRANCH(args->offset);
 			}
 			NEXT_INSTR();
 
@@ -712,12 +980,20 @@ int Thread::Evaluate()
 				OPC_ARGS(oa::Switch);
 				Value *const value = args->Value(f);
 				if (value->type != vm->types.Int)
-					return ThrowTypeError();
+				{
+					// Not a plain return: the error may have to unwind frames
+					// entered by CALL_OVERLOAD.
+					retCode = ThrowTypeError();
+					goto exitMethod;
+				}
 
+				int32_t offset = 0;
 				if (value->v.integer >= 0 && value->v.integer < args->count)
-					ip += (&args->firstOffset)[(size_t)value->v.integer];
+					offset = (&args->firstOffset)[(size_t)value->v.integer];
 
+				ip += offset;
 				ip += oa::SWITCH_SIZE(args->count);
+				CHECK_BACKWARD_BRANCH(offset);
 			}
 			NEXT_INSTR();
 		TARGET(OPI_SWITCH_S)
@@ -725,18 +1001,26 @@ int Thread::Evaluate()
 				OPC_ARGS(oa::Switch);
 				Value *const value = args->Value(f);
 				if (value->type != vm->types.Int)
-					return ThrowTypeError();
+				{
+					// Not a plain return: the error may have to unwind frames
+					// entered by CALL_OVERLOAD.
+					retCode = ThrowTypeError();
+					goto exitMethod;
+				}
 
+				int32_t offset = 0;
 				if (value->v.integer >= 0 && value->v.integer < args->count)
-					ip += (&args->firstOffset)[(size_t)value->v.integer];
+					offset = (&args->firstOffset)[(size_t)value->v.integer];
 
+				ip += offset;
 				ip += oa::SWITCH_SIZE(args->count);
 				f->stackCount--;
+				CHECK_BACKWARD_BRANCH(offset);
 			}
 			NEXT_INSTR();
 
 		// brref
-		TARGET(OPI_BRREF)
+		PURE_TARGET(OPI_BRREF)
 			{
 				OPC_ARGS(oa::ConditionalBranch);
 				Value *const ops = args->Value(f);
@@ -746,11 +1030,12 @@ int Thread::Evaluate()
 
 				ip += oa::CONDITIONAL_BRANCH_SIZE;
 				f->stackCount -= 2;
+				CHECK_BACKWARD_BRANCH(args->offset);
 			}
 			NEXT_INSTR();
 
 		// brnref
-		TARGET(OPI_BRNREF)
+		PURE_TARGET(OPI_BRNREF)
 			{
 				OPC_ARGS(oa::ConditionalBranch);
 				Value *const ops = args->Value(f);
@@ -760,158 +1045,245 @@ int Thread::Evaluate()
 
 				ip += oa::CONDITIONAL_BRANCH_SIZE;
 				f->stackCount -= 2;
+				CHECK_BACKWARD_BRANCH(args->offset);
 			}
 			NEXT_INSTR();
 
 		// operator
-		TARGET(OPI_OPERATOR_L)
+		PURE_TARGET(OPI_OPERATOR_L)
 			{
 				OPC_ARGS(oa::TwoLocalsAndValue<Operator>);
-				CHK(InvokeOperatorLL(args->Source(f), args->value, 2, args->Dest(f)));
+				if (!TryPrimitiveOperator(args->Source(f), args->value, args->Dest(f)))
+				{
+					SAVE_IP();
+					CHK(InvokeOperatorLL(args->Source(f), args->value, 2, args->Dest(f)));
+				}
 				ip += oa::TWO_LOCALS_AND_VALUE<Operator>::SIZE;
-				// InvokeOperatorLL pops arguments off the stack
+				// Both methods pop arguments off the stack
 			}
 			NEXT_INSTR();
-		TARGET(OPI_OPERATOR_S)
+		PURE_TARGET(OPI_OPERATOR_S)
 			{
 				OPC_ARGS(oa::TwoLocalsAndValue<Operator>);
-				CHK(InvokeOperatorLL(args->Source(f), args->value, 2, args->Dest(f)));
+				if (!TryPrimitiveOperator(args->Source(f), args->value, args->Dest(f)))
+				{
+					SAVE_IP();
+					CHK(InvokeOperatorLL(args->Source(f), args->value, 2, args->Dest(f)));
+				}
 				ip += oa::TWO_LOCALS_AND_VALUE<Operator>::SIZE;
-				// InvokeOperatorLL pops arguments off the stack
+				// Both methods pop arguments off the stack
 				f->stackCount++;
 			}
 			NEXT_INSTR();
 
 		// eq
-		TARGET(OPI_EQ_L)
+		PURE_TARGET(OPI_EQ_L)
 			{
 				OPC_ARGS(oa::TwoLocals);
 				bool eq;
-				CHK(EqualsLL(args->Source(f), eq));
+				if (!TryPrimitiveEquals(args->Source(f), eq))
+				{
+					SAVE_IP();
+					CHK(EqualsLL(args->Source(f), eq));
+				}
 				SET_BOOL(args->Dest(f), eq);
 				ip += oa::TWO_LOCALS_SIZE;
-				// EqualsLL pops arguments off the stack
+				// Both methods pop arguments off the stack
 			}
 			NEXT_INSTR();
-		TARGET(OPI_EQ_S)
+		PURE_TARGET(OPI_EQ_S)
 			{
 				OPC_ARGS(oa::TwoLocals);
 				bool eq;
-				CHK(EqualsLL(args->Source(f), eq));
+				if (!TryPrimitiveEquals(args->Source(f), eq))
+				{
+					SAVE_IP();
+					CHK(EqualsLL(args->Source(f), eq));
+				}
 				SET_BOOL(args->Dest(f), eq);
 				ip += oa::TWO_LOCALS_SIZE;
-				// EqualsLL pops arguments off the stack
+				// Both methods pop arguments off the stack
 				f->stackCount++;
 			}
 			NEXT_INSTR();
 
 		// cmp
-		TARGET(OPI_CMP_L)
+		PURE_TARGET(OPI_CMP_L)
 			{
 				OPC_ARGS(oa::TwoLocals);
-				CHK(CompareLL(args->Source(f), args->Dest(f)));
+				int cmp;
+				if (TryPrimitiveCompare(args->Source(f), cmp))
+					SET_INT(args->Dest(f), cmp)
+				else
+				{
+					SAVE_IP();
+					CHK(CompareLL(args->Source(f), args->Dest(f)));
+				}
 				ip += oa::TWO_LOCALS_SIZE;
-				// CompareLL pops arguments off the stack
+				// Both methods pop arguments off the stack
 			}
 			NEXT_INSTR();
-		TARGET(OPI_CMP_S)
+		PURE_TARGET(OPI_CMP_S)
 			{
 				OPC_ARGS(oa::TwoLocals);
-				CHK(CompareLL(args->Source(f), args->Dest(f)));
+				int cmp;
+				if (TryPrimitiveCompare(args->Source(f), cmp))
+					SET_INT(args->Dest(f), cmp)
+				else
+				{
+					SAVE_IP();
+					CHK(CompareLL(args->Source(f), args->Dest(f)));
+				}
 				ip += oa::TWO_LOCALS_SIZE;
-				// CompareLL pops arguments off the stack
+				// Both methods pop arguments off the stack
 				f->stackCount++;
 			}
 			NEXT_INSTR();
 
 		// lt
-		TARGET(OPI_LT_L)
+		PURE_TARGET(OPI_LT_L)
 			{
 				OPC_ARGS(oa::TwoLocals);
 				bool result;
-				CHK(CompareLessThanLL(args->Source(f), result));
+				int cmp;
+				if (TryPrimitiveCompare(args->Source(f), cmp))
+					result = cmp < 0;
+				else
+				{
+					SAVE_IP();
+					CHK(CompareLessThanLL(args->Source(f), result));
+				}
 				SET_BOOL(args->Dest(f), result);
 				ip += oa::TWO_LOCALS_SIZE;
-				// CompareLL pops arguments off the stack
+				// Both methods pop arguments off the stack
 			}
 			NEXT_INSTR();
-		TARGET(OPI_LT_S)
+		PURE_TARGET(OPI_LT_S)
 			{
 				OPC_ARGS(oa::TwoLocals);
 				bool result;
-				CHK(CompareLessThanLL(args->Source(f), result));
+				int cmp;
+				if (TryPrimitiveCompare(args->Source(f), cmp))
+					result = cmp < 0;
+				else
+				{
+					SAVE_IP();
+					CHK(CompareLessThanLL(args->Source(f), result));
+				}
 				SET_BOOL(args->Dest(f), result);
 				ip += oa::TWO_LOCALS_SIZE;
-				// CompareLL pops arguments off the stack
+				// Both methods pop arguments off the stack
 				f->stackCount++;
 			}
 			NEXT_INSTR();
 
 		// gt
-		TARGET(OPI_GT_L)
+		PURE_TARGET(OPI_GT_L)
 			{
 				OPC_ARGS(oa::TwoLocals);
 				bool result;
-				CHK(CompareGreaterThanLL(args->Source(f), result));
+				int cmp;
+				if (TryPrimitiveCompare(args->Source(f), cmp))
+					result = cmp > 0;
+				else
+				{
+					SAVE_IP();
+					CHK(CompareGreaterThanLL(args->Source(f), result));
+				}
 				SET_BOOL(args->Dest(f), result);
 				ip += oa::TWO_LOCALS_SIZE;
-				// CompareLL pops arguments off the stack
+				// Both methods pop arguments off the stack
 			}
 			NEXT_INSTR();
-		TARGET(OPI_GT_S)
+		PURE_TARGET(OPI_GT_S)
 			{
 				OPC_ARGS(oa::TwoLocals);
 				bool result;
-				CHK(CompareGreaterThanLL(args->Source(f), result));
+				int cmp;
+				if (TryPrimitiveCompare(args->Source(f), cmp))
+					result = cmp > 0;
+				else
+				{
+					SAVE_IP();
+					CHK(CompareGreaterThanLL(args->Source(f), result));
+				}
 				SET_BOOL(args->Dest(f), result);
 				ip += oa::TWO_LOCALS_SIZE;
-				// CompareLL pops arguments off the stack
+				// Both methods pop arguments off the stack
 				f->stackCount++;
 			}
 			NEXT_INSTR();
 
 		// lte
-		TARGET(OPI_LTE_L)
+		PURE_TARGET(OPI_LTE_L)
 			{
 				OPC_ARGS(oa::TwoLocals);
 				bool result;
-				CHK(CompareLessEqualsLL(args->Source(f), result));
+				int cmp;
+				if (TryPrimitiveCompare(args->Source(f), cmp))
+					result = cmp <= 0;
+				else
+				{
+					SAVE_IP();
+					CHK(CompareLessEqualsLL(args->Source(f), result));
+				}
 				SET_BOOL(args->Dest(f), result);
 				ip += oa::TWO_LOCALS_SIZE;
-				// CompareLL pops arguments off the stack
+				// Both methods pop arguments off the stack
 			}
 			NEXT_INSTR();
-		TARGET(OPI_LTE_S)
+		PURE_TARGET(OPI_LTE_S)
 			{
 				OPC_ARGS(oa::TwoLocals);
 				bool result;
-				CHK(CompareLessEqualsLL(args->Source(f), result));
+				int cmp;
+				if (TryPrimitiveCompare(args->Source(f), cmp))
+					result = cmp <= 0;
+				else
+				{
+					SAVE_IP();
+					CHK(CompareLessEqualsLL(args->Source(f), result));
+				}
 				SET_BOOL(args->Dest(f), result);
 				ip += oa::TWO_LOCALS_SIZE;
-				// CompareLL pops arguments off the stack
+				// Both methods pop arguments off the stack
 				f->stackCount++;
 			}
 			NEXT_INSTR();
 
 		// gte
-		TARGET(OPI_GTE_L)
+		PURE_TARGET(OPI_GTE_L)
 			{
 				OPC_ARGS(oa::TwoLocals);
 				bool result;
-				CHK(CompareGreaterEqualsLL(args->Source(f), result));
+				int cmp;
+				if (TryPrimitiveCompare(args->Source(f), cmp))
+					result = cmp >= 0;
+				else
+				{
+					SAVE_IP();
+					CHK(CompareGreaterEqualsLL(args->Source(f), result));
+				}
 				SET_BOOL(args->Dest(f), result);
 				ip += oa::TWO_LOCALS_SIZE;
-				// CompareLL pops arguments off the stack
+				// Both methods pop arguments off the stack
 			}
 			NEXT_INSTR();
-		TARGET(OPI_GTE_S)
+		PURE_TARGET(OPI_GTE_S)
 			{
 				OPC_ARGS(oa::TwoLocals);
 				bool result;
-				CHK(CompareGreaterEqualsLL(args->Source(f), result));
+				int cmp;
+				if (TryPrimitiveCompare(args->Source(f), cmp))
+					result = cmp >= 0;
+				else
+				{
+					SAVE_IP();
+					CHK(CompareGreaterEqualsLL(args->Source(f), result));
+				}
 				SET_BOOL(args->Dest(f), result);
 				ip += oa::TWO_LOCALS_SIZE;
-				// CompareLL pops arguments off the stack
+				// Both methods pop arguments off the stack
 				f->stackCount++;
 			}
 			NEXT_INSTR();
@@ -939,16 +1311,17 @@ int Thread::Evaluate()
 		TARGET(OPI_CALLMEM_L)
 			{
 				OPC_ARGS(oa::CallMember);
-				CHK(InvokeMemberLL(args->member, args->argc, args->Args(f), args->Dest(f), 0));
-				ip += oa::CALL_MEMBER_SIZE;
+				MethodOverload *mo;
+				CHK(ResolveMemberInvocationLL(args->member, args->argc, args->Args(f), 0, &args->cache, &mo));
+				CALL_OVERLOAD(mo, args->argc, args->Args(f), args->Dest(f), oa::CALL_MEMBER_SIZE, false);
 			}
 			NEXT_INSTR();
 		TARGET(OPI_CALLMEM_S)
 			{
 				OPC_ARGS(oa::CallMember);
-				CHK(InvokeMemberLL(args->member, args->argc, args->Args(f), args->Dest(f), 0));
-				ip += oa::CALL_MEMBER_SIZE;
-				f->stackCount++;
+				MethodOverload *mo;
+				CHK(ResolveMemberInvocationLL(args->member, args->argc, args->Args(f), 0, &args->cache, &mo));
+				CALL_OVERLOAD(mo, args->argc, args->Args(f), args->Dest(f), oa::CALL_MEMBER_SIZE, true);
 			}
 			NEXT_INSTR();
 
@@ -982,11 +1355,11 @@ int Thread::Evaluate()
 		// stmem
 		TARGET(OPI_STMEM)
 			{
-				OPC_ARGS(oa::LocalAndValue<String*>);
+				OPC_ARGS(oa::StoreMember);
 				// StoreMemberLL performs a null check
-				CHK(StoreMemberLL(args->Local(f), args->value));
+				CHK(StoreMemberLL(args->Args(f), args->member, &args->cache));
 				// It also pops the things off the stack
-				ip += oa::LOCAL_AND_VALUE<String*>::SIZE;
+				ip += oa::STORE_MEMBER_SIZE;
 			}
 			NEXT_INSTR();
 
@@ -1018,6 +1391,7 @@ int Thread::Evaluate()
 			// This Evaluate call was reached through FindErrorHandlers or
 			// EvaluateLeave, so we return here and let the thing continue
 			// with its search for more error handlers.
+			OVUM_ASSERT(f == entryFrame);
 			retCode = OVUM_SUCCESS;
 			goto exitMethod;
 
@@ -1051,79 +1425,121 @@ int Thread::Evaluate()
 			NEXT_INSTR();
 
 		// breq
-		TARGET(OPI_BREQ)
+		PURE_TARGET(OPI_BREQ)
 			{
 				OPC_ARGS(oa::ConditionalBranch);
 				bool eq;
-				CHK(EqualsLL(args->Value(f), eq));
+				if (!TryPrimitiveEquals(args->Value(f), eq))
+				{
+					SAVE_IP();
+					CHK(EqualsLL(args->Value(f), eq));
+				}
 				if (eq)
 					ip += args->offset;
 				ip += oa::CONDITIONAL_BRANCH_SIZE;
+				CHECK_BACKWARD_BRANCH(args->offset);
 			}
 			NEXT_INSTR();
 
 		// brneq
-		TARGET(OPI_BRNEQ)
+		PURE_TARGET(OPI_BRNEQ)
 			{
 				OPC_ARGS(oa::ConditionalBranch);
 				bool eq;
-				CHK(EqualsLL(args->Value(f), eq));
+				if (!TryPrimitiveEquals(args->Value(f), eq))
+				{
+					SAVE_IP();
+					CHK(EqualsLL(args->Value(f), eq));
+				}
 				if (!eq)
 					ip += args->offset;
 				ip += oa::CONDITIONAL_BRANCH_SIZE;
+				CHECK_BACKWARD_BRANCH(args->offset);
 			}
 			NEXT_INSTR();
 
 		// brlt
-		TARGET(OPI_BRLT)
+		PURE_TARGET(OPI_BRLT)
 			{
 				OPC_ARGS(oa::ConditionalBranch);
 				bool result;
-				CHK(CompareLessThanLL(args->Value(f), result));
+				int cmp;
+				if (TryPrimitiveCompare(args->Value(f), cmp))
+					result = cmp < 0;
+				else
+				{
+					SAVE_IP();
+					CHK(CompareLessThanLL(args->Value(f), result));
+				}
 				if (result)
 					ip += args->offset;
 				ip += oa::CONDITIONAL_BRANCH_SIZE;
+				CHECK_BACKWARD_BRANCH(args->offset);
 			}
 			NEXT_INSTR();
 
 		// brgt
-		TARGET(OPI_BRGT)
+		PURE_TARGET(OPI_BRGT)
 			{
 				OPC_ARGS(oa::ConditionalBranch);
 				bool result;
-				CHK(CompareGreaterThanLL(args->Value(f), result));
+				int cmp;
+				if (TryPrimitiveCompare(args->Value(f), cmp))
+					result = cmp > 0;
+				else
+				{
+					SAVE_IP();
+					CHK(CompareGreaterThanLL(args->Value(f), result));
+				}
 				if (result)
 					ip += args->offset;
 				ip += oa::CONDITIONAL_BRANCH_SIZE;
+				CHECK_BACKWARD_BRANCH(args->offset);
 			}
 			NEXT_INSTR();
 
 		// brlte
-		TARGET(OPI_BRLTE)
+		PURE_TARGET(OPI_BRLTE)
 			{
 				OPC_ARGS(oa::ConditionalBranch);
 				bool result;
-				CHK(CompareLessEqualsLL(args->Value(f), result));
+				int cmp;
+				if (TryPrimitiveCompare(args->Value(f), cmp))
+					result = cmp <= 0;
+				else
+				{
+					SAVE_IP();
+					CHK(CompareLessEqualsLL(args->Value(f), result));
+				}
 				if (result)
 					ip += args->offset;
 				ip += oa::CONDITIONAL_BRANCH_SIZE;
+				CHECK_BACKWARD_BRANCH(args->offset);
 			}
 			NEXT_INSTR();
 
 		// brgte
-		TARGET(OPI_BRGTE)
+		PURE_TARGET(OPI_BRGTE)
 			{
 				OPC_ARGS(oa::ConditionalBranch);
 				bool result;
-				CHK(CompareGreaterEqualsLL(args->Value(f), result));
+				int cmp;
+				if (TryPrimitiveCompare(args->Value(f), cmp))
+					result = cmp >= 0;
+				else
+				{
+					SAVE_IP();
+					CHK(CompareGreaterEqualsLL(args->Value(f), result));
+				}
 				if (result)
 					ip += args->offset;
 				ip += oa::CONDITIONAL_BRANCH_SIZE;
+				CHECK_BACKWARD_BRANCH(args->offset);
 			}
 			NEXT_INSTR();
 
 		// ldlocref
-		TARGET(OPI_LDLOCREF)
+		PURE_TARGET(OPI_LDLOCREF)
 			{
 				OPC_ARGS(oa::OneLocal);
 				Value *const dest = f->evalStack + f->stackCount++;
@@ -1198,15 +1614,12 @@ int Thread::Evaluate()
 				else
 				{
 					GCObject *gco = reinterpret_cast<GCObject*>(source->v.reference);
-					gco->fieldAccessLock.Enter();
 
 					uintptr_t offset = ~sourceType;
 					Value *field = reinterpret_cast<Value*>(
 						reinterpret_cast<char*>(source->v.reference) + offset
 					);
-					*args->Dest(f) = *field;
-
-					gco->fieldAccessLock.Leave();
+					gco->ReadField(field, args->Dest(f));
 				}
 
 				ip += oa::TWO_LOCALS_SIZE;
@@ -1229,15 +1642,12 @@ int Thread::Evaluate()
 				else
 				{
 					GCObject *gco = reinterpret_cast<GCObject*>(source->v.reference);
-					gco->fieldAccessLock.Enter();
 
 					uintptr_t offset = ~sourceType;
 					Value *field = reinterpret_cast<Value*>(
 						reinterpret_cast<char*>(source->v.reference) + offset
 					);
-					*args->Dest(f) = *field;
-
-					gco->fieldAccessLock.Leave();
+					gco->ReadField(field, args->Dest(f));
 				}
 
 				ip += oa::TWO_LOCALS_SIZE;
@@ -1261,15 +1671,16 @@ int Thread::Evaluate()
 				else
 				{
 					GCObject *gco = reinterpret_cast<GCObject*>(dest->v.reference);
-					gco->fieldAccessLock.Enter();
+					gco->fieldAccessLock.EnterWrite();
 
 					uint32_t offset = ~destType;
 					Value *field = reinterpret_cast<Value*>(
 						reinterpret_cast<char*>(dest->v.reference) + offset
 					);
 					*field = *args->Source(f);
+					GetGC()->WriteBarrier(gco, field);
 
-					gco->fieldAccessLock.Leave();
+					gco->fieldAccessLock.LeaveWrite();
 				}
 
 				ip += oa::TWO_LOCALS_SIZE;
@@ -1292,15 +1703,16 @@ int Thread::Evaluate()
 				else
 				{
 					GCObject *gco = reinterpret_cast<GCObject*>(dest->v.reference);
-					gco->fieldAccessLock.Enter();
+					gco->fieldAccessLock.EnterWrite();
 
 					uintptr_t offset = ~destType;
 					Value *field = reinterpret_cast<Value*>(
 						reinterpret_cast<char*>(dest->v.reference) + offset
 					);
 					*field = *args->Source(f);
+					GetGC()->WriteBarrier(gco, field);
 
-					gco->fieldAccessLock.Leave();
+					gco->fieldAccessLock.LeaveWrite();
 				}
 
 				ip += oa::TWO_LOCALS_SIZE;
@@ -1312,18 +1724,19 @@ int Thread::Evaluate()
 		TARGET(OPI_CALLR_L)
 			{
 				OPC_ARGS(oa::CallRef);
-				CHK(InvokeLL(args->argc, args->Args(f), args->Dest(f), args->refSignature));
-				ip += oa::CALL_REF_SIZE;
-				// InvokeLL pops the arguments
+				MethodOverload *mo;
+				CHK(ResolveInvocationLL(args->argc, args->Args(f), args->refSignature, &mo));
+				// The call pops the arguments
+				CALL_OVERLOAD(mo, args->argc, args->Args(f), args->Dest(f), oa::CALL_REF_SIZE, false);
 			}
 			NEXT_INSTR();
 		TARGET(OPI_CALLR_S)
 			{
 				OPC_ARGS(oa::CallRef);
-				CHK(InvokeLL(args->argc, args->Args(f), args->Dest(f), args->refSignature));
-				ip += oa::CALL_REF_SIZE;
-				// InvokeLL pops the arguments
-				f->stackCount++;
+				MethodOverload *mo;
+				CHK(ResolveInvocationLL(args->argc, args->Args(f), args->refSignature, &mo));
+				// The call pops the arguments
+				CALL_OVERLOAD(mo, args->argc, args->Args(f), args->Dest(f), oa::CALL_REF_SIZE, true);
 			}
 			NEXT_INSTR();
 
@@ -1331,15 +1744,105 @@ int Thread::Evaluate()
 		TARGET(OPI_CALLMEMR_L)
 			{
 				OPC_ARGS(oa::CallMemberRef);
-				CHK(InvokeMemberLL(args->member, args->argc, args->Args(f), args->Dest(f), args->refSignature));
-				ip += oa::CALL_MEMBER_REF_SIZE;
+				MethodOverload *mo;
+				CHK(ResolveMemberInvocationLL(args->member, args->argc, args->Args(f), args->refSignature, &args->cache, &mo));
+				CALL_OVERLOAD(mo, args->argc, args->Args(f), args->Dest(f), oa::CALL_MEMBER_REF_SIZE, false);
 			}
 			NEXT_INSTR();
 		TARGET(OPI_CALLMEMR_S)
 			{
 				OPC_ARGS(oa::CallMemberRef);
-				CHK(InvokeMemberLL(args->member, args->argc, args->Args(f), args->Dest(f), args->refSignature));
-				ip += oa::CALL_MEMBER_REF_SIZE;
+				MethodOverload *mo;
+				CHK(ResolveMemberInvocationLL(args->member, args->argc, args->Args(f), args->refSignature, &args->cache, &mo));
+				CALL_OVERLOAD(mo, args->argc, args->Args(f), args->Dest(f), oa::CALL_MEMBER_REF_SIZE, true);
+			}
+			NEXT_INSTR();
+
+		// ldlocfld (ldloc + ldfld)
+		TARGET(OPI_LDLOCFLD_L)
+			{
+				OPC_ARGS(oa::TwoLocalsAndValue<Field*>);
+				CHK(args->value->ReadField(this, args->Source(f), args->Dest(f)));
+				ip += oa::TWO_LOCALS_AND_VALUE<Field*>::SIZE;
+				// The instance is read from a local, and the field
+				// value is put in a local. No change.
+			}
+			NEXT_INSTR();
+		TARGET(OPI_LDLOCFLD_S)
+			{
+				OPC_ARGS(oa::TwoLocalsAndValue<Field*>);
+				CHK(args->value->ReadField(this, args->Source(f), args->Dest(f)));
+				ip += oa::TWO_LOCALS_AND_VALUE<Field*>::SIZE;
+				f->stackCount++;
+			}
+			NEXT_INSTR();
+
+		// operator.sc (ldc.i + operator)
+		// The constant is written to the stack, just as ldc.i would have done,
+		// and then the operator is evaluated exactly like OPI_OPERATOR_[LS].
+		PURE_TARGET(OPI_OPERSC_L)
+			{
+				OPC_ARGS(oa::OperatorConstant);
+				Value *const opArgs = args->Args(f);
+				SET_INT(opArgs + 1, args->value);
+				f->stackCount++;
+				if (!TryPrimitiveOperator(opArgs, args->op, args->Dest(f)))
+				{
+					SAVE_IP();
+					CHK(InvokeOperatorLL(opArgs, args->op, 2, args->Dest(f)));
+				}
+				ip += oa::OPERATOR_CONSTANT_SIZE;
+				// Both methods pop arguments off the stack
+			}
+			NEXT_INSTR();
+		PURE_TARGET(OPI_OPERSC_S)
+			{
+				OPC_ARGS(oa::OperatorConstant);
+				Value *const opArgs = args->Args(f);
+				SET_INT(opArgs + 1, args->value);
+				f->stackCount++;
+				if (!TryPrimitiveOperator(opArgs, args->op, args->Dest(f)))
+				{
+					SAVE_IP();
+					CHK(InvokeOperatorLL(opArgs, args->op, 2, args->Dest(f)));
+				}
+				ip += oa::OPERATOR_CONSTANT_SIZE;
+				// Both methods pop arguments off the stack
+				f->stackCount++;
+			}
+			NEXT_INSTR();
+
+		// operator.lc (ldloc + ldc.i + operator)
+		PURE_TARGET(OPI_OPERLC_L)
+			{
+				OPC_ARGS(oa::OperatorConstant);
+				Value *const opArgs = args->Args(f);
+				opArgs[0] = *args->Left(f);
+				SET_INT(opArgs + 1, args->value);
+				f->stackCount += 2;
+				if (!TryPrimitiveOperator(opArgs, args->op, args->Dest(f)))
+				{
+					SAVE_IP();
+					CHK(InvokeOperatorLL(opArgs, args->op, 2, args->Dest(f)));
+				}
+				ip += oa::OPERATOR_CONSTANT_SIZE;
+				// Both methods pop arguments off the stack
+			}
+			NEXT_INSTR();
+		PURE_TARGET(OPI_OPERLC_S)
+			{
+				OPC_ARGS(oa::OperatorConstant);
+				Value *const opArgs = args->Args(f);
+				opArgs[0] = *args->Left(f);
+				SET_INT(opArgs + 1, args->value);
+				f->stackCount += 2;
+				if (!TryPrimitiveOperator(opArgs, args->op, args->Dest(f)))
+				{
+					SAVE_IP();
+					CHK(InvokeOperatorLL(opArgs, args->op, 2, args->Dest(f)));
+				}
+				ip += oa::OPERATOR_CONSTANT_SIZE;
+				// Both methods pop arguments off the stack
 				f->stackCount++;
 			}
 			NEXT_INSTR();
@@ -1364,14 +1867,60 @@ int Thread::Evaluate()
 			NEXT_INSTR();
 
 		default:
+		TARGET_LABEL(INVALID)
 			OVUM_UNREACHABLE();
 		}
 	}
 
 ret:
 	OVUM_ASSERT(f->stackCount == 1);
+	if (f != entryFrame)
+	{
+		// The method was entered by CALL_OVERLOAD, so return to the caller
+		// within this loop. If the method has no parameters and the return
+		// value goes onto the caller's evaluation stack, then the value may
+		// be written on top of the frame itself (see InvokeMethodOverload),
+		// so we must read everything we need from the frame first.
+		StackFrame *const frame = f;
+		Value *const returnValue = frame->returnValue;
+		const bool pushReturnValue = frame->pushReturnValue;
+		OVUM_PROFILE(profiler->MethodLeft(frame->method));
+		f = frame->prevFrame;
+		ip = frame->returnInstr;
+		currentFrame = f;
+		this->ip = frame->prevInstr;
+
+		*returnValue = frame->evalStack[0];
+		if (pushReturnValue)
+			f->stackCount++;
+		goto dispatch;
+	}
 	// And then we just fall through and return!
 exitMethod:
+	// If an error occurred in a method entered by CALL_OVERLOAD, look for an
+	// error handler in it, the same way InvokeMethodOverload would. If there
+	// is none, the error propagates to the caller, exactly as though the call
+	// instruction had failed.
+	while (retCode != OVUM_SUCCESS && f != entryFrame)
+	{
+		if (retCode == OVUM_ERROR_THROWN)
+		{
+			retCode = FindErrorHandler(ALL_TRY_BLOCKS);
+			if (retCode == OVUM_SUCCESS)
+			{
+				// Error handler found! IP is now at the catch handler's offset,
+				// so let's resume the method there.
+				ip = this->ip;
+				goto dispatch;
+			}
+		}
+
+		StackFrame *const frame = f;
+		OVUM_PROFILE(profiler->MethodLeft(frame->method));
+		f = frame->prevFrame;
+		currentFrame = f;
+		this->ip = frame->prevInstr;
+	}
 	return retCode;
 }
 
@@ -2,6 +2,7 @@
 
 #include "../vm.h"
 #include "thread.h"
+#include "membercache.h"
 #include <vector>
 
 namespace ovum
@@ -373,6 +374,18 @@ enum IntermediateOpcode
 	OPI_CALLMEMR_L  = 0x78,
 	OPI_CALLMEMR_S  = 0x79,
 
+	// Superinstructions, which replace common sequences of instructions.
+	// See MethodInitializer::FuseInstructions().
+	// ldloc + ldfld: the instance is read from a local
+	OPI_LDLOCFLD_L  = 0x7a, // Store field value in local
+	OPI_LDLOCFLD_S  = 0x7b, // Store field value on stack
+	// ldc.i + binary operator: the left operand is on the stack
+	OPI_OPERSC_L    = 0x7c, // Store result in local
+	OPI_OPERSC_S    = 0x7d, // Store result on stack
+	// ldloc + ldc.i + binary operator: the left operand is read from a local
+	OPI_OPERLC_L    = 0x7e, // Store result in local
+	OPI_OPERLC_S    = 0x7f, // Store result on stack
+
 	// Unary operators (+, - and ~)
 	OPI_UNARYOP_L   = 0x80, // Store result in local
 	OPI_UNARYOP_S   = 0x81, // Store result on stack
@@ -506,6 +519,38 @@ namespace opcode_args
 		static const size_t SIZE = OVUM_ALIGN_TO(sizeof(TwoLocalsAndValue<T>), ALIGNMENT);
 	};
 
+	struct LoadMember
+	{
+		LocalOffset source;
+		LocalOffset dest;
+		String *member;
+		mutable MemberCache cache;
+
+		inline Value *const Source(StackFrame *const frame) const
+		{
+			return source.Resolve(frame);
+		}
+
+		inline Value *const Dest(StackFrame *const frame) const
+		{
+			return dest.Resolve(frame);
+		}
+	};
+	static const size_t LOAD_MEMBER_SIZE = OVUM_ALIGN_TO(sizeof(LoadMember), ALIGNMENT);
+
+	struct StoreMember
+	{
+		LocalOffset args;
+		String *member;
+		mutable MemberCache cache;
+
+		inline Value *const Args(StackFrame *const frame) const
+		{
+			return args.Resolve(frame);
+		}
+	};
+	static const size_t STORE_MEMBER_SIZE = OVUM_ALIGN_TO(sizeof(StoreMember), ALIGNMENT);
+
 	struct LoadEnum
 	{
 		LocalOffset dest;
@@ -581,6 +626,7 @@ namespace opcode_args
 		LocalOffset dest;
 		ovlocals_t argc;
 		String *member;
+		mutable MemberCache cache;
 
 		inline Value *const Args(StackFrame *const frame) const
 		{
@@ -620,6 +666,7 @@ namespace opcode_args
 		ovlocals_t argc;
 		uint32_t refSignature;
 		String *member;
+		mutable MemberCache cache;
 		
 		inline Value *const Args(StackFrame *const frame) const
 		{
@@ -633,6 +680,42 @@ namespace opcode_args
 	};
 	static const size_t CALL_MEMBER_REF_SIZE = OVUM_ALIGN_TO(sizeof(CallMemberRef), ALIGNMENT);
 
+	// A binary operator whose right operand is an Int constant. The operands
+	// are copied to args, on the stack, before the operator is evaluated, so
+	// that the operator sees exactly what the unfused instructions would have
+	// given it. The first three members are laid out like the members of
+	// TwoLocalsAndValue<Operator>.
+	struct OperatorConstant
+	{
+		LocalOffset args;
+		LocalOffset dest;
+		Operator op;
+		// The left operand, if it is read from a local. OPI_OPERSC_*
+		// ignores this; its left operand is already in args.
+		LocalOffset left;
+		int64_t value;
+
+		inline Value *const Args(StackFrame *const frame) const
+		{
+			return args.Resolve(frame);
+		}
+
+		inline Value *const Dest(StackFrame *const frame) const
+		{
+			return dest.Resolve(frame);
+		}
+
+		inline Value *const Left(StackFrame *const frame) const
+		{
+			return left.Resolve(frame);
+		}
+	};
+	static const size_t OPERATOR_CONSTANT_SIZE = OVUM_ALIGN_TO(sizeof(OperatorConstant), ALIGNMENT);
+	static_assert(
+		offsetof(OperatorConstant, op) == offsetof(TwoLocalsAndValue<Operator>, value),
+		"OperatorConstant does not begin like TwoLocalsAndValue<Operator>"
+	);
+
 	struct Branch
 	{
 		int32_t offset;
@@ -0,0 +1,174 @@
+#pragma once
+
+// The primitive fast paths of Thread. See the declarations in thread.h for
+// details. This file is included by the interpreter loop and the JIT helpers.
+
+#include "thread.h"
+#include "../object/type.h"
+#include <cmath>
+
+namespace ovum
+{
+
+inline bool Thread::TryPrimitiveOperator(Value *args, Operator op, Value *result)
+{
+	Type *type = args[0].type;
+	if (type != args[1].type)
+		return false;
+
+	if (type == vm->types.Int)
+	{
+		int64_t left = args[0].v.integer;
+		int64_t right = args[1].v.integer;
+		int64_t value;
+		switch (op)
+		{
+		case Operator::ADD:
+			if (Int_AddChecked(left, right, value)) return false;
+			break;
+		case Operator::SUB:
+			if (Int_SubtractChecked(left, right, value)) return false;
+			break;
+		case Operator::MUL:
+			if (Int_MultiplyChecked(left, right, value)) return false;
+			break;
+		case Operator::DIV:
+			if (Int_DivideChecked(left, right, value)) return false;
+			break;
+		case Operator::MOD:
+			if (Int_ModuloChecked(left, right, value)) return false;
+			break;
+		case Operator::OR:  value = left | right; break;
+		case Operator::XOR: value = left ^ right; break;
+		case Operator::AND: value = left & right; break;
+		default:
+			return false;
+		}
+		result->type = vm->types.Int;
+		result->v.integer = value;
+	}
+	else if (type == vm->types.UInt)
+	{
+		uint64_t left = args[0].v.uinteger;
+		uint64_t right = args[1].v.uinteger;
+		uint64_t value;
+		switch (op)
+		{
+		case Operator::ADD:
+			if (UInt_AddChecked(left, right, value)) return false;
+			break;
+		case Operator::SUB:
+			if (UInt_SubtractChecked(left, right, value)) return false;
+			break;
+		case Operator::MUL:
+			if (UInt_MultiplyChecked(left, right, value)) return false;
+			break;
+		case Operator::DIV:
+			if (UInt_DivideChecked(left, right, value)) return false;
+			break;
+		case Operator::MOD:
+			if (UInt_ModuloChecked(left, right, value)) return false;
+			break;
+		case Operator::OR:  value = left | right; break;
+		case Operator::XOR: value = left ^ right; break;
+		case Operator::AND: value = left & right; break;
+		default:
+			return false;
+		}
+		result->type = vm->types.UInt;
+		result->v.uinteger = value;
+	}
+	else if (type == vm->types.Real)
+	{
+		double left = args[0].v.real;
+		double right = args[1].v.real;
+		double value;
+		switch (op)
+		{
+		case Operator::ADD: value = left + right; break;
+		case Operator::SUB: value = left - right; break;
+		case Operator::MUL: value = left * right; break;
+		case Operator::DIV: value = left / right; break;
+		case Operator::MOD: value = std::fmod(left, right); break;
+		default:
+			return false;
+		}
+		result->type = vm->types.Real;
+		result->v.real = value;
+	}
+	else
+	{
+		return false;
+	}
+
+	currentFrame->stackCount -= 2;
+	return true;
+}
+
+inline bool Thread::TryPrimitiveEquals(Value *args, bool &result)
+{
+	Type *type = args[0].type;
+	if (type != args[1].type)
+		return false;
+
+	if (type == vm->types.Int || type == vm->types.UInt)
+	{
+		result = args[0].v.integer == args[1].v.integer;
+	}
+	else if (type == vm->types.Real)
+	{
+		// NaN is equal to itself here, as in Real's == operator.
+		double left = args[0].v.real;
+		double right = args[1].v.real;
+		result = left == right || std::isnan(left) && std::isnan(right);
+	}
+	else if (type == vm->types.Boolean)
+	{
+		result = !args[0].v.integer == !args[1].v.integer;
+	}
+	else
+	{
+		return false;
+	}
+
+	currentFrame->stackCount -= 2;
+	return true;
+}
+
+inline bool Thread::TryPrimitiveCompare(Value *args, int &result)
+{
+	Type *type = args[0].type;
+	if (type != args[1].type)
+		return false;
+
+	if (type == vm->types.Int || type == vm->types.Boolean)
+	{
+		int64_t left = args[0].v.integer;
+		int64_t right = args[1].v.integer;
+		result = left < right ? -1 : left > right ? 1 : 0;
+	}
+	else if (type == vm->types.UInt)
+	{
+		uint64_t left = args[0].v.uinteger;
+		uint64_t right = args[1].v.uinteger;
+		result = left < right ? -1 : left > right ? 1 : 0;
+	}
+	else if (type == vm->types.Real)
+	{
+		double left = args[0].v.real;
+		double right = args[1].v.real;
+		// Real's <=> operator orders NaN before all other values.
+		if (std::isnan(left) || std::isnan(right))
+			return false;
+		result = left < right ? -1 : left > right ? 1 : 0;
+	}
+	else
+	{
+		return false;
+	}
+
+	currentFrame->stackCount -= 2;
+	return true;
+}
+
+} // namespace ovum
@@ -1,6 +1,9 @@
 ﻿#include "vm.h"
 #include "thread.h"
 #include "refsignature.h"
+#include "sampler.h"
+#include "methodcache.h"
+#include "backgroundinitializer.h"
 #include "methodinitexception.h"
 #include "../gc/gc.h"
 #include "../gc/staticref.h"
@@ -12,6 +15,8 @@
 #include "../module/modulepool.h"
 #include "../util/pathname.h"
 #include "../res/staticstrings.h"
+#include "../config/defaults.h"
+#include "../jit/jit.h"
 #include <fcntl.h>
 #include <io.h>
 #include <cstdio>
@@ -31,6 +36,11 @@ TlsEntry<VM> VM::vmKey;
 
 VM::VM(VMStartParams &params) :
 	verbose(params.verbose),
+	lazyMethodBodies(params.lazyMethodBodies),
+	methodCacheDirectory(),
+	preinitializeMethods(params.preinitializeMethods),
+	backgroundInitializer(),
+	callStackSize(params.callStackSize),
 	argCount(params.argc),
 	argValues(),
 	types(),
@@ -40,6 +50,12 @@ VM::VM(VMStartParams &params) :
 	modulePath(),
 	mainThread(),
 	gc(),
+	jit(),
+#if OVUM_PROFILING
+	profiler(),
+#endif
+	sampler(),
+	sampleFile(),
 	modules(),
 	refSignatures()
 { }
@@ -55,6 +71,9 @@ VM::~VM()
 
 int VM::Run()
 {
+	if (preinitializeMethods)
+		return PreinitializeMethods();
+
 	int r;
 
 	Method *main = startupModule->GetMainMethod();
@@ -73,9 +92,22 @@ int VM::Run()
 		if (verbose)
 			wprintf(L"<<< Begin program output >>>\n");
 
+		if (sampler && !sampler->Start())
+			fwprintf(stderr, L"Warning: Could not start the sampling profiler.\n");
+
+		if (backgroundInitializer && !backgroundInitializer->Start(mo))
+			fwprintf(stderr, L"Warning: Could not start the background method initializer.\n");
+
 		Value returnValue;
 		r = mainThread->Start(argc, mo, returnValue);
 
+		if (sampler)
+			sampler->Stop();
+		// Stop the background initializer before the method caches are saved,
+		// as it may still be adding methods to them.
+		if (backgroundInitializer)
+			backgroundInitializer->Stop();
+
 		if (r == OVUM_SUCCESS)
 		{
 			if (returnValue.type == types.Int ||
@@ -88,16 +120,108 @@ int VM::Run()
 			PrintUnhandledError(mainThread.get());
 
 		if (verbose)
+		{
 			wprintf(L"<<< End program output >>>\n");
+			if (jit)
+				wprintf(L"JIT: %u methods compiled (%llu bytes), %u not compiled\n",
+					(unsigned int)jit->GetCompiledCount(),
+					(unsigned long long)jit->GetCodeSize(),
+					(unsigned int)jit->GetFailedCount());
+			if (backgroundInitializer)
+				wprintf(L"Background initializer: %u methods initialized\n",
+					(unsigned int)backgroundInitializer->GetInitializedCount());
+		}
+
+		if (sampler)
+			WriteSamples();
+		if (methodCacheDirectory)
+			SaveMethodCaches();
+		PrintProfile();
 	}
 
 	return r;
 }
 
+void VM::WriteSamples()
+{
+	if (!sampler->WriteCollapsedStacks(sampleFile->GetDataPointer()))
+	{
+		fwprintf(stderr, L"Error: Could not write samples to '%ls'.\n",
+			sampleFile->GetDataPointer());
+		return;
+	}
+
+	if (verbose)
+		wprintf(L"Sampler: %llu samples written to '%ls'\n",
+			(unsigned long long)sampler->GetSampleCount(),
+			sampleFile->GetDataPointer());
+}
+
+void VM::SaveMethodCaches()
+{
+	for (size_t i = 0; i < modules->GetLength(); i++)
+	{
+		Module *module = modules->Get((int)i);
+		MethodCache *cache = module->GetMethodCache();
+		if (!cache)
+			continue;
+
+		if (!cache->Save())
+		{
+			VM::PrintfErr(L"Warning: Could not save the method cache of module '%ls'.\n", module->GetName());
+			continue;
+		}
+
+		if (verbose)
+		{
+			VM::Printf(L"Method cache for '%ls': ", module->GetName());
+			wprintf(L"%u methods loaded, %u added\n",
+				(unsigned int)cache->GetHitCount(),
+				(unsigned int)cache->GetAddedCount());
+		}
+	}
+}
+
+int VM::PreinitializeMethods()
+{
+	PreinitializeCounts counts = { 0, 0, 0 };
+	for (size_t i = 0; i < modules->GetLength(); i++)
+	{
+		int r = modules->Get((int)i)->PreinitializeMethods(counts);
+		if (r != OVUM_SUCCESS)
+			return r;
+	}
+
+	if (verbose)
+	{
+		wprintf(L"Initialized %u methods\n", (unsigned int)counts.initialized);
+		wprintf(L"Loaded %u methods from the method cache\n", (unsigned int)counts.cached);
+		wprintf(L"Failed to initialize %u methods\n", (unsigned int)counts.failed);
+	}
+
+	// The methods that did initialize are still worth caching.
+	SaveMethodCaches();
+	if (counts.failed > 0)
+		return OVUM_ERROR_METHOD_INIT;
+	RETURN_SUCCESS;
+}
+
+bool VM::PrintProfile()
+{
+#if OVUM_PROFILING
+	profiler->PrintReport(jit != nullptr);
+	return true;
+#else
+	return false;
+#endif
+}
+
 int VM::New(VMStartParams &params, Box<VM> &result)
 {
 	int status__;
 	{
+		CHECKED(ValidateStartParams(params));
+
 		if (!vmKey.IsValid())
 			CHECKED_MEM(vmKey.Alloc());
 
@@ -108,10 +232,29 @@ int VM::New(VMStartParams &params, Box<VM> &result)
 		CHECKED_MEM(vm->strings = StaticStrings::New());
 
 		CHECKED_MEM(vm->mainThread = Thread::New(vm.get()));
-		CHECKED_MEM(vm->gc = GC::New(vm.get()));
+		CHECKED_MEM(vm->gc = GC::New(vm.get(), params));
 		CHECKED_MEM(vm->standardTypeCollection = StandardTypeCollection::New(vm.get()));
 		CHECKED_MEM(vm->modules = ModulePool::New(10));
 		CHECKED_MEM(vm->refSignatures = Box<RefSignaturePool>(new(std::nothrow) RefSignaturePool()));
+		if (params.jit)
+			CHECKED_MEM(vm->jit = Jit::New(vm.get(), params.jitThreshold));
+#if OVUM_PROFILING
+		CHECKED_MEM(vm->profiler = Profiler::New());
+#endif
+		if (params.sampleFile)
+		{
+			CHECKED_MEM(vm->sampler = Sampler::New(vm->mainThread.get(), params.sampleInterval));
+			CHECKED_MEM(vm->sampleFile = Box<PathName>(new(std::nothrow) PathName(params.sampleFile, std::nothrow)));
+			CHECKED_MEM(vm->sampleFile->IsValid());
+		}
+
+		if (params.backgroundMethodInit && !params.preinitializeMethods)
+			CHECKED_MEM(vm->backgroundInitializer = BackgroundInitializer::New(vm.get()));
+		if (params.methodCacheDirectory)
+		{
+			CHECKED_MEM(vm->methodCacheDirectory = Box<PathName>(new(std::nothrow) PathName(params.methodCacheDirectory, std::nothrow)));
+			CHECKED_MEM(vm->methodCacheDirectory->IsValid());
+		}
 
 		CHECKED(vm->LoadModules(params));
 		CHECKED(vm->InitArgs(params.argc, params.argv));
@@ -124,6 +267,93 @@ retStatus__:
 	return status__;
 }
 
+int VM::ValidateStartParams(VMStartParams &params)
+{
+	using namespace config;
+
+	if (params.gen0Size == 0)
+		params.gen0Size = Defaults::GEN0_SIZE;
+	if (params.gen1DeadObjectThreshold == 0)
+		params.gen1DeadObjectThreshold = Defaults::GEN1_DEAD_OBJECT_THRESHOLD;
+	if (params.largeObjectSize == 0)
+		params.largeObjectSize = Defaults::LARGE_OBJECT_SIZE;
+	if (params.callStackSize == 0)
+		params.callStackSize = Defaults::CALL_STACK_SIZE;
+	if (params.jitThreshold == 0)
+		params.jitThreshold = Defaults::JIT_THRESHOLD;
+	if (params.sampleInterval == 0)
+		params.sampleInterval = Defaults::SAMPLE_INTERVAL;
+	if (params.gcWorkerCount == 0)
+	{
+		params.gcWorkerCount = os::GetProcessorCount();
+		if (params.gcWorkerCount > Defaults::GC_MAX_WORKER_COUNT)
+			params.gcWorkerCount = Defaults::GC_MAX_WORKER_COUNT;
+	}
+
+	// Keep gen0 aligned like everything allocated from it, and the call stack
+	// in whole pages, so that it can be locked into memory.
+	params.gen0Size = OVUM_ALIGN_TO(params.gen0Size, 8);
+	params.callStackSize = OVUM_ALIGN_TO(params.callStackSize, os::GetPageSize());
+
+	if (params.gen0Size < Defaults::GEN0_MIN_SIZE ||
+		params.gen0Size > Defaults::GEN0_MAX_SIZE)
+	{
+		fwprintf(stderr, L"Startup error: The gen0 size must be between %llu and %llu bytes.\n",
+			(unsigned long long)Defaults::GEN0_MIN_SIZE,
+			(unsigned long long)Defaults::GEN0_MAX_SIZE);
+		return OVUM_ERROR_INVALID_PARAMS;
+	}
+
+	if (params.gen1DeadObjectThreshold < Defaults::GEN1_DEAD_OBJECT_MIN_THRESHOLD ||
+		params.gen1DeadObjectThreshold > Defaults::GEN1_DEAD_OBJECT_MAX_THRESHOLD)
+	{
+		fwprintf(stderr, L"Startup error: The gen1 dead object threshold must be between %llu and %llu bytes.\n",
+			(unsigned long long)Defaults::GEN1_DEAD_OBJECT_MIN_THRESHOLD,
+			(unsigned long long)Defaults::GEN1_DEAD_OBJECT_MAX_THRESHOLD);
+		return OVUM_ERROR_INVALID_PARAMS;
+	}
+
+	if (params.largeObjectSize < Defaults::LARGE_OBJECT_MIN_SIZE ||
+		params.largeObjectSize > params.gen0Size / 2)
+	{
+		fwprintf(stderr, L"Startup error: The large object size must be between %llu bytes and half the gen0 size.\n",
+			(unsigned long long)Defaults::LARGE_OBJECT_MIN_SIZE);
+		return OVUM_ERROR_INVALID_PARAMS;
+	}
+
+	if (params.callStackSize < Defaults::CALL_STACK_MIN_SIZE ||
+		params.callStackSize > Defaults::CALL_STACK_MAX_SIZE)
+	{
+		fwprintf(stderr, L"Startup error: The call stack size must be between %llu and %llu bytes.\n",
+			(unsigned long long)Defaults::CALL_STACK_MIN_SIZE,
+			(unsigned long long)Defaults::CALL_STACK_MAX_SIZE);
+		return OVUM_ERROR_INVALID_PARAMS;
+	}
+
+	if (params.gcWorkerCount > Defaults::GC_MAX_WORKER_COUNT)
+	{
+		fwprintf(stderr, L"Startup error: The number of GC workers must be at most %u.\n",
+			(unsigned int)Defaults::GC_MAX_WORKER_COUNT);
+		return OVUM_ERROR_INVALID_PARAMS;
+	}
+
+	if (params.preinitializeMethods && !params.methodCacheDirectory)
+	{
+		fwprintf(stderr, L"Startup error: Methods can only be pre-initialized if there is a method cache directory.\n");
+		return OVUM_ERROR_INVALID_PARAMS;
+	}
+
+#if !OVUM_JIT_SUPPORTED
+	if (params.jit)
+	{
+		fwprintf(stderr, L"Startup error: The JIT compiler is not supported on this platform.\n");
+		return OVUM_ERROR_INVALID_PARAMS;
+	}
+#endif
+
+	RETURN_SUCCESS;
+}
+
 int VM::LoadModules(VMStartParams &params)
 {
 	try
@@ -153,11 +383,7 @@ int VM::LoadModules(VMStartParams &params)
 	}
 	catch (ModuleLoadException &e)
 	{
-		const PathName &fileName = e.GetFileName();
-		if (fileName.GetLength() > 0)
-			fwprintf(stderr, L"Error loading module '" OVUM_PATHNWF L"': " CSTR L"\n", fileName.GetDataPointer(), e.what());
-		else
-			fwprintf(stderr, L"Error loading module: " CSTR L"\n", e.what());
+		PrintModuleLoadError(e);
 		return OVUM_ERROR_MODULE_LOAD;
 	}
 	catch (std::bad_alloc&)
@@ -334,9 +560,20 @@ void VM::PrintUnhandledError(Thread *const thread)
 	if (message != nullptr)
 		PrintErrLn(message);
 
-	if (error.v.error->stackTrace)
-		PrintErrLn(error.v.error->stackTrace);
+	String *stackTrace;
+	if (thread->GetErrorStackTrace(&error, &stackTrace) == OVUM_SUCCESS &&
+		stackTrace != nullptr)
+		PrintErrLn(stackTrace);
+}
+void VM::PrintModuleLoadError(ModuleLoadException &e)
+{
+	const PathName &fileName = e.GetFileName();
+	if (fileName.GetLength() > 0)
+		fwprintf(stderr, L"Error loading module '" OVUM_PATHNWF L"': " CSTR L"\n", fileName.GetDataPointer(), e.what());
+	else
+		fwprintf(stderr, L"Error loading module: " CSTR L"\n", e.what());
 }
+
 void VM::PrintMethodInitException(MethodInitException &e)
 {
 	FILE *err = stderr;
@@ -464,6 +701,11 @@ OVUM_API void VM_PrintErrLn(String *str)
 	ovum::VM::PrintErrLn(str);
 }
 
+OVUM_API bool VM_PrintProfile(ThreadHandle thread)
+{
+	return thread->GetVM()->PrintProfile();
+}
+
 OVUM_API size_t VM_GetArgCount(ThreadHandle thread)
 {
 	return thread->GetVM()->GetArgCount();
@@ -3,6 +3,7 @@
 #include "../vm.h"
 #include "../../inc/ovum_main.h"
 #include "../threading/tls.h"
+#include "profiler.h"
 #include <cstdio>
 
 namespace ovum
@@ -39,11 +40,43 @@ private:
 	// Whether the VM describes the startup process.
 	bool verbose;
 
+	// Whether method bodies are read when methods are first called, rather
+	// than when modules are loaded.
+	bool lazyMethodBodies;
+
+	// The directory that contains method cache files, or null if method
+	// bodies are not cached. See MethodCache for details.
+	Box<PathName> methodCacheDirectory;
+
+	// Whether the VM initializes every method and fills the method cache,
+	// instead of running the program.
+	bool preinitializeMethods;
+
+	// Initializes methods ahead of time on a separate thread, or null if
+	// background initialization is disabled.
+	Box<BackgroundInitializer> backgroundInitializer;
+
+	// The size of the managed call stack of each thread.
+	size_t callStackSize;
+
 	Module *startupModule;
 
 	// The current garbage collector.
 	Box<GC> gc;
 
+	// The JIT compiler, or null if it is disabled.
+	Box<Jit> jit;
+
+#if OVUM_PROFILING
+	// Counts instructions and method calls. See Profiler for details.
+	Box<Profiler> profiler;
+#endif
+
+	// The sampling profiler, or null if it is disabled.
+	Box<Sampler> sampler;
+	// The file to which the sampler's results are written.
+	Box<PathName> sampleFile;
+
 	// The module pool, which contains all currently loaded modules.
 	Box<ModulePool> modules;
 
@@ -57,12 +90,24 @@ private:
 	// Static strings, mostly member names and error messages.
 	Box<StaticStrings> strings;
 
+	// Validates the GC and execution engine parameters in the specified start
+	// parameters, and replaces zero values with defaults from config::Defaults.
+	// Prints a message and returns OVUM_ERROR_INVALID_PARAMS if a value is out
+	// of range.
+	static int ValidateStartParams(VMStartParams &params);
+
 	int LoadModules(VMStartParams &params);
 
 	int InitArgs(size_t argCount, const wchar_t *args[]);
 
 	int GetMainMethodOverload(Method *method, ovlocals_t &argc, MethodOverload *&overload);
 
+	void WriteSamples();
+
+	void SaveMethodCaches();
+
+	int PreinitializeMethods();
+
 	static void PrintInternal(FILE *file, const wchar_t *format, String *str);
 
 public:
@@ -81,6 +126,61 @@ public:
 		return gc.get();
 	}
 
+	// Gets the JIT compiler, or null if it is disabled.
+	inline Jit *GetJit() const
+	{
+		return jit.get();
+	}
+
+#if OVUM_PROFILING
+	inline Profiler *GetProfiler() const
+	{
+		return profiler.get();
+	}
+#endif
+
+	// Determines whether method bodies are read from module files the first
+	// time each method is called. See Module::ReadDeferredMethodBody().
+	inline bool HasLazyMethodBodies() const
+	{
+		return lazyMethodBodies;
+	}
+
+	// Gets the directory that contains method cache files, or null if method
+	// bodies are not cached.
+	inline const PathName *GetMethodCacheDirectory() const
+	{
+		return methodCacheDirectory.get();
+	}
+
+	// Gets the background method initializer, or null if it is disabled.
+	inline BackgroundInitializer *GetBackgroundInitializer() const
+	{
+		return backgroundInitializer.get();
+	}
+
+	// Gets the sampling profiler, or null if it is disabled.
+	inline Sampler *GetSampler() const
+	{
+		return sampler.get();
+	}
+
+	// Prints the profiler's report to stderr. Returns false if the VM was built
+	// without profiling (see OVUM_PROFILING), in which case nothing is printed.
+	bool PrintProfile();
+
+	// Gets the VM that is running on the current thread. This is set for
+	// every managed thread, as well as the GC's finalizer thread.
+	static inline VM *GetCurrent()
+	{
+		return vmKey.Get();
+	}
+
+	inline size_t GetCallStackSize() const
+	{
+		return callStackSize;
+	}
+
 	inline ModulePool *GetModulePool() const
 	{
 		return modules.get();
@@ -141,9 +241,13 @@ public:
 
 	void PrintMethodInitException(MethodInitException &e);
 
+	void PrintModuleLoadError(ModuleLoadException &e);
+
 	// Contains the VM running on the current thread.
 	static TlsEntry<VM> vmKey;
 
+	friend class BackgroundInitializer;
+	friend class FinalizerThread;
 	friend class GC;
 	friend class Module;
 	template<class Visitor>
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "../vm.h"
+#include "gcobject.h"
+
+namespace ovum
+{
+
+// A thread-local allocation buffer: a chunk of generation 0 that has been
+// handed out to a single thread, from which that thread can allocate small
+// objects without taking the GC's allocation lock. Objects are allocated by
+// simply bumping a pointer.
+//
+// Each Thread has exactly one AllocBuffer. When the buffer runs out of space,
+// the thread enters the allocation lock and asks the GC for a new chunk (see
+// GC::RefillAllocBuffer). At the start of each GC cycle, every thread's buffer
+// is invalidated, since generation 0 is emptied by the cycle.
+//
+// The GC records the start of each object in a side bitmap (see MarkBitmap).
+// Buffers start and end on bitmap word boundaries, so a thread can set the
+// bits for its own objects without the allocation lock.
+class AllocBuffer
+{
+public:
+	inline AllocBuffer() :
+		current(nullptr),
+		end(nullptr),
+		refillCount(0)
+	{ }
+
+	// Gets the number of times this buffer has been refilled.
+	inline uint32_t GetRefillCount() const
+	{
+		return refillCount;
+	}
+
+	// Attempts to allocate an object of the specified size from the buffer.
+	// The object is zeroed (the memory was cleared when the buffer was filled),
+	// and has its GEN_0 flag set. If there is not enough space left, returns
+	// null, and the buffer must be refilled.
+	//   size:
+	//     The total size of the object, including the GCObject header. This
+	//     value must be aligned to 8 bytes.
+	inline GCObject *TryAlloc(size_t size)
+	{
+		if ((size_t)(end - current) < size)
+			return nullptr;
+
+		GCObject *result = reinterpret_cast<GCObject*>(current);
+		current += size;
+		result->flags = GCOFlags::GEN_0;
+		return result;
+	}
+
+private:
+	// The next available byte in the buffer.
+	char *current;
+	// The end of the buffer (exclusive).
+	char *end;
+
+	// The number of times the buffer has been refilled.
+	uint32_t refillCount;
+
+	friend class GC;
+};
+
+} // namespace ovum
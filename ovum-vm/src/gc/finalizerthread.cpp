@@ -0,0 +1,179 @@
+#include "finalizerthread.h"
+#include "gc.h"
+#include "../ee/vm.h"
+
+namespace ovum
+{
+
+Box<FinalizerThread> FinalizerThread::New(VM *vm)
+{
+	Box<FinalizerThread> result(new(std::nothrow) FinalizerThread(vm));
+	if (!result)
+		return nullptr;
+
+	if (!os::ThreadStart(&result->thread, ThreadMain, result.get()))
+		return nullptr;
+	result->threadRunning = true;
+
+	return std::move(result);
+}
+
+FinalizerThread::FinalizerThread(VM *vm) :
+	vm(vm),
+	thread(),
+	threadRunning(false),
+	submittedCount(0),
+	finishedCount(0),
+	waiterCount(0),
+	shuttingDown(false),
+	workSignal(0),
+	batchDone(0)
+{ }
+
+FinalizerThread::~FinalizerThread()
+{
+	Shutdown();
+}
+
+void FinalizerThread::Submit(ObjectArray &objects)
+{
+	size_t count = objects.GetCount();
+	if (count == 0)
+		return;
+
+	lock.Enter();
+	if (pending.IsEmpty())
+	{
+		pending.Swap(objects);
+	}
+	else
+	{
+		for (size_t i = 0; i < count; i++)
+			if (!pending.Push(objects[i]))
+				// Not enough memory to keep track of the objects; cannot
+				// recover from this.
+				abort();
+	}
+	submittedCount += count;
+	lock.Leave();
+
+	objects.Clear();
+	workSignal.Leave();
+}
+
+void FinalizerThread::MarkFinishedObjects()
+{
+	lock.Enter();
+
+	size_t count = finished.GetCount();
+	for (size_t i = 0; i < count; i++)
+	{
+		GCObject *gco = finished[i];
+		OVUM_ASSERT((gco->flags & GCOFlags::FINALIZING) == GCOFlags::FINALIZING);
+
+		gco->flags &= ~GCOFlags::FINALIZING;
+		gco->flags |= GCOFlags::FINALIZED;
+		// The GC pinned the object. Native code might have pinned it as well,
+		// without ever unpinning it.
+		if (gco->pinCount == 0)
+			gco->flags &= ~GCOFlags::PINNED;
+	}
+	finished.Clear();
+
+	lock.Leave();
+}
+
+void FinalizerThread::WaitForPendingFinalizers()
+{
+	lock.Enter();
+
+	uint64_t target = submittedCount;
+	while (finishedCount < target)
+	{
+		// FinalizeWorking() increments batchDone once for every waiter that
+		// was registered when it finished its batch.
+		waiterCount++;
+		lock.Leave();
+
+		batchDone.Enter();
+
+		lock.Enter();
+	}
+
+	lock.Leave();
+}
+
+void FinalizerThread::Shutdown()
+{
+	if (!threadRunning)
+		return;
+
+	lock.Enter();
+	shuttingDown = true;
+	lock.Leave();
+
+	workSignal.Leave();
+	os::ThreadJoin(&thread);
+	threadRunning = false;
+}
+
+void FinalizerThread::FinalizeWorking()
+{
+	size_t count = working.GetCount();
+	if (count == 0)
+		return;
+
+	for (size_t i = 0; i < count; i++)
+		GC::RunFinalizers(working[i]);
+
+	lock.Enter();
+
+	if (finished.IsEmpty())
+	{
+		finished.Swap(working);
+	}
+	else
+	{
+		for (size_t i = 0; i < count; i++)
+			if (!finished.Push(working[i]))
+				abort(); // Same as in Submit()
+	}
+	finishedCount += count;
+
+	uint32_t waiters = waiterCount;
+	waiterCount = 0;
+
+	lock.Leave();
+
+	working.Clear();
+	for (uint32_t i = 0; i < waiters; i++)
+		batchDone.Leave();
+}
+
+void FinalizerThread::ThreadMain(void *state)
+{
+	FinalizerThread *self = reinterpret_cast<FinalizerThread*>(state);
+
+	// Finalizers have no managed thread, but some of them call back into
+	// the GC, which has to be able to find the VM.
+	VM::vmKey.Set(self->vm);
+
+	while (true)
+	{
+		self->workSignal.Enter();
+
+		self->lock.Enter();
+		self->working.Swap(self->pending);
+		// The GC only shuts us down outside of a cycle, so nothing can be
+		// submitted after this.
+		bool exit = self->shuttingDown;
+		self->lock.Leave();
+
+		self->FinalizeWorking();
+
+		if (exit)
+			break;
+	}
+}
+
+} // namespace ovum
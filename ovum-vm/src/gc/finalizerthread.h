@@ -0,0 +1,112 @@
+#pragma once
+
+#include "../vm.h"
+#include "gcobject.h"
+#include "objectarray.h"
+#include "../threading/sync.h"
+
+// The finalizer thread runs the finalizers of dead objects, so that the GC
+// doesn't have to. Finalizers can take an arbitrary amount of time (closing
+// a file handle may have to wait for the disk, for example), and running them
+// inside the GC cycle would make every pause as long as the slowest finalizer.
+//
+// When the GC finds a dead object whose type has a finalizer, it does not
+// release the object. Instead, the object is given the flags FINALIZING and
+// PINNED, and added to the GC's finalization queue. Gen0 objects are copied
+// to gen1 first, since gen0 is reused as soon as the cycle ends. At the end
+// of the cycle, the queue is submitted to the finalizer thread, which runs
+// the finalizers in the background, without holding any GC lock.
+//
+// While an object is FINALIZING, the GC leaves it alone: it is not swept, not
+// moved by compaction, and its fields are never examined. (Its fields may well
+// refer to objects that have been released.) Once its finalizers have run, the
+// object is handed back to the GC, which gives it the flag FINALIZED at the
+// start of the next cycle. A FINALIZED object is released without running its
+// finalizers again, the next time its generation is swept.
+//
+// The finalizer thread never touches the GCObject header of an object it is
+// finalizing. All communication with the GC goes through the arrays in this
+// class, which are protected by a lock.
+
+namespace ovum
+{
+
+class FinalizerThread
+{
+public:
+	// Creates a finalizer thread, and starts it.
+	//   vm:
+	//     The VM that owns the GC. Finalizers that call back into the GC
+	//     (such as GC_RemoveMemoryPressure) find the VM through this.
+	static Box<FinalizerThread> New(VM *vm);
+
+	// Shuts the thread down, if it is still running. See Shutdown().
+	~FinalizerThread();
+
+	// Queues objects to be finalized, and empties the array. Every object
+	// must have the flag FINALIZING. Called by the GC at the end of a cycle.
+	void Submit(ObjectArray &objects);
+
+	// Gives every object whose finalizers have run since the last call the
+	// flag FINALIZED (instead of FINALIZING and PINNED). Must only be called
+	// during a GC cycle, or once the thread has been shut down.
+	void MarkFinishedObjects();
+
+	// Blocks until every object submitted before the call has been finalized.
+	// This must not be called on the finalizer thread.
+	void WaitForPendingFinalizers();
+
+	// Runs the finalizers of every object that has been submitted, and then
+	// stops the thread. Afterwards, MarkFinishedObjects() should be called.
+	void Shutdown();
+
+private:
+	VM *vm;
+
+	os::NativeThread thread;
+	// True if thread refers to a running thread.
+	bool threadRunning;
+
+	// Protects everything below, except working.
+	SpinLock lock;
+
+	// Objects waiting to be finalized.
+	ObjectArray pending;
+	// Objects whose finalizers have run, but which have not yet been passed
+	// to MarkFinishedObjects().
+	ObjectArray finished;
+
+	// The total number of objects that have been submitted, and the total
+	// number of those that have been finalized. WaitForPendingFinalizers()
+	// waits until the latter catches up with the former.
+	uint64_t submittedCount;
+	uint64_t finishedCount;
+
+	// The number of threads blocked in WaitForPendingFinalizers().
+	uint32_t waiterCount;
+
+	// True when the thread should exit once pending is empty.
+	bool shuttingDown;
+
+	// The objects that the finalizer thread is currently finalizing. Only
+	// the finalizer thread touches this.
+	ObjectArray working;
+
+	// Incremented when objects are submitted, or when the thread should
+	// shut down.
+	Semaphore workSignal;
+	// Incremented once for each waiter after a batch of objects has been
+	// finalized.
+	Semaphore batchDone;
+
+	FinalizerThread(VM *vm);
+
+	// Runs the finalizers of every object in working, and empties it.
+	void FinalizeWorking();
+
+	static void ThreadMain(void *state);
+
+	OVUM_DISABLE_COPY_AND_ASSIGN(FinalizerThread);
+};
+
+} // namespace ovum
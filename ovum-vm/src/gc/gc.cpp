@@ -18,55 +18,80 @@
 namespace ovum
 {
 
-Box<GC> GC::New(VM *owner)
+Box<GC> GC::New(VM *owner, VMStartParams &params)
 {
-	Box<GC> result(new(std::nothrow) GC(owner));
+	Box<GC> result(new(std::nothrow) GC(owner, params));
 	if (!result)
 		return nullptr;
 	if (!result->InitializeHeaps())
 		return nullptr;
 
+	if (params.gcWorkerCount > 1)
+	{
+		result->parallelMarker = ParallelMarker::New(result.get(), params.gcWorkerCount);
+		if (!result->parallelMarker)
+			return nullptr;
+	}
+
+	result->finalizerThread = FinalizerThread::New(owner);
+	if (!result->finalizerThread)
+		return nullptr;
+
 	return std::move(result);
 }
 
-GC::GC(VM *owner) :
-	collectList(nullptr),
-	pinnedList(nullptr),
-	currentWhite((GCOFlags)1),
-	currentBlack((GCOFlags)3),
+GC::GC(VM *owner, VMStartParams &params) :
+	gen0Current(nullptr),
+	gen0Base(nullptr),
+	gen0End(nullptr),
+	gen0Size(params.gen0Size),
+	adaptiveGen0(params.adaptiveGen0),
+	largeObjectSize(params.largeObjectSize),
+	gen1DeadObjectThreshold(params.gen1DeadObjectThreshold),
+	mainHeap(nullptr),
+	largeObjectHeap(nullptr),
+	moduleStringCurrent(nullptr),
+	moduleStringEnd(nullptr),
+	nextPinned(0),
+	oldGrowthSinceFullCycle(0),
+	memoryPressure(0),
+	pressureSinceFullCycle(0),
 	gen1Size(0),
 	collectCount(0),
+	compactGen1(params.compactGen1),
+	compactionCount(0),
+	allocBufferRefillCount(0),
 	strings(32),
 	staticRefs(),
-	mainHeap(nullptr),
-	largeObjectHeap(nullptr),
-	gen0Base(nullptr),
-	gen0Current(nullptr),
-	gen0End(nullptr),
 	allocSection(5000),
 	vm(owner)
 { }
 
 GC::~GC()
 {
-	// Clean up all objects
-	GCObject *gco = collectList;
-	while (gco)
+	// Let the finalizer thread finish whatever it is doing. Once it has been
+	// shut down, the objects it finalized can be released, and any remaining
+	// finalizers run inline, on this thread.
+	if (finalizerThread)
 	{
-		GCObject *next = gco->next;
-		Release(gco);
-		gco = next;
+		finalizerThread->Shutdown();
+		finalizerThread->MarkFinishedObjects();
+		finalizerThread.reset();
 	}
-	collectList = nullptr;
 
-	gco = pinnedList;
-	while (gco)
+	// Clean up all objects. Outside of a cycle, the mark bits are left over
+	// from the last cycle, so we clear them first; then every object looks
+	// dead to the sweepers.
+	if (gen0Base)
 	{
-		GCObject *next = gco->next;
-		Release(gco);
-		gco = next;
+		gen0Marks.ClearAll();
+		SweepGen0();
 	}
-	pinnedList = nullptr;
+
+	gen1Heap.ClearMarks();
+	gen1Heap.Sweep(*this);
+
+	SweepLargeObjects();
 
 	DestroyHeaps();
 }
@@ -74,21 +99,32 @@ GC::~GC()
 bool GC::InitializeHeaps()
 {
 	// Create the mainHeap with enough initial memory for the gen0 chunk
-	if (!os::HeapCreate(&mainHeap, config::Defaults::GEN0_SIZE))
+	if (!os::HeapCreate(&mainHeap, gen0Size))
 		return false;
 
 	// The LOH has no initial size
 	if (!os::HeapCreate(&largeObjectHeap, 0))
 		return false;
 
+	if (!gen1Heap.Init())
+		return false;
+
 	// Allocate gen0
-	gen0Base = os::HeapAlloc(&mainHeap, config::Defaults::GEN0_SIZE, false);
-	if (!gen0Base)
+	void *base = os::HeapAlloc(&mainHeap, gen0Size, false);
+	if (!base)
 		// This shouldn't happen since mainHeap is initialized with
 		// a size that should be enough for gen0, but let's check
 		// for it anyway.
 		return false;
-	gen0End = (char*)gen0Base + config::Defaults::GEN0_SIZE;
+
+	if (!gen0Starts.Init(base, gen0Size) ||
+		!gen0Marks.Init(base, gen0Size))
+		return false;
+
+	// gen0Base is only set once everything has been initialized; the
+	// destructor relies on this.
+	gen0Base = base;
+	gen0End = (char*)gen0Base + gen0Size;
 	gen0Current = (char*)gen0Base;
 
 	return true;
@@ -107,11 +143,18 @@ GCObject *GC::AllocRaw(size_t size)
 	OVUM_ASSERT(size >= GCO_SIZE);
 
 	GCObject *result;
-	if (size > LARGE_OBJECT_SIZE)
+	if (size > largeObjectSize)
 	{
 		result = (GCObject*)os::HeapAlloc(&largeObjectHeap, size, true);
 		if (result)
+		{
 			result->flags |= GCOFlags::LARGE_OBJECT;
+			if (!largeObjects.Push(result))
+			{
+				os::HeapFree(&largeObjectHeap, result);
+				result = nullptr;
+			}
+		}
 	}
 	else
 	{
@@ -120,9 +163,9 @@ GCObject *GC::AllocRaw(size_t size)
 		// any pinned object. If so, we position the gen0Current
 		// pointer behind the last pinned object where space is
 		// available.
-		if (pinnedList)
+		while (nextPinned < pinnedObjects.GetCount())
 		{
-			GCObject *pinned = pinnedList;
+			GCObject *pinned = pinnedObjects[nextPinned];
 			// Given the ranges [a, b) and [c, d), e.g.:
 			//      a         b
 			//      [---------)
@@ -134,21 +177,12 @@ GCObject *GC::AllocRaw(size_t size)
 			//    b = (char*)pinned + pinned->size
 			//    c = gen0Current
 			//    d = gen0Current + size
-			while (pinned &&
-				gen0Current < (char*)pinned + pinned->size &&
-				(char*)pinned < gen0Current + size)
-			{
-				GCObject *next = pinned->next;
-				// The pinned list is only traversed in one direction;
-				// it is not necessary to call RemoveFromList first.
-				// InsertIntoList updates the prev and next pointers
-				// on the GCObject.
-				pinned->InsertIntoList(&collectList);
-				gen0Current = (char*)pinned + OVUM_ALIGN_TO(pinned->size, 8);
-
-				pinned = next;
-			}
-			pinnedList = pinned;
+			if (gen0Current >= (char*)pinned + pinned->size ||
+				(char*)pinned >= gen0Current + size)
+				break;
+
+			gen0Current = (char*)pinned + OVUM_ALIGN_TO(pinned->size, 8);
+			nextPinned++;
 		}
 
 		result = (GCObject*)gen0Current;
@@ -163,6 +197,7 @@ GCObject *GC::AllocRaw(size_t size)
 			// Always zero all the memory before returning
 			memset(result, 0, size);
 			result->flags |= GCOFlags::GEN_0;
+			gen0Starts.Set(result);
 		}
 	}
 
@@ -171,9 +206,9 @@ GCObject *GC::AllocRaw(size_t size)
 
 GCObject *GC::AllocRawGen1(size_t size)
 {
-	// Don't call with HEAP_ZERO_MEMORY. We'll be copying the old
+	// Gen1Heap does not zero the memory. We'll be copying the old
 	// object into this address anyway, it'd be unnecessary work.
-	return (GCObject*)os::HeapAlloc(&mainHeap, size, false);
+	return gen1Heap.Alloc(size);
 }
 
 void GC::ReleaseRaw(GCObject *gco)
@@ -183,7 +218,7 @@ void GC::ReleaseRaw(GCObject *gco)
 	// Do nothing with gen0 objects
 	case GCOFlags::GEN_1:
 		gen1Size -= gco->size;
-		os::HeapFree(&mainHeap, gco);
+		gen1Heap.Free(gco);
 		break;
 	case GCOFlags::LARGE_OBJECT:
 		os::HeapFree(&largeObjectHeap, gco);
@@ -196,14 +231,31 @@ int GC::Alloc(Thread *const thread, Type *type, size_t size, GCObject **output)
 	if (SIZE_MAX - size < GCO_SIZE)
 		return thread->ThrowMemoryError(vm->GetStrings()->error.ObjectTooLarge);
 
+	size += GCO_SIZE;
+
+	// Small objects are allocated from the thread's allocation buffer, which
+	// does not require the allocation lock in the common case.
+	if (size <= MAX_BUFFERED_OBJECT_SIZE)
+	{
+		GCObject *gco = AllocBuffered(thread, size);
+		if (!gco)
+			return OVUM_ERROR_NO_MEMORY;
+
+		// The buffer was zeroed when it was filled, so DO NOT do that here.
+		gco->size = size;
+		gco->type = type;
+
+		*output = gco;
+		RETURN_SUCCESS;
+	}
+
 	BeginAlloc(thread);
 
-	size += GCO_SIZE;
 	GCObject *gco = AllocRaw(size);
 
 	if (!gco) // Allocation failed (we're probably out of memory)
 	{
-		RunCycle(thread, size >= LARGE_OBJECT_SIZE);  // Try to free some memory...
+		RunCycle(thread, size >= largeObjectSize);  // Try to free some memory...
 		// Note: call RunCycle instead of Collect, because Collect calls
 		// BeginAlloc to protect instance members. We've already called
 		// that method, so we don't need to do it again.
@@ -211,14 +263,22 @@ int GC::Alloc(Thread *const thread, Type *type, size_t size, GCObject **output)
 		gco = AllocRaw(size); // ... And allocate again
 
 		if (!gco)
+		{
+			EndAlloc();
 			return OVUM_ERROR_NO_MEMORY;
+		}
 	}
 
 	// AllocRaw zeroes the memory, so DO NOT do that here.
 	gco->size = size;
 	gco->type = type;
-	gco->flags |= currentWhite;
-	gco->InsertIntoList(&collectList);
+	if ((gco->flags & GCOFlags::LARGE_OBJECT) == GCOFlags::LARGE_OBJECT)
+	{
+		// Large objects never live in gen0, so they go straight into the
+		// old generation.
+		oldGrowthSinceFullCycle += size;
+		RememberIfUnbarriered(gco);
+	}
 
 	*output = gco;
 
@@ -227,6 +287,127 @@ int GC::Alloc(Thread *const thread, Type *type, size_t size, GCObject **output)
 	RETURN_SUCCESS;
 }
 
+GCObject *GC::AllocBuffered(Thread *const thread, size_t size)
+{
+	size = OVUM_ALIGN_TO(size, 8);
+
+	AllocBuffer &buffer = thread->allocBuffer;
+	GCObject *gco = buffer.TryAlloc(size);
+	if (gco)
+	{
+		// The buffer covers whole words of the bitmap, so no other thread
+		// can be modifying the word we're writing to.
+		gen0Starts.Set(gco);
+		return gco;
+	}
+
+	// The buffer is exhausted; we have to get a new one, which means
+	// touching shared GC state.
+	BeginAlloc(thread);
+
+	if (!RefillAllocBuffer(thread, size))
+	{
+		// Not enough space left in gen0. RunCycle invalidates all buffers,
+		// including this thread's, and empties gen0.
+		RunCycle(thread, false);
+
+		if (!RefillAllocBuffer(thread, size))
+		{
+			EndAlloc();
+			return nullptr;
+		}
+	}
+
+	EndAlloc();
+
+	// Guaranteed to succeed now.
+	gco = buffer.TryAlloc(size);
+	OVUM_ASSERT(gco != nullptr);
+	gen0Starts.Set(gco);
+	return gco;
+}
+
+bool GC::RefillAllocBuffer(Thread *const thread, size_t minSize)
+{
+	// Allocations larger than this are not buffered.
+	OVUM_ASSERT(minSize <= config::Defaults::ALLOC_BUFFER_SIZE);
+
+	AllocBuffer &buffer = thread->allocBuffer;
+
+	// If nothing has been carved out of gen0 since this buffer was filled,
+	// we can give the unused tail back, so that it isn't wasted.
+	if (buffer.end != nullptr && buffer.end == gen0Current)
+		gen0Current = buffer.current;
+	buffer.current = nullptr;
+	buffer.end = nullptr;
+
+	while (true)
+	{
+		// The buffer cannot extend past the next pinned object, if there is
+		// one. The pinned objects are sorted by address, and every object
+		// from nextPinned onwards is located after gen0Current.
+		char *limit = nextPinned < pinnedObjects.GetCount()
+			? (char*)pinnedObjects[nextPinned]
+			: (char*)gen0End;
+
+		// The owning thread records its allocations in gen0Starts without
+		// the allocation lock. To ensure no other thread modifies the same
+		// words at the same time, the buffer must start and end on a word
+		// boundary of the bitmap.
+		// Note: a failed AllocRaw may leave gen0Current past the end of gen0.
+		const size_t wordSize = MarkBitmap::BYTES_PER_WORD;
+		char *start = (char*)gen0Base +
+			OVUM_ALIGN_TO((size_t)(gen0Current - (char*)gen0Base), wordSize);
+		char *end = (char*)gen0Base +
+			(size_t)(limit - (char*)gen0Base) / wordSize * wordSize;
+		size_t available = start < end ? end - start : 0;
+		if (available >= minSize)
+		{
+			// Both values are multiples of the word size, and so the result is
+			// as well.
+			size_t size = available;
+			if (size > config::Defaults::ALLOC_BUFFER_SIZE)
+				size = config::Defaults::ALLOC_BUFFER_SIZE;
+
+			// Zero the whole buffer up front, so that each allocation from it
+			// doesn't have to.
+			memset(start, 0, size);
+
+			buffer.current = start;
+			buffer.end = start + size;
+			buffer.refillCount++;
+			allocBufferRefillCount++;
+
+			gen0Current = start + size;
+			return true;
+		}
+
+		if (nextPinned == pinnedObjects.GetCount())
+			return false;
+
+		// Not enough room before the next pinned object; skip past it. See
+		// AllocRaw for details.
+		GCObject *pinned = pinnedObjects[nextPinned++];
+		gen0Current = (char*)pinned + OVUM_ALIGN_TO(pinned->size, 8);
+	}
+}
+
+void GC::InvalidateAllocBuffer(Thread *const thread)
+{
+	AllocBuffer &buffer = thread->allocBuffer;
+	buffer.current = nullptr;
+	buffer.end = nullptr;
+}
+
+void GC::InvalidateAllocBuffers()
+{
+	// Currently there is only one managed thread. When more are added, this
+	// must visit every one of them; by then, they are all suspended.
+	Thread *thread = vm->mainThread.get();
+	if (thread)
+		InvalidateAllocBuffer(thread);
+}
+
 int GC::Alloc(Thread *const thread, Type *type, size_t size, Value *output)
 {
 	GCObject *gco;
@@ -408,24 +589,59 @@ String *GC::ConvertString(Thread *const thread, const char *string)
 String *GC::ConstructModuleString(Thread *const thread, size_t length, const ovchar_t value[])
 {
 	// Replicate some functionality of Alloc here
-	size_t size = sizeof(String) + length*sizeof(ovchar_t) + GCO_SIZE;
+	size_t size = OVUM_ALIGN_TO(sizeof(String) + length*sizeof(ovchar_t) + GCO_SIZE, 8);
+
+	BeginAlloc(thread);
 
-	GCObject *gco = AllocRawGen1(size);
+	// Module strings live for as long as the VM does. They are not in any
+	// generation, and are allocated outside the gen1 heap, so that they are
+	// never marked or swept. The memory is released when the heap itself is
+	// destroyed. Since they are never freed individually, most of them are
+	// packed into larger chunks, which saves a heap block header per string.
+	GCObject *gco;
+	if (size > config::Defaults::MODULE_STRING_CHUNK_SIZE / 4)
+	{
+		// Large strings would waste too much of a chunk.
+		gco = (GCObject*)os::HeapAlloc(&mainHeap, size, true);
+	}
+	else
+	{
+		if (size > (size_t)(moduleStringEnd - moduleStringCurrent))
+		{
+			char *chunk = (char*)os::HeapAlloc(&mainHeap, config::Defaults::MODULE_STRING_CHUNK_SIZE, true);
+			if (chunk)
+			{
+				moduleStringCurrent = chunk;
+				moduleStringEnd = chunk + config::Defaults::MODULE_STRING_CHUNK_SIZE;
+			}
+		}
+
+		if (size <= (size_t)(moduleStringEnd - moduleStringCurrent))
+		{
+			gco = (GCObject*)moduleStringCurrent;
+			moduleStringCurrent += size;
+		}
+		else
+		{
+			gco = nullptr;
+		}
+	}
 	if (!gco)
+	{
+		EndAlloc();
 		throw ModuleLoadException(L"(none)", "Not enough memory for module string.");
+	}
 
-	// AllocRawGen1 does NOT zero the memory, so we have to do that ourselves:
-	memset(gco, 0, size);
-
-	// Pin the strings so that they will never move, even if we later update
-	// the GC to compact gen1
+	// Pin the strings so that they will never move. The root set walkers
+	// rely on this.
 	gco->size = size;
 	gco->type = vm->types.String;
-	gco->flags |= currentWhite | GCOFlags::PINNED;
+	gco->flags |= GCOFlags::PINNED;
 	if (gco->type == nullptr)
 		gco->flags |= GCOFlags::EARLY_STRING;
 	gco->pinCount++;
-	gco->InsertIntoList(&collectList);
+
+	EndAlloc();
 
 	MutableString *str = reinterpret_cast<MutableString*>(gco->InstanceBase());
 	str->length = length;
@@ -434,61 +650,127 @@ String *GC::ConstructModuleString(Thread *const thread, size_t length, const ovc
 	return str->AsString();
 }
 
+String *GC::GetModuleString(Thread *const thread, size_t length, const ovchar_t value[])
+{
+	// Most strings in a module also occur in modules that have already been
+	// loaded, such as member names and common messages.
+	String *string = strings.GetInterned(length, value);
+	if (string == nullptr)
+	{
+		string = ConstructModuleString(thread, length, value);
+		// Intern() returns the existing string if another thread got there
+		// first. The one we just allocated is then wasted, but that's rare.
+		string = strings.Intern(string);
+	}
+	return string;
+}
+
 String *GC::GetInternedString(Thread *const thread, String *value)
 {
-	BeginAlloc(thread);
-	String *result = strings.GetInterned(value);
-	EndAlloc();
-	return result;
+	return strings.GetInterned(value);
 }
 
 bool GC::HasInternedString(Thread *const thread, String *value)
 {
-	BeginAlloc(thread);
-	bool result = strings.HasInterned(value);
-	EndAlloc();
-	return result;
+	return strings.HasInterned(value);
 }
 
 String *GC::InternString(Thread *const thread, String *value)
 {
-	BeginAlloc(thread);
-	String *result = strings.Intern(value);
-	EndAlloc();
-	return result;
+	return strings.Intern(value);
 }
 
-void GC::Release(GCObject *gco)
+bool GC::Finalize(GCObject *gco)
 {
-	OVUM_ASSERT(gco->GetColor() == currentWhite);
-
 	if (gco->IsEarlyString() || gco->type == vm->types.String)	
 	{
 		String *str = reinterpret_cast<String*>(gco->InstanceBase());
 		if ((str->flags & StringFlags::INTERN) != StringFlags::NONE)
 			strings.RemoveIntern(str);
+		return true;
 	}
-	else if (!gco->IsArray() && gco->type->HasFinalizer())
+
+	if (gco->IsArray() || !gco->type->HasFinalizer())
+		return true;
+
+	// The finalizer thread has already run the finalizers of a FINALIZED
+	// object, and is still running those of a FINALIZING object.
+	if ((gco->flags & GCOFlags::FINALIZED) == GCOFlags::FINALIZED)
+		return true;
+	if ((gco->flags & GCOFlags::FINALIZING) == GCOFlags::FINALIZING)
+		return false;
+
+	// Without a finalizer thread (during shutdown), or if we run out of memory
+	// trying to queue the object, the finalizers have to run right here.
+	if (!finalizerThread)
+		goto runInline;
+
+	if ((gco->flags & GCOFlags::GENERATION) == GCOFlags::GEN_0)
 	{
-		Type *type = gco->type;
-		do
+		size_t objectSize = gco->size;
+		GCObject *copy = AllocRawGen1(objectSize);
+		if (copy == nullptr)
+			goto runInline;
+
+		memcpy(copy, gco, objectSize);
+		// The copy is dead, so it is never remembered, and its references to
+		// gen0 objects are never updated. If this is a full cycle, gen1 is
+		// swept after gen0, and the sweep keeps the copy (and marks it) since
+		// it is FINALIZING.
+		copy->flags = (copy->flags & ~(GCOFlags::GENERATION | GCOFlags::REMEMBERED | GCOFlags::HAS_GEN0_REFS)) |
+			GCOFlags::GEN_1 | GCOFlags::FINALIZING | GCOFlags::PINNED;
+
+		if (!finalizationQueue.Push(copy))
 		{
-			if (type->finalizer)
-				type->finalizer(gco->InstanceBase(type));
-		} while (type = type->baseType);
+			ReleaseRaw(copy);
+			goto runInline;
+		}
+
+		gen1Size += objectSize;
+		oldGrowthSinceFullCycle += objectSize;
+		// The gen0 original is released along with the rest of gen0.
+		return true;
 	}
 
-	ReleaseRaw(gco); // goodbye, dear pointer.
+	if (!finalizationQueue.Push(gco))
+		goto runInline;
+	// Pinning the object keeps compaction from moving it while the finalizer
+	// thread is using it.
+	gco->flags |= GCOFlags::FINALIZING | GCOFlags::PINNED;
+	return false;
+
+runInline:
+	RunFinalizers(gco);
+	return true;
+}
+
+void GC::RunFinalizers(GCObject *gco)
+{
+	Type *type = gco->type;
+	do
+	{
+		if (type->finalizer)
+			type->finalizer(gco->InstanceBase(type));
+	} while (type = type->baseType);
 }
 
 void GC::AddMemoryPressure(Thread *const thread, size_t size)
 {
-	// Not implemented yet
+	memoryPressure.fetch_add(size, std::memory_order_relaxed);
+	size_t sinceFullCycle = pressureSinceFullCycle.fetch_add(size, std::memory_order_relaxed) + size;
+
+	// The unmanaged memory is likely to be owned by an old object, or by one
+	// that will be old by the time it dies. If a lot of it has been allocated,
+	// we'd better find out how much of it is garbage, without waiting for gen0
+	// to fill up.
+	if (sinceFullCycle >= config::Defaults::MEMORY_PRESSURE_THRESHOLD)
+		Collect(thread, true);
 }
 
-void GC::RemoveMemoryPressure(Thread *const thread, size_t size)
+void GC::RemoveMemoryPressure(size_t size)
 {
-	// Not implemented yet
+	OVUM_ASSERT(memoryPressure.load(std::memory_order_relaxed) >= size);
+	memoryPressure.fetch_sub(size, std::memory_order_relaxed);
 }
 
 StaticRef *GC::AddStaticReference(Thread *const thread, Value *value)
@@ -520,84 +802,120 @@ void GC::Collect(Thread *const thread, bool collectGen1)
 	EndAlloc();
 }
 
+void GC::WaitForPendingFinalizers(Thread *const thread)
+{
+	// Finalizers may take a while, and the thread must not hold up any cycles
+	// that start while it waits.
+	thread->EnterUnmanagedRegion();
+	finalizerThread->WaitForPendingFinalizers();
+	thread->LeaveUnmanagedRegion();
+}
+
 void GC::RunCycle(Thread *const thread, bool collectGen1)
 {
 	BeginCycle(thread);
 
 	collectCount++;
 
-	// Upon entering this method, all objects are in collectList and pinnedList.
-	// The pinned list is usually empty when we enter here, but a cycle can be
-	// triggered when the pinned objects take up too much space or leave gaps
-	// too small to fit an object into, or when a large object can't be allocated.
+	// Objects whose finalizers have run since the last cycle can now be
+	// released, the next time their generation is swept.
+	finalizerThread->MarkFinishedObjects();
+
+	// No managed code is running, so nothing is looking at old intern tables.
+	strings.ReleaseRetiredTables();
+
+	// Gen0 is about to be emptied, so all allocation buffers are invalidated.
+	InvalidateAllocBuffers();
+
+	// A failed allocation may have left gen0Current past the end of gen0.
+	size_t gen0Used = gen0Current < (char*)gen0End
+		? gen0Current - (char*)gen0Base
+		: gen0Size;
+
+	bool fullCycle = collectGen1 || ShouldRunFullCycle();
+
+	// Every object is unmarked before we start. Gen0 objects are marked in
+	// gen0Marks, which is cleared every cycle.
 	//
-	// Let's start by copying all pinned objects into the Collect list. During
-	// the cycle, we'll rebuild the pinned list anyway.
-	if (pinnedList)
+	// A full cycle examines every object, so the gen1 mark bitmaps have to be
+	// cleared as well. (Large objects are unmarked as they are swept.) The
+	// remembered set is rebuilt from scratch as live objects are found.
+	//
+	// A minor cycle leaves the old generation alone; old objects are assumed
+	// to be alive, and objects in the remembered set act as additional roots.
+	gen0Marks.ClearAll();
+	if (fullCycle)
 	{
-		GCObject *pinned = pinnedList;
-		while (pinned)
-		{
-			GCObject *next = pinned->next;
-			// No need to call RemoveFromList first;
-			// we're accessing the items sequentially,
-			// and nothing else will touch the list.
-			pinned->InsertIntoList(&collectList);
-			pinned = next;
-		}
-		pinnedList = nullptr;
+		gen1Heap.ClearMarks();
+		rememberedSet.Clear();
 	}
 
 	// Step 1: Find all live objects.
-	// During this step, we also separate survivors into one of three groups:
-	//
-	// * Survivors from generation 0.
-	// * Survivors with references to generation 0 objects.
-	// * All other survivors.
-	//
-	// See LiveObjectFinder for more details on each group.
-	LiveObjectFinder liveFinder(this);
+	// The LiveObjectFinder marks every reachable object, using markStack to
+	// keep track of the objects whose fields have yet to be examined. Old
+	// objects with references to gen0 objects are collected in the array
+	// survivorsWithGen0Refs.
+	LiveObjectFinder liveFinder(this, fullCycle);
 	liveFinder.FindLiveObjects();
+	OVUM_ASSERT(markStack.IsEmpty());
 
 	// Step 2: Process gen0 survivors.
-	// For each object:
-	// * If the object is pinned, add it to the list of pinned objects.
+	// Gen0 is scanned linearly, and for each marked object:
+	// * If the object is pinned, add it to the array of pinned objects.
 	// * Otherwise, allocate gen1 space for the object, move the data, and mark
 	//   the original gen0 location with GCOFlags::MOVED.
-	// * Then, if the object has gen0 refs, add it to the list of such objects;
-	//   otherwise, move it to the "keep" list (nothing more to process).
+	// * Then, if the object has gen0 refs, add it to survivorsWithGen0Refs.
 	MoveGen0Survivors(liveFinder);
-	OVUM_ASSERT(liveFinder.survivorsFromGen0 == nullptr);
 
 	// Step 3: Update objects with gen0 references.
-	// An astute reader may have noticed that pinned objects with gen0 refs are
-	// not actually in liveFinder.survivorsWithGen0Refs, but in pinnedList. For
-	// this reason, we walk through those here as well. The number of pinned
-	// objects is likely to be small, so the performance impact negligible.
+	// Pinned objects with gen0 refs are not in survivorsWithGen0Refs, so we
+	// walk through those here as well. The number of pinned objects is likely
+	// to be small, so the performance impact negligible.
 	UpdateGen0References(liveFinder);
-	OVUM_ASSERT(liveFinder.survivorsWithGen0Refs == nullptr);
+	OVUM_ASSERT(survivorsWithGen0Refs.IsEmpty());
 
 	// Step 4: Collect garbage.
 	// Finalize any collectible dead objects with finalizers, and release the
-	// memory. We only collect gen1 if collectGen1 is true, or if there are
-	// enough dead objects in it.
-	CollectGarbage(liveFinder, collectGen1);
-
-	// The "keep" and "pinned" lists should contain all the live objects now,
-	// and all other lists should be empty.
-	OVUM_ASSERT(liveFinder.survivorsFromGen0 == nullptr);
-	OVUM_ASSERT(liveFinder.survivorsWithGen0Refs == nullptr);
-	OVUM_ASSERT(liveFinder.processList == nullptr);
-
-	// Step 6: Swap white and black for the next cycle and point collectList to
-	// the "keep" list.
-	std::swap(currentWhite, currentBlack);
-	collectList = liveFinder.keepList;
+	// memory. Every unmarked object is dead.
+	CollectGarbage(fullCycle);
+
+	if (fullCycle)
+	{
+		// Step 5: If gen1 is badly fragmented, compact it. Only live objects
+		// remain at this point, which is what makes this possible.
+		if (ShouldCompactGen1())
+			CompactGen1();
+
+		oldGrowthSinceFullCycle = 0;
+		pressureSinceFullCycle.store(0, std::memory_order_relaxed);
+	}
+
+	if (adaptiveGen0)
+		AdaptGen0Size(gen0Used, liveFinder.gen0SurvivorSize);
 	gen0Current = (char*)gen0Base;
+	ResetGen0Starts();
+
+	// Step 6: Hand the dead objects with finalizers to the finalizer thread.
+	finalizerThread->Submit(finalizationQueue);
 
 	EndCycle(thread);
 }
 
+bool GC::ShouldRunFullCycle() const
+{
+	// If the remembered set is incomplete, we have no choice.
+	if (rememberedSet.HasOverflowed())
+		return true;
+
+	// We don't know how much garbage there is in the old generation without
+	// tracing it, but it cannot be more than what has been added to it since
+	// the last full cycle. Unmanaged memory owned by managed objects counts
+	// too, as it is only released when its owner is collected.
+	size_t growth = oldGrowthSinceFullCycle +
+		pressureSinceFullCycle.load(std::memory_order_relaxed);
+	return growth >= gen1DeadObjectThreshold;
+}
+
 void GC::BeginCycle(Thread *const thread)
 {
 	// Future change: suspend every thread except the current
@@ -610,33 +928,95 @@ void GC::EndCycle(Thread *const thread)
 
 void GC::MoveGen0Survivors(LiveObjectFinder &liveFinder)
 {
-	GCObject **list = &liveFinder.survivorsFromGen0;
-
-	GCObject *obj = *list;
-	while (obj)
+	// The pinned objects from the last cycle are still in gen0Starts. They
+	// are added back if they are still alive and pinned. Since we walk gen0
+	// in address order, the array ends up sorted.
+	pinnedObjects.Clear();
+
+	char *end = (char*)gen0End;
+	char *cur = gen0Starts.FindNext((char*)gen0Base, end);
+	while (cur)
 	{
-		GCObject *next = obj->next;
+		GCObject *obj = reinterpret_cast<GCObject*>(cur);
+		// Moving the object does not modify its size.
+		size_t size = obj->size;
 
-		obj->RemoveFromList(list);
-		if (!obj->IsPinned())
-		{
-			// If the object is not pinned, then move it to gen1.
-			MoveSurvivorToGen1(liveFinder, obj);
-		}
-		else
+		if (gen0Marks.IsSet(obj))
 		{
-			// Otherwise, add it to pinnedList.
-			AddPinnedObject(obj);
+			liveFinder.gen0SurvivorSize += size;
+
+			if (!obj->IsPinned())
+			{
+				// If the object is not pinned, then move it to gen1.
+				MoveSurvivorToGen1(liveFinder, obj);
+			}
+			else
+			{
+				// Otherwise, add it to pinnedObjects. The object stays in gen0,
+				// so it will be traced again next cycle; it doesn't need
+				// remembering.
+				obj->flags &= ~GCOFlags::REMEMBERED;
+				if (!pinnedObjects.Push(obj))
+					// Not enough memory to keep track of the object; cannot
+					// recover from this.
+					abort();
+			}
 		}
 
-		obj = next;
+		cur = gen0Starts.FindNext(cur + OVUM_ALIGN_TO(size, 8), end);
 	}
+}
 
-	if (pinnedList)
+void GC::AdaptGen0Size(size_t gen0Used, size_t gen0Survived)
+{
+	// Pinned objects stay in gen0, which means we can't reallocate it.
+	if (!pinnedObjects.IsEmpty())
+		return;
+
+	// If gen0 wasn't even half full, the cycle was triggered by something
+	// else (a large object, memory pressure, an explicit collection), and
+	// the survival rate doesn't tell us much.
+	if (gen0Used < gen0Size / 2)
+		return;
+
+	size_t minSize = config::Defaults::GEN0_MIN_SIZE;
+	if (minSize < 2 * largeObjectSize)
+		minSize = 2 * largeObjectSize;
+
+	size_t survivalRate = gen0Survived * 100 / gen0Used;
+	size_t newSize = gen0Size;
+	if (survivalRate >= config::Defaults::GEN0_GROW_SURVIVAL_RATE &&
+		gen0Size <= config::Defaults::GEN0_MAX_SIZE / 2)
+		newSize = gen0Size * 2;
+	else if (survivalRate <= config::Defaults::GEN0_SHRINK_SURVIVAL_RATE &&
+		gen0Size / 2 >= minSize)
+		newSize = OVUM_ALIGN_TO(gen0Size / 2, 8);
+
+	if (newSize == gen0Size)
+		return;
+
+	// Gen0 is empty at this point, so nothing needs to be copied. If the new
+	// chunk can't be allocated, we just keep using the old one.
+	void *newBase = os::HeapAlloc(&mainHeap, newSize, false);
+	if (newBase == nullptr)
+		return;
+
+	// The bitmaps have to cover the new chunk. They're replaced only once
+	// both have been allocated, so that failure leaves everything as it was.
+	MarkBitmap newStarts, newMarks;
+	if (!newStarts.Init(newBase, newSize) ||
+		!newMarks.Init(newBase, newSize))
 	{
-		GCObject *lastPinned; // ignored
-		pinnedList = FlattenPinnedTree(pinnedList, &lastPinned);
+		os::HeapFree(&mainHeap, newBase);
+		return;
 	}
+	gen0Starts.Swap(newStarts);
+	gen0Marks.Swap(newMarks);
+
+	os::HeapFree(&mainHeap, gen0Base);
+	gen0Base = newBase;
+	gen0End = (char*)newBase + newSize;
+	gen0Size = newSize;
 }
 
 void GC::MoveSurvivorToGen1(LiveObjectFinder &liveFinder, GCObject *gco)
@@ -655,14 +1035,23 @@ void GC::MoveSurvivorToGen1(LiveObjectFinder &liveFinder, GCObject *gco)
 	memcpy(newAddress, gco, objectSize);
 
 	newAddress->flags = (newAddress->flags & ~GCOFlags::GENERATION) | GCOFlags::GEN_1;
-	newAddress->InsertIntoList(
-		newAddress->HasGen0Refs()
-			? &liveFinder.survivorsWithGen0Refs
-			: &liveFinder.keepList
-	);
+	// During a full cycle, gen1 is swept after this, and the new copy must
+	// not be mistaken for garbage.
+	if (liveFinder.fullCycle)
+		gen1Heap.TryMark(newAddress, false);
+	// If the object refers to pinned gen0 objects or has unbarriered refs,
+	// LiveObjectFinder has given it the REMEMBERED flag.
+	if (newAddress->IsRemembered())
+	{
+		newAddress->flags &= ~GCOFlags::REMEMBERED;
+		rememberedSet.Add(newAddress);
+	}
+	if (newAddress->HasGen0Refs() && !survivorsWithGen0Refs.Push(newAddress))
+		abort(); // Same as above
 
 	gen1Size += objectSize;
 	liveFinder.gen1SurvivorSize += objectSize;
+	oldGrowthSinceFullCycle += objectSize;
 
 	gco->flags |= GCOFlags::MOVED;
 	gco->newAddress = newAddress;
@@ -678,99 +1067,179 @@ void GC::MoveSurvivorToGen1(LiveObjectFinder &liveFinder, GCObject *gco)
 
 void GC::UpdateGen0References(LiveObjectFinder &liveFinder)
 {
-	MovedObjectUpdater updater(this, &liveFinder.keepList);
+	MovedObjectUpdater updater(this);
 
-	// MovedObjectUpdater also visits GC::pinnedList.
-	updater.UpdateMovedObjects(liveFinder.survivorsWithGen0Refs);
+	// MovedObjectUpdater also visits GC::pinnedObjects.
+	updater.UpdateMovedObjects(survivorsWithGen0Refs);
 
-	// All done with this list!
-	liveFinder.survivorsWithGen0Refs = nullptr;
+	// All done with these objects!
+	survivorsWithGen0Refs.Clear();
 }
 
-void GC::CollectGarbage(LiveObjectFinder &liveFinder, bool collectGen1)
+void GC::CollectGarbage(bool fullCycle)
 {
-	// If collectGen1 is false, we'll still collect generation 1 if there are
-	// enough dead objects in it.
-	if (!collectGen1)
+	// Every unmarked object is dead: unreachable gen0 objects and, during a
+	// full cycle, unreachable old objects.
+	SweepGen0();
+
+	if (fullCycle)
 	{
-		size_t deadGen1Size = gen1Size - liveFinder.gen1SurvivorSize;
-		collectGen1 = deadGen1Size >= config::Defaults::GEN1_DEAD_OBJECT_THRESHOLD;
+		gen1Heap.Sweep(*this);
+		SweepLargeObjects();
 	}
+}
 
-	GCObject *item = collectList;
-	while (item)
+void GC::SweepGen0()
+{
+	// Gen0 is about to be emptied, so its memory doesn't need to be freed.
+	// We only have to finalize the dead objects. Moved objects were marked,
+	// and are skipped.
+	char *end = (char*)gen0End;
+	char *cur = gen0Starts.FindNext((char*)gen0Base, end);
+	while (cur)
 	{
-		GCObject *next = item->next;
+		GCObject *gco = reinterpret_cast<GCObject*>(cur);
+		if (!gen0Marks.IsSet(gco))
+			Finalize(gco);
 
-		if (collectGen1 || (item->flags & GCOFlags::GENERATION) != GCOFlags::GEN_1)
-		{
-			Release(item);
-		}
-		else
-		{
-			// Uncollectible gen1 object, will be collected in the future.
-			// Note: We don't have to examine gen0 references or anything like
-			// that, because the object is dead.
-			item->InsertIntoList(&liveFinder.keepList);
-			// Color the object black now, so that it will be white next cycle.
-			item->SetColor(currentBlack);
-		}
-
-		item = next;
+		cur = gen0Starts.FindNext(cur + OVUM_ALIGN_TO(gco->size, 8), end);
 	}
-
-	collectList = nullptr;
 }
 
-void GC::AddPinnedObject(GCObject *gco)
+bool GC::ReleaseDeadObject(GCObject *gco)
 {
-	// We initially store the pinned objects in a binary search tree,
-	// which is then flattened to a linked list when we're done with
-	// moving gen0 survivors. Depending on the order in which we walk
-	// through pinned objects, this tree may be terribly unbalanced,
-	// but the number of pinned objects should be small and therefore
-	// the performance impact negligible.
-	// 'prev' is used as the left node (numerically less than the GCO),
-	// 'next' as the right (numerically greater than the GCO).
-	gco->prev = gco->next = nullptr;
+	// Gen1Heap frees the memory, unless we tell it not to.
+	if (!Finalize(gco))
+		return false;
+	gen1Size -= gco->size;
+	return true;
+}
 
-	GCObject **root = &pinnedList;
-	while (true)
+void GC::SweepLargeObjects()
+{
+	// Live objects are moved down to fill the gaps left by dead ones.
+	size_t count = largeObjects.GetCount();
+	size_t keptCount = 0;
+	for (size_t i = 0; i < count; i++)
 	{
-		if (!*root)
+		GCObject *gco = largeObjects[i];
+		if ((gco->flags & GCOFlags::MARKED) == GCOFlags::MARKED)
+		{
+			gco->flags &= ~GCOFlags::MARKED;
+			largeObjects.Set(keptCount++, gco);
+		}
+		else if (Finalize(gco))
 		{
-			*root = gco;
-			break;
+			ReleaseRaw(gco); // goodbye, dear pointer.
 		}
-		else if (gco < *root)
-			root = &(*root)->prev;
-		else if (gco > *root)
-			root = &(*root)->next;
-#if OVUM_DEBUG
 		else
 		{
-			OVUM_ASSERT(!"Failed to insert pinned object into tree; it's probably in the tree already!");
-			break; // fail :(
+			// Kept for the finalizer thread.
+			largeObjects.Set(keptCount++, gco);
 		}
-#endif
 	}
+	largeObjects.Truncate(keptCount);
 }
 
-GCObject *GC::FlattenPinnedTree(GCObject *root, GCObject **lastItem)
+void GC::ResetGen0Starts()
 {
-	GCObject *first = root;
-	*lastItem = root;
-	if (root->prev)
-	{
-		GCObject *leftLast;
-		first = FlattenPinnedTree(root->prev, &leftLast);
-		leftLast->next = root;
-	}
-	if (root->next)
+	gen0Starts.ClearAll();
+
+	size_t count = pinnedObjects.GetCount();
+	for (size_t i = 0; i < count; i++)
+		gen0Starts.Set(pinnedObjects[i]);
+	nextPinned = 0;
+}
+
+bool GC::ShouldCompactGen1() const
+{
+	if (!compactGen1)
+		return false;
+
+	size_t regionSize = gen1Heap.GetRegionSize();
+	if (regionSize < config::Defaults::GEN1_COMPACTION_MIN_SIZE)
+		return false;
+
+	// The fragmentation ratio is the percentage of gen1 memory that is made
+	// up of free cells that could be given back to the OS if the objects in
+	// each size class were packed together.
+	size_t reclaimable = gen1Heap.GetReclaimableSize();
+	return reclaimable * 100 / regionSize >= config::Defaults::GEN1_COMPACTION_THRESHOLD;
+}
+
+void GC::CompactGen1()
+{
+	// Gen1Heap takes care of not evacuating regions with pinned objects.
+	if (!gen1Heap.BeginCompaction())
+		return;
+
+	// Move objects out of the evacuating regions. The old copies are left in
+	// place, as their memory can't be reused until every reference to them
+	// has been updated.
+	gen1Heap.VisitEvacuatingObjects(*this);
+
+	// Now update every reference to the moved objects. This includes the
+	// remembered set, which was rebuilt during this cycle.
+	rememberedSet.UpdateMovedObjects();
+
+	MovedObjectUpdater updater(this);
+	updater.UpdateAllReferences();
+
+	// Finally, free the old copies. This releases the evacuated regions.
+	gen1Heap.EndCompaction();
+
+	compactionCount++;
+}
+
+void GC::EvacuateObject(GCObject *gco)
+{
+	OVUM_ASSERT(!gco->IsPinned());
+
+	GCObject *newAddress = gen1Heap.Alloc(gco->size);
+	// If we can't move the object, just leave it be. This is not fatal,
+	// unlike failing to promote an object from gen0.
+	if (newAddress == nullptr)
+		return;
+
+	memcpy(newAddress, gco, gco->size);
+	gco->flags |= GCOFlags::MOVED;
+	gco->newAddress = newAddress;
+
+	if (newAddress->type == vm->types.String ||
+		newAddress->IsEarlyString())
 	{
-		root->next = FlattenPinnedTree(root->next, lastItem);
+		String *str = reinterpret_cast<String*>(newAddress->InstanceBase());
+		if ((str->flags & StringFlags::INTERN) == StringFlags::INTERN)
+			strings.UpdateIntern(str);
 	}
-	return first;
+}
+
+void GC::RecordOldToYoungWrite(GCObject *gco, Value *value)
+{
+	if (value->type == nullptr || value->type->IsPrimitive())
+		return;
+
+	if (value->type == vm->types.String &&
+		(value->v.string->flags & StringFlags::STATIC) != StringFlags::NONE)
+		return;
+
+	GCObject *target = GCObject::FromValue(value);
+	if ((target->flags & GCOFlags::GEN_0) == GCOFlags::GEN_0)
+		rememberedSet.Add(gco);
+}
+
+bool GC::HasUnbarrieredRefs(Type *type)
+{
+	if (reinterpret_cast<uintptr_t>(type) == GC_VALUE_ARRAY)
+		// Value arrays are written to directly by native code.
+		return true;
+	return type != nullptr && type->HasNativeRefs();
+}
+
+void GC::RememberIfUnbarriered(GCObject *gco)
+{
+	if (!gco->IsRemembered() && HasUnbarrieredRefs(gco->type))
+		rememberedSet.Add(gco);
 }
 
 } // namespace ovum
@@ -807,7 +1276,18 @@ OVUM_API void GC_AddMemoryPressure(ThreadHandle thread, size_t size)
 
 OVUM_API void GC_RemoveMemoryPressure(ThreadHandle thread, size_t size)
 {
-	thread->GetGC()->RemoveMemoryPressure(thread, size);
+	using namespace ovum;
+
+	// The thread may be null if we're being called from a finalizer, which
+	// usually runs on the finalizer thread. That is not a managed thread, but
+	// it does know which VM it belongs to.
+	GC *gc = thread != nullptr ? thread->GetGC() : VM::GetCurrent()->GetGC();
+	gc->RemoveMemoryPressure(size);
+}
+
+OVUM_API size_t GC_GetMemoryPressure(ThreadHandle thread)
+{
+	return thread->GetGC()->GetMemoryPressure();
 }
 
 OVUM_API Value *GC_AddStaticReference(ThreadHandle thread, Value *initialValue)
@@ -818,16 +1298,46 @@ OVUM_API Value *GC_AddStaticReference(ThreadHandle thread, Value *initialValue)
 	return ref->GetValuePointer();
 }
 
+OVUM_API void GC_WriteBarrier(ThreadHandle thread, void *instance, Value *value)
+{
+	using namespace ovum;
+
+	GCObject *gco = GCObject::FromInst(instance);
+	gco->fieldAccessLock.EnterWrite();
+	thread->GetGC()->WriteBarrier(gco, value);
+	gco->fieldAccessLock.LeaveWrite();
+}
+
 OVUM_API void GC_Collect(ThreadHandle thread)
 {
 	thread->GetGC()->Collect(thread, false);
 }
 
+OVUM_API void GC_WaitForPendingFinalizers(ThreadHandle thread)
+{
+	thread->GetGC()->WaitForPendingFinalizers(thread);
+}
+
 OVUM_API uint32_t GC_GetCollectCount(ThreadHandle thread)
 {
 	return thread->GetGC()->GetCollectCount();
 }
 
+OVUM_API uint32_t GC_GetCompactionCount(ThreadHandle thread)
+{
+	return thread->GetGC()->GetCompactionCount();
+}
+
+OVUM_API uint32_t GC_GetAllocBufferRefillCount(ThreadHandle thread)
+{
+	return thread->GetGC()->GetAllocBufferRefillCount();
+}
+
+OVUM_API uint32_t GC_GetThreadAllocBufferRefillCount(ThreadHandle thread)
+{
+	return thread->GetAllocBufferRefillCount();
+}
+
 OVUM_API int GC_GetGeneration(Value *value)
 {
 	using namespace ovum;
@@ -874,11 +1384,11 @@ OVUM_API void GC_Pin(Value *value)
 	{
 		ovum::GCObject *gco = ovum::GCObject::FromValue(value);
 		// We must synchronise access to these two fields.
-		// Let's just reuse the field access lock.
-		gco->fieldAccessLock.Enter();
+		// Let's just reuse the field access lock's writer side.
+		gco->fieldAccessLock.EnterWrite();
 		gco->pinCount++;
 		gco->flags |= ovum::GCOFlags::PINNED;
-		gco->fieldAccessLock.Leave();
+		gco->fieldAccessLock.LeaveWrite();
 	}
 }
 
@@ -888,11 +1398,11 @@ OVUM_API void GC_PinInst(void *value)
 	{
 		ovum::GCObject *gco = ovum::GCObject::FromInst(value);
 		// We must synchronise access to these two fields.
-		// Let's just reuse the field access lock.
-		gco->fieldAccessLock.Enter();
+		// Let's just reuse the field access lock's writer side.
+		gco->fieldAccessLock.EnterWrite();
 		gco->pinCount++;
 		gco->flags |= ovum::GCOFlags::PINNED;
-		gco->fieldAccessLock.Leave();
+		gco->fieldAccessLock.LeaveWrite();
 	}
 }
 
@@ -902,12 +1412,12 @@ OVUM_API void GC_Unpin(Value *value)
 	{
 		ovum::GCObject *gco = ovum::GCObject::FromValue(value);
 		// We must synchronise access to these two fields.
-		// Let's just reuse the field access lock.
-		gco->fieldAccessLock.Enter();
+		// Let's just reuse the field access lock's writer side.
+		gco->fieldAccessLock.EnterWrite();
 		gco->pinCount--;
 		if (gco->pinCount == 0)
 			gco->flags &= ~ovum::GCOFlags::PINNED;
-		gco->fieldAccessLock.Leave();
+		gco->fieldAccessLock.LeaveWrite();
 	}
 }
 
@@ -917,11 +1427,11 @@ OVUM_API void GC_UnpinInst(void *value)
 	{
 		ovum::GCObject *gco = ovum::GCObject::FromInst(value);
 		// We must synchronise access to these two fields.
-		// Let's just reuse the field access lock.
-		gco->fieldAccessLock.Enter();
+		// Let's just reuse the field access lock's writer side.
+		gco->fieldAccessLock.EnterWrite();
 		gco->pinCount--;
 		if (gco->pinCount == 0)
 			gco->flags &= ~ovum::GCOFlags::PINNED;
-		gco->fieldAccessLock.Leave();
+		gco->fieldAccessLock.LeaveWrite();
 	}
 }
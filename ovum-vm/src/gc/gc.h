@@ -1,9 +1,17 @@
 #pragma once
 
 #include "../vm.h"
+#include "../../inc/ovum_main.h"
 #include "gcobject.h"
 #include "stringtable.h"
+#include "gen1heap.h"
+#include "rememberedset.h"
+#include "markbitmap.h"
+#include "objectarray.h"
+#include "parallelmarker.h"
+#include "finalizerthread.h"
 #include "../threading/sync.h"
+#include "../config/defaults.h"
 
 namespace ovum
 {
@@ -32,7 +40,7 @@ class GC
 {
 public:
 	// Creates a garbage collector instance.
-	OVUM_NOINLINE static Box<GC> New(VM *owner);
+	OVUM_NOINLINE static Box<GC> New(VM *owner, VMStartParams &params);
 
 	~GC();
 
@@ -41,6 +49,26 @@ public:
 		return collectCount;
 	}
 
+	// Gets the total amount of unmanaged memory currently reported to the GC
+	// through AddMemoryPressure().
+	inline size_t GetMemoryPressure() const
+	{
+		return memoryPressure.load(std::memory_order_relaxed);
+	}
+
+	// Gets the number of times generation 1 has been compacted.
+	inline uint32_t GetCompactionCount() const
+	{
+		return compactionCount;
+	}
+
+	// Gets the total number of times a thread-local allocation buffer has been
+	// refilled, across all threads.
+	inline uint32_t GetAllocBufferRefillCount() const
+	{
+		return allocBufferRefillCount;
+	}
+
 	inline VM *GetVM() const
 	{
 		return vm;
@@ -59,6 +87,14 @@ public:
 
 	String *ConstructModuleString(Thread *const thread, size_t length, const ovchar_t value[]);
 
+	// Gets an interned module string with the specified characters. The intern
+	// table is searched first, so that nothing is allocated if the string has
+	// been seen before; otherwise, a new module string is constructed and then
+	// interned.
+	String *GetModuleString(Thread *const thread, size_t length, const ovchar_t value[]);
+
+	// The intern table methods do not enter the allocation lock; see
+	// StringTable for details.
 	String *GetInternedString(Thread *const thread, String *value);
 
 	bool HasInternedString(Thread *const thread, String *value);
@@ -69,39 +105,143 @@ public:
 
 	int ConstructLL(Thread *const thread, Type *type, ovlocals_t argc, Value *args, Value *output);
 
+	// Informs the GC that a managed object has allocated the specified amount
+	// of unmanaged memory. Memory pressure counts towards the growth of the old
+	// generation (see ShouldRunFullCycle()); if enough pressure is added, this
+	// method runs a full cycle.
 	void AddMemoryPressure(Thread *const thread, size_t size);
 
-	void RemoveMemoryPressure(Thread *const thread, size_t size);
+	// Informs the GC that unmanaged memory previously reported through
+	// AddMemoryPressure() has been released. This may be called from within
+	// a finalizer, and does not need to enter the allocation lock.
+	void RemoveMemoryPressure(size_t size);
 
 	StaticRef *AddStaticReference(Thread *const thread, Value *value);
 
 	void Collect(Thread *const thread, bool collectGen1);
 
+	// Blocks until the finalizers of every object found dead before the call
+	// have run. The thread is in an unmanaged region while it waits, so other
+	// threads can run GC cycles in the meantime.
+	void WaitForPendingFinalizers(Thread *const thread);
+
+	// The write barrier. This must be called after a managed reference has been
+	// stored in a field of the specified object, while the object's field access
+	// lock is still held. If the object is outside generation 0 and the value is
+	// in generation 0, the object is added to the remembered set, so that minor
+	// cycles can find the reference without tracing the old generation.
+	//
+	// Static references are part of the root set and are always examined, so do
+	// not need a write barrier.
+	//   gco:
+	//     The object whose field was written to.
+	//   value:
+	//     The value that was written.
+	inline void WriteBarrier(GCObject *gco, Value *value)
+	{
+		// Writes into gen0 objects never have to be recorded; neither do writes
+		// into objects that are already in the remembered set.
+		if ((gco->flags & (GCOFlags::GEN_0 | GCOFlags::REMEMBERED)) == GCOFlags::NONE)
+			RecordOldToYoungWrite(gco, value);
+	}
+
 private:
-	static const size_t LARGE_OBJECT_SIZE = 87040;
 	static const intptr_t GC_VALUE_ARRAY = (intptr_t)1;
-
-	// The current bit pattern used for coloring an object white and black,
-	// respectively. These start out as 1 and 3, respectively, and are swapped
-	// after each GC cycle.
-	// The value GCOFlags::GRAY is also used, and does not change.
-	GCOFlags currentWhite;
-	GCOFlags currentBlack;
+	// Objects larger than this (including the GCObject header) bypass the
+	// thread-local allocation buffer, and are allocated directly from gen0
+	// under the allocation lock. This keeps a single large-ish object from
+	// consuming (and wasting) most of a buffer.
+	static const size_t MAX_BUFFERED_OBJECT_SIZE = config::Defaults::ALLOC_BUFFER_SIZE / 4;
 
 	char *gen0Current;
 	void *gen0Base;
 	void *gen0End;
+
+	// The current size of gen0. This only changes if adaptiveGen0 is true.
+	size_t gen0Size;
+	// Whether gen0 is resized according to its survival rate.
+	bool adaptiveGen0;
+	// Objects larger than this (including the GCObject header) are allocated
+	// in the large object heap.
+	size_t largeObjectSize;
+	// The amount by which the old generation may grow before the next cycle is
+	// a full cycle.
+	size_t gen1DeadObjectThreshold;
 	os::HeapHandle mainHeap;
 	os::HeapHandle largeObjectHeap;
-	
-	GCObject *collectList;
-	GCObject *pinnedList;
+
+	// Module strings are allocated from chunks of mainHeap, one after another;
+	// see ConstructModuleString(). This is the free part of the current chunk.
+	char *moduleStringCurrent;
+	char *moduleStringEnd;
+
+	// The region-based heap that contains generation 1 objects.
+	Gen1Heap gen1Heap;
+
+	// Records the start address of every object in gen0. This is how the GC
+	// finds gen0 objects, without having to link them together.
+	MarkBitmap gen0Starts;
+	// Records which gen0 objects have been marked during the current cycle.
+	MarkBitmap gen0Marks;
+
+	// Pinned gen0 objects that survived the last cycle, sorted by address.
+	ObjectArray pinnedObjects;
+	// The index in pinnedObjects of the first pinned object that gen0Current
+	// has not yet passed.
+	size_t nextPinned;
+
+	// Every object in the large object heap.
+	ObjectArray largeObjects;
+
+	// The mark stack, containing objects that have been marked but whose
+	// fields have not yet been examined. Only used during a cycle, but kept
+	// around between cycles so that its memory can be reused.
+	ObjectArray markStack;
+	// Spreads the mark phase out across several threads. This is null if the
+	// VM was started with a single GC worker, in which case marking is always
+	// serial.
+	Box<ParallelMarker> parallelMarker;
+	// Runs the finalizers of dead objects after each cycle. See the
+	// documentation of FinalizerThread for details.
+	Box<FinalizerThread> finalizerThread;
+	// Dead objects with finalizers found during the current cycle, which are
+	// handed to the finalizer thread at the end of the cycle.
+	ObjectArray finalizationQueue;
+	// Old objects and gen0 survivors with references to gen0 objects that
+	// are about to be moved. Like markStack, only used during a cycle.
+	ObjectArray survivorsWithGen0Refs;
+
+	// Old objects that may contain references to gen0 objects. These are used
+	// as additional roots during minor cycles.
+	RememberedSet rememberedSet;
+
+	// The total number of bytes that have entered the old generation (through
+	// promotion or large object allocation) since the last full cycle. When
+	// this exceeds gen1DeadObjectThreshold, the next cycle is a full cycle.
+	size_t oldGrowthSinceFullCycle;
+
+	// The total amount of unmanaged memory reported by AddMemoryPressure(),
+	// minus that reported by RemoveMemoryPressure().
+	std::atomic<size_t> memoryPressure;
+	// The amount of memory pressure that has been added since the last full
+	// cycle. Together with oldGrowthSinceFullCycle, this decides when to run
+	// the next full cycle.
+	std::atomic<size_t> pressureSinceFullCycle;
 
 	// The total size of generation 1, not including unmanaged data.
 	size_t gen1Size;
 
 	uint32_t collectCount;
 
+	// Whether generation 1 may be compacted. If false, gen1 objects never move.
+	bool compactGen1;
+
+	// The number of times gen1 has been compacted.
+	uint32_t compactionCount;
+
+	// The total number of thread-local allocation buffer refills.
+	uint32_t allocBufferRefillCount;
+
 	StringTable strings;
 	Box<StaticRefBlock> staticRefs;
 
@@ -113,7 +253,7 @@ private:
 	// The VM instance that owns the GC.
 	VM *vm;
 
-	GC(VM *owner);
+	GC(VM *owner, VMStartParams &params);
 
 	bool InitializeHeaps();
 
@@ -125,6 +265,37 @@ private:
 
 	void ReleaseRaw(GCObject *gco);
 
+	// Called for every dead object. Removes a dead string from the intern
+	// table; if the object has finalizers that have yet to run, queues the
+	// object for finalization. Returns true if the object's memory can be
+	// released right away, or false if the object must be kept until its
+	// finalizers have run. The memory is not released by this method.
+	//
+	// A gen0 object that is queued is copied to gen1, since gen0 is emptied
+	// at the end of the cycle. The gen0 copy can always be released.
+	bool Finalize(GCObject *gco);
+
+	// Runs the finalizers of an object, from the most derived type up.
+	static void RunFinalizers(GCObject *gco);
+
+	// Allocates a small object from the thread's allocation buffer. If the
+	// buffer is exhausted, it is refilled under the allocation lock; this may
+	// trigger a GC cycle. Returns null if there is not enough memory.
+	GCObject *AllocBuffered(Thread *const thread, size_t size);
+
+	// Gives the thread a new allocation buffer with room for at least minSize
+	// bytes. The allocation lock must be held. Returns false if gen0 does not
+	// have enough space left, in which case a cycle must be run.
+	bool RefillAllocBuffer(Thread *const thread, size_t minSize);
+
+	// Discards the rest of the thread's allocation buffer. This must be done
+	// for all threads before gen0 is reset. The allocation lock must be held.
+	void InvalidateAllocBuffer(Thread *const thread);
+
+	// Invalidates the allocation buffers of all managed threads. Called at
+	// the beginning of each GC cycle.
+	void InvalidateAllocBuffers();
+
 	// Acquires exclusive access to the allocation lock.
 	// If this lock cannot be acquired immediately, the thread spins
 	// for a bit, then sleeps, until the lock becomes available.
@@ -141,28 +312,116 @@ private:
 	// jump in and start allocating memory.
 	void EndAlloc();
 
+	// Runs a GC cycle. If collectGen1 is true, or if ShouldRunFullCycle() says
+	// so, the cycle is a full cycle, which traces and collects the entire heap.
+	// Otherwise, the cycle is a minor cycle, which only collects gen0 and only
+	// traces gen0 objects reachable from the root set or the remembered set.
 	void RunCycle(Thread *const thread, bool collectGen1);
 
+	bool ShouldRunFullCycle() const;
+
 	void BeginCycle(Thread *const thread);
 
 	void EndCycle(Thread *const thread);
 
-	void Release(GCObject *gco);
+	// Marks an object. Returns true if the object was not already marked.
+	// During a minor cycle, only gen0 objects are marked; this method always
+	// returns false for other objects.
+	//
+	// If concurrent is true, other threads may be marking objects at the
+	// same time, so the mark is set atomically. If several threads try to
+	// mark the same object, exactly one of them gets true.
+	inline bool TryMark(GCObject *gco, bool fullCycle, bool concurrent)
+	{
+		switch (gco->flags & GCOFlags::GENERATION)
+		{
+		case GCOFlags::GEN_0:
+			return gen0Marks.TrySet(gco, concurrent);
+		case GCOFlags::GEN_1:
+			return fullCycle && gen1Heap.TryMark(gco, concurrent);
+		case GCOFlags::LARGE_OBJECT:
+			if (!fullCycle || (gco->flags & GCOFlags::MARKED) == GCOFlags::MARKED)
+				return false;
+			if (concurrent)
+			{
+				std::atomic<uint32_t> &flags = reinterpret_cast<std::atomic<uint32_t>&>(gco->flags);
+				uint32_t marked = static_cast<uint32_t>(GCOFlags::MARKED);
+				return (flags.fetch_or(marked, std::memory_order_relaxed) & marked) == 0;
+			}
+			gco->flags |= GCOFlags::MARKED;
+			return true;
+		default:
+			// Module strings are not in any generation, and are never
+			// collected.
+			return false;
+		}
+	}
 
+	// Finds every gen0 object that was marked during the cycle, in address
+	// order. Pinned survivors are added to pinnedObjects; all others are moved
+	// to gen1.
 	void MoveGen0Survivors(LiveObjectFinder &liveFinder);
 
+	// Grows or shrinks gen0 based on the survival rate of the cycle that is
+	// just about to end. Only called if adaptiveGen0 is true.
+	//   gen0Used:
+	//     The number of bytes in gen0 that were in use when the cycle began.
+	//   gen0Survived:
+	//     The total size of the gen0 objects that survived the cycle.
+	void AdaptGen0Size(size_t gen0Used, size_t gen0Survived);
+
 	void MoveSurvivorToGen1(LiveObjectFinder &liveFinder, GCObject *gco);
 
 	void UpdateGen0References(LiveObjectFinder &liveFinder);
 
-	void CollectGarbage(LiveObjectFinder &liveFinder, bool collectGen1);
+	// Finalizes and frees every object that was not marked. Gen0 is swept by
+	// a linear scan over gen0Starts and gen0Marks; during a full cycle, gen1
+	// is swept region by region, and so are large objects.
+	void CollectGarbage(bool fullCycle);
+
+	// Finalizes the gen0 objects that were not marked.
+	void SweepGen0();
+
+	// Called by Gen1Heap::Sweep() for every dead gen1 object. Returns false
+	// if the object must be kept for the finalizer thread.
+	bool ReleaseDeadObject(GCObject *gco);
+
+	// Frees the large objects that were not marked, and unmarks the rest.
+	void SweepLargeObjects();
+
+	// Clears gen0Starts, except for the bits of pinned objects. Called after
+	// gen0 has been emptied.
+	void ResetGen0Starts();
+
+	// Determines whether gen1 is fragmented enough to warrant compaction.
+	// Only called at the end of a full cycle.
+	bool ShouldCompactGen1() const;
+
+	// Compacts generation 1 by moving objects out of sparsely populated
+	// regions, and updating all references to them. Pinned objects stay
+	// where they are. Only called at the end of a full cycle, after all dead
+	// objects have been freed.
+	void CompactGen1();
+
+	// Called by Gen1Heap::VisitEvacuatingObjects() for every object in an
+	// evacuating region.
+	void EvacuateObject(GCObject *gco);
+
+	OVUM_NOINLINE void RecordOldToYoungWrite(GCObject *gco, Value *value);
 
-	void AddPinnedObject(GCObject *gco);
+	// Determines whether instances of the specified type (which may also be
+	// GC_VALUE_ARRAY) can contain references that native code writes without
+	// calling the write barrier.
+	static bool HasUnbarrieredRefs(Type *type);
 
-	static GCObject *FlattenPinnedTree(GCObject *root, GCObject **lastItem);
+	// Adds an old object to the remembered set if it has unbarriered refs.
+	void RememberIfUnbarriered(GCObject *gco);
 
+	friend class FinalizerThread;
+	friend class Gen1Heap;
 	friend class LiveObjectFinder;
 	friend class MovedObjectUpdater;
+	friend class ParallelMarker;
 	template<class Visitor>
 	friend class ObjectGraphWalker;
 	template<class Visitor>
@@ -9,23 +9,20 @@ namespace ovum
 enum class GCOFlags : uint32_t
 {
 	NONE          = 0x0000,
-	// The color occupies the lowest two bits. The values for white
-	// and black are swapped each cycle, starting out at 1 = white
-	// and 3 = black. That way we don't have to walk through any
-	// black objects to make them white when the cycle is complete.
-	// The gray mark is invariant.
 
-	// Mask for extracting the color.
-	COLOR         = 0x0003,
-	// The GCObject is gray.
-	GRAY          = 0x0002,
+	// The GCObject has been marked during the current cycle. This flag is
+	// only used for large objects. Objects in generation 0 and generation 1
+	// are marked in side bitmaps instead (see MarkBitmap and Gen1Heap), and
+	// never have this flag.
+	MARKED        = 0x0001,
 
 	// The GCObject represents a string allocated before the
 	// standard String type was loaded.
 	EARLY_STRING  = 0x0004,
 
 	// The GCObject cannot be moved by the GC. This flag is only
-	// relevant for gen0 objects.
+	// relevant for gen0 objects, and for gen1 objects when gen1
+	// compaction is enabled.
 	PINNED        = 0x0008,
 
 	// The GCObject is in generation 0. This flag cannot be used
@@ -54,26 +51,45 @@ enum class GCOFlags : uint32_t
 	// GC_VALUE_ARRAY, then the array contains Values. Otherwise,
 	// we have no idea what it contains.
 	ARRAY         = 0x0200,
+
+	// The GCObject is in the GC's remembered set; see RememberedSet for
+	// details. This flag is only meaningful for objects outside gen0.
+	// During a GC cycle, a gen0 survivor with this flag is added to the
+	// remembered set as soon as it has been moved to gen1.
+	REMEMBERED    = 0x0400,
+
+	// The GCObject is dead, and is waiting for its finalizers to be run by
+	// the finalizer thread. Its memory must not be released or moved until
+	// then, and its fields must not be examined. Such objects are always
+	// outside gen0, and are also PINNED.
+	FINALIZING    = 0x0800,
+	// The GCObject is dead, and its finalizers have been run. It will be
+	// released the next time its generation is swept.
+	FINALIZED     = 0x1000,
+	// Mask for dead objects that are still kept in the heap.
+	DEAD          = 0x1800,
 };
 OVUM_ENUM_OPS(GCOFlags, uint32_t);
 
+// The header of every GC-managed object. The GC keeps no other per-object
+// bookkeeping in here: marks live in side bitmaps, and objects are found by
+// walking memory rather than lists. The fields are ordered so that there is
+// no padding between them.
 class GCObject
 {
 public:
 	GCOFlags flags; // Collection flag
+	uint32_t pinCount;
+
 	size_t size; // The size of the GCObject + fields.
 
-	uint32_t pinCount;
 	uint32_t hashCode;
 
-	GCObject *prev; // Pointer to the previous GC object in the object's list.
-	GCObject *next; // Pointer to the next GC object in the object's list.
-
-	// A lock that is entered while a thread is reading from or writing to
-	// a field of this instance. No other threads can read from or write
-	// to any field of the instance while this lock is held. This is to
-	// prevent race conditions, as Value cannot be read or written atomically.
-	SpinLock fieldAccessLock;
+	// Guards the fields of this instance, as Value cannot be read or written
+	// atomically. Writers enter the lock for writing, which also protects
+	// pinCount and the PINNED flag. Readers do not take the lock at all; they
+	// use ReadField(), which retries if a write happened at the same time.
+	SeqLock fieldAccessLock;
 
 	union
 	{
@@ -87,16 +103,6 @@ public:
 	// The first field of the Value immediately follows the type;
 	// this is the base of the Value's instance pointer.
 
-	inline GCOFlags GetColor() const
-	{
-		return flags & GCOFlags::COLOR;
-	}
-
-	inline void SetColor(GCOFlags color)
-	{
-		flags = flags & ~GCOFlags::COLOR | color;
-	}
-
 	inline bool IsEarlyString() const
 	{
 		return (flags & GCOFlags::EARLY_STRING) == GCOFlags::EARLY_STRING;
@@ -122,71 +128,38 @@ public:
 		return (flags & GCOFlags::MOVED) == GCOFlags::MOVED;
 	}
 
-	uint8_t *InstanceBase();
-	uint8_t *InstanceBase(Type *type);
-
-	Value *FieldsBase();
-	Value *FieldsBase(Type *type);
-
-	// Inserts the GCObject into a linked list.
-	// The parameter 'list' points to the first object in the list.
-	//
-	// For performance reasons, this method does not remove the GCO from
-	// the previous list it's in. Call RemoveFromList() first, unless you
-	// know the GCO isn't in any list.
-	inline void InsertIntoList(GCObject **list)
+	inline bool IsRemembered() const
 	{
-		// Before insertion:
-		//   nullptr  <--  *list  <->  (*list)->next
-		// After insertion:
-		//   nullptr  <--  this  <->  *list  <->  (*list)->next
-		this->prev = nullptr;  // this is the first value, so it has nothing prior to it.
-		this->next = *list; // The next value is the current base of the list.
-		if (*list)
-			(*list)->prev = this;
-		*list = this;       // And then we update the base of the list!
+		return (flags & GCOFlags::REMEMBERED) == GCOFlags::REMEMBERED;
 	}
 
-	// Removes the GCObject from its associated linked list, which is passed
-	// as a parameter (not stored with the GCObject).
-	//
-	// This should always be called before calling InsertIntoList, which
-	// does not automatically call this method for performance reasons.
-	//
-	// NOTE: also for performance reasons, this code does NOT set the GCO's
-	// next and prev fields to null. RemoveFromList will be called mostly
-	// before calling InsertIntoList, which writes to those fields.
-	// If you need these fields to be null, you must set them yourself.
-	// Call ClearLinks() on the GCO to accomplish this.
-	inline void RemoveFromList(GCObject **list)
+	// Determines whether the object is dead, but has been kept around for
+	// the finalizer thread. See GCOFlags::FINALIZING and FINALIZED.
+	inline bool IsDead() const
 	{
-		GCObject *prev = this->prev;
-		GCObject *next = this->next;
-		// This code maintains two important facts:
-		//   1. If this->prev == nullptr (that is, this is the first object in the list),
-		//      then this->next->prev will also be null.
-		//   2. If this->next == nullptr (that is, it's the last object in the list),
-		//      then this->prev->next will also be null.
-
-		// If this is the only object in the list, then this == *list
-		// and next == nullptr, so list will correctly be set to null.
-		if (this == *list)
-			*list = next;
-
-		// Before removal:
-		//   prev  <->  this  <->  next
-		// After removal:
-		//   prev  <->  next
-		if (prev) prev->next = next;
-		if (next) next->prev = prev;
+		return (flags & GCOFlags::DEAD) != GCOFlags::NONE;
 	}
 
-	inline void ClearLinks()
+	// Reads a field of this instance without tearing. The field must belong
+	// to this GCObject.
+	inline void ReadField(const Value *field, Value *dest) const
 	{
-		prev = nullptr;
-		next = nullptr;
+		Value result;
+		uint32_t seq;
+		do
+		{
+			seq = fieldAccessLock.BeginRead();
+			result = *field;
+		} while (!fieldAccessLock.EndRead(seq));
+		*dest = result;
 	}
 
+	uint8_t *InstanceBase();
+	uint8_t *InstanceBase(Type *type);
+
+	Value *FieldsBase();
+	Value *FieldsBase(Type *type);
+
 	static GCObject *FromInst(void *inst);
 
 	static GCObject *FromValue(Value *value);
@@ -0,0 +1,482 @@
+#include "gen1heap.h"
+
+namespace ovum
+{
+
+const size_t Gen1Heap::cellSizes[Gen1Heap::SIZE_CLASS_COUNT] = {
+	// Fine-grained classes, 16 bytes apart
+	16,   32,   48,   64,   80,   96,   112,  128,
+	144,  160,  176,  192,  208,  224,  240,  256,
+	272,  288,  304,  320,  336,  352,  368,  384,
+	400,  416,  432,  448,  464,  480,  496,  512,
+	// Coarse classes, four per doubling
+	640,  768,  896,  1024,
+	1280, 1536, 1792, 2048,
+	2560, 3072, 3584, 4096,
+	5120, 6144, 7168, 8192,
+};
+
+const size_t Gen1Heap::HEADER_SIZE = OVUM_ALIGN_TO(sizeof(Gen1Heap::Region), Gen1Heap::CELL_ALIGNMENT);
+
+void Gen1Heap::Region::InsertIntoList(Region **list)
+{
+	this->prev = nullptr;
+	this->next = *list;
+	if (*list)
+		(*list)->prev = this;
+	*list = this;
+}
+
+void Gen1Heap::Region::RemoveFromList(Region **list)
+{
+	if (this == *list)
+		*list = this->next;
+	if (this->prev)
+		this->prev->next = this->next;
+	if (this->next)
+		this->next->prev = this->prev;
+	this->prev = nullptr;
+	this->next = nullptr;
+}
+
+Gen1Heap::Gen1Heap() :
+	largeRegions(nullptr),
+	evacuatingRegions(nullptr),
+	regionCount(0),
+	regionSize(0),
+	virtualAllocIsAligned(false)
+{
+	for (size_t i = 0; i < SIZE_CLASS_COUNT; i++)
+	{
+		sizeClasses[i].partial = nullptr;
+		sizeClasses[i].full = nullptr;
+	}
+}
+
+Gen1Heap::~Gen1Heap()
+{
+	for (size_t i = 0; i < SIZE_CLASS_COUNT; i++)
+	{
+		ReleaseRegionList(sizeClasses[i].partial);
+		ReleaseRegionList(sizeClasses[i].full);
+	}
+	ReleaseRegionList(largeRegions);
+	ReleaseRegionList(evacuatingRegions);
+}
+
+bool Gen1Heap::Init()
+{
+	size_t granularity = os::GetAllocationGranularity();
+	virtualAllocIsAligned = granularity >= REGION_SIZE && granularity % REGION_SIZE == 0;
+	return true;
+}
+
+GCObject *Gen1Heap::Alloc(size_t size)
+{
+	size_t sizeClass = GetSizeClass(size);
+	if (sizeClass == LARGE_SIZE_CLASS)
+		return AllocLarge(size);
+
+	SizeClass &sc = sizeClasses[sizeClass];
+
+	Region *region = sc.partial;
+	if (region == nullptr)
+	{
+		region = NewRegion(sizeClass);
+		if (region == nullptr)
+			return nullptr;
+		region->InsertIntoList(&sc.partial);
+	}
+
+	char *cell;
+	if (region->freeList)
+	{
+		cell = reinterpret_cast<char*>(region->freeList);
+		region->freeList = region->freeList->next;
+	}
+	else
+	{
+		cell = region->bump;
+		region->bump += region->cellSize;
+	}
+	region->liveCount++;
+
+	size_t index = region->GetBitIndex(reinterpret_cast<GCObject*>(cell));
+	region->allocBits[index / BITS_PER_WORD] |= GetBit(index);
+
+	if (!region->HasSpace())
+	{
+		region->RemoveFromList(&sc.partial);
+		region->InsertIntoList(&sc.full);
+		region->isFull = true;
+	}
+
+	return reinterpret_cast<GCObject*>(cell);
+}
+
+void Gen1Heap::Free(GCObject *gco)
+{
+	if (GetSizeClass(gco->size) == LARGE_SIZE_CLASS)
+	{
+		FreeLarge(gco);
+		return;
+	}
+
+	Region *region = GetRegion(gco);
+	OVUM_ASSERT(region->sizeClass == GetSizeClass(gco->size));
+
+	ReleaseCell(region, gco);
+	UpdateRegionState(region);
+}
+
+void Gen1Heap::ClearMarks()
+{
+	for (size_t i = 0; i < SIZE_CLASS_COUNT; i++)
+	{
+		for (Region *region = sizeClasses[i].partial; region; region = region->next)
+			memset(region->markBits, 0, sizeof(region->markBits));
+		for (Region *region = sizeClasses[i].full; region; region = region->next)
+			memset(region->markBits, 0, sizeof(region->markBits));
+	}
+	for (Region *region = largeRegions; region; region = region->next)
+		memset(region->markBits, 0, sizeof(region->markBits));
+}
+
+void Gen1Heap::FreeDeadObjects(Region *region)
+{
+	if (region->sizeClass == LARGE_SIZE_CLASS)
+	{
+		// A large region only contains one object, which must be dead if
+		// we get here.
+		FreeLarge(reinterpret_cast<GCObject*>(region->FirstCell()));
+		return;
+	}
+
+	for (size_t w = 0; w < BITMAP_WORDS; w++)
+	{
+		uintptr_t dead = region->allocBits[w] & ~region->markBits[w];
+		while (dead != 0)
+		{
+			size_t index = w * BITS_PER_WORD + MarkBitmap::LowestSetBit(dead);
+			ReleaseCell(region, region->GetObject(index));
+			dead &= dead - 1;
+		}
+	}
+
+	UpdateRegionState(region);
+}
+
+void Gen1Heap::ReleaseCell(Region *region, GCObject *gco)
+{
+	size_t index = region->GetBitIndex(gco);
+	region->allocBits[index / BITS_PER_WORD] &= ~GetBit(index);
+	region->markBits[index / BITS_PER_WORD] &= ~GetBit(index);
+
+	FreeCell *cell = reinterpret_cast<FreeCell*>(gco);
+	cell->next = region->freeList;
+	region->freeList = cell;
+	region->liveCount--;
+}
+
+void Gen1Heap::UpdateRegionState(Region *region)
+{
+	SizeClass &sc = sizeClasses[region->sizeClass];
+
+	if (region->evacuating)
+	{
+		// Evacuating regions are not in any size class list, and are released
+		// as soon as they become empty.
+		if (region->liveCount == 0)
+		{
+			region->RemoveFromList(&evacuatingRegions);
+			ReleaseRegion(region);
+		}
+		return;
+	}
+
+	if (region->isFull)
+	{
+		region->RemoveFromList(&sc.full);
+		region->InsertIntoList(&sc.partial);
+		region->isFull = false;
+	}
+
+	if (region->liveCount == 0)
+	{
+		if (sc.partial == region && region->next == nullptr)
+		{
+			// This is the only region with available space in the size class.
+			// Rather than give it back to the OS, only to allocate a new region
+			// the next time an object of this size is promoted, we keep it and
+			// reset it, so that subsequent allocations are sequential.
+			region->freeList = nullptr;
+			region->bump = region->FirstCell();
+		}
+		else
+		{
+			region->RemoveFromList(&sc.partial);
+			ReleaseRegion(region);
+		}
+	}
+}
+
+bool Gen1Heap::HasPinnedObjects(Region *region)
+{
+	for (size_t w = 0; w < BITMAP_WORDS; w++)
+	{
+		uintptr_t word = region->allocBits[w];
+		while (word != 0)
+		{
+			size_t index = w * BITS_PER_WORD + MarkBitmap::LowestSetBit(word);
+			if (region->GetObject(index)->IsPinned())
+				return true;
+			word &= word - 1;
+		}
+	}
+	return false;
+}
+
+size_t Gen1Heap::GetSizeClass(size_t size)
+{
+	if (size <= MAX_FINE_CELL_SIZE)
+		return size == 0 ? 0 : (size - 1) / CELL_ALIGNMENT;
+
+	for (size_t i = MAX_FINE_CELL_SIZE / CELL_ALIGNMENT; i < SIZE_CLASS_COUNT; i++)
+		if (size <= cellSizes[i])
+			return i;
+
+	return LARGE_SIZE_CLASS;
+}
+
+size_t Gen1Heap::GetCellsPerRegion(size_t sizeClass)
+{
+	return (REGION_SIZE - HEADER_SIZE) / cellSizes[sizeClass];
+}
+
+size_t Gen1Heap::GetReclaimableSize() const
+{
+	size_t total = 0;
+	for (size_t i = 0; i < SIZE_CLASS_COUNT; i++)
+	{
+		size_t freeCells = 0;
+		for (Region *region = sizeClasses[i].partial; region; region = region->next)
+			freeCells += GetCellsPerRegion(i) - region->liveCount;
+
+		total += freeCells / GetCellsPerRegion(i) * REGION_SIZE;
+	}
+	return total;
+}
+
+bool Gen1Heap::BeginCompaction()
+{
+	for (size_t i = 0; i < SIZE_CLASS_COUNT; i++)
+	{
+		SizeClass &sc = sizeClasses[i];
+		size_t cellsPerRegion = GetCellsPerRegion(i);
+
+		// A region is a candidate for evacuation if it's at most half full
+		// and has no pinned objects. The objects in the candidates must go
+		// somewhere: either into the free cells of the remaining regions, or
+		// into new regions. In the latter case, we only gain anything if
+		// there are at least two candidates, as they are at most half full.
+		//
+		// For the time being, candidates are marked as evacuating, so that we
+		// don't have to scan them for pinned objects twice. If it turns out
+		// not to be worth evacuating anything, the flag is cleared below.
+		size_t candidateCount = 0;
+		size_t candidateLiveCount = 0;
+		size_t remainingFreeCells = 0;
+		for (Region *region = sc.partial; region; region = region->next)
+		{
+			region->evacuating =
+				region->liveCount <= cellsPerRegion / 2 &&
+				!HasPinnedObjects(region);
+			if (region->evacuating)
+			{
+				candidateCount++;
+				candidateLiveCount += region->liveCount;
+			}
+			else
+			{
+				remainingFreeCells += cellsPerRegion - region->liveCount;
+			}
+		}
+
+		bool evacuate = candidateCount >= 2 ||
+			(candidateCount == 1 && candidateLiveCount <= remainingFreeCells);
+
+		Region *region = sc.partial;
+		while (region)
+		{
+			Region *next = region->next;
+
+			if (evacuate && region->evacuating)
+			{
+				region->RemoveFromList(&sc.partial);
+				region->InsertIntoList(&evacuatingRegions);
+			}
+			else
+			{
+				region->evacuating = false;
+			}
+
+			region = next;
+		}
+	}
+
+	return evacuatingRegions != nullptr;
+}
+
+void Gen1Heap::EndCompaction()
+{
+	Region *region = evacuatingRegions;
+	while (region)
+	{
+		Region *next = region->next;
+
+		for (size_t w = 0; w < BITMAP_WORDS; w++)
+		{
+			uintptr_t word = region->allocBits[w];
+			while (word != 0)
+			{
+				size_t index = w * BITS_PER_WORD + MarkBitmap::LowestSetBit(word);
+				GCObject *gco = region->GetObject(index);
+				if (gco->IsMoved())
+					ReleaseCell(region, gco);
+				word &= word - 1;
+			}
+		}
+
+		if (region->liveCount == 0)
+		{
+			region->RemoveFromList(&evacuatingRegions);
+			ReleaseRegion(region);
+		}
+		else
+		{
+			// If the GC was unable to move some object out of the region (which
+			// can only happen if a new region could not be allocated), the region
+			// stays around. Since it was in a partial list before, it has free
+			// cells.
+			region->RemoveFromList(&evacuatingRegions);
+			region->evacuating = false;
+			region->InsertIntoList(&sizeClasses[region->sizeClass].partial);
+		}
+
+		region = next;
+	}
+	OVUM_ASSERT(evacuatingRegions == nullptr);
+}
+
+GCObject *Gen1Heap::AllocLarge(size_t size)
+{
+	// Large regions don't need to be aligned to REGION_SIZE, as we never
+	// look them up by masking the object's address.
+	size_t allocSize = HEADER_SIZE + size;
+	void *mem = os::VirtualAlloc(nullptr, allocSize, os::VPROT_READ_WRITE);
+	if (mem == nullptr)
+		return nullptr;
+
+	Region *region = reinterpret_cast<Region*>(mem);
+	region->allocBase = mem;
+	region->allocSize = allocSize;
+	region->sizeClass = LARGE_SIZE_CLASS;
+	region->cellSize = size;
+	region->liveCount = 1;
+	region->bump = region->FirstCell() + size;
+	region->end = region->bump;
+	region->freeList = nullptr;
+	region->isFull = true;
+	region->evacuating = false;
+	// The memory is zeroed, so all we need is the one allocation bit.
+	size_t index = region->GetBitIndex(reinterpret_cast<GCObject*>(region->FirstCell()));
+	region->allocBits[index / BITS_PER_WORD] = GetBit(index);
+	region->InsertIntoList(&largeRegions);
+
+	regionCount++;
+	regionSize += allocSize;
+
+	return reinterpret_cast<GCObject*>(region->FirstCell());
+}
+
+void Gen1Heap::FreeLarge(GCObject *gco)
+{
+	Region *region = reinterpret_cast<Region*>(reinterpret_cast<char*>(gco) - HEADER_SIZE);
+	OVUM_ASSERT(region->sizeClass == LARGE_SIZE_CLASS);
+
+	region->RemoveFromList(&largeRegions);
+	ReleaseRegion(region);
+}
+
+Gen1Heap::Region *Gen1Heap::NewRegion(size_t sizeClass)
+{
+	void *mem;
+	size_t allocSize;
+	Region *region;
+	if (virtualAllocIsAligned)
+	{
+		allocSize = REGION_SIZE;
+		mem = os::VirtualAlloc(nullptr, allocSize, os::VPROT_READ_WRITE);
+		if (mem == nullptr)
+			return nullptr;
+		region = reinterpret_cast<Region*>(mem);
+	}
+	else
+	{
+		// Allocate twice as much as we need, and align the region within
+		// the allocated memory. Pages are not physically allocated until
+		// they are touched, so this only wastes address space.
+		allocSize = 2 * REGION_SIZE;
+		mem = os::VirtualAlloc(nullptr, allocSize, os::VPROT_READ_WRITE);
+		if (mem == nullptr)
+			return nullptr;
+		region = reinterpret_cast<Region*>(
+			OVUM_ALIGN_TO(reinterpret_cast<uintptr_t>(mem), REGION_SIZE)
+		);
+	}
+	OVUM_ASSERT(reinterpret_cast<uintptr_t>(region) % REGION_SIZE == 0);
+
+	size_t cellSize = cellSizes[sizeClass];
+
+	region->prev = nullptr;
+	region->next = nullptr;
+	region->allocBase = mem;
+	region->allocSize = allocSize;
+	region->sizeClass = sizeClass;
+	region->cellSize = cellSize;
+	region->liveCount = 0;
+	region->bump = region->FirstCell();
+	// The end is the last cell boundary within the region
+	region->end = region->bump + (REGION_SIZE - HEADER_SIZE) / cellSize * cellSize;
+	region->freeList = nullptr;
+	region->isFull = false;
+	region->evacuating = false;
+	// The bitmaps were zeroed by the OS.
+
+	regionCount++;
+	regionSize += REGION_SIZE;
+
+	return region;
+}
+
+void Gen1Heap::ReleaseRegion(Region *region)
+{
+	regionCount--;
+	regionSize -= region->sizeClass == LARGE_SIZE_CLASS
+		? region->allocSize
+		: REGION_SIZE;
+
+	os::VirtualFree(region->allocBase);
+}
+
+void Gen1Heap::ReleaseRegionList(Region *list)
+{
+	while (list)
+	{
+		Region *next = list->next;
+		ReleaseRegion(list);
+		list = next;
+	}
+}
+
+} // namespace ovum
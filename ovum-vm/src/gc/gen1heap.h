@@ -0,0 +1,396 @@
+#pragma once
+
+#include "../vm.h"
+#include "gcobject.h"
+#include "markbitmap.h"
+
+namespace ovum
+{
+
+// The heap that holds all generation 1 objects.
+//
+// Gen1 memory is organised into regions: contiguous chunks of virtual memory,
+// REGION_SIZE bytes large and aligned to REGION_SIZE. Every region belongs to
+// exactly one size class, and is divided into cells of that size class. The
+// region header lives at the very start of the region, which means we can get
+// from an object to its region by masking off the low bits of its address.
+//
+// Allocating an object is either a free-list pop (if some cell in the region
+// has been freed) or a pointer bump. Freeing an object pushes its cell onto
+// the region's free list. When the last object in a region dies, the entire
+// region is returned to the OS with a single call.
+//
+// Objects that are too large for any size class get a region of their own,
+// with the region header immediately preceding the object. These are rare,
+// as gen1 only contains objects that fit in gen0, plus module strings.
+//
+// Each region header also contains two side bitmaps, with one bit for every
+// CELL_ALIGNMENT bytes of the region: one records which cells are allocated,
+// the other which objects have been marked during the current full cycle.
+// Only the bits that correspond to the start of a cell are ever used. This
+// lets the GC mark a gen1 object without touching the object itself, and it
+// lets the heap find every object (or every dead object) in a region with a
+// linear scan over the bitmaps.
+//
+// Over time, regions can end up sparsely populated: a few long-lived objects
+// keep an otherwise empty region alive. The heap can be compacted by moving
+// objects out of such regions; see BeginCompaction() for details. The heap
+// only selects the regions to evacuate and hands out new cells; moving the
+// objects and updating references to them is up to the GC.
+//
+// The Gen1Heap is not thread-safe. The GC only accesses it while holding the
+// allocation lock, or during a cycle.
+class Gen1Heap
+{
+public:
+	Gen1Heap();
+
+	~Gen1Heap();
+
+	// Initializes the heap. Returns true on success.
+	bool Init();
+
+	// Allocates memory for a gen1 object. The memory is NOT zeroed.
+	//   size:
+	//     The total size of the object, including the GCObject header.
+	// Returns:
+	//   A pointer to the memory, or null if the memory could not be allocated.
+	GCObject *Alloc(size_t size);
+
+	// Frees memory previously allocated by Alloc. The GCObject's size field
+	// must be the same as the size passed to Alloc.
+	void Free(GCObject *gco);
+
+	// Marks the specified object. Returns true if the object was not already
+	// marked. If concurrent is true, the mark bit is set atomically; see
+	// MarkBitmap::TrySetBit().
+	inline bool TryMark(GCObject *gco, bool concurrent)
+	{
+		Region *region = FindRegion(gco);
+		size_t index = region->GetBitIndex(gco);
+		return MarkBitmap::TrySetBit(
+			region->markBits[index / BITS_PER_WORD],
+			GetBit(index),
+			concurrent
+		);
+	}
+
+	// Determines whether the specified object has been marked.
+	inline bool IsMarked(GCObject *gco)
+	{
+		Region *region = FindRegion(gco);
+		size_t index = region->GetBitIndex(gco);
+		return (region->markBits[index / BITS_PER_WORD] & GetBit(index)) != 0;
+	}
+
+	// Unmarks every object in the heap. This must be called at the start of
+	// each full cycle.
+	void ClearMarks();
+
+	// Frees every object that is not marked. Before any memory is freed, the
+	// visitor's bool ReleaseDeadObject(GCObject*) method is called for each
+	// such object, so that the object can be finalized. If that returns false,
+	// the object is kept, and is marked so that it stays until the next full
+	// cycle. The visitor must not allocate from or free memory in the heap.
+	template<class Visitor>
+	void Sweep(Visitor &visitor)
+	{
+		OVUM_ASSERT(evacuatingRegions == nullptr);
+
+		for (size_t i = 0; i < SIZE_CLASS_COUNT; i++)
+		{
+			// Full regions may be moved to the partial list as objects are
+			// freed, so sweep the partial list first. Regions are inserted at
+			// the start of a list, so we never visit a region twice.
+			SweepRegionList(visitor, sizeClasses[i].partial);
+			SweepRegionList(visitor, sizeClasses[i].full);
+		}
+		SweepRegionList(visitor, largeRegions);
+	}
+
+	// Calls the visitor's VisitHeapObject(GCObject*) method for every object
+	// in the heap. The visitor must not allocate from or free memory in the
+	// heap.
+	template<class Visitor>
+	void VisitObjects(Visitor &visitor)
+	{
+		for (size_t i = 0; i < SIZE_CLASS_COUNT; i++)
+		{
+			VisitRegionList(visitor, sizeClasses[i].partial);
+			VisitRegionList(visitor, sizeClasses[i].full);
+		}
+		VisitRegionList(visitor, largeRegions);
+		VisitRegionList(visitor, evacuatingRegions);
+	}
+
+	// Gets the number of regions currently allocated.
+	inline size_t GetRegionCount() const
+	{
+		return regionCount;
+	}
+
+	// Gets the total number of bytes occupied by regions, including region
+	// headers, free cells and the unused space at the end of each region.
+	inline size_t GetRegionSize() const
+	{
+		return regionSize;
+	}
+
+	// Gets the number of bytes that could be returned to the OS if every size
+	// class were perfectly compacted. This is always a multiple of the region
+	// size, and only counts whole regions' worth of free cells; the space at
+	// the end of a partially filled region is not fragmentation.
+	size_t GetReclaimableSize() const;
+
+	// Selects the regions that are to be evacuated. Evacuating regions are
+	// taken out of their size class, so that Alloc() never returns cells in
+	// them. Regions that contain pinned objects are never selected.
+	//
+	// Once the heap is in this state, the GC should call VisitEvacuatingObjects
+	// to move every object in the evacuating regions to a new cell obtained
+	// from Alloc(), giving the old copy the MOVED flag, and then update all
+	// references to the moved objects. EndCompaction() frees the old copies.
+	//
+	// Returns:
+	//   True if at least one region was selected; otherwise, false, in which
+	//   case EndCompaction() does not need to be called.
+	bool BeginCompaction();
+
+	// Calls the visitor's EvacuateObject(GCObject*) method for every object
+	// in a region that is being evacuated. The visitor may allocate memory
+	// from the heap, but must not free anything.
+	template<class Visitor>
+	void VisitEvacuatingObjects(Visitor &visitor)
+	{
+		for (Region *region = evacuatingRegions; region; region = region->next)
+			VisitRegionObjects(visitor, region, &Visitor::EvacuateObject);
+	}
+
+	// Frees every object in the evacuated regions that has been moved, and
+	// releases the regions that become empty as a result. Regions that could
+	// not be completely evacuated are put back into their size classes.
+	void EndCompaction();
+
+private:
+	// The size of a region that contains cells of a size class. This must
+	// be a power of two.
+	static const size_t REGION_SIZE = 64 * 1024;
+	// The alignment of each cell.
+	static const size_t CELL_ALIGNMENT = 16;
+	// Cell sizes up to this value are spaced CELL_ALIGNMENT bytes apart.
+	static const size_t MAX_FINE_CELL_SIZE = 512;
+	// The total number of size classes.
+	static const size_t SIZE_CLASS_COUNT = 48;
+	// The size class of objects that are too large for any size class.
+	static const size_t LARGE_SIZE_CLASS = SIZE_CLASS_COUNT;
+
+	// The cell size of each size class.
+	static const size_t cellSizes[SIZE_CLASS_COUNT];
+
+	static const size_t BITS_PER_WORD = MarkBitmap::BITS_PER_WORD;
+	// The number of words in each of a region's bitmaps.
+	static const size_t BITMAP_WORDS = REGION_SIZE / CELL_ALIGNMENT / BITS_PER_WORD;
+
+	struct FreeCell
+	{
+		FreeCell *next;
+	};
+
+	struct Region
+	{
+		// The previous and next region in the region list that this region
+		// belongs to.
+		Region *prev;
+		Region *next;
+
+		// The address returned by os::VirtualAlloc. This may be different
+		// from the region itself, if we had to align the region manually.
+		void *allocBase;
+		// The size of the memory allocated for the region.
+		size_t allocSize;
+
+		// The size class of the region.
+		size_t sizeClass;
+		// The size of each cell in the region.
+		size_t cellSize;
+		// The number of live objects in the region.
+		size_t liveCount;
+
+		// The next never-allocated cell in the region.
+		char *bump;
+		// The end of the region's cell area.
+		char *end;
+		// The first free cell in the region.
+		FreeCell *freeList;
+
+		// True if the region is in its size class's full list.
+		bool isFull;
+		// True if the region is being evacuated, in which case it is in
+		// evacuatingRegions rather than in a size class.
+		bool evacuating;
+
+		// One bit per CELL_ALIGNMENT bytes of the region. The bit at the
+		// start of each cell is set if the cell is allocated.
+		uintptr_t allocBits[BITMAP_WORDS];
+		// Likewise, but the bit is set if the cell's object is marked.
+		uintptr_t markBits[BITMAP_WORDS];
+
+		inline char *FirstCell()
+		{
+			return reinterpret_cast<char*>(this) + HEADER_SIZE;
+		}
+
+		inline size_t GetBitIndex(GCObject *gco) const
+		{
+			return (reinterpret_cast<const char*>(gco) - reinterpret_cast<const char*>(this)) / CELL_ALIGNMENT;
+		}
+
+		inline GCObject *GetObject(size_t bitIndex)
+		{
+			return reinterpret_cast<GCObject*>(reinterpret_cast<char*>(this) + bitIndex * CELL_ALIGNMENT);
+		}
+
+		inline bool HasSpace() const
+		{
+			return freeList != nullptr || bump + cellSize <= end;
+		}
+
+		void InsertIntoList(Region **list);
+
+		void RemoveFromList(Region **list);
+	};
+
+	static const size_t HEADER_SIZE;
+
+	struct SizeClass
+	{
+		// Regions that have at least one available cell.
+		Region *partial;
+		// Regions in which every cell is allocated.
+		Region *full;
+	};
+
+	SizeClass sizeClasses[SIZE_CLASS_COUNT];
+
+	// Regions containing a single object that is too large for any size class.
+	Region *largeRegions;
+
+	// Regions that are being evacuated during compaction.
+	Region *evacuatingRegions;
+
+	// The number of regions currently allocated.
+	size_t regionCount;
+	// The total size of all regions currently allocated.
+	size_t regionSize;
+
+	// Whether os::VirtualAlloc returns addresses that are aligned to at least
+	// REGION_SIZE. If not, we have to over-allocate and align regions ourselves.
+	bool virtualAllocIsAligned;
+
+	static size_t GetSizeClass(size_t size);
+
+	// Gets the number of cells that fit in a region of the specified size class.
+	static size_t GetCellsPerRegion(size_t sizeClass);
+
+	static inline Region *GetRegion(GCObject *gco)
+	{
+		return reinterpret_cast<Region*>(
+			reinterpret_cast<uintptr_t>(gco) & ~(uintptr_t)(REGION_SIZE - 1)
+		);
+	}
+
+	// Like GetRegion, but also works for objects in large regions.
+	static inline Region *FindRegion(GCObject *gco)
+	{
+		if (gco->size > cellSizes[SIZE_CLASS_COUNT - 1])
+			return reinterpret_cast<Region*>(reinterpret_cast<char*>(gco) - HEADER_SIZE);
+		return GetRegion(gco);
+	}
+
+	static inline uintptr_t GetBit(size_t index)
+	{
+		return (uintptr_t)1 << (index % BITS_PER_WORD);
+	}
+
+	// Calls (visitor.*method)(gco) for every allocated object in a region.
+	template<class Visitor>
+	static void VisitRegionObjects(Visitor &visitor, Region *region, void (Visitor::*method)(GCObject*))
+	{
+		for (size_t w = 0; w < BITMAP_WORDS; w++)
+		{
+			uintptr_t word = region->allocBits[w];
+			while (word != 0)
+			{
+				size_t index = w * BITS_PER_WORD + MarkBitmap::LowestSetBit(word);
+				(visitor.*method)(region->GetObject(index));
+				word &= word - 1;
+			}
+		}
+	}
+
+	template<class Visitor>
+	static void VisitRegionList(Visitor &visitor, Region *list)
+	{
+		for (Region *region = list; region; region = region->next)
+			VisitRegionObjects(visitor, region, &Visitor::VisitHeapObject);
+	}
+
+	template<class Visitor>
+	void SweepRegionList(Visitor &visitor, Region *list)
+	{
+		Region *region = list;
+		while (region)
+		{
+			// FreeDeadObjects may move or release the region.
+			Region *next = region->next;
+
+			bool hasDeadObjects = false;
+			for (size_t w = 0; w < BITMAP_WORDS; w++)
+			{
+				uintptr_t dead = region->allocBits[w] & ~region->markBits[w];
+				while (dead != 0)
+				{
+					size_t index = w * BITS_PER_WORD + MarkBitmap::LowestSetBit(dead);
+					if (visitor.ReleaseDeadObject(region->GetObject(index)))
+						hasDeadObjects = true;
+					else
+						region->markBits[w] |= GetBit(index);
+					dead &= dead - 1;
+				}
+			}
+
+			if (hasDeadObjects)
+				FreeDeadObjects(region);
+
+			region = next;
+		}
+	}
+
+	// Frees every allocated cell in the region whose object is not marked.
+	void FreeDeadObjects(Region *region);
+
+	// Returns a cell to its region's free list. This does not move the region
+	// between lists; call UpdateRegionState() afterwards.
+	void ReleaseCell(Region *region, GCObject *gco);
+
+	// Moves the region to the list that matches its state after one or more
+	// cells have been freed, or releases it if it's empty.
+	void UpdateRegionState(Region *region);
+
+	// Determines whether any object in the region is pinned.
+	static bool HasPinnedObjects(Region *region);
+
+	GCObject *AllocLarge(size_t size);
+
+	void FreeLarge(GCObject *gco);
+
+	Region *NewRegion(size_t sizeClass);
+
+	void ReleaseRegion(Region *region);
+
+	void ReleaseRegionList(Region *list);
+
+	OVUM_DISABLE_COPY_AND_ASSIGN(Gen1Heap);
+};
+
+} // namespace ovum
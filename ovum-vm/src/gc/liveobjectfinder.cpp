@@ -3,6 +3,7 @@
 #include "objectgraphwalker.h"
 #include "gc.h"
 #include "staticref.h"
+#include "parallelmarker.h"
 #include "../object/value.h"
 #include "../ee/vm.h"
 #include "../object/type.h"
@@ -10,102 +11,138 @@
 namespace ovum
 {
 
-LiveObjectFinder::LiveObjectFinder(GC *gc) :
+LiveObjectFinder::LiveObjectFinder(GC *gc, bool fullCycle, MarkWorker *worker) :
 	gc(gc),
+	fullCycle(fullCycle),
+	worker(worker),
+	inRememberedObject(false),
 	hasGen0Refs(false),
+	hasPinnedGen0Refs(false),
 	gen1SurvivorSize(0),
-	processList(nullptr),
-	keepList(nullptr),
-	survivorsFromGen0(nullptr),
-	survivorsWithGen0Refs(nullptr)
+	gen0SurvivorSize(0)
 {
-	currentWhite = gc->currentWhite;
-	currentBlack = gc->currentBlack;
 	stringType = gc->GetVM()->types.String;
 }
 
 void LiveObjectFinder::FindLiveObjects()
 {
 	// Every object that can be reached from the root set is guaranteed
-	// to be alive. Let's start by graying all of those objects, and add
-	// all appropriate objects to the processList.
+	// to be alive. Let's start by marking all of those objects, and push
+	// all appropriate objects onto the mark stack.
 	RootSetWalker<LiveObjectFinder> walker(this->gc);
 	walker.VisitRootSet(*this);
 
-	// Now we can start processing known survivors. We loop through each
-	// object in processList, add their field references to the start of
-	// that list, and repeat until processList is empty.
-	while (processList != nullptr)
+	// During a minor cycle, the remembered set is part of the root set.
+	if (!fullCycle)
+		VisitRememberedSet();
+
+	// Now we can start processing known survivors. We pop each object off
+	// the mark stack and examine its fields, which pushes any unmarked
+	// objects they refer to, and repeat until the stack is empty.
+	//
+	// If there are parallel mark workers, they take over as soon as there
+	// is enough work to go around. Small minor cycles may never get there.
+	ObjectArray &markStack = gc->markStack;
+	ParallelMarker *parallelMarker = gc->parallelMarker.get();
+	while (!markStack.IsEmpty())
 	{
-		ObjectGraphWalker<LiveObjectFinder>::VisitObjectList(*this, processList);
+		if (parallelMarker != nullptr &&
+			markStack.GetCount() >= config::Defaults::PARALLEL_MARK_MIN_OBJECTS)
+		{
+			// This empties the mark stack.
+			parallelMarker->Mark(*this);
+			break;
+		}
+
+		ObjectGraphWalker<LiveObjectFinder>::VisitObject(*this, markStack.Pop());
 	}
-	OVUM_ASSERT(processList == nullptr);
 
-	// Now we have found all survivors, and grouped them into the correct
-	// survivor lists, which means we're done!
+	// Now we have found and marked all survivors, which means we're done!
 }
 
-void LiveObjectFinder::TryGrayValue(Value *value)
+void LiveObjectFinder::VisitRememberedSet()
 {
-	if (ShouldGrayValue(value))
-		GrayObject(GCObject::FromValue(value));
+	RememberedSet &set = gc->rememberedSet;
+
+	inRememberedObject = true;
+
+	// Objects are visited in place. Those that should stay in the set are
+	// moved down to fill the gaps left by those that shouldn't. Nothing is
+	// added to the set while we're doing this.
+	size_t count = set.count;
+	size_t keptCount = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		GCObject *gco = set.items[i];
+		OVUM_ASSERT(gco->IsRemembered());
+
+		ObjectGraphWalker<LiveObjectFinder>::VisitObject(*this, gco);
+
+		if (ShouldRemember(gco))
+			set.items[keptCount++] = gco;
+		else
+			gco->flags &= ~GCOFlags::REMEMBERED;
+	}
+	set.count = keptCount;
+
+	inRememberedObject = false;
 }
 
-void LiveObjectFinder::TryGrayString(String *str)
+void LiveObjectFinder::NoteReference(GCOFlags flags)
 {
-	// If the string is not static, it has an associated GCObject.
-	if ((str->flags & StringFlags::STATIC) == StringFlags::NONE)
+	if ((flags & GCOFlags::GEN_0) == GCOFlags::GEN_0)
 	{
-		GCObject *gco = GCObject::FromInst(str);
-
-		// If the string belongs to generation 0, mark whatever referred
-		// to it as having gen0 references:
-		if ((gco->flags & GCOFlags::GEN_0) == GCOFlags::GEN_0)
+		// If the referenced object is a non-pinned gen0 object, its address
+		// will have to be updated once it has been moved to gen1. Otherwise,
+		// it stays where it is, and whatever referred to it may need to stay
+		// in the remembered set.
+		if ((flags & GCOFlags::PINNED) == GCOFlags::NONE)
 			hasGen0Refs = true;
-
-		// If the GCObject is white, we need to gray it.
-		if (gco->GetColor() == currentWhite)
-			GrayObject(gco);
+		else
+			hasPinnedGen0Refs = true;
 	}
 }
 
-bool LiveObjectFinder::ShouldGrayValue(Value *value)
+bool LiveObjectFinder::ShouldRemember(GCObject *gco)
+{
+	return hasPinnedGen0Refs || GC::HasUnbarrieredRefs(gco->type);
+}
+
+void LiveObjectFinder::TryMarkValue(Value *value)
 {
-	// A value should be grayed if the following conditions are met:
-	//
-	// * It is not null;
-	// * It is not of a primitive type;
-	// * It is not a static string (no associated GCObject); and
-	// * Its GCObject is white.
 	if (value->type == nullptr || value->type->IsPrimitive())
-		return false;
+		return;
 
 	if (value->type == stringType &&
 		(value->v.string->flags & StringFlags::STATIC) != StringFlags::NONE)
-		return false;
+		return;
 
 	// The null value, primitive values, and static strings do not have
 	// associated GCObjects. Since we have ruled out those possibilities
-	// now, we can safely retrieve a GCObject (or at least, its flags):
-	GCOFlags flags = GCObject::FromValue(value)->flags;
+	// now, we can safely retrieve a GCObject:
+	TryMarkObject(GCObject::FromValue(value));
+}
+
+void LiveObjectFinder::TryMarkString(String *str)
+{
+	// If the string is not static, it has an associated GCObject.
+	if ((str->flags & StringFlags::STATIC) == StringFlags::NONE)
+		TryMarkObject(GCObject::FromInst(str));
+}
 
-	// If the value is a non-pinned gen0 object, its address will have
+void LiveObjectFinder::TryMarkObject(GCObject *gco)
+{
+	// If the object is a non-pinned gen0 object, its address will have
 	// to be updated once moved to gen1. Mark whatever referred to this
-	// value as having gen0 references:
-	if ((flags & GCOFlags::GEN_0) == GCOFlags::GEN_0 &&
-		(flags & GCOFlags::PINNED) == GCOFlags::NONE)
-	{
-		hasGen0Refs = true;
-	}
+	// object as having gen0 references:
+	NoteReference(gco->flags);
 
-	return (flags & GCOFlags::COLOR) == currentWhite;
+	if (gc->TryMark(gco, fullCycle, worker != nullptr))
+		PushObject(gco);
 }
 
-void LiveObjectFinder::GrayObject(GCObject *gco)
+void LiveObjectFinder::PushObject(GCObject *gco)
 {
-	// We can only move to gray from white.
-	OVUM_ASSERT(gco->GetColor() == currentWhite);
-
 	Type *type = gco->type;
 	OVUM_ASSERT(
 		// If gco is an early sting (that is, a string allocated before aves.String
@@ -117,13 +154,6 @@ void LiveObjectFinder::GrayObject(GCObject *gco)
 		type != nullptr
 	);
 
-	// Now let's move the GCObject to the correct list. We'll start by removing
-	// it from its current list:
-	gco->RemoveFromList(&gc->collectList);
-	// Note that pinned objects are moved to collectList before any objects are
-	// examined, and are put back in pinnedList only after we've located all the
-	// survivors.
-
 	bool couldContainFields =
 		// If the type is null, the value is an early string or a GC-managed non-
 		// Value array. In that case, the type cannot contain any Value fields.
@@ -138,45 +168,31 @@ void LiveObjectFinder::GrayObject(GCObject *gco)
 
 	if (couldContainFields)
 	{
-		// If the value could contain managed Value fields, we have to make it
-		// gray so it can be examined in the next pass.
-		gco->InsertIntoList(&processList);
-		gco->SetColor(GCOFlags::GRAY);
+		// If the value could contain managed Value fields, we have to examine
+		// them later.
+		if (worker != nullptr)
+			worker->Push(gco);
+		else if (!gc->markStack.Push(gco))
+			// Not enough memory to continue marking; cannot recover from this.
+			abort();
 	}
 	else
 	{
-		// No chance of instance fields, so nothing to process. Move it directly
-		// to the black set.
-		AddSurvivor(gco);
-		gco->SetColor(currentBlack);
+		// No chance of instance fields, so nothing to process.
+		CountSurvivor(gco);
 	}
 }
 
-void LiveObjectFinder::AddSurvivor(GCObject *gco)
+void LiveObjectFinder::CountSurvivor(GCObject *gco)
 {
-	GCObject **list = nullptr;
-	if ((gco->flags & GCOFlags::GEN_0) == GCOFlags::GEN_0)
-	{
-		list = &survivorsFromGen0;
-	}
-	else
-	{
-		if (gco->HasGen0Refs())
-			list = &survivorsWithGen0Refs;
-		else
-			list = &keepList;
-
-		// We have to keep track of the total gen1 survivor size too.
-		if ((gco->flags & GCOFlags::GEN_1) == GCOFlags::GEN_1)
-			gen1SurvivorSize += gco->size;
-	}
-
-	gco->InsertIntoList(list);
+	// We have to keep track of the total gen1 survivor size.
+	if ((gco->flags & GCOFlags::GEN_1) == GCOFlags::GEN_1)
+		gen1SurvivorSize += gco->size;
 }
 
 void LiveObjectFinder::VisitRootValue(Value *value)
 {
-	TryGrayValue(value);
+	TryMarkValue(value);
 }
 
 void LiveObjectFinder::VisitRootLocalValue(Value *const value)
@@ -200,20 +216,20 @@ void LiveObjectFinder::VisitRootLocalValue(Value *const value)
 			// from the base of the GCObject. Value::v::reference is a
 			// pointer to the GCObject. We only want the GCObject.
 			GCObject *gco = reinterpret_cast<GCObject*>(value->v.reference);
-			if (gco->GetColor() == currentWhite)
-				GrayObject(gco);
+			if (gc->TryMark(gco, fullCycle, worker != nullptr))
+				PushObject(gco);
 		}
 	}
 	else
 	{
 		// If it's not a reference, treat it like any other value.
-		TryGrayValue(value);
+		TryMarkValue(value);
 	}
 }
 
 void LiveObjectFinder::VisitRootString(String *str)
 {
-	TryGrayString(str);
+	TryMarkString(str);
 }
 
 bool LiveObjectFinder::EnterStaticRefBlock(StaticRefBlock *const refs)
@@ -231,15 +247,10 @@ void LiveObjectFinder::LeaveStaticRefBlock(StaticRefBlock *const refs)
 
 bool LiveObjectFinder::EnterObject(GCObject *gco)
 {
-	// If an object gets here, it must be a gray object.
-	OVUM_ASSERT(gco->GetColor() == GCOFlags::GRAY);
-
-	// Make the object black immediately.
-	gco->SetColor(currentBlack);
-
 	hasGen0Refs = false;
+	hasPinnedGen0Refs = false;
 
-	// If the object has been added to the processList, we know it
+	// If the object has been pushed onto the mark stack, we know it
 	// might have some instance fields. We'll want to examine them.
 	return true;
 }
@@ -247,38 +258,54 @@ bool LiveObjectFinder::EnterObject(GCObject *gco)
 void LiveObjectFinder::LeaveObject(GCObject *gco)
 {
 	if (hasGen0Refs)
+	{
 		gco->flags |= GCOFlags::HAS_GEN0_REFS;
 
-	// Now let's move this survivor to the appropriate survivor list.
-	gco->RemoveFromList(&processList);
-	AddSurvivor(gco);
+		// If the object is outside gen0, its references must be updated once
+		// the gen0 objects have been moved. Gen0 objects are added after they
+		// have been moved; see GC::MoveSurvivorToGen1().
+		if ((gco->flags & GCOFlags::GEN_0) == GCOFlags::NONE)
+		{
+			if (worker != nullptr)
+				worker->AddSurvivorWithGen0Refs(gco);
+			else if (!gc->survivorsWithGen0Refs.Push(gco))
+				abort(); // Same as in PushObject()
+		}
+	}
+
+	// Objects in the remembered set are not marked. VisitRememberedSet()
+	// decides whether they stay remembered.
+	if (inRememberedObject)
+		return;
+
+	// Update the remembered set. Gen0 objects are added to it after they have
+	// been moved; see GC::MoveSurvivorToGen1().
+	if (!gco->IsRemembered() && ShouldRemember(gco))
+	{
+		if ((gco->flags & GCOFlags::GEN_0) == GCOFlags::GEN_0)
+			gco->flags |= GCOFlags::REMEMBERED;
+		else
+			gc->rememberedSet.Add(gco);
+	}
+
+	CountSurvivor(gco);
 }
 
 void LiveObjectFinder::VisitFieldValue(Value *value)
 {
-	TryGrayValue(value);
+	TryMarkValue(value);
 }
 
 void LiveObjectFinder::VisitFieldString(String **str)
 {
-	TryGrayString(*str);
+	TryMarkString(*str);
 }
 
 void LiveObjectFinder::VisitFieldArray(void **arrayBase)
 {
 	// The base of the array is the base of the instance, from which
 	// we can get a GCObject.
-	GCObject *gco = GCObject::FromInst(*arrayBase);
-
-	// If we have a non-pinned gen0 object, we have to set hasGen0Refs
-	// to true.
-	if ((gco->flags & GCOFlags::GEN_0) == GCOFlags::GEN_0 &&
-		!gco->IsPinned())
-		hasGen0Refs = true;
-
-	// And if its white, we need to gray it.
-	if (gco->GetColor() == currentWhite)
-		GrayObject(gco);
+	TryMarkObject(GCObject::FromInst(*arrayBase));
 }
 
 } // namespace ovum
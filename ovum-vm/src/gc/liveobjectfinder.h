@@ -4,56 +4,63 @@
 #include "gcobject.h"
 
 // The primary purpose of the LiveObjectFinder is to find live objects, exactly
-// as you might expect from the name. The secondary purpose: to categorise live
-// objects by generation. Let's discuss both.
+// as you might expect from the name. The secondary purpose: to note which
+// survivors refer to generation 0 objects. Let's discuss both.
 //
 // In order to find live objects, the class implements RootSetVisitor as well as
 // ObjectGraphVisitor. The RootSetWalker only visits live objects, and then we
-// can visit all of their members recursively, through ObjectGraphWalker. As we
-// locate survivors, we add them to the gray set (the "process" list), so that
-// the next ObjectGraphWalker iteration can process their members. As we process
-// each object in the gray set, we move it to the black set, which contains all
-// survivors whose members have been examined. Pretty normal tri-state garbage
-// collector, in other words.
+// can visit all of their members, through ObjectGraphWalker. As we locate each
+// survivor, we mark it, and push it onto the GC's mark stack, so that we can
+// examine its members later. Once the mark stack is empty, every live object
+// has been marked. Pretty normal mark phase, in other words.
 //
-// If we can determine that an object cannot possibly contain any references of
-// its own, we can move it directly to the black set. Hence we can save a tiny
-// bit of time by not even trying to process its members.
-//
-// However, as a survivor is added to the black set, we want to categorise it
-// based on certain generational characteristics. Since gen0 objects are moved
-// to gen1 before the garbage collection cycle concludes, we need to classify
-// survivors into one of the following groups, prioritised as shown:
+// Marks are not stored in the objects themselves. Gen0 objects are marked in a
+// side bitmap that covers all of gen0, and gen1 objects in bitmaps in the header
+// of the region that contains them (see GC::TryMark()). The mark stack is just
+// a dense array of pointers. As a result, marking touches very little memory
+// besides the fields of the objects being examined.
 //
-// 1. Survivors from generation 0.
-// 2. Survivors with references to generation 0 objects.
-// 3. All other survivors.
-//
-// We do this so as to spend minimal time updating references to gen0 objects,
-// after moving them to gen1. The rationale behind the three groups is this:
+// If we can determine that an object cannot possibly contain any references of
+// its own, we don't push it onto the mark stack. Hence we can save a tiny bit
+// of time by not even trying to process its members.
 //
-// 1. Gen0 objects are most likely to contain references to other gen0 objects,
-//    since objects tend to be created together in an "inside out" fashion. In
-//    practice, we will need to update many references of gen0 objects, so the
-//    performance impact of examining all of these objects is minimal.
-// 2. Survivors with gen0 references need to have those references updated as
-//    soon as gen0 objects have been moved. We can't really get around having
-//    to examine these object's members.
-// 3. The remaining survivors have no gen0 references. We don't have to do a
-//    single thing about them. These will be the regular "keep" list.
+// Survivors are not moved anywhere while we're marking. Afterwards, the GC
+// finds the gen0 survivors by scanning the gen0 bitmaps linearly, and moves
+// them to gen1. Every reference to a moved object then needs to be updated, so
+// as we examine each old object, we note whether it has any references to gen0
+// objects. Such objects are added to GC::survivorsWithGen0Refs, so that the GC
+// doesn't have to examine every survivor once gen0 objects have been moved.
+// Gen0 survivors with gen0 references are added by the GC once moved.
 //
 // Note that not ALL gen0 objects are moved to gen1: in particular, pinned gen0
 // objects CANNOT be moved (that's the point of pinning). These are added back
-// to the GC's pinnedList as they are found. See GC::AddPinnedObject() for more
-// details.
+// to the GC's pinnedObjects by GC::MoveGen0Survivors().
 //
-// The LiveObjectFinder also keeps track of the total size of gen1 survivors, as
-// this value is later used to determine whether to collect gen1 garbage.
+// The LiveObjectFinder also keeps track of the total size of gen1 survivors.
 //
 // Technically, large objects (meaning primarily sizable GC-managed arrays) do
 // not belong to generation 0 or 1, as they are in a wholly separate heap. But
 // for the purposes of this discussion, since they don't move, we will treat
-// them like gen1 objects.
+// them like gen1 objects. (They do differ in one respect: the mark bit of a
+// large object is in its header, since the LOH has no side bitmaps.)
+//
+// During a minor cycle, only gen0 objects are marked. Objects outside of gen0
+// are assumed to be alive, and are neither marked nor traced, except for the
+// objects in the GC's remembered set: their fields are examined (but they are
+// not marked) before the mark stack is processed, as they may be the only thing
+// keeping some gen0 objects alive.
+//
+// The LiveObjectFinder also maintains the remembered set. After examining the
+// fields of an old object, if the object refers to pinned gen0 objects (which
+// are not moved to gen1), or if the object has unbarriered references (see
+// GC::HasUnbarrieredRefs), it is kept in or added to the remembered set. Gen0
+// objects that satisfy the same condition are given the REMEMBERED flag, and
+// are added to the set by the GC after they have been moved to gen1.
+//
+// Marking can be spread out across several threads; see ParallelMarker for
+// details. In that case, each worker has its own LiveObjectFinder, which
+// pushes objects onto the worker's mark stacks instead of the GC's, and marks
+// objects atomically.
 
 namespace ovum
 {
@@ -61,7 +68,15 @@ namespace ovum
 class LiveObjectFinder
 {
 public:
-	LiveObjectFinder(GC *gc);
+	// Creates a LiveObjectFinder.
+	//   gc:
+	//     The GC that is running the cycle.
+	//   fullCycle:
+	//     True if the cycle collects the entire heap.
+	//   worker:
+	//     The parallel mark worker that the finder belongs to, or null if the
+	//     finder runs on the cycle thread and uses the GC's mark stack.
+	LiveObjectFinder(GC *gc, bool fullCycle, MarkWorker *worker = nullptr);
 
 	void FindLiveObjects();
 
@@ -94,10 +109,20 @@ public:
 private:
 	GC *gc;
 	// Cached values for maximum performance
-	GCOFlags currentWhite;
-	GCOFlags currentBlack;
 	Type *stringType;
 
+	// True if the current cycle collects the entire heap; false if it only
+	// collects gen0.
+	bool fullCycle;
+
+	// The parallel mark worker this finder belongs to, or null. If this is
+	// not null, other threads are marking at the same time.
+	MarkWorker *worker;
+
+	// True while the fields of an object in the remembered set are being
+	// examined. Only used during minor cycles.
+	bool inRememberedObject;
+
 	// If the current object or static ref block contains references to
 	// generation 0, this member is set to true. It is reset to false
 	// upon entering an object or static ref block.
@@ -106,55 +131,66 @@ private:
 	// the basic idea.
 	bool hasGen0Refs;
 
+	// Like hasGen0Refs, but set to true if the current object contains any
+	// references to pinned gen0 objects.
+	bool hasPinnedGen0Refs;
+
 	// The total size of survivors from generation 1.
 	size_t gen1SurvivorSize;
 
-	// The gray set; that is, objects whose members are to be visited and
-	// processed.
-	GCObject *processList;
-
-	// The black list. Initially containing only gen1 survivors without
-	// gen0 references, later filled in with other survivors.
-	GCObject *keepList;
+	// The total size of survivors from generation 0, including those that are
+	// pinned. This is calculated by GC::MoveGen0Survivors().
+	size_t gen0SurvivorSize;
 
-	// Survivors from generation 0. These will be moved to generation 1,
-	// except for pinned objects.
-	GCObject *survivorsFromGen0;
+	// Examines the fields of every object in the remembered set, marking the
+	// gen0 objects they refer to, and removes objects that no longer need to
+	// be remembered.
+	void VisitRememberedSet();
 
-	// Gen1 survivors with gen0 references. These will have their members
-	// examined after gen0 survivors are moved.
-	GCObject *survivorsWithGen0Refs;
+	// Updates hasGen0Refs and hasPinnedGen0Refs based on the flags of an
+	// object that is being referred to.
+	void NoteReference(GCOFlags flags);
 
-	// Makes a value gray, if it should be made gray. Side effect: sets
-	// hasGen0Refs to true if the value is in gen0.
-	void TryGrayValue(Value *value);
+	// Determines whether an object with the specified type should be in the
+	// remembered set once it's in the old generation, based on the current
+	// value of hasPinnedGen0Refs.
+	bool ShouldRemember(GCObject *gco);
 
-	// Makes a string gray, if it should be made gray. Side effect: sets
-	// hasGen0Refs to true if the string is in gen0.
-	void TryGrayString(String *str);
-
-	// Determines whether a value should be made gray. Side effect: sets
-	// hasGen0Refs to true if the value is in gen0 (even if the method
-	// returns false).
+	// Marks the object referred to by a value, if it has one and it should
+	// be marked. Side effect: sets hasGen0Refs to true if the value is in
+	// gen0.
 	//
-	// A value should be grayed if the following conditions are met:
+	// A value is marked if the following conditions are met:
 	//
 	// * It is not null;
 	// * It is not of a primitive type;
-	// * It is not a static string (no associated GCObject); and
-	// * Its GCObject is white.
+	// * It is not a static string (no associated GCObject);
+	// * Its GCObject is not already marked; and
+	// * During a minor cycle, its GCObject is in gen0.
 	//
 	// Note: This method is only called for reachable values. Unreachable
-	// values will never be visited, so will never be grayed.
-	bool ShouldGrayValue(Value *value);
+	// values will never be visited, so will never be marked.
+	void TryMarkValue(Value *value);
+
+	// Marks a string, if it should be marked. Side effect: sets hasGen0Refs
+	// to true if the string is in gen0.
+	void TryMarkString(String *str);
+
+	// Marks an object, if it should be marked. Side effect: sets hasGen0Refs
+	// to true if the object is in gen0.
+	void TryMarkObject(GCObject *gco);
 
-	// Makes an object gray.
-	void GrayObject(GCObject *gco);
+	// Pushes a newly marked object onto the mark stack, if its fields need to
+	// be examined.
+	void PushObject(GCObject *gco);
 
-	// Adds the object to an appropriate survivor list.
-	void AddSurvivor(GCObject *gco);
+	// Updates survivor statistics for an object whose fields have been
+	// examined (or that has no fields to examine).
+	void CountSurvivor(GCObject *gco);
 
 	friend class GC;
+	friend class MarkWorker;
+	friend class ParallelMarker;
 };
 
 } // namespace ovum
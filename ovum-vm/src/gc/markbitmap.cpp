@@ -0,0 +1,75 @@
+#include "markbitmap.h"
+
+namespace ovum
+{
+
+MarkBitmap::MarkBitmap() :
+	base(nullptr),
+	size(0),
+	words(nullptr),
+	wordCount(0)
+{ }
+
+MarkBitmap::~MarkBitmap()
+{
+	delete[] words;
+}
+
+bool MarkBitmap::Init(void *base, size_t size)
+{
+	size_t newWordCount = (size + BYTES_PER_WORD - 1) / BYTES_PER_WORD;
+	uintptr_t *newWords = new(std::nothrow) uintptr_t[newWordCount];
+	if (newWords == nullptr)
+		return false;
+
+	delete[] words;
+	this->base = (char*)base;
+	this->size = size;
+	this->words = newWords;
+	this->wordCount = newWordCount;
+
+	ClearAll();
+	return true;
+}
+
+void MarkBitmap::ClearAll()
+{
+	memset(words, 0, wordCount * sizeof(uintptr_t));
+}
+
+void MarkBitmap::Swap(MarkBitmap &other)
+{
+	std::swap(base, other.base);
+	std::swap(size, other.size);
+	std::swap(words, other.words);
+	std::swap(wordCount, other.wordCount);
+}
+
+char *MarkBitmap::FindNext(char *from, char *to) const
+{
+	if (from >= to)
+		return nullptr;
+
+	size_t index = GetIndex(from);
+	size_t wordIndex = index / BITS_PER_WORD;
+	// Ignore the bits below 'from' in the first word.
+	uintptr_t word = words[wordIndex] & ~(GetBit(index) - 1);
+
+	while (true)
+	{
+		if (word != 0)
+		{
+			size_t bitIndex = wordIndex * BITS_PER_WORD + LowestSetBit(word);
+			char *result = base + bitIndex * GRANULE_SIZE;
+			return result < to ? result : nullptr;
+		}
+
+		wordIndex++;
+		if (wordIndex >= wordCount ||
+			base + wordIndex * BYTES_PER_WORD >= to)
+			return nullptr;
+		word = words[wordIndex];
+	}
+}
+
+} // namespace ovum
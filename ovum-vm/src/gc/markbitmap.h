@@ -0,0 +1,146 @@
+#pragma once
+
+#include "../vm.h"
+#include <atomic>
+
+namespace ovum
+{
+
+// A side bitmap over a contiguous range of memory, with one bit for every
+// GRANULE_SIZE bytes. The GC keeps two of these for generation 0: one that
+// records where each object starts, and one that records which objects have
+// been marked during the current cycle.
+//
+// Keeping this information off to the side, rather than in the GCObject
+// header, means that the marker only touches a small, dense array, and that
+// the sweeper can find every object by scanning the bitmap linearly, instead
+// of chasing pointers from one object to the next.
+//
+// The bitmap is not thread-safe in general. However, bits that are stored in
+// different words can be modified by different threads at the same time. The
+// GC relies on this to let each thread record its allocations without taking
+// a lock; see GC::RefillAllocBuffer(). During parallel marking, TrySet() can
+// be told to set bits atomically instead.
+class MarkBitmap
+{
+public:
+	// The number of bytes covered by each bit. Every address that is passed
+	// to the bitmap must be aligned to this.
+	static const size_t GRANULE_SIZE = 8;
+	// The number of bits in each word of the bitmap.
+	static const size_t BITS_PER_WORD = sizeof(uintptr_t) * 8;
+	// The number of bytes covered by each word of the bitmap.
+	static const size_t BYTES_PER_WORD = BITS_PER_WORD * GRANULE_SIZE;
+
+	MarkBitmap();
+
+	~MarkBitmap();
+
+	// Makes the bitmap cover a new range of memory. All bits are cleared.
+	//   base:
+	//     The start of the range.
+	//   size:
+	//     The size of the range, in bytes.
+	// Returns:
+	//   True on success. If the bitmap could not be allocated, returns false
+	//   and leaves the bitmap unchanged.
+	bool Init(void *base, size_t size);
+
+	// Clears every bit in the bitmap.
+	void ClearAll();
+
+	// Exchanges the contents of this bitmap with those of another.
+	void Swap(MarkBitmap &other);
+
+	inline bool IsSet(void *address) const
+	{
+		size_t index = GetIndex(address);
+		return (words[index / BITS_PER_WORD] & GetBit(index)) != 0;
+	}
+
+	inline void Set(void *address)
+	{
+		size_t index = GetIndex(address);
+		words[index / BITS_PER_WORD] |= GetBit(index);
+	}
+
+	// Sets the bit for the specified address, and returns true if it was not
+	// already set.
+	//   concurrent:
+	//     If true, the bit is set atomically, so that several threads can set
+	//     bits in the same word at the same time. Used by parallel marking.
+	inline bool TrySet(void *address, bool concurrent)
+	{
+		size_t index = GetIndex(address);
+		return TrySetBit(words[index / BITS_PER_WORD], GetBit(index), concurrent);
+	}
+
+	// Finds the lowest address in the range [from, to) whose bit is set.
+	// Returns null if there is no such address.
+	char *FindNext(char *from, char *to) const;
+
+	// Sets a bit in a bitmap word, and returns true if it was not already set.
+	// If concurrent is true, the bit is set with an atomic OR; in that case,
+	// exactly one of several threads racing to set the same bit succeeds.
+	// This is also used for the mark bitmaps of gen1 regions.
+	static inline bool TrySetBit(uintptr_t &word, uintptr_t bit, bool concurrent)
+	{
+		// Most objects are reached more than once, so check before paying for
+		// an atomic operation.
+		if ((word & bit) != 0)
+			return false;
+
+		if (concurrent)
+		{
+			std::atomic<uintptr_t> &atomicWord = reinterpret_cast<std::atomic<uintptr_t>&>(word);
+			return (atomicWord.fetch_or(bit, std::memory_order_relaxed) & bit) == 0;
+		}
+
+		word |= bit;
+		return true;
+	}
+
+	// Gets the index of the lowest set bit in a non-zero word.
+	static inline size_t LowestSetBit(uintptr_t word)
+	{
+		OVUM_ASSERT(word != 0);
+		size_t index = 0;
+		while ((word & 0xff) == 0)
+		{
+			word >>= 8;
+			index += 8;
+		}
+		while ((word & 1) == 0)
+		{
+			word >>= 1;
+			index++;
+		}
+		return index;
+	}
+
+private:
+	char *base;
+	size_t size;
+
+	uintptr_t *words;
+	size_t wordCount;
+
+	inline size_t GetIndex(void *address) const
+	{
+		OVUM_ASSERT((char*)address >= base && (char*)address < base + size);
+		return ((char*)address - base) / GRANULE_SIZE;
+	}
+
+	static inline uintptr_t GetBit(size_t index)
+	{
+		return (uintptr_t)1 << (index % BITS_PER_WORD);
+	}
+
+	OVUM_DISABLE_COPY_AND_ASSIGN(MarkBitmap);
+};
+
+// TrySetBit() treats bitmap words as atomics.
+static_assert(sizeof(std::atomic<uintptr_t>) == sizeof(uintptr_t),
+	"std::atomic<uintptr_t> must have the same size as uintptr_t");
+
+} // namespace ovum
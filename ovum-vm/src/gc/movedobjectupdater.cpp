@@ -11,22 +11,41 @@
 namespace ovum
 {
 
-MovedObjectUpdater::MovedObjectUpdater(GC *gc, GCObject **keepList) :
+MovedObjectUpdater::MovedObjectUpdater(GC *gc) :
 	gc(gc),
-	keepList(keepList)
+	updateAll(false)
 {
 	stringType = gc->GetVM()->types.String;
 }
 
-void MovedObjectUpdater::UpdateMovedObjects(GCObject *list)
+void MovedObjectUpdater::UpdateMovedObjects(ObjectArray &objects)
 {
 	RootSetWalker<MovedObjectUpdater> rootWalker(gc);
 	rootWalker.VisitRootSet(*this);
 
-	ObjectGraphWalker<MovedObjectUpdater>::VisitObjectList(*this, list);
+	ObjectGraphWalker<MovedObjectUpdater>::VisitObjectArray(*this, objects);
 
-	// We have to update the GC's pinnedList too
-	ObjectGraphWalker<MovedObjectUpdater>::VisitObjectList(*this, gc->pinnedList);
+	// We have to update the GC's pinned objects too
+	ObjectGraphWalker<MovedObjectUpdater>::VisitObjectArray(*this, gc->pinnedObjects);
+}
+
+void MovedObjectUpdater::UpdateAllReferences()
+{
+	updateAll = true;
+
+	RootSetWalker<MovedObjectUpdater> rootWalker(gc);
+	rootWalker.VisitRootSet(*this);
+
+	gc->gen1Heap.VisitObjects(*this);
+	ObjectGraphWalker<MovedObjectUpdater>::VisitObjectArray(*this, gc->largeObjects);
+	ObjectGraphWalker<MovedObjectUpdater>::VisitObjectArray(*this, gc->pinnedObjects);
+
+	updateAll = false;
+}
+
+void MovedObjectUpdater::VisitHeapObject(GCObject *gco)
+{
+	ObjectGraphWalker<MovedObjectUpdater>::VisitObject(*this, gco);
 }
 
 GCObject *MovedObjectUpdater::ValueToGco(Value *value)
@@ -98,7 +117,7 @@ void MovedObjectUpdater::VisitRootLocalValue(Value *const value)
 void MovedObjectUpdater::VisitRootString(String *str)
 {
 	// Root strings are always allocated in generation 1 directly, and
-	// so should never require moving.
+	// are pinned, so should never require moving.
 	OVUM_ASSERT(
 		(str->flags & StringFlags::STATIC) == StringFlags::STATIC ||
 		!GCObject::FromInst(str)->IsMoved()
@@ -108,8 +127,8 @@ void MovedObjectUpdater::VisitRootString(String *str)
 bool MovedObjectUpdater::EnterStaticRefBlock(StaticRefBlock *const refs)
 {
 	// We only need to examine the values in the static ref block if
-	// any of them are in generation 0.
-	return refs->hasGen0Refs;
+	// any of them are in generation 0, unless gen1 has been compacted.
+	return updateAll || refs->hasGen0Refs;
 }
 
 void MovedObjectUpdater::LeaveStaticRefBlock(StaticRefBlock *const refs)
@@ -120,10 +139,12 @@ void MovedObjectUpdater::LeaveStaticRefBlock(StaticRefBlock *const refs)
 
 bool MovedObjectUpdater::EnterObject(GCObject *gco)
 {
-	// If the object is NOT pinned, move it to the "keep" list. Otherwise
-	// leave it in GC::pinnedList, where it belongs.
-	if (!gco->IsPinned())
-		gco->InsertIntoList(keepList);
+	// After compaction, any object may refer to a moved object. The old
+	// copies of the moved objects are still in the heap, however, and no
+	// longer have a valid type. Dead objects that are waiting for their
+	// finalizers may refer to objects that no longer exist.
+	if (updateAll)
+		return !gco->IsMoved() && !gco->IsDead();
 
 	// We only need to examine the object's references if any of them
 	// are in generation 0.
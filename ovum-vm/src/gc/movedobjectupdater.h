@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../vm.h"
+#include "objectarray.h"
 
 // As part of a GC cycle, objects in generation 0 are moved out into generation
 // 1, which entails actually physically moving the data in memory. This does of
@@ -12,6 +13,12 @@
 // MovedObjectUpdater walks through the root set as well as one level of the
 // object graph, updating all references to moved gen0 objects.
 //
+// The same machinery is used when generation 1 is compacted (see
+// GC::CompactGen1()). In that case, any live object may refer to a moved
+// object, so every object is examined, not just those with gen0 references.
+// The objects are found by walking the gen1 heap, the large object array and
+// the pinned gen0 objects.
+//
 // NOTE: This class assumes live objects have been located beforehand (using
 // LiveObjectFinder), and that gen0 objects have been moved to gen1 (using the
 // method GC::MoveGen0Survivors()). Failure to do these things first absolutely
@@ -23,9 +30,18 @@ namespace ovum
 class MovedObjectUpdater
 {
 public:
-	MovedObjectUpdater(GC *gc, GCObject **keepList);
+	MovedObjectUpdater(GC *gc);
+
+	// Updates references to moved gen0 objects in the root set, the objects
+	// in 'objects' (which must have gen0 references), and GC::pinnedObjects.
+	void UpdateMovedObjects(ObjectArray &objects);
+
+	// Updates references to moved objects in the root set and every object
+	// in the heap. This is used after gen1 has been compacted.
+	void UpdateAllReferences();
 
-	void UpdateMovedObjects(GCObject *list);
+	// Gen1Heap visitor method
+	void VisitHeapObject(GCObject *gco);
 
 	// RootSetVisitor methods
 
@@ -54,15 +70,12 @@ public:
 private:
 	GC *gc;
 
-	// The "keep" list, which receives all live, non-pinned objects.
-	// Objects are moved to this list as they are processed.
-	//
-	// This points to LiveObjectFinder::keepList.
-	GCObject **keepList;
-
 	// Cached for speediness.
 	Type *stringType;
 
+	// If true, every object and static reference block is examined.
+	bool updateAll;
+
 	// Tries to find a value's GCObject. If the value does not have
 	// an associated GCObject, the result is null.
 	GCObject *ValueToGco(Value *value);
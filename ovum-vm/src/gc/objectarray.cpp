@@ -0,0 +1,42 @@
+#include "objectarray.h"
+
+namespace ovum
+{
+
+ObjectArray::ObjectArray() :
+	items(nullptr),
+	count(0),
+	capacity(0)
+{ }
+
+ObjectArray::~ObjectArray()
+{
+	delete[] items;
+}
+
+void ObjectArray::Swap(ObjectArray &other)
+{
+	std::swap(items, other.items);
+	std::swap(count, other.count);
+	std::swap(capacity, other.capacity);
+}
+
+bool ObjectArray::Grow()
+{
+	size_t newCapacity = capacity == 0 ? INITIAL_CAPACITY : 2 * capacity;
+	GCObject **newItems = new(std::nothrow) GCObject*[newCapacity];
+	if (newItems == nullptr)
+		return false;
+
+	if (items)
+	{
+		CopyMemoryT(newItems, items, count);
+		delete[] items;
+	}
+
+	items = newItems;
+	capacity = newCapacity;
+	return true;
+}
+
+} // namespace ovum
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "../vm.h"
+#include "gcobject.h"
+
+namespace ovum
+{
+
+// A growable, densely packed array of GCObject pointers. The GC uses these
+// instead of threading objects together through their headers: for the mark
+// stack, for the set of pinned gen0 objects, for large objects, and so on.
+//
+// The array never shrinks. Since the GC reuses the same arrays every cycle,
+// memory is only allocated when an array needs more room than it has ever
+// needed before.
+//
+// ObjectArray is not thread-safe.
+class ObjectArray
+{
+public:
+	ObjectArray();
+
+	~ObjectArray();
+
+	// Gets the number of objects in the array.
+	inline size_t GetCount() const
+	{
+		return count;
+	}
+
+	inline bool IsEmpty() const
+	{
+		return count == 0;
+	}
+
+	inline GCObject *operator[](size_t index) const
+	{
+		OVUM_ASSERT(index < count);
+		return items[index];
+	}
+
+	// Adds an object to the end of the array. Returns false if the array is
+	// full and could not be grown.
+	inline bool Push(GCObject *gco)
+	{
+		if (count == capacity && !Grow())
+			return false;
+		items[count++] = gco;
+		return true;
+	}
+
+	// Removes and returns the last object in the array. The array must not
+	// be empty.
+	inline GCObject *Pop()
+	{
+		OVUM_ASSERT(count > 0);
+		return items[--count];
+	}
+
+	// Replaces the object at the specified index.
+	inline void Set(size_t index, GCObject *gco)
+	{
+		OVUM_ASSERT(index < count);
+		items[index] = gco;
+	}
+
+	// Discards every object at or after the specified index.
+	inline void Truncate(size_t newCount)
+	{
+		OVUM_ASSERT(newCount <= count);
+		count = newCount;
+	}
+
+	// Removes all objects from the array, without releasing its memory.
+	inline void Clear()
+	{
+		count = 0;
+	}
+
+	// Exchanges the contents of this array with those of another.
+	void Swap(ObjectArray &other);
+
+private:
+	static const size_t INITIAL_CAPACITY = 256;
+
+	GCObject **items;
+	size_t count;
+	size_t capacity;
+
+	bool Grow();
+
+	OVUM_DISABLE_COPY_AND_ASSIGN(ObjectArray);
+};
+
+} // namespace ovum
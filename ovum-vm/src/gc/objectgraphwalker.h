@@ -5,13 +5,12 @@
 #include "../object/type.h"
 
 // The ObjectGraphWalker, as the name implies, walks the object graph. Given a
-// GCObject list (in the form of a single GCObject, which makes up the head of
-// a doubly linked list), the ObjectGraphWalker visits each GCObject in the
-// list, as well as each object's fields.
+// GCObject, or an array of them, the ObjectGraphWalker visits each GCObject,
+// as well as each object's fields.
 //
 // To prevent extremely deep recursion, the ObjectGraphWalker only visits one
 // level of the object graph. It's up to the visitor to collect the objects to
-// be visited in the next pass. Thus you get a breadth-first visitor.
+// be visited next (e.g. on a mark stack).
 //
 // An object's fields can contain one of three kinds of values:
 //
@@ -23,10 +22,6 @@
 // prototype ObjectGraphVisitor. The visitor must manage any state it requires
 // while processing the object graph.
 //
-// The visited GCObject can safely be moved to another GCObject list as soon as
-// EnterObject() is called for that object, or any time thereafter. The walker
-// simply caches the next GCObject.
-//
 // A class can safely implement both ObjectGraphVisitor and RootSetVisitor. The
 // method names do not overlap.
 
@@ -84,20 +79,12 @@ template<class Visitor>
 class ObjectGraphWalker
 {
 public:
-	static void VisitObjectList(Visitor &visitor, GCObject *head)
+	// Visits every object in an array. The visitor must not modify the array.
+	static void VisitObjectArray(Visitor &visitor, ObjectArray &objects)
 	{
-		while (head)
-		{
-			// We have to support situations where the object is removed from
-			// the list as part of visiting it, hence we need to cache the next
-			// value in the list here. Since we never move backwards, there is
-			// no need to cache the previous value.
-			GCObject *next = head->next;
-
-			VisitObject(visitor, head);
-
-			head = next;
-		}
+		size_t count = objects.GetCount();
+		for (size_t i = 0; i < count; i++)
+			VisitObject(visitor, objects[i]);
 	}
 
 	static void VisitObject(Visitor &visitor, GCObject *gco)
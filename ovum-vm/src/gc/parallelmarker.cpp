@@ -0,0 +1,246 @@
+#include "parallelmarker.h"
+#include "gc.h"
+#include "liveobjectfinder.h"
+#include "objectgraphwalker.h"
+
+namespace ovum
+{
+
+MarkWorker::MarkWorker() :
+	marker(nullptr),
+	index(0),
+	thread(),
+	sharedCount(0),
+	gen1SurvivorSize(0)
+{ }
+
+void MarkWorker::Run()
+{
+	LiveObjectFinder finder(marker->gc, marker->fullCycle, this);
+
+	do
+	{
+		while (!privateStack.IsEmpty())
+		{
+			ObjectGraphWalker<LiveObjectFinder>::VisitObject(finder, privateStack.Pop());
+
+			// Share some of our work if we have plenty of it and the other
+			// workers have nothing left to steal from us.
+			if (privateStack.GetCount() >= PUBLISH_THRESHOLD &&
+				sharedCount.load(std::memory_order_relaxed) == 0)
+				Publish();
+		}
+	} while (FindWork());
+
+	gen1SurvivorSize = finder.gen1SurvivorSize;
+}
+
+void MarkWorker::Publish()
+{
+	size_t count = privateStack.GetCount() / 2;
+
+	sharedLock.Enter();
+	for (size_t i = 0; i < count; i++)
+		if (!sharedStack.Push(privateStack.Pop()))
+			abort(); // Same as in Push()
+	sharedCount.store(sharedStack.GetCount(), std::memory_order_relaxed);
+	sharedLock.Leave();
+}
+
+bool MarkWorker::TakeFrom(MarkWorker *victim)
+{
+	if (victim->sharedCount.load(std::memory_order_relaxed) == 0)
+		return false;
+
+	if (victim == this)
+		sharedLock.Enter();
+	else if (!victim->sharedLock.TryEnter())
+		// Don't wait for a busy victim; there are probably others.
+		return false;
+
+	ObjectArray &stack = victim->sharedStack;
+	size_t available = stack.GetCount();
+	size_t count = victim == this ? available : (available + 1) / 2;
+	for (size_t i = 0; i < count; i++)
+		Push(stack.Pop());
+	victim->sharedCount.store(stack.GetCount(), std::memory_order_relaxed);
+
+	victim->sharedLock.Leave();
+	return count > 0;
+}
+
+bool MarkWorker::FindWork()
+{
+	// Take back anything the other workers haven't stolen from us yet. This
+	// must happen before we go idle; see ParallelMarker for details.
+	if (TakeFrom(this))
+		return true;
+
+	ParallelMarker *marker = this->marker;
+	uint32_t workerCount = marker->workerCount;
+	MarkWorker *workers = marker->workers.get();
+
+	while (true)
+	{
+		// Try every other worker once, starting with our neighbour, so that
+		// the workers don't all go after the same victim.
+		for (uint32_t i = 1; i < workerCount; i++)
+		{
+			MarkWorker *victim = workers + (index + i) % workerCount;
+			if (TakeFrom(victim))
+				return true;
+		}
+
+		// Nothing to steal. Go idle, and wait until either some other worker
+		// publishes something, or every worker is idle.
+		marker->idleCount.fetch_add(1);
+
+		int spinCount = 0;
+		while (true)
+		{
+			if (marker->idleCount.load() == workerCount)
+				return false;
+
+			if (marker->HasSharedWork())
+				break;
+
+			if (++spinCount == MAX_SPIN_COUNT)
+			{
+				os::Yield();
+				spinCount = 0;
+			}
+		}
+
+		marker->idleCount.fetch_sub(1);
+	}
+}
+
+void MarkWorker::ThreadMain(void *state)
+{
+	MarkWorker *worker = reinterpret_cast<MarkWorker*>(state);
+	ParallelMarker *marker = worker->marker;
+
+	while (true)
+	{
+		marker->startSignal.Enter();
+		if (marker->shuttingDown)
+			break;
+
+		worker->Run();
+
+		marker->doneSignal.Leave();
+	}
+}
+
+Box<ParallelMarker> ParallelMarker::New(GC *gc, uint32_t workerCount)
+{
+	OVUM_ASSERT(workerCount >= 2);
+
+	Box<ParallelMarker> result(new(std::nothrow) ParallelMarker(gc, workerCount));
+	if (!result)
+		return nullptr;
+
+	result->workers.reset(new(std::nothrow) MarkWorker[workerCount]);
+	if (!result->workers)
+		return nullptr;
+
+	for (uint32_t i = 0; i < workerCount; i++)
+	{
+		MarkWorker *worker = result->workers.get() + i;
+		worker->marker = result.get();
+		worker->index = i;
+	}
+
+	if (!result->StartThreads())
+		return nullptr;
+
+	return std::move(result);
+}
+
+ParallelMarker::ParallelMarker(GC *gc, uint32_t workerCount) :
+	gc(gc),
+	workerCount(workerCount),
+	workers(),
+	startedThreads(0),
+	fullCycle(false),
+	idleCount(0),
+	shuttingDown(false),
+	startSignal(0),
+	doneSignal(0)
+{ }
+
+ParallelMarker::~ParallelMarker()
+{
+	// Wake up every worker thread; when they see shuttingDown, they exit.
+	shuttingDown = true;
+	for (uint32_t i = 0; i < startedThreads; i++)
+		startSignal.Leave();
+
+	for (uint32_t i = 1; i <= startedThreads; i++)
+		os::ThreadJoin(&workers[i].thread);
+}
+
+bool ParallelMarker::StartThreads()
+{
+	// Worker 0 runs on the cycle thread.
+	for (uint32_t i = 1; i < workerCount; i++)
+	{
+		MarkWorker *worker = workers.get() + i;
+		if (!os::ThreadStart(&worker->thread, MarkWorker::ThreadMain, worker))
+			return false;
+		startedThreads++;
+	}
+	return true;
+}
+
+void ParallelMarker::Mark(LiveObjectFinder &finder)
+{
+	fullCycle = finder.fullCycle;
+	idleCount.store(0);
+
+	// Deal out the contents of the mark stack. Objects that are next to each
+	// other in the mark stack were often found in the same object, so dealing
+	// them out one by one spreads related work across all workers.
+	ObjectArray &markStack = gc->markStack;
+	uint32_t next = 0;
+	while (!markStack.IsEmpty())
+	{
+		workers[next].Push(markStack.Pop());
+		next = (next + 1) % workerCount;
+	}
+
+	for (uint32_t i = 1; i < workerCount; i++)
+		startSignal.Leave();
+
+	workers[0].Run();
+
+	for (uint32_t i = 1; i < workerCount; i++)
+		doneSignal.Enter();
+
+	// Now merge the workers' results.
+	for (uint32_t i = 0; i < workerCount; i++)
+	{
+		MarkWorker &worker = workers[i];
+		OVUM_ASSERT(worker.privateStack.IsEmpty());
+		OVUM_ASSERT(worker.sharedStack.IsEmpty());
+
+		finder.gen1SurvivorSize += worker.gen1SurvivorSize;
+		worker.gen1SurvivorSize = 0;
+
+		ObjectArray &survivors = worker.survivorsWithGen0Refs;
+		for (size_t j = 0; j < survivors.GetCount(); j++)
+			if (!gc->survivorsWithGen0Refs.Push(survivors[j]))
+				abort(); // Same as in MarkWorker::Push()
+		survivors.Clear();
+	}
+}
+
+bool ParallelMarker::HasSharedWork() const
+{
+	for (uint32_t i = 0; i < workerCount; i++)
+		if (workers[i].sharedCount.load(std::memory_order_relaxed) != 0)
+			return true;
+	return false;
+}
+
+} // namespace ovum
@@ -0,0 +1,192 @@
+#pragma once
+
+#include "../vm.h"
+#include "gcobject.h"
+#include "objectarray.h"
+#include "../threading/sync.h"
+#include <atomic>
+
+// The ParallelMarker lets several threads share the work of the mark phase.
+//
+// The LiveObjectFinder always starts marking on the thread that runs the GC
+// cycle: it marks the root set and examines the remembered set, which fills up
+// the GC's mark stack. Once the mark stack holds enough objects for it to be
+// worth it (see config::Defaults::PARALLEL_MARK_MIN_OBJECTS), the objects are
+// dealt out to the workers, and all of them drain their share at once, each
+// with its own LiveObjectFinder. The cycle thread takes part as worker 0; the
+// other workers are native threads that sleep between cycles.
+//
+// Each worker has two mark stacks:
+//
+// * A private stack, which only the owner touches. Objects are pushed onto
+//   and popped off it without any synchronization.
+// * A shared stack, protected by a spinlock, from which other workers may
+//   steal. When the private stack grows large and the shared stack is empty,
+//   the owner publishes half of its private stack by moving it to the shared
+//   stack.
+//
+// A worker whose private stack runs dry first takes back whatever is left in
+// its own shared stack, then tries to steal half of another worker's shared
+// stack. If there is nothing to steal, the worker goes idle until there is.
+// Marking is over when every worker is idle at the same time. A worker only
+// publishes objects while it is busy, and empties its shared stack before it
+// goes idle, so at that point every stack is empty, and no new work can show
+// up.
+//
+// Marking from several threads at once is safe because:
+//
+// * Mark bits are set atomically (see GC::TryMark()), so exactly one worker
+//   claims each object. That worker alone examines the object's fields and
+//   updates its flags.
+// * The remembered set is thread-safe.
+// * Everything else that a LiveObjectFinder accumulates, such as survivor
+//   sizes and survivors with gen0 references, is kept per worker, and merged
+//   once marking is done.
+// * ReferenceWalkers must be safe to call concurrently for different objects
+//   (see the documentation of ReferenceWalker in ovum_type.h).
+//
+// If the VM is started with a single GC worker, there is no ParallelMarker,
+// and the whole mark phase runs serially, on the cycle thread.
+
+namespace ovum
+{
+
+class ParallelMarker;
+
+class MarkWorker
+{
+public:
+	MarkWorker();
+
+	// Pushes a newly marked object onto the worker's private mark stack.
+	inline void Push(GCObject *gco)
+	{
+		if (!privateStack.Push(gco))
+			// Not enough memory to continue marking; cannot recover from this.
+			abort();
+	}
+
+	// Adds an object outside gen0 that has references to gen0 objects. These
+	// are moved to GC::survivorsWithGen0Refs after marking.
+	inline void AddSurvivorWithGen0Refs(GCObject *gco)
+	{
+		if (!survivorsWithGen0Refs.Push(gco))
+			abort(); // Same as in Push()
+	}
+
+private:
+	// The number of objects the private stack must contain before the worker
+	// publishes half of them.
+	static const size_t PUBLISH_THRESHOLD = 64;
+
+	// The number of times an idle worker checks for work before yielding its
+	// time slice to another thread.
+	static const int MAX_SPIN_COUNT = 50;
+
+	ParallelMarker *marker;
+	// The index of this worker in ParallelMarker::workers.
+	uint32_t index;
+
+	// The native thread that runs this worker. Worker 0 does not have one;
+	// it runs on the thread that runs the GC cycle.
+	os::NativeThread thread;
+
+	ObjectArray privateStack;
+
+	ObjectArray sharedStack;
+	// The number of objects in sharedStack. Other workers read this to find
+	// out whether there is anything to steal, without entering the lock.
+	std::atomic<size_t> sharedCount;
+	// Protects sharedStack.
+	SpinLock sharedLock;
+
+	ObjectArray survivorsWithGen0Refs;
+	// The total size of gen1 survivors found by this worker.
+	size_t gen1SurvivorSize;
+
+	// Marks everything reachable from the objects in the private stack, and
+	// from anything stolen from other workers. Returns when every worker has
+	// run out of work.
+	void Run();
+
+	// Moves half of the objects in the private stack to the shared stack.
+	void Publish();
+
+	// Moves up to half of the objects in victim's shared stack (all of them,
+	// if victim is this worker) to the private stack. Returns true if any
+	// objects were taken.
+	bool TakeFrom(MarkWorker *victim);
+
+	// Looks for more work once the private stack is empty, going idle if
+	// there is none. Returns true if objects were added to the private stack,
+	// or false if every worker is idle, which means marking is done.
+	bool FindWork();
+
+	static void ThreadMain(void *state);
+
+	OVUM_DISABLE_COPY_AND_ASSIGN(MarkWorker);
+
+	friend class ParallelMarker;
+};
+
+class ParallelMarker
+{
+public:
+	// Creates a parallel marker with the specified number of workers, which
+	// must be at least 2, and starts the worker threads.
+	static Box<ParallelMarker> New(GC *gc, uint32_t workerCount);
+
+	// Stops all worker threads.
+	~ParallelMarker();
+
+	inline uint32_t GetWorkerCount() const
+	{
+		return workerCount;
+	}
+
+	// Marks every object reachable from the objects in the GC's mark stack,
+	// using all workers, and then empties the mark stack. Must only be called
+	// during a GC cycle.
+	//   finder:
+	//     The LiveObjectFinder that filled the mark stack. The workers' gen1
+	//     survivor sizes are added to this.
+	void Mark(LiveObjectFinder &finder);
+
+private:
+	GC *gc;
+
+	uint32_t workerCount;
+	Box<MarkWorker[]> workers;
+	// The number of worker threads that have been started. Usually this is
+	// workerCount - 1, but may be fewer if something went wrong in New().
+	uint32_t startedThreads;
+
+	// True if the current cycle is a full cycle.
+	bool fullCycle;
+
+	// The number of workers that have run out of work.
+	std::atomic<uint32_t> idleCount;
+
+	// True when the worker threads should terminate.
+	bool shuttingDown;
+
+	// Entered by each worker thread before it starts marking. The cycle
+	// thread increments it once per worker thread to start the mark phase.
+	Semaphore startSignal;
+	// Incremented by each worker thread when it has finished marking. The
+	// cycle thread waits on it once per worker thread.
+	Semaphore doneSignal;
+
+	ParallelMarker(GC *gc, uint32_t workerCount);
+
+	bool StartThreads();
+
+	// Determines whether the shared stack of any worker contains objects.
+	bool HasSharedWork() const;
+
+	OVUM_DISABLE_COPY_AND_ASSIGN(ParallelMarker);
+
+	friend class MarkWorker;
+};
+
+} // namespace ovum
@@ -0,0 +1,71 @@
+#include "rememberedset.h"
+
+namespace ovum
+{
+
+RememberedSet::RememberedSet() :
+	items(nullptr),
+	count(0),
+	capacity(0),
+	overflowed(false)
+{ }
+
+RememberedSet::~RememberedSet()
+{
+	delete[] items;
+}
+
+void RememberedSet::Add(GCObject *gco)
+{
+	OVUM_ASSERT((gco->flags & GCOFlags::REMEMBERED) == GCOFlags::NONE);
+
+	lock.Enter();
+
+	// Always set the flag, even if we run out of memory; the object will not
+	// be added again until the next full cycle, which clears the flag.
+	gco->flags |= GCOFlags::REMEMBERED;
+	if (EnsureCapacity())
+		items[count++] = gco;
+	else
+		overflowed = true;
+
+	lock.Leave();
+}
+
+void RememberedSet::UpdateMovedObjects()
+{
+	for (size_t i = 0; i < count; i++)
+		if (items[i]->IsMoved())
+			items[i] = items[i]->newAddress;
+}
+
+void RememberedSet::Clear()
+{
+	for (size_t i = 0; i < count; i++)
+		items[i]->flags &= ~GCOFlags::REMEMBERED;
+	count = 0;
+	overflowed = false;
+}
+
+bool RememberedSet::EnsureCapacity()
+{
+	if (count < capacity)
+		return true;
+
+	size_t newCapacity = capacity == 0 ? INITIAL_CAPACITY : 2 * capacity;
+	GCObject **newItems = new(std::nothrow) GCObject*[newCapacity];
+	if (newItems == nullptr)
+		return false;
+
+	if (items)
+	{
+		CopyMemoryT(newItems, items, count);
+		delete[] items;
+	}
+
+	items = newItems;
+	capacity = newCapacity;
+	return true;
+}
+
+} // namespace ovum
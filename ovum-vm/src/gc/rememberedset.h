@@ -0,0 +1,84 @@
+#pragma once
+
+#include "../vm.h"
+#include "gcobject.h"
+#include "../threading/sync.h"
+
+namespace ovum
+{
+
+// The remembered set contains objects outside generation 0 that may contain
+// references to generation 0 objects. During a minor cycle (a cycle in which
+// only gen0 is collected), the GC does not trace the old generation at all;
+// instead, it treats the objects in the remembered set as additional roots.
+//
+// Objects end up in the remembered set in one of three ways:
+//
+// * The write barrier (see GC::WriteBarrier) adds an object when a reference
+//   to a gen0 object is stored in one of its fields.
+// * After a cycle, an object that still refers to a pinned gen0 object stays
+//   in the set, as pinned objects are not promoted.
+// * Objects whose references are written by native code without going through
+//   the write barrier (GC-managed Value arrays, and instances of types with
+//   TypeFlags::HAS_NATIVE_REFS) are always in the set.
+//
+// An object in the remembered set has the flag GCOFlags::REMEMBERED, which is
+// used to ensure each object is added at most once. The set is rebuilt from
+// scratch during every full cycle.
+class RememberedSet
+{
+public:
+	RememberedSet();
+
+	~RememberedSet();
+
+	// Gets the number of objects in the set.
+	inline size_t GetCount() const
+	{
+		return count;
+	}
+
+	// Determines whether an object could not be added to the set, due to lack
+	// of memory. If this happens, the remembered set is incomplete, and the GC
+	// must run a full cycle.
+	inline bool HasOverflowed() const
+	{
+		return overflowed;
+	}
+
+	// Replaces each object in the set that has been moved (that is, has the
+	// flag GCOFlags::MOVED) with its new address.
+	void UpdateMovedObjects();
+
+	// Adds an object to the set, and gives it the flag GCOFlags::REMEMBERED.
+	// The caller must ensure the object does not already have that flag, and
+	// must hold the object's field access lock if other threads could modify
+	// the object's flags.
+	//
+	// This method is thread-safe.
+	void Add(GCObject *gco);
+
+	// Removes all objects from the set, and clears their REMEMBERED flag. This
+	// also resets the overflow flag. Only call this during a GC cycle.
+	void Clear();
+
+private:
+	OVUM_DISABLE_COPY_AND_ASSIGN(RememberedSet);
+
+	static const size_t INITIAL_CAPACITY = 256;
+
+	GCObject **items;
+	size_t count;
+	size_t capacity;
+
+	bool overflowed;
+
+	// Protects the set from concurrent modification by mutator threads.
+	SpinLock lock;
+
+	bool EnsureCapacity();
+
+	friend class LiveObjectFinder;
+};
+
+} // namespace ovum
@@ -1,101 +1,206 @@
 #include "../vm.h"
 #include "../../inc/ovum_string.h"
 #include "stringtable.h"
+#include <cstring>
 
 namespace ovum
 {
 
+String *const StringTable::REMOVED = reinterpret_cast<String*>(1);
+
 StringTable::StringTable(size_t capacity) :
+	table(nullptr),
+	retired(nullptr),
 	count(0),
-	freeCount(0),
-	freeList(LAST),
-	buckets(),
-	entries()
+	removedCount(0)
+{
+	size_t actualCapacity = 16;
+	while (actualCapacity < capacity * 2)
+		actualCapacity *= 2;
+
+	Table *initialTable = NewTable(actualCapacity);
+	if (initialTable == nullptr)
+		throw std::bad_alloc();
+	table.store(initialTable, std::memory_order_relaxed);
+}
+
+StringTable::~StringTable()
+{
+	ReleaseRetiredTables();
+	delete table.load(std::memory_order_relaxed);
+}
+
+StringTable::Table *StringTable::NewTable(size_t capacity)
+{
+	Table *result = new(std::nothrow) Table;
+	if (result == nullptr)
+		return nullptr;
+
+	result->capacity = capacity;
+	result->slots.reset(new(std::nothrow) Slot[capacity]);
+	result->nextRetired = nullptr;
+	if (!result->slots)
+	{
+		delete result;
+		return nullptr;
+	}
+
+	for (size_t i = 0; i < capacity; i++)
+		result->slots[i].store(nullptr, std::memory_order_relaxed);
+
+	return result;
+}
+
+size_t StringTable::GetStartIndex(const Table *table, int32_t hashCode)
 {
-	this->capacity = HashHelper_GetPrime(capacity);
+	return (size_t)(uint32_t)hashCode & (table->capacity - 1);
+}
 
-	this->buckets.reset(new size_t[this->capacity]);
-	memset(this->buckets.get(), -1, this->capacity * sizeof(size_t));
+StringTable::Slot *StringTable::FindSlot(Table *table, String *value, int32_t hashCode)
+{
+	size_t mask = table->capacity - 1;
+	for (size_t i = GetStartIndex(table, hashCode); ; i = (i + 1) & mask)
+	{
+		Slot *slot = table->slots.get() + i;
+		String *entry = slot->load(std::memory_order_acquire);
+		if (entry == nullptr)
+			return nullptr;
+		if (entry != REMOVED &&
+			entry->hashCode == hashCode &&
+			String_Equals(entry, value))
+			return slot;
+	}
+}
+
+String *StringTable::GetInterned(String *value)
+{
+	int32_t hashCode = String_GetHashCode(value);
 
-	this->entries.reset(new Entry[this->capacity]);
-	memset(this->entries.get(), 0, this->capacity * sizeof(Entry));
+	Slot *slot = FindSlot(table.load(std::memory_order_acquire), value, hashCode);
+	return slot != nullptr ? slot->load(std::memory_order_acquire) : nullptr;
 }
 
-String *StringTable::GetValue(String *value, bool add)
+String *StringTable::GetInterned(size_t length, const ovchar_t *chars)
 {
-	int32_t hashCode = String_GetHashCode(value) & INT32_MAX;
+	int32_t hashCode = String_GetHashCodeOfChars(length, chars);
 
-	size_t bucket = hashCode % capacity;
-	for (size_t i = buckets[bucket]; i != LAST; i = entries[i].next)
+	Table *current = table.load(std::memory_order_acquire);
+	size_t mask = current->capacity - 1;
+	for (size_t i = GetStartIndex(current, hashCode); ; i = (i + 1) & mask)
 	{
-		Entry *e = entries.get() + i;
-		if (e->hashCode == hashCode && String_Equals(e->value, value))
-			return e->value;
+		String *entry = current->slots[i].load(std::memory_order_acquire);
+		if (entry == nullptr)
+			return nullptr;
+		if (entry != REMOVED &&
+			entry->hashCode == hashCode &&
+			entry->length == length &&
+			memcmp(&entry->firstChar, chars, length * sizeof(ovchar_t)) == 0)
+			return entry;
 	}
+}
 
-	// The bucket did not contain the specified value.
-	if (add)
+String *StringTable::Intern(String *value)
+{
+	int32_t hashCode = String_GetHashCode(value);
+
+	// Most of the time, the string is already there.
+	String *result = GetInterned(value);
+	if (result != nullptr)
+		return result;
+
+	writeLock.Enter();
+
+	// Keep at least half of the slots empty, so that probe sequences stay
+	// short, and always end.
+	if ((count + removedCount + 1) * 2 > table.load(std::memory_order_relaxed)->capacity &&
+		!Resize())
+		// Not enough memory to grow the table; cannot recover from this.
+		abort();
+
+	// Look again, now that no one else can add the string, and find the
+	// first free slot along the way.
+	Table *current = table.load(std::memory_order_relaxed);
+	size_t mask = current->capacity - 1;
+	Slot *freeSlot = nullptr;
+	for (size_t i = GetStartIndex(current, hashCode); ; i = (i + 1) & mask)
 	{
-		size_t index;
-		if (freeCount > 0)
+		Slot *slot = current->slots.get() + i;
+		String *entry = slot->load(std::memory_order_relaxed);
+		if (entry == nullptr)
 		{
-			index = freeList;
-			freeList = entries[freeList].next;
-			freeCount--;
+			if (freeSlot == nullptr)
+				freeSlot = slot;
+			break;
 		}
-		else
+		if (entry == REMOVED)
 		{
-			if (count == capacity)
-			{
-				Resize();
-				bucket = hashCode % capacity;
-			}
-			index = count++;
+			if (freeSlot == nullptr)
+				freeSlot = slot;
 		}
+		else if (entry->hashCode == hashCode && String_Equals(entry, value))
+		{
+			result = entry;
+			break;
+		}
+	}
+
+	if (result == nullptr)
+	{
+		if (freeSlot->load(std::memory_order_relaxed) == REMOVED)
+			removedCount--;
+		count++;
 
-		Entry *e = entries.get() + index;
-		e->next = buckets[bucket];
-		e->hashCode = hashCode;
-		e->value = value;
-		buckets[bucket] = index;
 		value->flags |= StringFlags::INTERN;
-		return value; // We just interned it! yay!
+		// Publish the string only once its flags are up to date.
+		freeSlot->store(value, std::memory_order_release);
+		result = value; // We just interned it! yay!
 	}
 
-	return nullptr;
+	writeLock.Leave();
+	return result;
 }
 
-void StringTable::Resize()
+bool StringTable::Resize()
 {
-	size_t newSize = HashHelper_GetPrime(capacity * 2);
+	Table *oldTable = table.load(std::memory_order_relaxed);
 
-	Box<size_t[]> newBuckets(new size_t[newSize]);
-	memset(newBuckets.get(), -1, newSize * sizeof(size_t));
+	size_t newCapacity = oldTable->capacity;
+	if (count * 4 >= newCapacity)
+		newCapacity *= 2;
 
-	Box<Entry[]> newEntries(new Entry[newSize]);
-	CopyMemoryT(newEntries.get(), entries.get(), count);
+	Table *newTable = NewTable(newCapacity);
+	if (newTable == nullptr)
+		return false;
 
-	Entry *e = newEntries.get();
-	for (size_t i = 0; i < count; i++, e++)
+	size_t mask = newCapacity - 1;
+	for (size_t i = 0; i < oldTable->capacity; i++)
 	{
-		size_t bucket = e->hashCode % newSize;
-		e->next = newBuckets[bucket];
-		newBuckets[bucket] = i;
+		String *entry = oldTable->slots[i].load(std::memory_order_relaxed);
+		if (entry == nullptr || entry == REMOVED)
+			continue;
+
+		size_t j = GetStartIndex(newTable, entry->hashCode);
+		while (newTable->slots[j].load(std::memory_order_relaxed) != nullptr)
+			j = (j + 1) & mask;
+		newTable->slots[j].store(entry, std::memory_order_relaxed);
 	}
 
-	capacity = newSize;
-	this->buckets = std::move(newBuckets);
-	this->entries = std::move(newEntries);
-}
+	removedCount = 0;
+	table.store(newTable, std::memory_order_release);
 
-String *StringTable::GetInterned(String *value)
-{
-	return GetValue(value, false);
+	oldTable->nextRetired = retired;
+	retired = oldTable;
+	return true;
 }
 
-String *StringTable::Intern(String *value)
+void StringTable::ReleaseRetiredTables()
 {
-	return GetValue(value, true);
+	while (retired)
+	{
+		Table *next = retired->nextRetired;
+		delete retired;
+		retired = next;
+	}
 }
 
 bool StringTable::RemoveIntern(String *value)
@@ -106,30 +211,26 @@ bool StringTable::RemoveIntern(String *value)
 	// without hashing it, but let's check it anyway.
 	OVUM_ASSERT((value->flags & StringFlags::HASHED) == StringFlags::HASHED);
 
-	size_t bucket = (value->hashCode & INT32_MAX) % capacity;
-	Entry *lastEntry = nullptr;
-	for (size_t i = buckets[bucket]; i != LAST; i = lastEntry->next)
+	Table *current = table.load(std::memory_order_relaxed);
+	size_t mask = current->capacity - 1;
+	for (size_t i = GetStartIndex(current, value->hashCode); ; i = (i + 1) & mask)
 	{
-		Entry *e = entries.get() + i;
-		if (e->value == value) // Compare pointers for great speed
+		Slot *slot = current->slots.get() + i;
+		String *entry = slot->load(std::memory_order_relaxed);
+		if (entry == nullptr)
+			break;
+		if (entry == value) // Compare pointers for great speed
 		{
-			// We found it!
-			if (lastEntry == nullptr)
-				buckets[bucket] = e->next;
-			else
-				lastEntry->next = e->next;
-
-			e->hashCode = -1;
-			e->next = freeList;
-			e->value = nullptr;
-			freeList = i;
-			freeCount++;
+			// We found it! The slot cannot be emptied, as that would cut
+			// off the probe sequences of any strings after it.
+			slot->store(REMOVED, std::memory_order_relaxed);
+			count--;
+			removedCount++;
 			// Do we need this? This method isn't supposed to be called
 			// outside of the GC's collection cycle.
 			value->flags &= ~StringFlags::INTERN;
 			return true;
 		}
-		lastEntry = e;
 	}
 
 	return false;
@@ -142,17 +243,11 @@ void StringTable::UpdateIntern(String *value)
 	// It should also not be possible to have a non-hashed intern.
 	OVUM_ASSERT((value->flags & StringFlags::HASHED) == StringFlags::HASHED);
 
-	int32_t hashCode = value->hashCode & INT32_MAX;
-	Entry *entry;
-	for (size_t i = buckets[hashCode % capacity]; i != LAST; i = entry->next)
-	{
-		entry = entries.get() + i;
-		if (entry->hashCode == hashCode && String_Equals(value, entry->value))
-		{
-			entry->value = value;
-			break;
-		}
-	}
+	// The slot still refers to the old copy of the string, which the GC
+	// has not yet released, so it can be compared against.
+	Slot *slot = FindSlot(table.load(std::memory_order_relaxed), value, value->hashCode);
+	if (slot != nullptr)
+		slot->store(value, std::memory_order_relaxed);
 }
 
 } // namespace ovum
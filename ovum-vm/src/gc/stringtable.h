@@ -1,6 +1,8 @@
 #pragma once
 
 #include "../vm.h"
+#include "../threading/sync.h"
+#include <atomic>
 
 namespace ovum
 {
@@ -10,13 +12,45 @@ namespace ovum
 // This is used by the GC when strings are constructed during module
 // loading, to avoid the allocation of multiple identical strings.
 // Strings can also be explicitly interned.
+//
+// Lookups do not take any lock, so that interning (which happens a lot
+// during module loading) does not contend with allocation. The table is
+// an open-addressed hash set with linear probing, and every slot is an
+// atomic pointer. Slots only ever change from empty to a string, from a
+// string to REMOVED, from REMOVED to a string (Intern() reuses removed
+// slots), or (during a GC cycle) from a string to the moved copy of the
+// same string. Insertions are serialized by a spinlock.
+//
+// Lock-free readers remain safe under all of these transitions. Strings
+// are stored with release semantics, so a reader that sees a string sees
+// it fully initialized. A slot never becomes empty again, so a probe
+// sequence that a reader is following is never cut short; readers skip
+// REMOVED slots and keep probing. If a removed slot is reused while a
+// reader is probing past it, the reader either sees REMOVED and moves on,
+// or sees the new string, which it compares like any other; either way,
+// the result is the same as if the lookup had happened just before or
+// just after the insertion.
+//
+// When the table grows, the entries are copied to a new table, which is
+// then published. Readers may still be probing the old table, so it is
+// kept around until the next GC cycle, when no managed code is running,
+// and can be freed by ReleaseRetiredTables().
+//
+// RemoveIntern() and UpdateIntern() are only called by the GC during a
+// cycle, and never run concurrently with other methods.
 class StringTable
 {
 public:
 	StringTable(size_t capacity);
 
+	~StringTable();
+
 	String *GetInterned(String *value);
 
+	// Finds an interned string with the specified characters, without having
+	// to construct a String first. Returns null if there is no such string.
+	String *GetInterned(size_t length, const ovchar_t *chars);
+
 	inline bool HasInterned(String *value)
 	{
 		return GetInterned(value) != nullptr;
@@ -28,36 +62,54 @@ public:
 
 	void UpdateIntern(String *value);
 
+	// Frees tables that have been replaced by larger ones. Must only be
+	// called during a GC cycle.
+	void ReleaseRetiredTables();
+
 private:
-	static const size_t LAST = (size_t)-1;
+	typedef std::atomic<String*> Slot;
 
-	struct Entry
+	struct Table
 	{
-		// Index of the next entry in the bucket. If there is no next
-		// entry, the value is LAST.
-		size_t next;
-		// The lower 31 bits of the hash code.
-		int32_t hashCode;
-		// The actual string!
-		String *value;
+		// The number of slots. Always a power of two.
+		size_t capacity;
+		// The slots. Each is null (empty), REMOVED, or an interned string.
+		Box<Slot[]> slots;
+		// The next table in the retired list.
+		Table *nextRetired;
 	};
 
-	// Size of buckets and entries.
-	size_t capacity;
-	// Total number of entries used.
+	// Marks a slot whose string has been removed. Probing continues past
+	// removed slots, but they can be reused by Intern().
+	static String *const REMOVED;
+
+	// The current table. Readers load this once per lookup.
+	std::atomic<Table*> table;
+	// Tables that have been replaced, but which readers may still be using.
+	Table *retired;
+
+	// The number of slots that contain a string, and the number of REMOVED
+	// slots. Only accessed under writeLock, or during a GC cycle.
 	size_t count;
-	// Total number of entries that were freed after being used.
-	size_t freeCount;
-	// Index of first freed entry.
-	size_t freeList;
-	// Indexes into entries.
-	Box<size_t[]> buckets;
-	// The actual entries.
-	Box<Entry[]> entries;
-
-	String *GetValue(String *value, bool add);
-
-	void Resize();
+	size_t removedCount;
+
+	// Serializes Intern() calls.
+	SpinLock writeLock;
+
+	static Table *NewTable(size_t capacity);
+
+	static size_t GetStartIndex(const Table *table, int32_t hashCode);
+
+	// Finds the slot that contains a string equal to the specified value,
+	// or null if there is no such string.
+	static Slot *FindSlot(Table *table, String *value, int32_t hashCode);
+
+	// Copies every live entry to a new table, which becomes the current table.
+	// The new table has twice the capacity, unless most of the old entries
+	// have been removed. Must be called inside writeLock.
+	bool Resize();
+
+	OVUM_DISABLE_COPY_AND_ASSIGN(StringTable);
 
 	friend class GC;
 };
@@ -0,0 +1,115 @@
+#include "jit.h"
+#include "jitcompiler.h"
+#include "../config/defaults.h"
+
+namespace ovum
+{
+
+Box<Jit> Jit::New(VM *owner, uint32_t threshold)
+{
+	Box<Jit> result(new(std::nothrow) Jit(owner, threshold));
+	return std::move(result);
+}
+
+Jit::Jit(VM *owner, uint32_t threshold) :
+	vm(owner),
+	threshold(threshold),
+	compileSection(1000),
+	code(),
+	chunks(),
+	chunkCurrent(nullptr),
+	chunkEnd(nullptr),
+	compiledCount(0),
+	failedCount(0),
+	codeSize(0)
+{ }
+
+Jit::~Jit()
+{
+	// Method overloads still refer to their JitCode, but they are never run
+	// again once the VM is shutting down.
+	for (size_t i = 0; i < chunks.size(); i++)
+		os::VirtualFree(chunks[i]);
+}
+
+void Jit::Compile(MethodOverload *method)
+{
+	compileSection.Enter();
+
+	// Another thread may have got here first.
+	if (method->jitCode.load(std::memory_order_relaxed) == nullptr)
+	{
+		JitCode *result = nullptr;
+		try
+		{
+			JitCompiler compiler(vm, method);
+			if (compiler.Compile())
+			{
+				size_t size = compiler.GetCodeSize();
+				size_t allocSize = OVUM_ALIGN_TO(size, os::GetPageSize());
+
+				uint8_t *memory = AllocCode(allocSize);
+				if (memory != nullptr)
+				{
+					compiler.CopyTo(memory);
+					if (os::VirtualProtect(memory, allocSize, os::VPROT_READ_EXEC))
+					{
+						Box<JitCode> jitCode(new JitCode());
+						jitCode->entryPoint = reinterpret_cast<JitCode::EntryPoint>(memory);
+						jitCode->size = size;
+						jitCode->method = method;
+
+						code.push_back(std::move(jitCode));
+						result = code.back().get();
+						codeSize += size;
+					}
+				}
+			}
+		}
+		catch (std::bad_alloc&)
+		{
+			// Not enough memory to compile the method; keep interpreting it.
+		}
+
+		if (result != nullptr)
+		{
+			compiledCount++;
+			// Thread::Evaluate() reads jitCode without taking the lock, so the
+			// code must be complete before anyone sees it.
+			method->jitCode.store(result, std::memory_order_release);
+		}
+		else
+		{
+			failedCount++;
+		}
+	}
+
+	compileSection.Leave();
+}
+
+uint8_t *Jit::AllocCode(size_t size)
+{
+	if (size > (size_t)(chunkEnd - chunkCurrent))
+	{
+		// Whatever is left of the current chunk is wasted. Methods rarely need
+		// more than a page or two, so this is not much.
+		size_t chunkSize = config::Defaults::JIT_CODE_CHUNK_SIZE;
+		if (size > chunkSize)
+			chunkSize = OVUM_ALIGN_TO(size, chunkSize);
+
+		chunks.reserve(chunks.size() + 1);
+		void *chunk = os::VirtualAlloc(nullptr, chunkSize, os::VPROT_READ_WRITE);
+		if (chunk == nullptr)
+			return nullptr;
+		chunks.push_back(chunk);
+
+		chunkCurrent = static_cast<uint8_t*>(chunk);
+		chunkEnd = chunkCurrent + chunkSize;
+	}
+
+	uint8_t *result = chunkCurrent;
+	chunkCurrent += size;
+	return result;
+}
+
+} // namespace ovum
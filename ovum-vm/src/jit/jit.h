@@ -0,0 +1,131 @@
+#pragma once
+
+#include "../vm.h"
+#include "../object/method.h"
+#include "../threading/sync.h"
+#include <vector>
+
+// The JIT compiler generates x86-64 code, for the Windows x64 calling
+// convention when OVUM_WINDOWS is set and the System V one otherwise. On other
+// targets, VM_Start rejects VMStartParams::jit.
+#if defined(_M_X64) || defined(__x86_64__)
+# define OVUM_JIT_SUPPORTED 1
+#else
+# define OVUM_JIT_SUPPORTED 0
+#endif
+
+namespace ovum
+{
+
+// The native code generated for a method overload by JitCompiler.
+class JitCode
+{
+public:
+	// Runs the method in the specified stack frame, starting at the instruction
+	// at ip, until it returns to the interpreter.
+	//   thread:
+	//     The current thread.
+	//   frame:
+	//     The current stack frame, which belongs to the method.
+	//   ip:
+	//     The address of the instruction to start at.
+	// Returns:
+	//   OVUM_SUCCESS if Thread::Evaluate() should continue at thread->ip, in
+	//   the thread's current stack frame; otherwise, an error code, with
+	//   thread->ip at the instruction that failed.
+	typedef int (*EntryPoint)(Thread *thread, StackFrame *frame, uint8_t *ip);
+
+	EntryPoint entryPoint;
+	// The size of the generated code, in bytes.
+	size_t size;
+	// The method overload that the code belongs to.
+	MethodOverload *method;
+};
+
+// Decides which methods to compile, and owns the compiled code.
+//
+// Each bytecode method overload counts its calls. When the count reaches the
+// threshold, the overload is compiled, and Thread::Evaluate() runs the compiled
+// code instead of interpreting it from then on. The count stops at the
+// threshold, so an overload that cannot be compiled is only attempted once.
+//
+// Code is never freed before the VM shuts down.
+class Jit
+{
+public:
+	// Creates a JIT compiler for the specified VM.
+	//   owner:
+	//     The VM that the compiler belongs to.
+	//   threshold:
+	//     The number of calls after which a method overload is compiled.
+	OVUM_NOINLINE static Box<Jit> New(VM *owner, uint32_t threshold);
+
+	~Jit();
+
+	// Records a call to a bytecode method overload, and compiles it if it has
+	// reached the threshold. Must be called after the method is initialized.
+	inline void MethodCalled(MethodOverload *method)
+	{
+		// The count does not need to be exact, so races between threads are
+		// harmless. Compile() copes with being called twice for a method.
+		uint32_t count = method->callCount.load(std::memory_order_relaxed);
+		if (count < threshold)
+		{
+			count++;
+			method->callCount.store(count, std::memory_order_relaxed);
+			if (count == threshold)
+				Compile(method);
+		}
+	}
+
+	// Gets the number of method overloads that have been compiled.
+	inline uint32_t GetCompiledCount() const
+	{
+		return compiledCount;
+	}
+
+	// Gets the number of method overloads that reached the threshold, but could
+	// not be compiled.
+	inline uint32_t GetFailedCount() const
+	{
+		return failedCount;
+	}
+
+	// Gets the total size of the generated code, in bytes.
+	inline size_t GetCodeSize() const
+	{
+		return codeSize;
+	}
+
+private:
+	VM *vm;
+
+	uint32_t threshold;
+
+	// Taken while compiling. Methods are only compiled once each, so this is
+	// rarely contended.
+	CriticalSection compileSection;
+
+	std::vector<Box<JitCode>> code;
+
+	// Executable memory is allocated in chunks, and each method's code gets
+	// its own whole pages within a chunk. The pages are writable while the
+	// code is copied into them, and then become read-only and executable.
+	std::vector<void*> chunks;
+	uint8_t *chunkCurrent;
+	uint8_t *chunkEnd;
+
+	uint32_t compiledCount;
+	uint32_t failedCount;
+	size_t codeSize;
+
+	Jit(VM *owner, uint32_t threshold);
+
+	OVUM_NOINLINE void Compile(MethodOverload *method);
+
+	// Allocates writable pages for code of the specified size, which must be
+	// a multiple of the page size. Returns null if there is not enough memory.
+	uint8_t *AllocCode(size_t size);
+};
+
+} // namespace ovum
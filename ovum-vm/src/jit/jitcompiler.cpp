@@ -0,0 +1,844 @@
+#include "jitcompiler.h"
+#include "../ee/stackframe.h"
+#include "../ee/vm.h"
+#include "../object/method.h"
+
+namespace ovum
+{
+
+namespace oa = ovum::opcode_args;
+
+typedef X64Assembler A;
+
+// Offsets of the fields of a Value, relative to the Value.
+static const int32_t TYPE_OFFSET = (int32_t)offsetof(Value, type);
+static const int32_t VALUE_OFFSET = (int32_t)offsetof(Value, v);
+
+// Instructions that take two operands from the stack read them from two
+// consecutive Values, the first of which is at the instruction's local.
+static const int32_t SECOND_OPERAND = (int32_t)sizeof(Value);
+
+JitCompiler::JitCompiler(VM *vm, MethodOverload *method) :
+	vm(vm),
+	method(method),
+	a()
+{ }
+
+bool JitCompiler::Compile()
+{
+	OVUM_ASSERT(method->IsInitialized() && !method->IsNative());
+
+	if (!FindInstructions())
+		return false;
+
+	trap = a.NewLabel();
+	exit = a.NewLabel();
+	entryTable = a.NewLabel();
+
+	EmitPrologue();
+
+	const size_t slotCount = method->length / oa::ALIGNMENT;
+	for (size_t slot = 0; slot < slotCount; slot++)
+	{
+		if (!instrStarts[slot])
+			continue;
+
+		uint8_t *ip = method->entry + slot * oa::ALIGNMENT;
+		a.Bind(instrLabels[slot]);
+		if (!EmitInstruction(ip, GetInstructionSize(ip)))
+			return false;
+	}
+
+	// Valid bytecode never runs off the end of the method, but a conditional
+	// branch at the very end has a fall-through label all the same.
+	a.Bind(instrLabels[slotCount]);
+	a.Bind(trap);
+	a.Ud2();
+
+	EmitExit();
+	EmitTables();
+	return true;
+}
+
+void JitCompiler::CopyTo(uint8_t *dest) const
+{
+	a.CopyTo(dest);
+}
+
+size_t JitCompiler::GetInstructionSize(const uint8_t *ip)
+{
+	size_t argsSize;
+	switch (static_cast<IntermediateOpcode>(*ip))
+	{
+	case OPI_RET:
+	case OPI_RETNULL:
+	case OPI_NOP:
+	case OPI_POP:
+	case OPI_THROW:
+	case OPI_RETHROW:
+	case OPI_ENDFINALLY:
+		argsSize = 0;
+		break;
+
+	case OPI_MVLOC_LL:
+	case OPI_MVLOC_SL:
+	case OPI_MVLOC_LS:
+	case OPI_MVLOC_SS:
+	case OPI_LDITER_L:
+	case OPI_LDITER_S:
+	case OPI_LDTYPE_L:
+	case OPI_LDTYPE_S:
+	case OPI_APPLY_L:
+	case OPI_APPLY_S:
+	case OPI_EQ_L:
+	case OPI_EQ_S:
+	case OPI_CMP_L:
+	case OPI_CMP_S:
+	case OPI_LT_L:
+	case OPI_LT_S:
+	case OPI_GT_L:
+	case OPI_GT_S:
+	case OPI_LTE_L:
+	case OPI_LTE_S:
+	case OPI_GTE_L:
+	case OPI_GTE_S:
+	case OPI_CONCAT_L:
+	case OPI_CONCAT_S:
+		argsSize = oa::TWO_LOCALS_SIZE;
+		break;
+
+	case OPI_LDNULL_L:
+	case OPI_LDNULL_S:
+	case OPI_LDFALSE_L:
+	case OPI_LDFALSE_S:
+	case OPI_LDTRUE_L:
+	case OPI_LDTRUE_S:
+	case OPI_LDARGC_L:
+	case OPI_LDARGC_S:
+		argsSize = oa::ONE_LOCAL_SIZE;
+		break;
+
+	case OPI_LDC_I_L:
+	case OPI_LDC_I_S:
+		argsSize = oa::LOCAL_AND_VALUE<int64_t>::SIZE;
+		break;
+	case OPI_LDC_U_L:
+	case OPI_LDC_U_S:
+		argsSize = oa::LOCAL_AND_VALUE<uint64_t>::SIZE;
+		break;
+	case OPI_LDC_R_L:
+	case OPI_LDC_R_S:
+		argsSize = oa::LOCAL_AND_VALUE<double>::SIZE;
+		break;
+	case OPI_LDSTR_L:
+	case OPI_LDSTR_S:
+		argsSize = oa::LOCAL_AND_VALUE<String*>::SIZE;
+		break;
+	case OPI_LDENUM_L:
+	case OPI_LDENUM_S:
+		argsSize = oa::LOAD_ENUM_SIZE;
+		break;
+
+	case OPI_NEWOBJ_L:
+	case OPI_NEWOBJ_S:
+		argsSize = oa::NEW_OBJECT_SIZE;
+		break;
+	case OPI_LIST_L:
+	case OPI_LIST_S:
+	case OPI_HASH_L:
+	case OPI_HASH_S:
+		argsSize = oa::LOCAL_AND_VALUE<size_t>::SIZE;
+		break;
+
+	case OPI_LDFLD_L:
+	case OPI_LDFLD_S:
+	case OPI_LDFLDFAST_L:
+	case OPI_LDFLDFAST_S:
+	case OPI_LDLOCFLD_L:
+	case OPI_LDLOCFLD_S:
+		argsSize = oa::TWO_LOCALS_AND_VALUE<Field*>::SIZE;
+		break;
+	case OPI_LDSFLD_L:
+	case OPI_LDSFLD_S:
+	case OPI_STSFLD_L:
+	case OPI_STSFLD_S:
+	case OPI_STFLD:
+	case OPI_STFLDFAST:
+		argsSize = oa::LOCAL_AND_VALUE<Field*>::SIZE;
+		break;
+	case OPI_LDMEM_L:
+	case OPI_LDMEM_S:
+		argsSize = oa::LOAD_MEMBER_SIZE;
+		break;
+	case OPI_LDIDX_L:
+	case OPI_LDIDX_S:
+		argsSize = oa::TWO_LOCALS_AND_VALUE<ovlocals_t>::SIZE;
+		break;
+	case OPI_LDSFN_L:
+	case OPI_LDSFN_S:
+		argsSize = oa::LOCAL_AND_VALUE<Method*>::SIZE;
+		break;
+	case OPI_LDTYPETKN_L:
+	case OPI_LDTYPETKN_S:
+		argsSize = oa::LOCAL_AND_VALUE<Type*>::SIZE;
+		break;
+
+	case OPI_CALL_L:
+	case OPI_CALL_S:
+		argsSize = oa::CALL_SIZE;
+		break;
+	case OPI_CALLR_L:
+	case OPI_CALLR_S:
+		argsSize = oa::CALL_REF_SIZE;
+		break;
+	case OPI_SCALL_L:
+	case OPI_SCALL_S:
+		argsSize = oa::STATIC_CALL_SIZE;
+		break;
+	case OPI_CALLMEM_L:
+	case OPI_CALLMEM_S:
+		argsSize = oa::CALL_MEMBER_SIZE;
+		break;
+	case OPI_CALLMEMR_L:
+	case OPI_CALLMEMR_S:
+		argsSize = oa::CALL_MEMBER_REF_SIZE;
+		break;
+	case OPI_SAPPLY_L:
+	case OPI_SAPPLY_S:
+		argsSize = oa::TWO_LOCALS_AND_VALUE<Method*>::SIZE;
+		break;
+
+	case OPI_BR:
+	case OPI_LEAVE:
+		argsSize = oa::BRANCH_SIZE;
+		break;
+	case OPI_BRNULL_L:
+	case OPI_BRNULL_S:
+	case OPI_BRINST_L:
+	case OPI_BRINST_S:
+	case OPI_BRFALSE_L:
+	case OPI_BRFALSE_S:
+	case OPI_BRTRUE_L:
+	case OPI_BRTRUE_S:
+	case OPI_BRREF:
+	case OPI_BRNREF:
+	case OPI_BREQ:
+	case OPI_BRNEQ:
+	case OPI_BRLT:
+	case OPI_BRGT:
+	case OPI_BRLTE:
+	case OPI_BRGTE:
+		argsSize = oa::CONDITIONAL_BRANCH_SIZE;
+		break;
+	case OPI_BRTYPE_L:
+	case OPI_BRTYPE_S:
+		argsSize = oa::BRANCH_IF_TYPE_SIZE;
+		break;
+	case OPI_SWITCH_L:
+	case OPI_SWITCH_S:
+		{
+			const oa::Switch *args = reinterpret_cast<const oa::Switch*>(ip + JitHelpers::OPCODE_SIZE);
+			argsSize = oa::SWITCH_SIZE(args->count);
+		}
+		break;
+
+	case OPI_OPERATOR_L:
+	case OPI_OPERATOR_S:
+	case OPI_UNARYOP_L:
+	case OPI_UNARYOP_S:
+		argsSize = oa::TWO_LOCALS_AND_VALUE<Operator>::SIZE;
+		break;
+	case OPI_OPERSC_L:
+	case OPI_OPERSC_S:
+	case OPI_OPERLC_L:
+	case OPI_OPERLC_S:
+		argsSize = oa::OPERATOR_CONSTANT_SIZE;
+		break;
+
+	case OPI_STMEM:
+		argsSize = oa::STORE_MEMBER_SIZE;
+		break;
+	case OPI_STIDX:
+		argsSize = oa::LOCAL_AND_VALUE<ovlocals_t>::SIZE;
+		break;
+
+	default:
+		// Instructions that produce or consume references (ldlocref, ldmemref,
+		// ldfldref, ldsfldref and mvloc_r*) are not supported. They are rare
+		// enough that such methods are simply left to the interpreter.
+		return 0;
+	}
+
+	return JitHelpers::OPCODE_SIZE + argsSize;
+}
+
+bool JitCompiler::FindInstructions()
+{
+	OVUM_ASSERT(method->length % oa::ALIGNMENT == 0);
+
+	const size_t slotCount = method->length / oa::ALIGNMENT;
+	instrStarts.resize(slotCount + 1, false);
+	instrLabels.reserve(slotCount + 1);
+	for (size_t slot = 0; slot <= slotCount; slot++)
+		instrLabels.push_back(a.NewLabel());
+
+	size_t offset = 0;
+	while (offset < method->length)
+	{
+		size_t size = GetInstructionSize(method->entry + offset);
+		if (size == 0 || size > method->length - offset)
+			return false;
+
+		instrStarts[offset / oa::ALIGNMENT] = true;
+		offset += size;
+	}
+
+	// The end of the method counts as an instruction start, for the purposes
+	// of GetTargetLabel(); see Compile().
+	instrStarts[slotCount] = true;
+	return true;
+}
+
+bool JitCompiler::GetTargetLabel(size_t offset, Label &label) const
+{
+	if (offset > method->length || offset % oa::ALIGNMENT != 0)
+		return false;
+
+	size_t slot = offset / oa::ALIGNMENT;
+	if (!instrStarts[slot])
+		return false;
+
+	label = instrLabels[slot];
+	return true;
+}
+
+bool JitCompiler::EmitInstruction(uint8_t *ip, size_t size)
+{
+	const IntermediateOpcode opc = static_cast<IntermediateOpcode>(*ip);
+	const uint8_t *argsPtr = ip + JitHelpers::OPCODE_SIZE;
+	const size_t offset = (size_t)(ip - method->entry);
+
+	switch (opc)
+	{
+	case OPI_NOP:
+		break;
+
+	case OPI_POP:
+		EmitStackChange(-1);
+		break;
+
+	case OPI_MVLOC_LL:
+	case OPI_MVLOC_SL:
+	case OPI_MVLOC_LS:
+	case OPI_MVLOC_SS:
+		{
+			const oa::TwoLocals *args = reinterpret_cast<const oa::TwoLocals*>(argsPtr);
+			EmitMove(args->dest.GetOffset(), args->source.GetOffset());
+			if (opc == OPI_MVLOC_SL)
+				EmitStackChange(-1);
+			else if (opc == OPI_MVLOC_LS)
+				EmitStackChange(1);
+		}
+		break;
+
+	case OPI_LDNULL_L:
+	case OPI_LDNULL_S:
+		{
+			const oa::OneLocal *args = reinterpret_cast<const oa::OneLocal*>(argsPtr);
+			a.MovMemImm(FRAME, args->local.GetOffset() + TYPE_OFFSET, 0);
+			if (opc == OPI_LDNULL_S)
+				EmitStackChange(1);
+		}
+		break;
+
+	case OPI_LDFALSE_L:
+	case OPI_LDFALSE_S:
+	case OPI_LDTRUE_L:
+	case OPI_LDTRUE_S:
+		{
+			const oa::OneLocal *args = reinterpret_cast<const oa::OneLocal*>(argsPtr);
+			bool value = opc == OPI_LDTRUE_L || opc == OPI_LDTRUE_S;
+			EmitLoadConstant(args->local.GetOffset(), vm->types.Boolean, value);
+			if (opc == OPI_LDFALSE_S || opc == OPI_LDTRUE_S)
+				EmitStackChange(1);
+		}
+		break;
+
+	case OPI_LDC_I_L:
+	case OPI_LDC_I_S:
+		{
+			const oa::LocalAndValue<int64_t> *args = reinterpret_cast<const oa::LocalAndValue<int64_t>*>(argsPtr);
+			EmitLoadConstant(args->local.GetOffset(), vm->types.Int, (uint64_t)args->value);
+			if (opc == OPI_LDC_I_S)
+				EmitStackChange(1);
+		}
+		break;
+	case OPI_LDC_U_L:
+	case OPI_LDC_U_S:
+		{
+			const oa::LocalAndValue<uint64_t> *args = reinterpret_cast<const oa::LocalAndValue<uint64_t>*>(argsPtr);
+			EmitLoadConstant(args->local.GetOffset(), vm->types.UInt, args->value);
+			if (opc == OPI_LDC_U_S)
+				EmitStackChange(1);
+		}
+		break;
+	case OPI_LDC_R_L:
+	case OPI_LDC_R_S:
+		{
+			const oa::LocalAndValue<double> *args = reinterpret_cast<const oa::LocalAndValue<double>*>(argsPtr);
+			uint64_t bits;
+			memcpy(&bits, &args->value, sizeof(uint64_t));
+			EmitLoadConstant(args->local.GetOffset(), vm->types.Real, bits);
+			if (opc == OPI_LDC_R_S)
+				EmitStackChange(1);
+		}
+		break;
+
+	case OPI_LDSTR_L:
+	case OPI_LDSTR_S:
+		{
+			// The String* is read from the instruction rather than embedded in
+			// the code, so that it always agrees with what the interpreter uses.
+			const oa::LocalAndValue<String*> *args = reinterpret_cast<const oa::LocalAndValue<String*>*>(argsPtr);
+			const int32_t dest = args->local.GetOffset();
+			a.MovRegImm(A::RAX, (uint64_t)(uintptr_t)&args->value);
+			a.MovRegMem(A::RAX, A::RAX, 0);
+			a.MovMemReg(FRAME, dest + VALUE_OFFSET, A::RAX);
+			a.MovRegImm(A::RAX, (uint64_t)(uintptr_t)vm->types.String);
+			a.MovMemReg(FRAME, dest + TYPE_OFFSET, A::RAX);
+			if (opc == OPI_LDSTR_S)
+				EmitStackChange(1);
+		}
+		break;
+
+	case OPI_LDARGC_L:
+	case OPI_LDARGC_S:
+		{
+			const oa::OneLocal *args = reinterpret_cast<const oa::OneLocal*>(argsPtr);
+			const int32_t dest = args->local.GetOffset();
+			a.MovReg32Mem(A::RAX, FRAME, (int32_t)offsetof(StackFrame, argc));
+			a.MovMemReg(FRAME, dest + VALUE_OFFSET, A::RAX);
+			a.MovRegImm(A::RAX, (uint64_t)(uintptr_t)vm->types.Int);
+			a.MovMemReg(FRAME, dest + TYPE_OFFSET, A::RAX);
+			if (opc == OPI_LDARGC_S)
+				EmitStackChange(1);
+		}
+		break;
+
+	case OPI_LDENUM_L:
+	case OPI_LDENUM_S:
+		{
+			const oa::LoadEnum *args = reinterpret_cast<const oa::LoadEnum*>(argsPtr);
+			EmitLoadConstant(args->dest.GetOffset(), args->type, (uint64_t)args->value);
+			if (opc == OPI_LDENUM_S)
+				EmitStackChange(1);
+		}
+		break;
+
+	case OPI_BR:
+	case OPI_LEAVE:
+		{
+			const oa::Branch *args = reinterpret_cast<const oa::Branch*>(argsPtr);
+			Label target;
+			if (!GetTargetLabel(offset + size + args->offset, target))
+				return false;
+			if (opc == OPI_LEAVE)
+				EmitHelperCall(JitHelpers::GetHelper(opc), ip);
+			a.Jmp(target);
+		}
+		break;
+
+	case OPI_BRNULL_L:
+	case OPI_BRNULL_S:
+	case OPI_BRINST_L:
+	case OPI_BRINST_S:
+		{
+			const oa::ConditionalBranch *args = reinterpret_cast<const oa::ConditionalBranch*>(argsPtr);
+			Label target;
+			if (!GetTargetLabel(offset + size + args->offset, target))
+				return false;
+			// The stack change must come before the comparison, as it
+			// overwrites the flags.
+			if (opc == OPI_BRNULL_S || opc == OPI_BRINST_S)
+				EmitStackChange(-1);
+			a.CmpMemImm(FRAME, args->value.GetOffset() + TYPE_OFFSET, 0);
+			bool branchIfNull = opc == OPI_BRNULL_L || opc == OPI_BRNULL_S;
+			a.Jcc(branchIfNull ? A::CC_E : A::CC_NE, target);
+		}
+		break;
+
+	case OPI_BRFALSE_L:
+		return EmitTruthBranch(ip, size, false, 0);
+	case OPI_BRFALSE_S:
+		return EmitTruthBranch(ip, size, false, -1);
+	case OPI_BRTRUE_L:
+		return EmitTruthBranch(ip, size, true, 0);
+	case OPI_BRTRUE_S:
+		return EmitTruthBranch(ip, size, true, -1);
+
+	case OPI_BRTYPE_L:
+	case OPI_BRTYPE_S:
+		{
+			const oa::BranchIfType *args = reinterpret_cast<const oa::BranchIfType*>(argsPtr);
+			Label target;
+			if (!GetTargetLabel(offset + size + args->offset, target))
+				return false;
+			EmitBranchHelperCall(JitHelpers::GetHelper(opc), ip, target);
+		}
+		break;
+
+	case OPI_BRREF:
+	case OPI_BRNREF:
+		{
+			const oa::ConditionalBranch *args = reinterpret_cast<const oa::ConditionalBranch*>(argsPtr);
+			Label target;
+			if (!GetTargetLabel(offset + size + args->offset, target))
+				return false;
+			EmitBranchHelperCall(JitHelpers::GetHelper(opc), ip, target);
+		}
+		break;
+
+	case OPI_BREQ:
+	case OPI_BRNEQ:
+	case OPI_BRLT:
+	case OPI_BRGT:
+	case OPI_BRLTE:
+	case OPI_BRGTE:
+		return EmitCompareBranch(ip, size);
+
+	case OPI_SWITCH_L:
+		return EmitSwitch(ip, size, 0);
+	case OPI_SWITCH_S:
+		return EmitSwitch(ip, size, -1);
+
+	case OPI_OPERATOR_L:
+		EmitOperator(ip, -2);
+		break;
+	case OPI_OPERATOR_S:
+		EmitOperator(ip, -1);
+		break;
+	case OPI_OPERSC_L:
+		EmitOperatorConstant(ip, -1);
+		break;
+	case OPI_OPERSC_S:
+	case OPI_OPERLC_L:
+		EmitOperatorConstant(ip, 0);
+		break;
+	case OPI_OPERLC_S:
+		EmitOperatorConstant(ip, 1);
+		break;
+
+	default:
+		{
+			JitHelper helper = JitHelpers::GetHelper(opc);
+			if (helper == nullptr)
+				return false;
+			EmitHelperCall(helper, ip);
+		}
+		break;
+	}
+
+	return true;
+}
+
+void JitCompiler::EmitPrologue()
+{
+	a.Push(THREAD);
+	a.Push(FRAME);
+	a.SubRegImm(A::RSP, FRAME_ALLOCATION);
+	a.MovRegReg(THREAD, ARG0);
+	a.MovRegReg(FRAME, ARG1);
+
+	// Jump to the instruction at ip. The entry table has one address for each
+	// 8-byte slot of the method body, so the byte offset of the instruction is
+	// also the byte offset of its entry.
+	a.MovRegReg(A::RAX, ARG2);
+	a.MovRegImm(A::RCX, (uint64_t)(uintptr_t)method->entry);
+	a.SubRegReg(A::RAX, A::RCX);
+	a.LeaLabel(A::RCX, entryTable);
+	a.JmpMemIndex(A::RCX, A::RAX, 1);
+}
+
+void JitCompiler::EmitExit()
+{
+	// EAX holds the status code of a helper, and is never OVUM_SUCCESS here.
+	// JitHelpers::EXIT turns into OVUM_SUCCESS for the caller; anything else
+	// is an error code, returned as is.
+	Label epilogue = a.NewLabel();
+
+	a.Bind(exit);
+	a.CmpReg32Imm(A::RAX, JitHelpers::EXIT);
+	a.Jcc(A::CC_NE, epilogue);
+	a.XorReg32Reg32(A::RAX, A::RAX);
+
+	a.Bind(epilogue);
+	a.AddRegImm(A::RSP, FRAME_ALLOCATION);
+	a.Pop(FRAME);
+	a.Pop(THREAD);
+	a.Ret();
+}
+
+void JitCompiler::EmitTables()
+{
+	a.AlignTo(sizeof(uint64_t));
+
+	a.Bind(entryTable);
+	const size_t slotCount = method->length / oa::ALIGNMENT;
+	for (size_t slot = 0; slot < slotCount; slot++)
+		a.EmitLabelAddress(instrStarts[slot] ? instrLabels[slot] : trap);
+
+	for (size_t i = 0; i < switchTables.size(); i++)
+	{
+		const SwitchTable &table = switchTables[i];
+		a.Bind(table.table);
+		for (size_t t = 0; t < table.count; t++)
+			a.EmitLabelAddress(instrLabels[switchTargets[table.firstTarget + t] / oa::ALIGNMENT]);
+	}
+}
+
+void JitCompiler::EmitHelperCall(JitHelper helper, uint8_t *ip)
+{
+	a.MovRegReg(ARG0, THREAD);
+	a.MovRegReg(ARG1, FRAME);
+	a.MovRegImm(ARG2, (uint64_t)(uintptr_t)ip);
+	a.MovRegImm(A::RAX, (uint64_t)(uintptr_t)helper);
+	a.CallReg(A::RAX);
+	a.TestReg32Reg32(A::RAX, A::RAX);
+	a.Jcc(A::CC_NE, exit);
+}
+
+void JitCompiler::EmitBranchHelperCall(JitHelper helper, uint8_t *ip, Label target)
+{
+	a.MovRegReg(ARG0, THREAD);
+	a.MovRegReg(ARG1, FRAME);
+	a.MovRegImm(ARG2, (uint64_t)(uintptr_t)ip);
+	a.MovRegImm(A::RAX, (uint64_t)(uintptr_t)helper);
+	a.CallReg(A::RAX);
+	a.CmpReg32Imm(A::RAX, JitHelpers::BRANCH);
+	a.Jcc(A::CC_E, target);
+	a.TestReg32Reg32(A::RAX, A::RAX);
+	a.Jcc(A::CC_NE, exit);
+}
+
+void JitCompiler::EmitStackChange(int32_t delta)
+{
+	a.AddMem32Imm(FRAME, (int32_t)offsetof(StackFrame, stackCount), delta);
+}
+
+void JitCompiler::EmitLoadConstant(int32_t offset, Type *type, uint64_t value)
+{
+	a.MovRegImm(A::RAX, (uint64_t)(uintptr_t)type);
+	a.MovMemReg(FRAME, offset + TYPE_OFFSET, A::RAX);
+	a.MovRegImm(A::RAX, value);
+	a.MovMemReg(FRAME, offset + VALUE_OFFSET, A::RAX);
+}
+
+void JitCompiler::EmitMove(int32_t dest, int32_t source)
+{
+	a.MovRegMem(A::RAX, FRAME, source + TYPE_OFFSET);
+	a.MovRegMem(A::RCX, FRAME, source + VALUE_OFFSET);
+	a.MovMemReg(FRAME, dest + TYPE_OFFSET, A::RAX);
+	a.MovMemReg(FRAME, dest + VALUE_OFFSET, A::RCX);
+}
+
+void JitCompiler::EmitIntPairCheck(int32_t left, Label fail)
+{
+	a.MovRegImm(A::RCX, (uint64_t)(uintptr_t)vm->types.Int);
+	a.CmpMemReg(FRAME, left + TYPE_OFFSET, A::RCX);
+	a.Jcc(A::CC_NE, fail);
+	a.CmpMemReg(FRAME, left + SECOND_OPERAND + TYPE_OFFSET, A::RCX);
+	a.Jcc(A::CC_NE, fail);
+}
+
+void JitCompiler::EmitOperator(uint8_t *ip, int32_t stackChange)
+{
+	typedef oa::TwoLocalsAndValue<Operator> Args;
+	const Args *args = reinterpret_cast<const Args*>(ip + JitHelpers::OPCODE_SIZE);
+	JitHelper helper = JitHelpers::GetHelper(static_cast<IntermediateOpcode>(*ip));
+
+	if (args->value != Operator::ADD && args->value != Operator::SUB)
+	{
+		EmitHelperCall(helper, ip);
+		return;
+	}
+
+	// Int + Int and Int - Int are done inline. Anything else, including
+	// overflow, goes through the helper, which does what the interpreter does.
+	const int32_t source = args->source.GetOffset();
+	const int32_t dest = args->dest.GetOffset();
+	Label slow = a.NewLabel();
+	Label done = a.NewLabel();
+
+	EmitIntPairCheck(source, slow);
+	a.MovRegMem(A::RAX, FRAME, source + VALUE_OFFSET);
+	if (args->value == Operator::ADD)
+		a.AddRegMem(A::RAX, FRAME, source + SECOND_OPERAND + VALUE_OFFSET);
+	else
+		a.SubRegMem(A::RAX, FRAME, source + SECOND_OPERAND + VALUE_OFFSET);
+	a.Jcc(A::CC_O, slow);
+	// The destination may overlap the operands, which have both been read by
+	// now. RCX still holds the Int type.
+	a.MovMemReg(FRAME, dest + VALUE_OFFSET, A::RAX);
+	a.MovMemReg(FRAME, dest + TYPE_OFFSET, A::RCX);
+	EmitStackChange(stackChange);
+	a.Jmp(done);
+
+	a.Bind(slow);
+	EmitHelperCall(helper, ip);
+	a.Bind(done);
+}
+
+void JitCompiler::EmitOperatorConstant(uint8_t *ip, int32_t stackChange)
+{
+	const IntermediateOpcode opc = static_cast<IntermediateOpcode>(*ip);
+	const oa::OperatorConstant *args = reinterpret_cast<const oa::OperatorConstant*>(ip + JitHelpers::OPCODE_SIZE);
+	JitHelper helper = JitHelpers::GetHelper(opc);
+
+	if ((args->op != Operator::ADD && args->op != Operator::SUB) ||
+		args->value != (int64_t)(int32_t)args->value)
+	{
+		EmitHelperCall(helper, ip);
+		return;
+	}
+
+	// As in EmitOperator(), but the right operand is an immediate, so the
+	// operands never need to be copied to the stack on the fast path.
+	const bool leftIsLocal = opc == OPI_OPERLC_L || opc == OPI_OPERLC_S;
+	const int32_t left = leftIsLocal ? args->left.GetOffset() : args->args.GetOffset();
+	const int32_t dest = args->dest.GetOffset();
+	Label slow = a.NewLabel();
+	Label done = a.NewLabel();
+
+	a.MovRegImm(A::RCX, (uint64_t)(uintptr_t)vm->types.Int);
+	a.CmpMemReg(FRAME, left + TYPE_OFFSET, A::RCX);
+	a.Jcc(A::CC_NE, slow);
+	a.MovRegMem(A::RAX, FRAME, left + VALUE_OFFSET);
+	if (args->op == Operator::ADD)
+		a.AddRegImm(A::RAX, (int32_t)args->value);
+	else
+		a.SubRegImm(A::RAX, (int32_t)args->value);
+	a.Jcc(A::CC_O, slow);
+	a.MovMemReg(FRAME, dest + VALUE_OFFSET, A::RAX);
+	a.MovMemReg(FRAME, dest + TYPE_OFFSET, A::RCX);
+	if (stackChange != 0)
+		EmitStackChange(stackChange);
+	a.Jmp(done);
+
+	a.Bind(slow);
+	EmitHelperCall(helper, ip);
+	a.Bind(done);
+}
+
+bool JitCompiler::EmitCompareBranch(uint8_t *ip, size_t size)
+{
+	const IntermediateOpcode opc = static_cast<IntermediateOpcode>(*ip);
+	const oa::ConditionalBranch *args = reinterpret_cast<const oa::ConditionalBranch*>(ip + JitHelpers::OPCODE_SIZE);
+	const size_t offset = (size_t)(ip - method->entry);
+
+	Label target, next;
+	if (!GetTargetLabel(offset + size + args->offset, target) ||
+		!GetTargetLabel(offset + size, next))
+		return false;
+
+	A::Condition cond;
+	switch (opc)
+	{
+	case OPI_BREQ:  cond = A::CC_E;  break;
+	case OPI_BRNEQ: cond = A::CC_NE; break;
+	case OPI_BRLT:  cond = A::CC_L;  break;
+	case OPI_BRGT:  cond = A::CC_G;  break;
+	case OPI_BRLTE: cond = A::CC_LE; break;
+	case OPI_BRGTE: cond = A::CC_GE; break;
+	default:
+		OVUM_UNREACHABLE();
+	}
+
+	// Two Ints are compared inline; everything else goes through the helper.
+	const int32_t left = args->value.GetOffset();
+	Label slow = a.NewLabel();
+
+	EmitIntPairCheck(left, slow);
+	EmitStackChange(-2);
+	a.MovRegMem(A::RAX, FRAME, left + VALUE_OFFSET);
+	a.CmpRegMem(A::RAX, FRAME, left + SECOND_OPERAND + VALUE_OFFSET);
+	a.Jcc(cond, target);
+	a.Jmp(next);
+
+	a.Bind(slow);
+	EmitBranchHelperCall(JitHelpers::GetHelper(opc), ip, target);
+	return true;
+}
+
+bool JitCompiler::EmitTruthBranch(uint8_t *ip, size_t size, bool branchIfTrue, int32_t stackChange)
+{
+	const oa::ConditionalBranch *args = reinterpret_cast<const oa::ConditionalBranch*>(ip + JitHelpers::OPCODE_SIZE);
+	const size_t offset = (size_t)(ip - method->entry);
+
+	Label target, next;
+	if (!GetTargetLabel(offset + size + args->offset, target) ||
+		!GetTargetLabel(offset + size, next))
+		return false;
+
+	if (stackChange != 0)
+		EmitStackChange(stackChange);
+
+	// Same as IsTrue_ and IsFalse_: null is false, a Boolean is true if it is
+	// non-zero, and everything else is true.
+	const int32_t value = args->value.GetOffset();
+	a.MovRegMem(A::RAX, FRAME, value + TYPE_OFFSET);
+	a.CmpRegImm(A::RAX, 0);
+	a.Jcc(A::CC_E, branchIfTrue ? next : target);
+	a.MovRegImm(A::RCX, (uint64_t)(uintptr_t)vm->types.Boolean);
+	a.CmpRegReg(A::RAX, A::RCX);
+	a.Jcc(A::CC_NE, branchIfTrue ? target : next);
+	a.CmpMemImm(FRAME, value + VALUE_OFFSET, 0);
+	a.Jcc(branchIfTrue ? A::CC_NE : A::CC_E, target);
+	return true;
+}
+
+bool JitCompiler::EmitSwitch(uint8_t *ip, size_t size, int32_t stackChange)
+{
+	const oa::Switch *args = reinterpret_cast<const oa::Switch*>(ip + JitHelpers::OPCODE_SIZE);
+	const size_t offset = (size_t)(ip - method->entry);
+
+	Label next;
+	if (!GetTargetLabel(offset + size, next) || args->count > INT32_MAX)
+		return false;
+
+	SwitchTable table;
+	table.table = a.NewLabel();
+	table.firstTarget = switchTargets.size();
+	table.count = args->count;
+
+	for (size_t i = 0; i < args->count; i++)
+	{
+		size_t targetOffset = offset + size + (&args->firstOffset)[i];
+		Label target;
+		if (!GetTargetLabel(targetOffset, target))
+			return false;
+		switchTargets.push_back(targetOffset);
+	}
+	switchTables.push_back(table);
+
+	const int32_t value = args->value.GetOffset();
+	Label isInt = a.NewLabel();
+
+	a.MovRegImm(A::RCX, (uint64_t)(uintptr_t)vm->types.Int);
+	a.CmpMemReg(FRAME, value + TYPE_OFFSET, A::RCX);
+	a.Jcc(A::CC_E, isInt);
+	// Always fails, and jumps to exit.
+	EmitHelperCall(JitHelpers::ThrowSwitchTypeError, ip);
+
+	a.Bind(isInt);
+	if (stackChange != 0)
+		EmitStackChange(stackChange);
+	// Negative values are out of range too, as an unsigned comparison.
+	a.MovRegMem(A::RAX, FRAME, value + VALUE_OFFSET);
+	a.CmpRegImm(A::RAX, (int32_t)args->count);
+	a.Jcc(A::CC_AE, next);
+	a.LeaLabel(A::RCX, table.table);
+	a.JmpMemIndex(A::RCX, A::RAX, 8);
+	return true;
+}
+
+} // namespace ovum
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "../vm.h"
+#include "../ee/thread.opcodes.h"
+#include "x64assembler.h"
+#include "jithelpers.h"
+#include <vector>
+
+namespace ovum
+{
+
+// Translates the intermediate bytecode of a single method overload into x86-64
+// machine code. This is a baseline compiler: each instruction is compiled on
+// its own, into a fixed sequence of machine instructions, without any register
+// allocation or analysis across instructions. Locals and the evaluation stack
+// stay in the stack frame, exactly where the interpreter keeps them, so that
+// the generated code can hand over to Thread::Evaluate() between any two
+// instructions.
+//
+// The simplest instructions (moves, constants, branches, and arithmetic and
+// comparisons on Int values) are compiled inline. Everything else is compiled
+// to a call to a JitHelper.
+//
+// The generated code has the signature of JitCode::EntryPoint, and can be
+// entered at the start of any instruction. It runs until an instruction that
+// leaves the method (ret, retnull, throw, rethrow, endfinally), a call to a
+// bytecode method, or an error; see JitHelpers::EXIT.
+class JitCompiler
+{
+public:
+	JitCompiler(VM *vm, MethodOverload *method);
+
+	// Compiles the method. The method must have been initialized.
+	// Returns:
+	//   True if the method was compiled; false if it contains an instruction
+	//   that the compiler does not support.
+	bool Compile();
+
+	// Gets the size of the generated code, in bytes.
+	inline size_t GetCodeSize() const
+	{
+		return a.GetSize();
+	}
+
+	// Copies the generated code to its final location.
+	//   dest:
+	//     The location to copy the code to. This must be at least
+	//     GetCodeSize() bytes long.
+	void CopyTo(uint8_t *dest) const;
+
+private:
+	typedef X64Assembler::Register Register;
+	typedef X64Assembler::Label Label;
+
+	// The registers that arguments are passed in. The generated code is called
+	// with (Thread*, StackFrame*, uint8_t*), and helpers take the same.
+#if OVUM_WINDOWS
+	static const Register ARG0 = X64Assembler::RCX;
+	static const Register ARG1 = X64Assembler::RDX;
+	static const Register ARG2 = X64Assembler::R8;
+#else
+	static const Register ARG0 = X64Assembler::RDI;
+	static const Register ARG1 = X64Assembler::RSI;
+	static const Register ARG2 = X64Assembler::RDX;
+#endif
+	// Callee-saved registers, which hold the Thread* and StackFrame* for the
+	// duration of the code.
+	static const Register THREAD = X64Assembler::RBX;
+	static const Register FRAME = X64Assembler::R12;
+
+	// The amount by which the prologue moves the stack pointer. This keeps it
+	// 16-byte aligned at each call, and reserves the 32 bytes of shadow space
+	// that the Windows x64 calling convention requires.
+	static const int32_t FRAME_ALLOCATION = 40;
+
+	// A switch instruction whose jump table is emitted after the code.
+	struct SwitchTable
+	{
+		Label table;
+		size_t firstTarget;
+		size_t count;
+	};
+
+	VM *vm;
+	MethodOverload *method;
+
+	X64Assembler a;
+
+	// Labels for the start of each instruction, indexed by byte offset / 8.
+	// Every instruction starts on an 8-byte boundary. The last entry refers to
+	// the end of the method.
+	std::vector<Label> instrLabels;
+	// Whether an instruction starts at each 8-byte offset.
+	std::vector<bool> instrStarts;
+	// The targets of every switch instruction, as byte offsets, in the order
+	// they appear.
+	std::vector<size_t> switchTargets;
+	std::vector<SwitchTable> switchTables;
+
+	// Entering the code at an offset that is not an instruction goes here.
+	Label trap;
+	// Returns from the code; see EmitExit().
+	Label exit;
+	// The table of instruction addresses used by the prologue.
+	Label entryTable;
+
+	// Gets the total size of the instruction at ip, including the opcode, or
+	// 0 if the instruction is not supported.
+	static size_t GetInstructionSize(const uint8_t *ip);
+
+	bool FindInstructions();
+	bool EmitInstruction(uint8_t *ip, size_t size);
+
+	// Gets the label of the instruction at the specified byte offset, or
+	// returns false if no instruction starts there.
+	bool GetTargetLabel(size_t offset, Label &label) const;
+
+	void EmitPrologue();
+	void EmitExit();
+	void EmitTables();
+
+	// Calls a helper, and jumps to exit unless it returns OVUM_SUCCESS.
+	void EmitHelperCall(JitHelper helper, uint8_t *ip);
+	// Calls a conditional branch helper, and jumps to target if it returns
+	// JitHelpers::BRANCH.
+	void EmitBranchHelperCall(JitHelper helper, uint8_t *ip, Label target);
+
+	// Adds delta to the stack frame's stackCount.
+	void EmitStackChange(int32_t delta);
+	// Stores a value of the specified type in the local at offset.
+	void EmitLoadConstant(int32_t offset, Type *type, uint64_t value);
+	// Copies the Value at source to dest.
+	void EmitMove(int32_t dest, int32_t source);
+	// Jumps to fail unless the Values at left and left + sizeof(Value) are both
+	// of type Int. Leaves the Int type in RCX.
+	void EmitIntPairCheck(int32_t left, Label fail);
+
+	void EmitOperator(uint8_t *ip, int32_t stackChange);
+	// Like EmitOperator(), for the superinstructions whose right operand is an
+	// Int constant.
+	void EmitOperatorConstant(uint8_t *ip, int32_t stackChange);
+	// The following return false if a branch target is not an instruction.
+	bool EmitCompareBranch(uint8_t *ip, size_t size);
+	bool EmitTruthBranch(uint8_t *ip, size_t size, bool branchIfTrue, int32_t stackChange);
+	bool EmitSwitch(uint8_t *ip, size_t size, int32_t stackChange);
+
+	OVUM_DISABLE_COPY_AND_ASSIGN(JitCompiler);
+};
+
+} // namespace ovum
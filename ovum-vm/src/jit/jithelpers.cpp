@@ -0,0 +1,679 @@
+#include "jithelpers.h"
+#include "../ee/thread.primitives.h"
+#include "../object/type.h"
+#include "../object/field.h"
+#include "../object/method.h"
+#include "../object/value.h"
+#include "../gc/gc.h"
+#include "../gc/staticref.h"
+#include "../res/staticstrings.h"
+
+namespace ovum
+{
+
+namespace oa = ovum::opcode_args;
+
+#define JIT_ARGS(T) const T *const args = reinterpret_cast<const T*>(ip + OPCODE_SIZE)
+
+#define SET_BOOL(ptarg, bvalue) \
+	{                                              \
+		(ptarg)->type = thread->vm->types.Boolean; \
+		(ptarg)->v.integer = bvalue;               \
+	}
+#define SET_INT(ptarg, ivalue) \
+	{                                              \
+		(ptarg)->type = thread->vm->types.Int;     \
+		(ptarg)->v.integer = ivalue;               \
+	}
+
+JitHelper JitHelpers::GetHelper(IntermediateOpcode opc)
+{
+	switch (opc)
+	{
+	case OPI_RET:
+	case OPI_RETNULL:
+	case OPI_THROW:
+	case OPI_RETHROW:
+	case OPI_ENDFINALLY:
+		return Exit;
+
+	case OPI_NEWOBJ_L:    return NewObject<false>;
+	case OPI_NEWOBJ_S:    return NewObject<true>;
+	case OPI_LIST_L:      return List<false>;
+	case OPI_LIST_S:      return List<true>;
+	case OPI_HASH_L:      return Hash<false>;
+	case OPI_HASH_S:      return Hash<true>;
+	case OPI_LDFLD_L:     return LoadField<false>;
+	case OPI_LDFLD_S:     return LoadField<true>;
+	case OPI_LDFLDFAST_L: return LoadFieldFast<false>;
+	case OPI_LDFLDFAST_S: return LoadFieldFast<true>;
+	case OPI_LDLOCFLD_L:  return LoadLocalField<false>;
+	case OPI_LDLOCFLD_S:  return LoadLocalField<true>;
+	case OPI_LDSFLD_L:    return LoadStaticField<false>;
+	case OPI_LDSFLD_S:    return LoadStaticField<true>;
+	case OPI_LDMEM_L:     return LoadMember<false>;
+	case OPI_LDMEM_S:     return LoadMember<true>;
+	case OPI_LDITER_L:    return LoadIterator<false>;
+	case OPI_LDITER_S:    return LoadIterator<true>;
+	case OPI_LDTYPE_L:    return LoadType<false>;
+	case OPI_LDTYPE_S:    return LoadType<true>;
+	case OPI_LDIDX_L:     return LoadIndexer<false>;
+	case OPI_LDIDX_S:     return LoadIndexer<true>;
+	case OPI_LDSFN_L:     return LoadStaticFunction<false>;
+	case OPI_LDSFN_S:     return LoadStaticFunction<true>;
+	case OPI_LDTYPETKN_L: return LoadTypeToken<false>;
+	case OPI_LDTYPETKN_S: return LoadTypeToken<true>;
+
+	case OPI_CALL_L:      return Call<false>;
+	case OPI_CALL_S:      return Call<true>;
+	case OPI_CALLR_L:     return CallRef<false>;
+	case OPI_CALLR_S:     return CallRef<true>;
+	case OPI_SCALL_L:     return StaticCall<false>;
+	case OPI_SCALL_S:     return StaticCall<true>;
+	case OPI_CALLMEM_L:   return CallMember<false>;
+	case OPI_CALLMEM_S:   return CallMember<true>;
+	case OPI_CALLMEMR_L:  return CallMemberRef<false>;
+	case OPI_CALLMEMR_S:  return CallMemberRef<true>;
+	case OPI_APPLY_L:     return Apply<false>;
+	case OPI_APPLY_S:     return Apply<true>;
+	case OPI_SAPPLY_L:    return StaticApply<false>;
+	case OPI_SAPPLY_S:    return StaticApply<true>;
+
+	case OPI_LEAVE:       return Leave;
+	case OPI_BRTYPE_L:    return BranchIfType<false>;
+	case OPI_BRTYPE_S:    return BranchIfType<true>;
+	case OPI_BRREF:       return BranchIfReference<true>;
+	case OPI_BRNREF:      return BranchIfReference<false>;
+	case OPI_BREQ:        return BranchIfEqual<true>;
+	case OPI_BRNEQ:       return BranchIfEqual<false>;
+	case OPI_BRLT:        return BranchIfCompare<&Thread::CompareLessThanLL, IsLess>;
+	case OPI_BRGT:        return BranchIfCompare<&Thread::CompareGreaterThanLL, IsGreater>;
+	case OPI_BRLTE:       return BranchIfCompare<&Thread::CompareLessEqualsLL, IsLessOrEqual>;
+	case OPI_BRGTE:       return BranchIfCompare<&Thread::CompareGreaterEqualsLL, IsGreaterOrEqual>;
+
+	case OPI_OPERATOR_L:  return BinaryOperator<false>;
+	case OPI_OPERATOR_S:  return BinaryOperator<true>;
+	case OPI_UNARYOP_L:   return UnaryOperator<false>;
+	case OPI_UNARYOP_S:   return UnaryOperator<true>;
+	case OPI_OPERSC_L:    return BinaryOperatorConstant<false, false>;
+	case OPI_OPERSC_S:    return BinaryOperatorConstant<true, false>;
+	case OPI_OPERLC_L:    return BinaryOperatorConstant<false, true>;
+	case OPI_OPERLC_S:    return BinaryOperatorConstant<true, true>;
+	case OPI_EQ_L:        return Equals<false>;
+	case OPI_EQ_S:        return Equals<true>;
+	case OPI_CMP_L:       return Compare<false>;
+	case OPI_CMP_S:       return Compare<true>;
+	case OPI_LT_L:        return CompareValues<&Thread::CompareLessThanLL, IsLess, false>;
+	case OPI_LT_S:        return CompareValues<&Thread::CompareLessThanLL, IsLess, true>;
+	case OPI_GT_L:        return CompareValues<&Thread::CompareGreaterThanLL, IsGreater, false>;
+	case OPI_GT_S:        return CompareValues<&Thread::CompareGreaterThanLL, IsGreater, true>;
+	case OPI_LTE_L:       return CompareValues<&Thread::CompareLessEqualsLL, IsLessOrEqual, false>;
+	case OPI_LTE_S:       return CompareValues<&Thread::CompareLessEqualsLL, IsLessOrEqual, true>;
+	case OPI_GTE_L:       return CompareValues<&Thread::CompareGreaterEqualsLL, IsGreaterOrEqual, false>;
+	case OPI_GTE_S:       return CompareValues<&Thread::CompareGreaterEqualsLL, IsGreaterOrEqual, true>;
+	case OPI_CONCAT_L:    return Concat<false>;
+	case OPI_CONCAT_S:    return Concat<true>;
+
+	case OPI_STSFLD_L:    return StoreStaticField<false>;
+	case OPI_STSFLD_S:    return StoreStaticField<true>;
+	case OPI_STFLD:       return StoreField;
+	case OPI_STFLDFAST:   return StoreFieldFast;
+	case OPI_STMEM:       return StoreMember;
+	case OPI_STIDX:       return StoreIndexer;
+
+	default:
+		return nullptr;
+	}
+}
+
+int JitHelpers::ThrowSwitchTypeError(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	thread->ip = ip;
+	return thread->ThrowTypeError();
+}
+
+int JitHelpers::CallOverload(
+	Thread *thread,
+	StackFrame *frame,
+	MethodOverload *mo,
+	ovlocals_t argc,
+	Value *args,
+	Value *dest,
+	uint8_t *returnInstr,
+	bool push
+)
+{
+	int r;
+	if (mo->IsNative())
+	{
+		r = thread->InvokeMethodOverload(mo, argc, args, dest);
+		if (r != OVUM_SUCCESS) return r;
+		if (push)
+			frame->stackCount++;
+		RETURN_SUCCESS;
+	}
+
+	r = thread->EnterMethod(mo, argc, args, dest, returnInstr, push);
+	if (r != OVUM_SUCCESS) return r;
+	return EXIT;
+}
+
+int JitHelpers::Exit(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	thread->ip = ip;
+	return EXIT;
+}
+
+template<bool push>
+int JitHelpers::NewObject(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::NewObject);
+	thread->ip = ip;
+	// ConstructLL pops the arguments
+	int r = thread->GetGC()->ConstructLL(thread, args->type, args->argc, args->Args(frame), args->Dest(frame));
+	if (r != OVUM_SUCCESS) return r;
+	if (push)
+		frame->stackCount++;
+	RETURN_SUCCESS;
+}
+
+template<bool push>
+int JitHelpers::List(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::LocalAndValue<size_t>);
+	thread->ip = ip;
+	// The list goes into the destination during initialization, so that the
+	// GC can reach it.
+	Value *result = args->Local(frame);
+	int r = thread->GetGC()->Alloc(thread, thread->vm->types.List, sizeof(ListInst), result);
+	if (r != OVUM_SUCCESS) return r;
+	if (push)
+		frame->stackCount++;
+	return thread->vm->functions.initListInstance(thread, result->v.list, args->value);
+}
+
+template<bool push>
+int JitHelpers::Hash(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::LocalAndValue<size_t>);
+	thread->ip = ip;
+	int r = thread->vm->functions.initHashInstance(thread, args->value, args->Local(frame));
+	if (r != OVUM_SUCCESS) return r;
+	if (push)
+		frame->stackCount++;
+	RETURN_SUCCESS;
+}
+
+template<bool push>
+int JitHelpers::LoadField(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::TwoLocalsAndValue<Field*>);
+	thread->ip = ip;
+	int r = args->value->ReadField(thread, args->Source(frame), args->Dest(frame));
+	if (r != OVUM_SUCCESS) return r;
+	// The instance is always read from the stack.
+	if (!push)
+		frame->stackCount--;
+	RETURN_SUCCESS;
+}
+
+template<bool push>
+int JitHelpers::LoadFieldFast(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::TwoLocalsAndValue<Field*>);
+	thread->ip = ip;
+	int r = args->value->ReadFieldFast(thread, args->Source(frame), args->Dest(frame));
+	if (r != OVUM_SUCCESS) return r;
+	if (!push)
+		frame->stackCount--;
+	RETURN_SUCCESS;
+}
+
+template<bool push>
+int JitHelpers::LoadLocalField(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::TwoLocalsAndValue<Field*>);
+	thread->ip = ip;
+	int r = args->value->ReadField(thread, args->Source(frame), args->Dest(frame));
+	if (r != OVUM_SUCCESS) return r;
+	// The instance is read from a local.
+	if (push)
+		frame->stackCount++;
+	RETURN_SUCCESS;
+}
+
+template<bool push>
+int JitHelpers::LoadStaticField(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::LocalAndValue<Field*>);
+	args->value->staticValue->Read(args->Local(frame));
+	if (push)
+		frame->stackCount++;
+	RETURN_SUCCESS;
+}
+
+template<bool push>
+int JitHelpers::LoadMember(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::LoadMember);
+	thread->ip = ip;
+	// LoadMemberLL pops the instance
+	int r = thread->LoadMemberLL(args->Source(frame), args->member, args->Dest(frame), &args->cache);
+	if (r != OVUM_SUCCESS) return r;
+	if (push)
+		frame->stackCount++;
+	RETURN_SUCCESS;
+}
+
+template<bool push>
+int JitHelpers::LoadIterator(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::TwoLocals);
+	thread->ip = ip;
+	MethodOverload *mo;
+	int r = thread->ResolveMemberInvocationLL(thread->strings->members.iter_, 0, args->Source(frame), 0, nullptr, &mo);
+	if (r != OVUM_SUCCESS) return r;
+	return CallOverload(
+		thread, frame, mo, 0,
+		args->Source(frame), args->Dest(frame),
+		ip + OPCODE_SIZE + oa::TWO_LOCALS_SIZE,
+		push
+	);
+}
+
+template<bool push>
+int JitHelpers::LoadType(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::TwoLocals);
+	thread->ip = ip;
+	Value *const inst = args->Source(frame);
+	if (inst->type)
+	{
+		int r = inst->type->GetTypeToken(thread, args->Dest(frame));
+		if (r != OVUM_SUCCESS) return r;
+	}
+	else
+	{
+		args->Dest(frame)->type = nullptr;
+	}
+	if (!push)
+		frame->stackCount--;
+	RETURN_SUCCESS;
+}
+
+template<bool push>
+int JitHelpers::LoadIndexer(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::TwoLocalsAndValue<ovlocals_t>);
+	thread->ip = ip;
+	// LoadIndexerLL decrements the stack height by the argument count + instance
+	int r = thread->LoadIndexerLL(args->value, args->Source(frame), args->Dest(frame));
+	if (r != OVUM_SUCCESS) return r;
+	if (push)
+		frame->stackCount++;
+	RETURN_SUCCESS;
+}
+
+template<bool push>
+int JitHelpers::LoadStaticFunction(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::LocalAndValue<Method*>);
+	thread->ip = ip;
+	Value *const dest = args->Local(frame);
+	int r = thread->GetGC()->Alloc(thread, thread->vm->types.Method, sizeof(MethodInst), dest);
+	if (r != OVUM_SUCCESS) return r;
+	dest->v.method->method = args->value;
+	if (push)
+		frame->stackCount++;
+	RETURN_SUCCESS;
+}
+
+template<bool push>
+int JitHelpers::LoadTypeToken(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::LocalAndValue<Type*>);
+	thread->ip = ip;
+	int r = args->value->GetTypeToken(thread, args->Local(frame));
+	if (r != OVUM_SUCCESS) return r;
+	if (push)
+		frame->stackCount++;
+	RETURN_SUCCESS;
+}
+
+template<bool push>
+int JitHelpers::Call(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::Call);
+	thread->ip = ip;
+	MethodOverload *mo;
+	int r = thread->ResolveInvocationLL(args->argc, args->Args(frame), 0, &mo);
+	if (r != OVUM_SUCCESS) return r;
+	return CallOverload(
+		thread, frame, mo, args->argc,
+		args->Args(frame), args->Dest(frame),
+		ip + OPCODE_SIZE + oa::CALL_SIZE,
+		push
+	);
+}
+
+template<bool push>
+int JitHelpers::CallRef(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::CallRef);
+	thread->ip = ip;
+	MethodOverload *mo;
+	int r = thread->ResolveInvocationLL(args->argc, args->Args(frame), args->refSignature, &mo);
+	if (r != OVUM_SUCCESS) return r;
+	return CallOverload(
+		thread, frame, mo, args->argc,
+		args->Args(frame), args->Dest(frame),
+		ip + OPCODE_SIZE + oa::CALL_REF_SIZE,
+		push
+	);
+}
+
+template<bool push>
+int JitHelpers::StaticCall(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::StaticCall);
+	thread->ip = ip;
+	return CallOverload(
+		thread, frame, args->method, args->argc,
+		args->Args(frame), args->Dest(frame),
+		ip + OPCODE_SIZE + oa::STATIC_CALL_SIZE,
+		push
+	);
+}
+
+template<bool push>
+int JitHelpers::CallMember(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::CallMember);
+	thread->ip = ip;
+	MethodOverload *mo;
+	int r = thread->ResolveMemberInvocationLL(args->member, args->argc, args->Args(frame), 0, &args->cache, &mo);
+	if (r != OVUM_SUCCESS) return r;
+	return CallOverload(
+		thread, frame, mo, args->argc,
+		args->Args(frame), args->Dest(frame),
+		ip + OPCODE_SIZE + oa::CALL_MEMBER_SIZE,
+		push
+	);
+}
+
+template<bool push>
+int JitHelpers::CallMemberRef(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::CallMemberRef);
+	thread->ip = ip;
+	MethodOverload *mo;
+	int r = thread->ResolveMemberInvocationLL(args->member, args->argc, args->Args(frame), args->refSignature, &args->cache, &mo);
+	if (r != OVUM_SUCCESS) return r;
+	return CallOverload(
+		thread, frame, mo, args->argc,
+		args->Args(frame), args->Dest(frame),
+		ip + OPCODE_SIZE + oa::CALL_MEMBER_REF_SIZE,
+		push
+	);
+}
+
+template<bool push>
+int JitHelpers::Apply(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::TwoLocals);
+	thread->ip = ip;
+	// InvokeApplyLL pops the arguments
+	int r = thread->InvokeApplyLL(args->Source(frame), args->Dest(frame));
+	if (r != OVUM_SUCCESS) return r;
+	if (push)
+		frame->stackCount++;
+	RETURN_SUCCESS;
+}
+
+template<bool push>
+int JitHelpers::StaticApply(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::TwoLocalsAndValue<Method*>);
+	thread->ip = ip;
+	// InvokeApplyMethodLL pops the arguments
+	int r = thread->InvokeApplyMethodLL(args->value, args->Source(frame), args->Dest(frame));
+	if (r != OVUM_SUCCESS) return r;
+	if (push)
+		frame->stackCount++;
+	RETURN_SUCCESS;
+}
+
+int JitHelpers::Leave(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::Branch);
+	thread->ip = ip;
+	// The generated code jumps to the target.
+	return thread->EvaluateLeave(frame, args->offset);
+}
+
+template<bool pop>
+int JitHelpers::BranchIfType(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::BranchIfType);
+	bool taken = Type::ValueIsType(args->Value(frame), args->type);
+	if (pop)
+		frame->stackCount--;
+	return taken ? BRANCH : OVUM_SUCCESS;
+}
+
+template<bool same>
+int JitHelpers::BranchIfReference(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::ConditionalBranch);
+	Value *const ops = args->Value(frame);
+	bool taken = IsSameReference_(ops + 0, ops + 1) == same;
+	frame->stackCount -= 2;
+	return taken ? BRANCH : OVUM_SUCCESS;
+}
+
+template<bool equal>
+int JitHelpers::BranchIfEqual(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::ConditionalBranch);
+	bool eq;
+	if (!thread->TryPrimitiveEquals(args->Value(frame), eq))
+	{
+		thread->ip = ip;
+		int r = thread->EqualsLL(args->Value(frame), eq);
+		if (r != OVUM_SUCCESS) return r;
+	}
+	return eq == equal ? BRANCH : OVUM_SUCCESS;
+}
+
+template<int (Thread::*compare)(Value*, bool&), bool (*test)(int)>
+int JitHelpers::BranchIfCompare(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::ConditionalBranch);
+	bool result;
+	int cmp;
+	if (thread->TryPrimitiveCompare(args->Value(frame), cmp))
+	{
+		result = test(cmp);
+	}
+	else
+	{
+		thread->ip = ip;
+		int r = (thread->*compare)(args->Value(frame), result);
+		if (r != OVUM_SUCCESS) return r;
+	}
+	return result ? BRANCH : OVUM_SUCCESS;
+}
+
+template<bool push>
+int JitHelpers::BinaryOperator(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::TwoLocalsAndValue<Operator>);
+	if (!thread->TryPrimitiveOperator(args->Source(frame), args->value, args->Dest(frame)))
+	{
+		thread->ip = ip;
+		int r = thread->InvokeOperatorLL(args->Source(frame), args->value, 2, args->Dest(frame));
+		if (r != OVUM_SUCCESS) return r;
+	}
+	// Both methods pop arguments off the stack
+	if (push)
+		frame->stackCount++;
+	RETURN_SUCCESS;
+}
+
+template<bool push>
+int JitHelpers::UnaryOperator(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::TwoLocalsAndValue<Operator>);
+	thread->ip = ip;
+	// InvokeOperatorLL pops arguments off the stack
+	int r = thread->InvokeOperatorLL(args->Source(frame), args->value, 1, args->Dest(frame));
+	if (r != OVUM_SUCCESS) return r;
+	if (push)
+		frame->stackCount++;
+	RETURN_SUCCESS;
+}
+
+template<bool push, bool leftIsLocal>
+int JitHelpers::BinaryOperatorConstant(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::OperatorConstant);
+	Value *const opArgs = args->Args(frame);
+	if (leftIsLocal)
+	{
+		opArgs[0] = *args->Left(frame);
+		frame->stackCount++;
+	}
+	SET_INT(opArgs + 1, args->value);
+	frame->stackCount++;
+	if (!thread->TryPrimitiveOperator(opArgs, args->op, args->Dest(frame)))
+	{
+		thread->ip = ip;
+		int r = thread->InvokeOperatorLL(opArgs, args->op, 2, args->Dest(frame));
+		if (r != OVUM_SUCCESS) return r;
+	}
+	// Both methods pop arguments off the stack
+	if (push)
+		frame->stackCount++;
+	RETURN_SUCCESS;
+}
+
+template<bool push>
+int JitHelpers::Equals(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::TwoLocals);
+	bool eq;
+	if (!thread->TryPrimitiveEquals(args->Source(frame), eq))
+	{
+		thread->ip = ip;
+		int r = thread->EqualsLL(args->Source(frame), eq);
+		if (r != OVUM_SUCCESS) return r;
+	}
+	SET_BOOL(args->Dest(frame), eq);
+	if (push)
+		frame->stackCount++;
+	RETURN_SUCCESS;
+}
+
+template<bool push>
+int JitHelpers::Compare(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::TwoLocals);
+	int cmp;
+	if (thread->TryPrimitiveCompare(args->Source(frame), cmp))
+	{
+		SET_INT(args->Dest(frame), cmp);
+	}
+	else
+	{
+		thread->ip = ip;
+		int r = thread->CompareLL(args->Source(frame), args->Dest(frame));
+		if (r != OVUM_SUCCESS) return r;
+	}
+	if (push)
+		frame->stackCount++;
+	RETURN_SUCCESS;
+}
+
+template<int (Thread::*compare)(Value*, bool&), bool (*test)(int), bool push>
+int JitHelpers::CompareValues(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::TwoLocals);
+	bool result;
+	int cmp;
+	if (thread->TryPrimitiveCompare(args->Source(frame), cmp))
+	{
+		result = test(cmp);
+	}
+	else
+	{
+		thread->ip = ip;
+		int r = (thread->*compare)(args->Source(frame), result);
+		if (r != OVUM_SUCCESS) return r;
+	}
+	SET_BOOL(args->Dest(frame), result);
+	if (push)
+		frame->stackCount++;
+	RETURN_SUCCESS;
+}
+
+template<bool push>
+int JitHelpers::Concat(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::TwoLocals);
+	thread->ip = ip;
+	// ConcatLL pops arguments off stack
+	int r = thread->ConcatLL(args->Source(frame), args->Dest(frame));
+	if (r != OVUM_SUCCESS) return r;
+	if (push)
+		frame->stackCount++;
+	RETURN_SUCCESS;
+}
+
+template<bool pop>
+int JitHelpers::StoreStaticField(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::LocalAndValue<Field*>);
+	thread->ip = ip;
+	args->value->staticValue->Write(args->Local(frame));
+	if (pop)
+		frame->stackCount--;
+	RETURN_SUCCESS;
+}
+
+int JitHelpers::StoreField(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::LocalAndValue<Field*>);
+	thread->ip = ip;
+	int r = args->value->WriteField(thread, args->Local(frame));
+	if (r != OVUM_SUCCESS) return r;
+	frame->stackCount -= 2;
+	RETURN_SUCCESS;
+}
+
+int JitHelpers::StoreFieldFast(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::LocalAndValue<Field*>);
+	thread->ip = ip;
+	int r = args->value->WriteFieldFast(thread, args->Local(frame));
+	if (r != OVUM_SUCCESS) return r;
+	frame->stackCount -= 2;
+	RETURN_SUCCESS;
+}
+
+int JitHelpers::StoreMember(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::StoreMember);
+	thread->ip = ip;
+	// StoreMemberLL performs a null check, and pops the things off the stack
+	return thread->StoreMemberLL(args->Args(frame), args->member, &args->cache);
+}
+
+int JitHelpers::StoreIndexer(Thread *thread, StackFrame *frame, uint8_t *ip)
+{
+	JIT_ARGS(oa::LocalAndValue<ovlocals_t>);
+	thread->ip = ip;
+	// StoreIndexerLL performs a null check, and pops things off the stack
+	return thread->StoreIndexerLL(args->value, args->Local(frame));
+}
+
+} // namespace ovum
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "../vm.h"
+#include "../ee/thread.opcodes.h"
+
+namespace ovum
+{
+
+// A JIT helper implements a single intermediate instruction on behalf of code
+// generated by JitCompiler. Instructions that are not simple enough to be
+// expressed inline in machine code are compiled to a call to a helper.
+//
+// A helper has exactly the same effect as the corresponding case in
+// Thread::Evaluate(), including on the evaluation stack height, except that
+// it does not advance the instruction pointer; the generated code continues
+// with the next instruction by itself.
+//   thread:
+//     The current thread.
+//   frame:
+//     The current stack frame.
+//   ip:
+//     The address of the instruction, that is, of its opcode. The helper
+//     stores this in thread->ip before doing anything that may need it.
+// Returns:
+//   OVUM_SUCCESS to continue with the next instruction, an error code if the
+//   instruction failed, or one of JitHelpers::EXIT and JitHelpers::BRANCH.
+typedef int (*JitHelper)(Thread *thread, StackFrame *frame, uint8_t *ip);
+
+class JitHelpers
+{
+public:
+	// Every instruction starts with the opcode, which is followed by the
+	// instruction's arguments.
+	static const size_t OPCODE_SIZE = OVUM_ALIGN_TO(sizeof(IntermediateOpcode), opcode_args::ALIGNMENT);
+
+	// Returned by a helper when the generated code must return to
+	// Thread::Evaluate(), which continues at thread->ip in the current stack
+	// frame. This happens when a bytecode method has been entered, and for
+	// instructions that leave the method, such as ret and throw, which are
+	// left to the interpreter.
+	static const int EXIT = 0x7fff0001;
+
+	// Returned by a conditional branch helper when the branch is taken.
+	static const int BRANCH = 0x7fff0002;
+
+	// Gets the helper that implements the specified instruction, or null if
+	// the instruction has no helper.
+	static JitHelper GetHelper(IntermediateOpcode opc);
+
+	// Throws the TypeError of a switch instruction whose value is not an Int.
+	// The generated code checks the type itself.
+	static int ThrowSwitchTypeError(Thread *thread, StackFrame *frame, uint8_t *ip);
+
+private:
+	// Invokes a method overload from a call instruction. Native methods are
+	// invoked directly. Bytecode methods are entered, as by CALL_OVERLOAD in
+	// Thread::Evaluate(), and EXIT is returned, so that the method runs in the
+	// interpreter loop, or in its own generated code.
+	static int CallOverload(
+		Thread *thread,
+		StackFrame *frame,
+		MethodOverload *mo,
+		ovlocals_t argc,
+		Value *args,
+		Value *dest,
+		uint8_t *returnInstr,
+		bool push
+	);
+
+	static int Exit(Thread *thread, StackFrame *frame, uint8_t *ip);
+
+	template<bool push> static int NewObject(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int List(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int Hash(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int LoadField(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int LoadFieldFast(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int LoadLocalField(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int LoadStaticField(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int LoadMember(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int LoadIterator(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int LoadType(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int LoadIndexer(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int LoadStaticFunction(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int LoadTypeToken(Thread *thread, StackFrame *frame, uint8_t *ip);
+
+	template<bool push> static int Call(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int CallRef(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int StaticCall(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int CallMember(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int CallMemberRef(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int Apply(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int StaticApply(Thread *thread, StackFrame *frame, uint8_t *ip);
+
+	static int Leave(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool pop> static int BranchIfType(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool same> static int BranchIfReference(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool equal> static int BranchIfEqual(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<int (Thread::*compare)(Value*, bool&), bool (*test)(int)>
+	static int BranchIfCompare(Thread *thread, StackFrame *frame, uint8_t *ip);
+
+	template<bool push> static int BinaryOperator(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int UnaryOperator(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push, bool leftIsLocal>
+	static int BinaryOperatorConstant(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int Equals(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int Compare(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<int (Thread::*compare)(Value*, bool&), bool (*test)(int), bool push>
+	static int CompareValues(Thread *thread, StackFrame *frame, uint8_t *ip);
+	template<bool push> static int Concat(Thread *thread, StackFrame *frame, uint8_t *ip);
+
+	template<bool pop> static int StoreStaticField(Thread *thread, StackFrame *frame, uint8_t *ip);
+	static int StoreField(Thread *thread, StackFrame *frame, uint8_t *ip);
+	static int StoreFieldFast(Thread *thread, StackFrame *frame, uint8_t *ip);
+	static int StoreMember(Thread *thread, StackFrame *frame, uint8_t *ip);
+	static int StoreIndexer(Thread *thread, StackFrame *frame, uint8_t *ip);
+
+	// Tests for the result of TryPrimitiveCompare().
+	static inline bool IsLess(int cmp) { return cmp < 0; }
+	static inline bool IsGreater(int cmp) { return cmp > 0; }
+	static inline bool IsLessOrEqual(int cmp) { return cmp <= 0; }
+	static inline bool IsGreaterOrEqual(int cmp) { return cmp >= 0; }
+};
+
+} // namespace ovum
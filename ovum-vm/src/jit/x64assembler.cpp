@@ -0,0 +1,340 @@
+#include "x64assembler.h"
+
+namespace ovum
+{
+
+const size_t X64Assembler::UNBOUND;
+
+X64Assembler::X64Assembler()
+{ }
+
+X64Assembler::Label X64Assembler::NewLabel()
+{
+	labels.push_back(UNBOUND);
+	return labels.size() - 1;
+}
+
+void X64Assembler::Bind(Label label)
+{
+	OVUM_ASSERT(labels[label] == UNBOUND);
+	labels[label] = code.size();
+}
+
+void X64Assembler::CopyTo(uint8_t *dest) const
+{
+	memcpy(dest, code.data(), code.size());
+
+	for (size_t i = 0; i < relativeFixups.size(); i++)
+	{
+		const Fixup &fixup = relativeFixups[i];
+		size_t target = labels[fixup.label];
+		OVUM_ASSERT(target != UNBOUND);
+
+		// The displacement is relative to the end of the rel32 itself.
+		int32_t rel = (int32_t)((intptr_t)target - (intptr_t)(fixup.position + 4));
+		memcpy(dest + fixup.position, &rel, sizeof(int32_t));
+	}
+
+	for (size_t i = 0; i < absoluteFixups.size(); i++)
+	{
+		const Fixup &fixup = absoluteFixups[i];
+		size_t target = labels[fixup.label];
+		OVUM_ASSERT(target != UNBOUND);
+
+		uint64_t address = (uint64_t)(uintptr_t)(dest + target);
+		memcpy(dest + fixup.position, &address, sizeof(uint64_t));
+	}
+}
+
+void X64Assembler::Push(Register reg)
+{
+	EmitRex(false, 0, 0, reg);
+	Emit8(0x50 + (reg & 7));
+}
+
+void X64Assembler::Pop(Register reg)
+{
+	EmitRex(false, 0, 0, reg);
+	Emit8(0x58 + (reg & 7));
+}
+
+void X64Assembler::Ret()
+{
+	Emit8(0xc3);
+}
+
+void X64Assembler::Ud2()
+{
+	Emit8(0x0f);
+	Emit8(0x0b);
+}
+
+void X64Assembler::MovRegReg(Register dest, Register src)
+{
+	EmitRex(true, src, 0, dest);
+	Emit8(0x89);
+	EmitModRMReg(src, dest);
+}
+
+void X64Assembler::MovRegImm(Register dest, uint64_t imm)
+{
+	EmitRex(true, 0, 0, dest);
+	Emit8(0xb8 + (dest & 7));
+	Emit64(imm);
+}
+
+void X64Assembler::MovRegMem(Register dest, Register base, int32_t disp)
+{
+	EmitRex(true, dest, 0, base);
+	Emit8(0x8b);
+	EmitModRMMem(dest, base, disp);
+}
+
+void X64Assembler::MovReg32Mem(Register dest, Register base, int32_t disp)
+{
+	EmitRex(false, dest, 0, base);
+	Emit8(0x8b);
+	EmitModRMMem(dest, base, disp);
+}
+
+void X64Assembler::MovMemReg(Register base, int32_t disp, Register src)
+{
+	EmitRex(true, src, 0, base);
+	Emit8(0x89);
+	EmitModRMMem(src, base, disp);
+}
+
+void X64Assembler::MovMemImm(Register base, int32_t disp, int32_t imm)
+{
+	EmitRex(true, 0, 0, base);
+	Emit8(0xc7);
+	EmitModRMMem(0, base, disp);
+	Emit32((uint32_t)imm);
+}
+
+void X64Assembler::AddRegMem(Register dest, Register base, int32_t disp)
+{
+	EmitRex(true, dest, 0, base);
+	Emit8(0x03);
+	EmitModRMMem(dest, base, disp);
+}
+
+void X64Assembler::SubRegMem(Register dest, Register base, int32_t disp)
+{
+	EmitRex(true, dest, 0, base);
+	Emit8(0x2b);
+	EmitModRMMem(dest, base, disp);
+}
+
+void X64Assembler::SubRegReg(Register dest, Register src)
+{
+	EmitRex(true, src, 0, dest);
+	Emit8(0x29);
+	EmitModRMReg(src, dest);
+}
+
+void X64Assembler::AddRegImm(Register reg, int32_t imm)
+{
+	EmitRex(true, 0, 0, reg);
+	Emit8(0x81);
+	EmitModRMReg(0, reg); // /0 = add
+	Emit32((uint32_t)imm);
+}
+
+void X64Assembler::SubRegImm(Register reg, int32_t imm)
+{
+	EmitRex(true, 0, 0, reg);
+	Emit8(0x81);
+	EmitModRMReg(5, reg); // /5 = sub
+	Emit32((uint32_t)imm);
+}
+
+void X64Assembler::AddMem32Imm(Register base, int32_t disp, int32_t imm)
+{
+	EmitRex(false, 0, 0, base);
+	Emit8(0x81);
+	EmitModRMMem(0, base, disp); // /0 = add
+	Emit32((uint32_t)imm);
+}
+
+void X64Assembler::CmpRegMem(Register reg, Register base, int32_t disp)
+{
+	EmitRex(true, reg, 0, base);
+	Emit8(0x3b);
+	EmitModRMMem(reg, base, disp);
+}
+
+void X64Assembler::CmpMemReg(Register base, int32_t disp, Register reg)
+{
+	EmitRex(true, reg, 0, base);
+	Emit8(0x39);
+	EmitModRMMem(reg, base, disp);
+}
+
+void X64Assembler::CmpMemImm(Register base, int32_t disp, int32_t imm)
+{
+	EmitRex(true, 0, 0, base);
+	Emit8(0x81);
+	EmitModRMMem(7, base, disp); // /7 = cmp
+	Emit32((uint32_t)imm);
+}
+
+void X64Assembler::CmpRegImm(Register reg, int32_t imm)
+{
+	EmitRex(true, 0, 0, reg);
+	Emit8(0x81);
+	EmitModRMReg(7, reg); // /7 = cmp
+	Emit32((uint32_t)imm);
+}
+
+void X64Assembler::CmpRegReg(Register a, Register b)
+{
+	EmitRex(true, b, 0, a);
+	Emit8(0x39);
+	EmitModRMReg(b, a);
+}
+
+void X64Assembler::CmpReg32Imm(Register reg, int32_t imm)
+{
+	EmitRex(false, 0, 0, reg);
+	Emit8(0x81);
+	EmitModRMReg(7, reg); // /7 = cmp
+	Emit32((uint32_t)imm);
+}
+
+void X64Assembler::TestReg32Reg32(Register a, Register b)
+{
+	EmitRex(false, b, 0, a);
+	Emit8(0x85);
+	EmitModRMReg(b, a);
+}
+
+void X64Assembler::XorReg32Reg32(Register dest, Register src)
+{
+	EmitRex(false, src, 0, dest);
+	Emit8(0x31);
+	EmitModRMReg(src, dest);
+}
+
+void X64Assembler::Jmp(Label target)
+{
+	Emit8(0xe9);
+	EmitRel32(target);
+}
+
+void X64Assembler::Jcc(Condition cond, Label target)
+{
+	Emit8(0x0f);
+	Emit8(0x80 + cond);
+	EmitRel32(target);
+}
+
+void X64Assembler::JmpReg(Register reg)
+{
+	EmitRex(false, 0, 0, reg);
+	Emit8(0xff);
+	EmitModRMReg(4, reg); // /4 = jmp
+}
+
+void X64Assembler::JmpMemIndex(Register base, Register index, int scale)
+{
+	OVUM_ASSERT(scale == 1 || scale == 8);
+	// With mod = 00, a base of RBP or R13 means "no base", and RSP cannot be
+	// an index. Neither is needed.
+	OVUM_ASSERT((base & 7) != RBP);
+	OVUM_ASSERT(index != RSP);
+
+	EmitRex(false, 0, index, base);
+	Emit8(0xff);
+	// ModRM: mod = 00, reg = /4 (jmp), rm = 100 (SIB follows)
+	Emit8(0x24);
+	// SIB: scale (00 = 1, 11 = 8), index, base
+	Emit8((uint8_t)((scale == 8 ? 0xc0 : 0x00) | ((index & 7) << 3) | (base & 7)));
+}
+
+void X64Assembler::CallReg(Register reg)
+{
+	EmitRex(false, 0, 0, reg);
+	Emit8(0xff);
+	EmitModRMReg(2, reg); // /2 = call
+}
+
+void X64Assembler::LeaLabel(Register dest, Label label)
+{
+	EmitRex(true, dest, 0, 0);
+	Emit8(0x8d);
+	// ModRM: mod = 00, rm = 101 means [rip + disp32]
+	Emit8((uint8_t)(((dest & 7) << 3) | 0x05));
+	EmitRel32(label);
+}
+
+void X64Assembler::AlignTo(size_t alignment)
+{
+	while (code.size() % alignment != 0)
+		Emit8(0xcc); // int3
+}
+
+void X64Assembler::EmitLabelAddress(Label label)
+{
+	Fixup fixup = { code.size(), label };
+	absoluteFixups.push_back(fixup);
+	Emit64(0);
+}
+
+void X64Assembler::Emit8(uint8_t value)
+{
+	code.push_back(value);
+}
+
+void X64Assembler::Emit32(uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+		code.push_back((uint8_t)(value >> (8 * i)));
+}
+
+void X64Assembler::Emit64(uint64_t value)
+{
+	for (int i = 0; i < 8; i++)
+		code.push_back((uint8_t)(value >> (8 * i)));
+}
+
+void X64Assembler::EmitRex(bool wide, int reg, int index, int base)
+{
+	uint8_t rex = 0x40;
+	if (wide)
+		rex |= 0x08; // REX.W
+	if (reg & 8)
+		rex |= 0x04; // REX.R
+	if (index & 8)
+		rex |= 0x02; // REX.X
+	if (base & 8)
+		rex |= 0x01; // REX.B
+
+	if (rex != 0x40)
+		Emit8(rex);
+}
+
+void X64Assembler::EmitModRMReg(int reg, int rm)
+{
+	// mod = 11: register-direct
+	Emit8((uint8_t)(0xc0 | ((reg & 7) << 3) | (rm & 7)));
+}
+
+void X64Assembler::EmitModRMMem(int reg, Register base, int32_t disp)
+{
+	// mod = 10: [base + disp32]
+	Emit8((uint8_t)(0x80 | ((reg & 7) << 3) | (base & 7)));
+	// An rm of 100 (RSP or R12) means a SIB byte follows. Give it no index.
+	if ((base & 7) == RSP)
+		Emit8(0x24);
+	Emit32((uint32_t)disp);
+}
+
+void X64Assembler::EmitRel32(Label label)
+{
+	Fixup fixup = { code.size(), label };
+	relativeFixups.push_back(fixup);
+	Emit32(0);
+}
+
+} // namespace ovum
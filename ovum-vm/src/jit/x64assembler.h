@@ -0,0 +1,185 @@
+#pragma once
+
+#include "../vm.h"
+#include <vector>
+
+namespace ovum
+{
+
+// A small x86-64 assembler, which encodes the instructions that JitCompiler
+// emits, and nothing else. Memory operands are always of the form
+// [base + disp32]; the assembler does not bother with shorter encodings.
+//
+// Code is assembled into a growable buffer, and copied to its final location
+// by CopyTo(). Jump targets are Labels, which can be used before they are
+// bound to a position; they are resolved when the code is copied.
+//
+// Operand order follows Intel syntax: the destination comes first.
+class X64Assembler
+{
+public:
+	enum Register
+	{
+		RAX = 0,
+		RCX = 1,
+		RDX = 2,
+		RBX = 3,
+		RSP = 4,
+		RBP = 5,
+		RSI = 6,
+		RDI = 7,
+		R8  = 8,
+		R9  = 9,
+		R10 = 10,
+		R11 = 11,
+		R12 = 12,
+		R13 = 13,
+		R14 = 14,
+		R15 = 15,
+	};
+
+	// Condition codes, as encoded in the low four bits of Jcc.
+	enum Condition
+	{
+		CC_O  = 0x0, // Overflow
+		CC_NO = 0x1, // No overflow
+		CC_B  = 0x2, // Below (unsigned <)
+		CC_AE = 0x3, // Above or equal (unsigned >=)
+		CC_E  = 0x4, // Equal
+		CC_NE = 0x5, // Not equal
+		CC_BE = 0x6, // Below or equal (unsigned <=)
+		CC_A  = 0x7, // Above (unsigned >)
+		CC_L  = 0xc, // Less (signed <)
+		CC_GE = 0xd, // Greater or equal (signed >=)
+		CC_LE = 0xe, // Less or equal (signed <=)
+		CC_G  = 0xf, // Greater (signed >)
+	};
+
+	typedef size_t Label;
+
+	X64Assembler();
+
+	// Gets the number of bytes of code emitted so far.
+	inline size_t GetSize() const
+	{
+		return code.size();
+	}
+
+	// Creates a new, unbound label.
+	Label NewLabel();
+
+	// Binds a label to the current position. A label can only be bound once.
+	void Bind(Label label);
+
+	// Copies the assembled code to the specified location, and resolves all
+	// label references. Every label that has been referenced must be bound.
+	//   dest:
+	//     The final location of the code. This must be at least GetSize()
+	//     bytes long.
+	void CopyTo(uint8_t *dest) const;
+
+	void Push(Register reg);
+	void Pop(Register reg);
+	void Ret();
+	// Emits ud2, which raises an invalid opcode exception.
+	void Ud2();
+
+	// mov dest, src
+	void MovRegReg(Register dest, Register src);
+	// mov dest, imm64
+	void MovRegImm(Register dest, uint64_t imm);
+	// mov dest, qword [base + disp]
+	void MovRegMem(Register dest, Register base, int32_t disp);
+	// mov dest32, dword [base + disp], which zero-extends into dest.
+	void MovReg32Mem(Register dest, Register base, int32_t disp);
+	// mov qword [base + disp], src
+	void MovMemReg(Register base, int32_t disp, Register src);
+	// mov qword [base + disp], imm32 (sign-extended)
+	void MovMemImm(Register base, int32_t disp, int32_t imm);
+
+	// add dest, qword [base + disp]
+	void AddRegMem(Register dest, Register base, int32_t disp);
+	// sub dest, qword [base + disp]
+	void SubRegMem(Register dest, Register base, int32_t disp);
+	// sub dest, src
+	void SubRegReg(Register dest, Register src);
+	// add reg, imm32 (sign-extended)
+	void AddRegImm(Register reg, int32_t imm);
+	// sub reg, imm32 (sign-extended)
+	void SubRegImm(Register reg, int32_t imm);
+	// add dword [base + disp], imm32
+	void AddMem32Imm(Register base, int32_t disp, int32_t imm);
+
+	// cmp reg, qword [base + disp]
+	void CmpRegMem(Register reg, Register base, int32_t disp);
+	// cmp qword [base + disp], reg
+	void CmpMemReg(Register base, int32_t disp, Register reg);
+	// cmp qword [base + disp], imm32 (sign-extended)
+	void CmpMemImm(Register base, int32_t disp, int32_t imm);
+	// cmp reg, imm32 (sign-extended)
+	void CmpRegImm(Register reg, int32_t imm);
+	// cmp a, b
+	void CmpRegReg(Register a, Register b);
+	// cmp reg32, imm32
+	void CmpReg32Imm(Register reg, int32_t imm);
+	// test a32, b32
+	void TestReg32Reg32(Register a, Register b);
+	// xor dest32, src32
+	void XorReg32Reg32(Register dest, Register src);
+
+	// jmp label
+	void Jmp(Label target);
+	// jcc label
+	void Jcc(Condition cond, Label target);
+	// jmp reg
+	void JmpReg(Register reg);
+	// jmp qword [base + index * scale], where scale is 1 or 8.
+	void JmpMemIndex(Register base, Register index, int scale);
+	// call reg
+	void CallReg(Register reg);
+	// lea dest, [rip + label]
+	void LeaLabel(Register dest, Label label);
+
+	// Pads the code with int3 instructions until the current position is a
+	// multiple of the specified alignment.
+	void AlignTo(size_t alignment);
+	// Emits the absolute address of a label, as 8 bytes of data.
+	void EmitLabelAddress(Label label);
+
+private:
+	static const size_t UNBOUND = (size_t)-1;
+
+	struct Fixup
+	{
+		// The position of the rel32 or address to patch.
+		size_t position;
+		Label label;
+	};
+
+	std::vector<uint8_t> code;
+	// The position of each label, or UNBOUND.
+	std::vector<size_t> labels;
+	// References to labels that are relative to the end of the 32-bit
+	// displacement, as in jumps and RIP-relative addressing.
+	std::vector<Fixup> relativeFixups;
+	// References to labels that are absolute 64-bit addresses.
+	std::vector<Fixup> absoluteFixups;
+
+	void Emit8(uint8_t value);
+	void Emit32(uint32_t value);
+	void Emit64(uint64_t value);
+
+	// Emits a REX prefix for the specified operands, if one is needed. Pass
+	// 0 for operands that are not used by the instruction.
+	void EmitRex(bool wide, int reg, int index, int base);
+	// Emits a ModRM byte with two register operands.
+	void EmitModRMReg(int reg, int rm);
+	// Emits a ModRM byte (and SIB byte, if needed) for [base + disp32].
+	void EmitModRMMem(int reg, Register base, int32_t disp);
+	// Emits a rel32 that refers to the specified label.
+	void EmitRel32(Label label);
+
+	OVUM_DISABLE_COPY_AND_ASSIGN(X64Assembler);
+};
+
+} // namespace ovum
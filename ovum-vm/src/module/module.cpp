@@ -14,6 +14,10 @@
 #include "../debug/debugsymbols.h"
 #include "../ee/thread.h"
 #include "../ee/refsignature.h"
+#include "../ee/methodcache.h"
+#include "../ee/methodbuilder.h"
+#include "../ee/methodinitializer.h"
+#include "../ee/methodinitexception.h"
 #include "../res/staticstrings.h"
 
 namespace ovum
@@ -42,6 +46,8 @@ Module::Module(VM *vm, const PathName &fileName, ModuleParams &params) :
 	nativeLib(),
 	mainMethod(nullptr),
 	debugData(nullptr),
+	file(),
+	methodCache(),
 	vm(vm),
 	pool(vm->GetModulePool())
 { }
@@ -215,6 +221,100 @@ void Module::InitStaticState(void *state, StaticStateDeallocator deallocator)
 	this->staticStateDeallocator = deallocator;
 }
 
+int Module::ReadDeferredMethodBody(MethodOverload *overload)
+{
+	OVUM_ASSERT(overload->HasDeferredBody());
+	OVUM_ASSERT(file != nullptr);
+
+	try
+	{
+		MethodBodyReader reader(*file, this);
+		reader.ReadBody(overload, overload->deferredBody);
+	}
+	catch (ModuleLoadException &e)
+	{
+		// The method body is malformed. When the module is read eagerly, this
+		// error prevents the program from starting; now that it's running, all
+		// we can do is report the error and bail, like MethodInitializer does.
+		vm->PrintModuleLoadError(e);
+		abort();
+	}
+	catch (std::bad_alloc&)
+	{
+		return OVUM_ERROR_NO_MEMORY;
+	}
+
+	overload->deferredBody = 0;
+	RETURN_SUCCESS;
+}
+
+int Module::PreinitializeMethods(PreinitializeCounts &counts)
+{
+	MethodInitializer initer(vm);
+
+	for (size_t i = 0; i < functions.GetLength(); i++)
+	{
+		int r = PreinitializeMethod(initer, functions[i].get(), counts);
+		if (r != OVUM_SUCCESS)
+			return r;
+	}
+
+	for (size_t i = 0; i < methods.GetLength(); i++)
+	{
+		int r = PreinitializeMethod(initer, methods[i].get(), counts);
+		if (r != OVUM_SUCCESS)
+			return r;
+	}
+
+	RETURN_SUCCESS;
+}
+
+int Module::PreinitializeMethod(MethodInitializer &initer, Method *method, PreinitializeCounts &counts)
+{
+	if (method == nullptr)
+		RETURN_SUCCESS;
+
+	for (size_t i = 0; i < method->overloadCount; i++)
+	{
+		MethodOverload *overload = method->overloads + i;
+		if (overload->IsAbstract() || overload->IsNative() || overload->IsInitialized())
+			continue;
+
+		if (overload->HasDeferredBody())
+		{
+			int r = ReadDeferredMethodBody(overload);
+			if (r != OVUM_SUCCESS)
+				return r;
+		}
+
+		// Static constructors are not run here. The method cache records which
+		// types the method depends on, and their static constructors are run
+		// when the method is loaded from the cache.
+		instr::MethodBuilder builder;
+		size_t hitCount = methodCache ? methodCache->GetHitCount() : 0;
+		try
+		{
+			initer.InitializeBodyOrThrow(overload, builder, nullptr);
+		}
+		catch (MethodInitException &e)
+		{
+			// Nothing runs after preinitialization, so the overload can be
+			// left as it is. If it is called in a later run, it fails again.
+			vm->PrintMethodInitException(e);
+			counts.failed++;
+			continue;
+		}
+		overload->SetInitialized();
+
+		if (methodCache && methodCache->GetHitCount() != hitCount)
+			counts.cached++;
+		else
+			counts.initialized++;
+	}
+
+	RETURN_SUCCESS;
+}
+
 Module *Module::Open(
 	VM *vm,
 	const PathName &fileName,
@@ -22,6 +22,17 @@ struct ModuleParams
 	size_t globalMemberCount;
 };
 
+// The number of method overloads handled by Module::PreinitializeMethods().
+struct PreinitializeCounts
+{
+	// Overloads that were initialized from their bytecode.
+	size_t initialized;
+	// Overloads that were loaded from the method cache instead.
+	size_t cached;
+	// Overloads that could not be initialized.
+	size_t failed;
+};
+
 // And then the actual Module class! Hurrah!
 class Module
 {
@@ -74,6 +85,13 @@ public:
 		return vm->GetGC();
 	}
 
+	// Gets the module's method cache, or null if the VM does not cache method
+	// bodies.
+	inline MethodCache *GetMethodCache() const
+	{
+		return methodCache.get();
+	}
+
 	Module *FindModuleRef(String *name) const;
 
 	bool FindMember(String *name, bool includeInternal, GlobalMember &result) const;
@@ -98,6 +116,21 @@ public:
 
 	void InitStaticState(void *state, StaticStateDeallocator deallocator);
 
+	// Reads the bytecode and try blocks of a method overload whose body was
+	// deferred when the module was loaded (see VMStartParams::lazyMethodBodies).
+	// This must be called before the overload is initialized.
+	int ReadDeferredMethodBody(MethodOverload *overload);
+
+	// Initializes every bytecode method overload in the module that has not
+	// been initialized yet, without running any static constructors. This is
+	// used to fill the module's method cache ahead of time (see
+	// VMStartParams::preinitializeMethods). An overload that fails to
+	// initialize is reported and skipped; it is not marked as initialized,
+	// and it must not be run afterwards.
+	//   counts:
+	//     Incremented once for each overload that is handled.
+	int PreinitializeMethods(PreinitializeCounts &counts);
+
 	// See ModuleFinder for details on how modules are located.
 	static Module *OpenByName(
 		VM *vm,
@@ -136,6 +169,14 @@ private:
 	// Debug data attached to the module.
 	Box<debug::ModuleDebugData> debugData;
 
+	// The file from which the module was loaded. This is only kept open if the
+	// VM reads method bodies lazily; otherwise, it is null.
+	Box<ModuleFile> file;
+
+	// The module's method cache. This is null unless the VM has a method cache
+	// directory (see VMStartParams::methodCacheDirectory).
+	Box<MethodCache> methodCache;
+
 	// The VM instance that the module belongs to
 	VM *vm;
 	// The module pool that the module belongs to
@@ -171,6 +212,8 @@ private:
 
 	void FreeNativeLibrary();
 
+	int PreinitializeMethod(MethodInitializer &initer, Method *method, PreinitializeCounts &counts);
+
 	void TryRegisterStandardType(Type *type);
 
 	static inline int CompareVersion(const ModuleVersion &a, const ModuleVersion &b)
@@ -189,6 +232,7 @@ private:
 
 	friend class ModulePool;
 	friend class ModuleReader;
+	friend class MethodCache;
 	friend class GC;
 	template<class Visitor>
 	friend class RootSetWalker;
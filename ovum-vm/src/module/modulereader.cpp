@@ -8,6 +8,7 @@
 #include "../object/method.h"
 #include "../object/property.h"
 #include "../ee/refsignature.h"
+#include "../ee/methodcache.h"
 #include "../res/staticstrings.h"
 
 // Strictly for convenience
@@ -62,7 +63,7 @@ void ModuleFile::HandleFileOpenError(os::FileStatus error)
 }
 
 ModuleReader::ModuleReader(VM *owner, PartiallyOpenedModulesList &partiallyOpenedModules) :
-	file(),
+	file(new ModuleFile()),
 	vm(owner),
 	unresolvedConstants(),
 	partiallyOpenedModules(partiallyOpenedModules)
@@ -73,7 +74,7 @@ ModuleReader::~ModuleReader()
 
 void ModuleReader::Open(const pathchar_t *fileName)
 {
-	file.Open(fileName);
+	file->Open(fileName);
 }
 void ModuleReader::Open(const PathName &fileName)
 {
@@ -82,7 +83,7 @@ void ModuleReader::Open(const PathName &fileName)
 
 Box<Module> ModuleReader::ReadModule()
 {
-	const mf::ModuleHeader *header = file.Read<mf::ModuleHeader>(0);
+	const mf::ModuleHeader *header = file->Read<mf::ModuleHeader>(0);
 	VerifyHeader(header);
 
 	ModuleParams params;
@@ -105,10 +106,10 @@ Box<Module> ModuleReader::ReadModule()
 
 	// The first true managed thing we read is the string table, since pretty much
 	// every member refers to it.
-	ReadStringTable(output.get(), file.Deref(header->strings));
+	ReadStringTable(output.get(), file->Deref(header->strings));
 
 	// Definitions generally depend on references, so we'll read the references next.
-	ReadReferences(output.get(), file.Deref(header->references));
+	ReadReferences(output.get(), file->Deref(header->references));
 
 	// And finally definitions!
 	ReadDefinitions(output.get(), header);
@@ -129,25 +130,32 @@ Box<Module> ModuleReader::ReadModule()
 			nativeMain(output.get());
 	}
 
+	// If method bodies are read lazily, the module needs the file for as long
+	// as any of its methods may be called.
+	if (vm->HasLazyMethodBodies())
+		output->file = std::move(file);
+
+	// The method cache is only an optimization, so if it cannot be created,
+	// the module is simply loaded without it.
+	const PathName *methodCacheDirectory = vm->GetMethodCacheDirectory();
+	if (methodCacheDirectory)
+		output->methodCache = MethodCache::New(output.get(), *methodCacheDirectory);
+
 	partiallyOpenedModules.Remove(output.get());
 	return std::move(output);
 }
 
 String *ModuleReader::ReadString(mf::Rva<mf::WideString> rva)
 {
-	const mf::WideString *str = file.Deref(rva);
+	const mf::WideString *str = file->Deref(rva);
 
-	String *string = GetGC()->ConstructModuleString(
+	// If a string with this value is already interned, we get that string, and
+	// nothing is allocated.
+	return GetGC()->GetModuleString(
 		nullptr,
 		(size_t)str->length,
 		str->chars.Get()
 	);
-	// If a string with this value is already interned, we get that string instead.
-	// If we have that string, GC::InternString does nothing; if we don't, we have
-	// a brand new string and interning it actually interns it.
-	string = GetGC()->InternString(nullptr, string);
-
-	return string;
 }
 
 String *ModuleReader::ResolveString(Module *module, Token token)
@@ -165,7 +173,7 @@ void ModuleReader::ReadNativeLibrary(Module *module, mf::Rva<mf::WideString> lib
 	String *libraryName = ReadString(libraryNameRva);
 
 	// Native libraries are always loaded from the module's folder.
-	module->LoadNativeLibrary(libraryName, file.GetFileName());
+	module->LoadNativeLibrary(libraryName, file->GetFileName());
 }
 
 Method *ModuleReader::GetMainMethod(Module *module, Token token)
@@ -214,7 +222,7 @@ void ModuleReader::ReadModuleRefs(Module *module, const mf::RefTableHeader *head
 	size_t count = (size_t)header->moduleRefCount;
 	moduleRefs.Init(count);
 
-	const mf::ModuleRef *refs = file.Deref(header->moduleRefs);
+	const mf::ModuleRef *refs = file->Deref(header->moduleRefs);
 	for (size_t i = 0; i < count; i++)
 	{
 		const mf::ModuleRef *ref = refs + i;
@@ -247,7 +255,7 @@ void ModuleReader::ReadTypeRefs(Module *module, const mf::RefTableHeader *header
 	size_t count = (size_t)header->typeRefCount;
 	typeRefs.Init(count);
 
-	const mf::TypeRef *refs = file.Deref(header->typeRefs);
+	const mf::TypeRef *refs = file->Deref(header->typeRefs);
 	for (size_t i = 0; i < count; i++)
 	{
 		const mf::TypeRef *ref = refs + i;
@@ -276,7 +284,7 @@ void ModuleReader::ReadFieldRefs(Module *module, const mf::RefTableHeader *heade
 	size_t count = (size_t)header->fieldRefCount;
 	fieldRefs.Init(count);
 
-	const mf::FieldRef *refs = file.Deref(header->fieldRefs);
+	const mf::FieldRef *refs = file->Deref(header->fieldRefs);
 	for (size_t i = 0; i < count; i++)
 	{
 		const mf::FieldRef *ref = refs + i;
@@ -307,7 +315,7 @@ void ModuleReader::ReadMethodRefs(Module *module, const mf::RefTableHeader *head
 	size_t count = (size_t)header->methodRefCount;
 	methodRefs.Init(count);
 
-	const mf::MethodRef *refs = file.Deref(header->methodRefs);
+	const mf::MethodRef *refs = file->Deref(header->methodRefs);
 	for (size_t i = 0; i < count; i++)
 	{
 		const mf::MethodRef *ref = refs + i;
@@ -338,7 +346,7 @@ void ModuleReader::ReadFunctionRefs(Module *module, const mf::RefTableHeader *he
 	size_t count = (size_t)header->functionRefCount;
 	functionRefs.Init(count);
 
-	const mf::FunctionRef *refs = file.Deref(header->functionRefs);
+	const mf::FunctionRef *refs = file->Deref(header->functionRefs);
 	for (size_t i = 0; i < count; i++)
 	{
 		const mf::FunctionRef *ref = refs + i;
@@ -383,7 +391,7 @@ void ModuleReader::ReadTypeDefs(Module *module, const mf::ModuleHeader *header)
 	module->fields.Init(header->fieldCount);
 	module->methods.Init(header->methodCount);
 
-	const mf::TypeDef *defs = file.Deref(header->types);
+	const mf::TypeDef *defs = file->Deref(header->types);
 	for (size_t i = 0; i < count; i++)
 	{
 		const mf::TypeDef *def = defs + i;
@@ -473,6 +481,13 @@ Box<Type> ModuleReader::ReadSingleTypeDef(Module *module, const mf::ModuleHeader
 			type->fieldCount > 0 ||
 			type->walkReferences != nullptr)
 			type->flags |= TypeFlags::HAS_MANAGED_REFS;
+
+		if (baseType && baseType->HasNativeRefs() ||
+			type->IsCustomPtr() && (
+				type->fieldCount > 0 ||
+				type->walkReferences != nullptr
+			))
+			type->flags |= TypeFlags::HAS_NATIVE_REFS;
 	}
 
 	return std::move(type);
@@ -516,7 +531,7 @@ Method *ModuleReader::FindInstanceConstructor(Type *type)
 
 void ModuleReader::RunTypeIniter(Module *module, Type *type, mf::Rva<mf::ByteString> initerRva)
 {
-	const mf::ByteString *initerName = file.Deref(initerRva);
+	const mf::ByteString *initerName = file->Deref(initerRva);
 
 	TypeInitializer initerFunc = (TypeInitializer)module->FindNativeEntryPoint(initerName->chars.Get());
 	if (initerFunc == nullptr)
@@ -535,7 +550,7 @@ void ModuleReader::ReadFieldDefs(Module *module, Type *type, uint32_t fieldsBase
 	auto &fields = module->fields;
 
 	uint32_t tokenIndex = (firstField & mf::TOKEN_INDEX_MASK) - 1;
-	const mf::FieldDef *defs = file.Read<mf::FieldDef>(
+	const mf::FieldDef *defs = file->Read<mf::FieldDef>(
 		fieldsBase + sizeof(mf::FieldDef) * tokenIndex
 	);
 	for (size_t i = 0; i < count; i++)
@@ -548,7 +563,7 @@ void ModuleReader::ReadFieldDefs(Module *module, Type *type, uint32_t fieldsBase
 		Box<Field> field(new Field(name, type, flags));
 
 		if ((def->flags & mf::FIELD_HAS_VALUE) == mf::FIELD_HAS_VALUE)
-			ReadFieldConstantValue(module, field.get(), file.Deref(def->value), true);
+			ReadFieldConstantValue(module, field.get(), file->Deref(def->value), true);
 
 		if (field->IsStatic())
 		{
@@ -604,7 +619,7 @@ void ModuleReader::ReadMethodDefs(Module *module, Type *type, uint32_t methodsBa
 	auto &methods = module->methods;
 
 	uint32_t tokenIndex = (firstMethod & mf::TOKEN_INDEX_MASK) - 1;
-	const mf::MethodDef *defs = file.Read<mf::MethodDef>(
+	const mf::MethodDef *defs = file->Read<mf::MethodDef>(
 		methodsBase + sizeof(mf::FieldDef) * tokenIndex
 	);
 	for (size_t i = 0; i < count; i++)
@@ -683,7 +698,7 @@ void ModuleReader::ReadPropertyDefs(Module *module, Type *type, size_t count, mf
 	if (count == 0)
 		return;
 
-	const mf::PropertyDef *defs = file.Deref(properties);
+	const mf::PropertyDef *defs = file->Deref(properties);
 	for (size_t i = 0; i < count; i++)
 	{
 		const mf::PropertyDef *def = defs + i;
@@ -753,7 +768,7 @@ void ModuleReader::ReadOperatorDefs(Module *module, Type *type, size_t count, mf
 	if (count == 0)
 		return;
 
-	const mf::OperatorDef *defs = file.Deref(operators);
+	const mf::OperatorDef *defs = file->Deref(operators);
 	for (size_t i = 0; i < count; i++)
 	{
 		const mf::OperatorDef *def = defs + i;
@@ -799,7 +814,7 @@ void ModuleReader::ReadFunctionDefs(Module *module, const mf::ModuleHeader *head
 	size_t count = (size_t)header->functionCount;
 	functions.Init(count);
 
-	const mf::MethodDef *defs = file.Deref(header->functions);
+	const mf::MethodDef *defs = file->Deref(header->functions);
 	for (size_t i = 0; i < count; i++)
 	{
 		const mf::MethodDef *def = defs + i;
@@ -821,7 +836,7 @@ void ModuleReader::ReadConstantDefs(Module *module, const mf::ModuleHeader *head
 		return;
 
 	size_t count = (size_t)header->constantCount;
-	const mf::ConstantDef *defs = file.Deref(header->constants);
+	const mf::ConstantDef *defs = file->Deref(header->constants);
 	for (size_t i = 0; i < count; i++)
 	{
 		const mf::ConstantDef *def = defs + i;
@@ -829,7 +844,7 @@ void ModuleReader::ReadConstantDefs(Module *module, const mf::ModuleHeader *head
 		String *name = ResolveString(module, def->name);
 
 		Value value;
-		if (!ReadConstantValue(module, file.Deref(def->value), value))
+		if (!ReadConstantValue(module, file->Deref(def->value), value))
 			ModuleLoadError("Unresolved type in ConstantDef.");
 
 		VerifyAnnotations(def->annotations);
@@ -890,7 +905,7 @@ Box<Method> ModuleReader::ReadSingleMethodDef(Module *module, const mf::MethodDe
 	// Note: this is not an array of pointers!
 	Box<MethodOverload[]> overloads(new MethodOverload[overloadCount]);
 
-	const mf::OverloadDef *overloadDefs = file.Deref(def->overloads);
+	const mf::OverloadDef *overloadDefs = file->Deref(def->overloads);
 	for (size_t i = 0; i < overloadCount; i++)
 	{
 		const mf::OverloadDef *overloadDef = overloadDefs + i;
@@ -938,7 +953,7 @@ void ModuleReader::ReadParameters(Module *module, MethodOverload *overload, size
 		RefSignatureBuilder refBuilder(static_cast<ovlocals_t>(count + 1));
 		ovlocals_t optionalCount = 0;
 
-		const mf::Parameter *defs = file.Deref(rva);
+		const mf::Parameter *defs = file->Deref(rva);
 		for (size_t i = 0; i < count; i++)
 		{
 			const mf::Parameter *def = defs + i;
@@ -971,11 +986,29 @@ void ModuleReader::ReadParameters(Module *module, MethodOverload *overload, size
 void ModuleReader::ReadMethodBody(Module *module, MethodOverload *overload, const mf::OverloadDef *def)
 {
 	if (overload->IsNative())
-		ReadNativeMethodBody(module, overload, file.Deref(def->h.nativeHeader));
-	else if (overload->HasShortHeader())
-		ReadShortMethodBody(module, overload, file.Deref(def->h.shortHeader));
+	{
+		ReadNativeMethodBody(module, overload, file->Deref(def->h.nativeHeader));
+		return;
+	}
+
+	uint32_t headerAddress = overload->HasShortHeader()
+		? def->h.shortHeader.address
+		: def->h.longHeader.address;
+
+	MethodBodyReader bodyReader(*file, module);
+	if (vm->HasLazyMethodBodies())
+	{
+		// The rest of the body is read by Module::ReadDeferredMethodBody(), when
+		// the method is initialized.
+		bodyReader.ReadFrameInfo(overload, headerAddress);
+		overload->entry = nullptr;
+		overload->length = 0;
+		overload->deferredBody = headerAddress;
+	}
 	else
-		ReadLongMethodBody(module, overload, file.Deref(def->h.longHeader));
+	{
+		bodyReader.ReadBody(overload, headerAddress);
+	}
 }
 
 void ModuleReader::ReadNativeMethodBody(Module *module, MethodOverload *overload, const mf::NativeMethodHeader *header)
@@ -990,27 +1023,112 @@ void ModuleReader::ReadNativeMethodBody(Module *module, MethodOverload *overload
 	overload->locals = header->localCount;
 }
 
-void ModuleReader::ReadShortMethodBody(Module *module, MethodOverload *overload, const mf::MethodBody *header)
+MemberFlags ModuleReader::GetMemberFlags(mf::FieldFlags flags)
 {
-	// Short header implies certain defaults:
-	overload->tryBlockCount = 0;
-	overload->tryBlocks = nullptr;
-	overload->maxStack = 8;
+	// Field accessibility is compatible with MemberFlags by design.
+	MemberFlags result = static_cast<MemberFlags>(flags) & MemberFlags::ACCESSIBILITY;
 
-	ReadBytecodeBody(module, overload, header);
+	if ((flags & mf::FIELD_INSTANCE) == mf::FIELD_INSTANCE)
+		result |= MemberFlags::INSTANCE;
+	if ((flags & mf::FIELD_IMPL) == mf::FIELD_IMPL)
+		result |= MemberFlags::IMPL;
+
+	return result;
 }
 
-void ModuleReader::ReadLongMethodBody(Module *module, MethodOverload *overload, const mf::MethodHeader *header)
+MemberFlags ModuleReader::GetMemberFlags(mf::MethodFlags flags)
 {
-	overload->maxStack = header->maxStack;
-	overload->locals = header->localCount;
+	// Method accessibility is compatible with MemberFlags by design.
+	MemberFlags result = static_cast<MemberFlags>(flags) & MemberFlags::ACCESSIBILITY;
+
+	if ((flags & mf::METHOD_INSTANCE) == mf::METHOD_INSTANCE)
+		result |= MemberFlags::INSTANCE;
+	if ((flags & mf::METHOD_IMPL) == mf::METHOD_IMPL)
+		result |= MemberFlags::IMPL;
+	if ((flags & mf::METHOD_CTOR) == mf::METHOD_CTOR)
+		result |= MemberFlags::CTOR;
+
+	return result;
+}
+
+OverloadFlags ModuleReader::GetOverloadFlags(mf::OverloadFlags flags)
+{
+	// ovum::OverloadFlags is fully compatible with mf::OverloadFlags by design.
+	return static_cast<OverloadFlags>(flags);
+}
+
+ModuleVersion ModuleReader::ReadVersion(const mf::ModuleVersion &version)
+{
+	ModuleVersion result;
+	result.major = version.major;
+	result.minor = version.minor;
+	result.patch = version.patch;
+	return result;
+}
+
+void ModuleReader::VerifyHeader(const mf::ModuleHeader *header)
+{
+	if (header->magic.number != mf::ExpectedMagicNumber.number)
+		ModuleLoadError("Invalid magic number in module file.");
+
+	if (header->formatVersion < mf::MinFileFormatVersion ||
+		header->formatVersion > mf::MaxFileFormatVersion)
+		ModuleLoadError("Unsupported module file format version.");
+}
+
+void ModuleReader::VerifyAnnotations(mf::Rva<mf::Annotations> rva)
+{
+	if (!rva.IsNull())
+		ModuleLoadError("Annotations are not yet supported.");
+}
+
+OVUM_NOINLINE void ModuleReader::ModuleLoadError(const char *message)
+{
+	throw ModuleLoadException(GetFileName(), message);
+}
+
+MethodBodyReader::MethodBodyReader(const ModuleFile &file, Module *module) :
+	file(file),
+	module(module)
+{ }
+
+void MethodBodyReader::ReadFrameInfo(MethodOverload *overload, uint32_t headerAddress)
+{
+	if (overload->HasShortHeader())
+	{
+		// Short header implies certain defaults:
+		overload->maxStack = 8;
+	}
+	else
+	{
+		const mf::MethodHeader *header = file.Read<mf::MethodHeader>(headerAddress);
+		overload->maxStack = header->maxStack;
+		overload->locals = header->localCount;
+	}
+}
+
+void MethodBodyReader::ReadBody(MethodOverload *overload, uint32_t headerAddress)
+{
+	ReadFrameInfo(overload, headerAddress);
+
+	if (overload->HasShortHeader())
+	{
+		overload->tryBlockCount = 0;
+		overload->tryBlocks = nullptr;
+
+		ReadBytecodeBody(overload, file.Read<mf::MethodBody>(headerAddress));
+	}
+	else
+	{
+		const mf::MethodHeader *header = file.Read<mf::MethodHeader>(headerAddress);
 
-	ReadTryBlocks(module, overload, (size_t)header->tryBlockCount, header->tryBlocks);
+		ReadTryBlocks(overload, (size_t)header->tryBlockCount, header->tryBlocks);
 
-	ReadBytecodeBody(module, overload, &header->body);
+		ReadBytecodeBody(overload, &header->body);
+	}
 }
 
-void ModuleReader::ReadTryBlocks(Module *module, MethodOverload *overload, size_t count, mf::Rva<mf::TryBlock[]> rva)
+void MethodBodyReader::ReadTryBlocks(MethodOverload *overload, size_t count, mf::Rva<mf::TryBlock[]> rva)
 {
 	if (count == 0)
 	{
@@ -1033,7 +1151,7 @@ void ModuleReader::ReadTryBlocks(Module *module, MethodOverload *overload, size_
 		case mf::TRY_CATCH:
 			{
 				*tryBlock = TryBlock(TryKind::CATCH, def->tryStart, def->tryEnd);
-				ReadCatchClauses(module, tryBlock, def->m.catchClauses);
+				ReadCatchClauses(tryBlock, def->m.catchClauses);
 			}
 			break;
 		case mf::TRY_FINALLY:
@@ -1060,7 +1178,7 @@ void ModuleReader::ReadTryBlocks(Module *module, MethodOverload *overload, size_
 	overload->tryBlocks = tryBlocks.release();
 }
 
-void ModuleReader::ReadCatchClauses(Module *module, TryBlock *tryBlock, const mf::CatchClauses &catchClauses)
+void MethodBodyReader::ReadCatchClauses(TryBlock *tryBlock, const mf::CatchClauses &catchClauses)
 {
 	if (catchClauses.count == 0)
 		ModuleLoadError("A try-catch block must have at least one catch clause.");
@@ -1087,7 +1205,7 @@ void ModuleReader::ReadCatchClauses(Module *module, TryBlock *tryBlock, const mf
 	tryBlock->catches.blocks = catchBlocks.release();
 }
 
-void ModuleReader::ReadBytecodeBody(Module *module, MethodOverload *overload, const mf::MethodBody *body)
+void MethodBodyReader::ReadBytecodeBody(MethodOverload *overload, const mf::MethodBody *body)
 {
 	Box<uint8_t[]> bodyBytes(new uint8_t[body->size]);
 	CopyMemoryT(bodyBytes.get(), body->data.Get(), static_cast<size_t>(body->size));
@@ -1096,68 +1214,9 @@ void ModuleReader::ReadBytecodeBody(Module *module, MethodOverload *overload, co
 	overload->entry = bodyBytes.release();
 }
 
-MemberFlags ModuleReader::GetMemberFlags(mf::FieldFlags flags)
-{
-	// Field accessibility is compatible with MemberFlags by design.
-	MemberFlags result = static_cast<MemberFlags>(flags) & MemberFlags::ACCESSIBILITY;
-
-	if ((flags & mf::FIELD_INSTANCE) == mf::FIELD_INSTANCE)
-		result |= MemberFlags::INSTANCE;
-	if ((flags & mf::FIELD_IMPL) == mf::FIELD_IMPL)
-		result |= MemberFlags::IMPL;
-
-	return result;
-}
-
-MemberFlags ModuleReader::GetMemberFlags(mf::MethodFlags flags)
-{
-	// Method accessibility is compatible with MemberFlags by design.
-	MemberFlags result = static_cast<MemberFlags>(flags) & MemberFlags::ACCESSIBILITY;
-
-	if ((flags & mf::METHOD_INSTANCE) == mf::METHOD_INSTANCE)
-		result |= MemberFlags::INSTANCE;
-	if ((flags & mf::METHOD_IMPL) == mf::METHOD_IMPL)
-		result |= MemberFlags::IMPL;
-	if ((flags & mf::METHOD_CTOR) == mf::METHOD_CTOR)
-		result |= MemberFlags::CTOR;
-
-	return result;
-}
-
-OverloadFlags ModuleReader::GetOverloadFlags(mf::OverloadFlags flags)
-{
-	// ovum::OverloadFlags is fully compatible with mf::OverloadFlags by design.
-	return static_cast<OverloadFlags>(flags);
-}
-
-ModuleVersion ModuleReader::ReadVersion(const mf::ModuleVersion &version)
+OVUM_NOINLINE void MethodBodyReader::ModuleLoadError(const char *message)
 {
-	ModuleVersion result;
-	result.major = version.major;
-	result.minor = version.minor;
-	result.patch = version.patch;
-	return result;
-}
-
-void ModuleReader::VerifyHeader(const mf::ModuleHeader *header)
-{
-	if (header->magic.number != mf::ExpectedMagicNumber.number)
-		ModuleLoadError("Invalid magic number in module file.");
-
-	if (header->formatVersion < mf::MinFileFormatVersion ||
-		header->formatVersion > mf::MaxFileFormatVersion)
-		ModuleLoadError("Unsupported module file format version.");
-}
-
-void ModuleReader::VerifyAnnotations(mf::Rva<mf::Annotations> rva)
-{
-	if (!rva.IsNull())
-		ModuleLoadError("Annotations are not yet supported.");
-}
-
-OVUM_NOINLINE void ModuleReader::ModuleLoadError(const char *message)
-{
-	throw ModuleLoadException(GetFileName(), message);
+	throw ModuleLoadException(file.GetFileName(), message);
 }
 
 } // namespace ovum
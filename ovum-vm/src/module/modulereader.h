@@ -92,7 +92,7 @@ public:
 
 	inline const PathName &GetFileName() const
 	{
-		return file.GetFileName();
+		return file->GetFileName();
 	}
 
 	inline VM *GetVM() const
@@ -110,7 +110,7 @@ public:
 private:
 	struct UnresolvedConstant;
 
-	ModuleFile file;
+	Box<ModuleFile> file;
 
 	// The VM instance that the reader reads module data for.
 	VM *vm;
@@ -190,16 +190,6 @@ private:
 
 	void ReadNativeMethodBody(Module *module, MethodOverload *overload, const module_file::NativeMethodHeader *header);
 
-	void ReadShortMethodBody(Module *module, MethodOverload *overload, const module_file::MethodBody *header);
-
-	void ReadLongMethodBody(Module *module, MethodOverload *overload, const module_file::MethodHeader *header);
-
-	void ReadTryBlocks(Module *module, MethodOverload *overload, size_t count, module_file::Rva<module_file::TryBlock[]> rva);
-
-	void ReadCatchClauses(Module *module, TryBlock *tryBlock, const module_file::CatchClauses &catchClauses);
-
-	void ReadBytecodeBody(Module *module, MethodOverload *overload, const module_file::MethodBody *body);
-
 	static MemberFlags GetMemberFlags(module_file::FieldFlags flags);
 	static MemberFlags GetMemberFlags(module_file::MethodFlags flags);
 
@@ -222,4 +212,40 @@ private:
 	static const int MaxShortStringLength = 128;
 };
 
+// Reads the bytecode and try blocks of a method overload. ModuleReader uses this
+// class while it reads a module. If the VM reads method bodies lazily (see
+// VMStartParams::lazyMethodBodies), the module keeps its file open and uses
+// this class again the first time the method is called.
+class MethodBodyReader
+{
+public:
+	MethodBodyReader(const ModuleFile &file, Module *module);
+
+	// Reads the maximum stack height and local count of a bytecode method.
+	// This is all that is needed to push a stack frame for the method; the rest
+	// of the body is only used when the method is initialized.
+	//   overload:
+	//     The overload whose body is being read.
+	//   headerAddress:
+	//     The address of the overload's method header, which is a MethodBody
+	//     if the overload has a short header, or a MethodHeader otherwise.
+	void ReadFrameInfo(MethodOverload *overload, uint32_t headerAddress);
+
+	// Reads the entire body of a bytecode method, including the information
+	// that ReadFrameInfo() reads.
+	void ReadBody(MethodOverload *overload, uint32_t headerAddress);
+
+private:
+	const ModuleFile &file;
+	Module *module;
+
+	void ReadTryBlocks(MethodOverload *overload, size_t count, module_file::Rva<module_file::TryBlock[]> rva);
+
+	void ReadCatchClauses(TryBlock *tryBlock, const module_file::CatchClauses &catchClauses);
+
+	void ReadBytecodeBody(MethodOverload *overload, const module_file::MethodBody *body);
+
+	OVUM_NOINLINE void ModuleLoadError(const char *message);
+};
+
 } // namespace ovum
@@ -2,6 +2,7 @@
 #include "../ee/thread.h"
 #include "../object/type.h"
 #include "../gc/gcobject.h"
+#include "../gc/gc.h"
 
 namespace ovum
 {
@@ -14,9 +15,7 @@ int Field::ReadField(Thread *const thread, Value *instance, Value *dest) const
 		return thread->ThrowTypeError();
 
 	GCObject *gco = GCObject::FromInst(instance->v.instance);
-	gco->fieldAccessLock.Enter();
-	*dest = *reinterpret_cast<Value*>(instance->v.instance + this->offset);
-	gco->fieldAccessLock.Leave();
+	gco->ReadField(reinterpret_cast<Value*>(instance->v.instance + this->offset), dest);
 
 	RETURN_SUCCESS;
 }
@@ -27,9 +26,7 @@ int Field::ReadFieldFast(Thread *const thread, Value *instance, Value *dest) con
 		return thread->ThrowNullReferenceError();
 
 	GCObject *gco = GCObject::FromInst(instance->v.instance);
-	gco->fieldAccessLock.Enter();
-	*dest = *reinterpret_cast<Value*>(instance->v.instance + this->offset);
-	gco->fieldAccessLock.Leave();
+	gco->ReadField(reinterpret_cast<Value*>(instance->v.instance + this->offset), dest);
 
 	RETURN_SUCCESS;
 }
@@ -37,9 +34,7 @@ int Field::ReadFieldFast(Thread *const thread, Value *instance, Value *dest) con
 void Field::ReadFieldUnchecked(Value *instance, Value *dest) const
 {
 	GCObject *gco = GCObject::FromInst(instance->v.instance);
-	gco->fieldAccessLock.Enter();
-	*dest = *reinterpret_cast<Value*>(instance->v.instance + this->offset);
-	gco->fieldAccessLock.Leave();
+	gco->ReadField(reinterpret_cast<Value*>(instance->v.instance + this->offset), dest);
 }
 
 int Field::WriteField(Thread *const thread, Value *instanceAndValue) const
@@ -50,9 +45,10 @@ int Field::WriteField(Thread *const thread, Value *instanceAndValue) const
 		return thread->ThrowTypeError();
 
 	GCObject *gco = GCObject::FromInst(instanceAndValue[0].v.instance);
-	gco->fieldAccessLock.Enter();
+	gco->fieldAccessLock.EnterWrite();
 	*reinterpret_cast<Value*>(instanceAndValue[0].v.instance + this->offset) = instanceAndValue[1];
-	gco->fieldAccessLock.Leave();
+	thread->GetGC()->WriteBarrier(gco, &instanceAndValue[1]);
+	gco->fieldAccessLock.LeaveWrite();
 
 	RETURN_SUCCESS;
 }
@@ -63,9 +59,10 @@ int Field::WriteFieldFast(Thread *const thread, Value *instanceAndValue) const
 		return thread->ThrowNullReferenceError();
 
 	GCObject *gco = GCObject::FromInst(instanceAndValue[0].v.instance);
-	gco->fieldAccessLock.Enter();
+	gco->fieldAccessLock.EnterWrite();
 	*reinterpret_cast<Value*>(instanceAndValue[0].v.instance + this->offset) = instanceAndValue[1];
-	gco->fieldAccessLock.Leave();
+	thread->GetGC()->WriteBarrier(gco, &instanceAndValue[1]);
+	gco->fieldAccessLock.LeaveWrite();
 
 	RETURN_SUCCESS;
 }
@@ -73,9 +70,10 @@ int Field::WriteFieldFast(Thread *const thread, Value *instanceAndValue) const
 void Field::WriteFieldUnchecked(Value *instanceAndValue) const
 {
 	GCObject *gco = GCObject::FromInst(instanceAndValue[0].v.instance);
-	gco->fieldAccessLock.Enter();
+	gco->fieldAccessLock.EnterWrite();
 	*reinterpret_cast<Value*>(instanceAndValue[0].v.instance + this->offset) = instanceAndValue[1];
-	gco->fieldAccessLock.Leave();
+	declType->GetGC()->WriteBarrier(gco, &instanceAndValue[1]);
+	gco->fieldAccessLock.LeaveWrite();
 }
 
 } // namespace ovum
@@ -3,6 +3,8 @@
 #include "../vm.h"
 #include "member.h"
 #include "../ee/thread.opcodes.h"
+#include "../ee/profiler.h"
+#include <atomic>
 
 namespace ovum
 {
@@ -47,9 +49,6 @@ enum class OverloadFlags : int32_t
 	// Note: The containing Method has an CTOR flag too. It is present here for
 	// convenience.
 	CTOR        = 0x00020000,
-	// The method has been initialized. Used for bytecode methods only, to
-	// indicate that the bytecode initializer has processed the method.
-	INITED      = 0x00040000,
 };
 OVUM_ENUM_OPS(OverloadFlags, int32_t);
 
@@ -163,6 +162,11 @@ public:
 
 	debug::OverloadSymbols *debugSymbols;
 
+	// If the bytecode and try blocks have not been read yet, the address of
+	// the overload's method header in the module file; otherwise, zero. See
+	// Module::ReadDeferredMethodBody().
+	uint32_t deferredBody;
+
 	union
 	{
 		struct
@@ -178,6 +182,23 @@ public:
 	// The type that declares the overload
 	Type *declType;
 
+	// The native code generated for the overload by the JIT compiler, or null
+	// if the overload has not been compiled. See Jit for details.
+	std::atomic<JitCode*> jitCode;
+	// The number of times the overload has been called. This is only counted
+	// while the JIT compiler is enabled, and stops at its threshold.
+	std::atomic<uint32_t> callCount;
+	// Whether the overload has been initialized. Used for bytecode methods
+	// only, to indicate that the bytecode initializer has processed the
+	// method. This is separate from flags, which are not atomic, because the
+	// method may be initialized on another thread; see IsInitialized().
+	std::atomic<bool> initialized;
+
+#if OVUM_PROFILING
+	// The overload's call count and time, as recorded by the Profiler.
+	MethodProfile profile;
+#endif
+
 	// Simply initializes all members to their default values.
 	// We need a default constructor so we can use the type in
 	// an array.
@@ -193,8 +214,12 @@ public:
 		tryBlocks(nullptr),
 		maxStack(0),
 		debugSymbols(nullptr),
+		deferredBody(0),
 		group(nullptr),
-		declType(nullptr)
+		declType(nullptr),
+		jitCode(nullptr),
+		callCount(0),
+		initialized(false)
 	{ }
 
 	inline ~MethodOverload()
@@ -247,9 +272,25 @@ public:
 		return (flags & OverloadFlags::CTOR) == OverloadFlags::CTOR;
 	}
 
+	// Determines whether the overload has been initialized. If this returns
+	// true, the initialized body is visible to the calling thread, even if the
+	// overload was initialized on another thread (see BackgroundInitializer).
 	inline bool IsInitialized() const
 	{
-		return (flags & OverloadFlags::INITED) == OverloadFlags::INITED;
+		return initialized.load(std::memory_order_acquire);
+	}
+
+	// Marks the overload as initialized. This must be called after the body,
+	// try blocks and debug symbols have been updated, and publishes them to
+	// other threads.
+	inline void SetInitialized()
+	{
+		initialized.store(true, std::memory_order_release);
+	}
+
+	inline bool HasDeferredBody() const
+	{
+		return deferredBody != 0;
 	}
 
 	inline bool Accepts(ovlocals_t argc) const
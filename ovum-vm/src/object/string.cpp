@@ -46,6 +46,11 @@ OVUM_API int32_t String_GetHashCodeSubstr(const String *str, size_t index, size_
 	return String_GetHashCode(count, &str->firstChar + index);
 }
 
+OVUM_API int32_t String_GetHashCodeOfChars(size_t length, const ovchar_t *chars)
+{
+	return String_GetHashCode(length, chars);
+}
+
 OVUM_API bool String_Equals(const String *a, const String *b)
 {
 	if (!a || !b || a == b)
@@ -68,6 +68,15 @@ enum class TypeFlags : uint32_t
 	//
 	// In addition, the type cannot be primitive.
 	HAS_MANAGED_REFS    = 0x00800000,
+	// The type may contain managed references that native code writes to
+	// directly, without going through the GC's write barrier. The GC keeps
+	// old instances of such types in its remembered set permanently.
+	//
+	// This flag is set if at least one of the following is true:
+	//
+	//   - The type is CUSTOMPTR, and has native fields or a ReferenceWalker.
+	//   - The base type's HAS_NATIVE_REFS flag is set.
+	HAS_NATIVE_REFS     = 0x01000000,
 };
 OVUM_ENUM_OPS(TypeFlags, uint32_t);
 
@@ -273,6 +282,11 @@ public:
 		return (flags & TypeFlags::HAS_MANAGED_REFS) == TypeFlags::HAS_MANAGED_REFS;
 	}
 
+	inline bool HasNativeRefs() const
+	{
+		return (flags & TypeFlags::HAS_NATIVE_REFS) == TypeFlags::HAS_NATIVE_REFS;
+	}
+
 	void InitOperators();
 
 	bool InitStaticFields(Thread *const thread);
@@ -1,5 +1,6 @@
 #include "value.h"
 #include "../gc/gcobject.h"
+#include "../gc/gc.h"
 #include "../gc/staticref.h"
 #include "../ee/thread.h"
 
@@ -66,15 +67,12 @@ OVUM_API void ReadReference(Value *ref, Value *target)
 	else
 	{
 		GCObject *gco = reinterpret_cast<GCObject*>(ref->v.reference);
-		gco->fieldAccessLock.Enter();
 
 		uintptr_t offset = ~(uintptr_t)type;
 		Value *field = reinterpret_cast<Value*>(
 			reinterpret_cast<char*>(ref->v.reference) + offset
 		);
-		*target = *field;
-
-		gco->fieldAccessLock.Leave();
+		gco->ReadField(field, target);
 	}
 }
 
@@ -94,14 +92,15 @@ OVUM_API void WriteReference(Value *ref, Value *value)
 	else
 	{
 		GCObject *gco = reinterpret_cast<GCObject*>(ref->v.reference);
-		gco->fieldAccessLock.Enter();
+		gco->fieldAccessLock.EnterWrite();
 
 		uintptr_t offset = ~(uintptr_t)type;
 		Value *field = reinterpret_cast<Value*>(
 			reinterpret_cast<char*>(ref->v.reference) + offset
 		);
 		*field = *value;
+		Thread::GetCurrent()->GetGC()->WriteBarrier(gco, value);
 
-		gco->fieldAccessLock.Leave();
+		gco->fieldAccessLock.LeaveWrite();
 	}
 }
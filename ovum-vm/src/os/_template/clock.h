@@ -0,0 +1,23 @@
+#pragma once
+
+#include "def.h"
+
+namespace ovum
+{
+
+namespace os
+{
+
+	// Gets the current value of a monotonic, high-resolution clock. The value
+	// is measured in ticks, whose length is given by GetClockFrequency(), and
+	// is only meaningful relative to other values returned by this function.
+	// The clock must not be affected by changes to the system time.
+	uint64_t GetClockTicks();
+
+	// Gets the number of ticks per second of the clock used by GetClockTicks().
+	// This must not change while the system is running.
+	uint64_t GetClockFrequency();
+
+} // namespace os
+
+} // namespace ovum
@@ -17,3 +17,6 @@
 
 // Console output
 #include "console.h"
+
+// High-resolution timing
+#include "clock.h"
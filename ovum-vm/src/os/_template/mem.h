@@ -34,6 +34,11 @@ namespace os
 	// Gets the page size on the current OS.
 	size_t GetPageSize();
 
+	// Gets the allocation granularity on the current OS. The address returned
+	// by VirtualAlloc is always a multiple of this value. On many systems this
+	// is the same as the page size.
+	size_t GetAllocationGranularity();
+
 	// Allocates the specified number of bytes in the virtual address space.
 	// Pages are not physically allocated until they are used.
 	//   addr:
@@ -15,8 +15,14 @@ namespace os
 	typedef ... CriticalSection;
 	typedef ... Semaphore;
 	typedef ... TlsKey;
+	// Native thread handle type. This must be a type that can be copied
+	// safely by value.
+	typedef ... NativeThread;
 
 	static const ThreadId INVALID_THREAD_ID = ...;
+
+	// The entry point of a thread started by ThreadStart().
+	typedef void (*ThreadStartRoutine)(void *state);
 	
 	// Gets the ID of the current thread.
 	ThreadId GetCurrentThread();
@@ -36,6 +42,21 @@ namespace os
 	//   sleep may or may not be interruptible.
 	bool Sleep(uint32_t milliseconds);
 
+	// Gets the number of logical processors available to the process.
+	// Always returns at least 1.
+	uint32_t GetProcessorCount();
+
+	// Starts a new native thread, which calls the specified function and
+	// terminates when the function returns. The thread is not known to the
+	// VM, and must not run managed code.
+	// Returns:
+	//   True if the thread was started; otherwise, false.
+	bool ThreadStart(NativeThread *thread, ThreadStartRoutine routine, void *state);
+
+	// Waits for a thread started by ThreadStart() to terminate, and then
+	// releases the resources associated with it.
+	void ThreadJoin(NativeThread *thread);
+
 	// Attempts to initialize a critical section. The spin count
 	// may be ignored on some platforms. Returns true if successful;
 	// otherwise, false.
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "def.h"
+
+namespace ovum
+{
+
+namespace os
+{
+
+	// Gets the current value of a monotonic, high-resolution clock. The value
+	// is measured in ticks, whose length is given by GetClockFrequency(), and
+	// is only meaningful relative to other values returned by this function.
+	inline uint64_t GetClockTicks()
+	{
+		LARGE_INTEGER ticks;
+		// QueryPerformanceCounter does not fail on Windows XP and later.
+		QueryPerformanceCounter(&ticks);
+		return (uint64_t)ticks.QuadPart;
+	}
+
+	// Gets the number of ticks per second of the clock used by GetClockTicks().
+	// This does not change while the system is running.
+	inline uint64_t GetClockFrequency()
+	{
+		LARGE_INTEGER frequency;
+		// QueryPerformanceFrequency does not fail on Windows XP and later.
+		QueryPerformanceFrequency(&frequency);
+		return (uint64_t)frequency.QuadPart;
+	}
+
+} // namespace os
+
+} // namespace ovum
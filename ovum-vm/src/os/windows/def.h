@@ -19,3 +19,6 @@
 
 // Console output
 #include "console.h"
+
+// High-resolution timing
+#include "clock.h"
@@ -39,6 +39,15 @@ namespace os
 		return (size_t)info.dwPageSize;
 	}
 
+	// Gets the allocation granularity on the current OS. The address returned
+	// by VirtualAlloc is always a multiple of this value.
+	inline size_t GetAllocationGranularity()
+	{
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return (size_t)info.dwAllocationGranularity;
+	}
+
 	// Allocates the specified number of bytes in the virtual address space.
 	// Pages are not physically allocated until they are used.
 	//   addr:
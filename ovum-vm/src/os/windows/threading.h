@@ -14,9 +14,13 @@ namespace os
 	typedef CRITICAL_SECTION CriticalSection;
 	typedef HANDLE Semaphore;
 	typedef DWORD TlsKey;
+	typedef HANDLE NativeThread;
 
 	static const ThreadId INVALID_THREAD_ID = 0;
 
+	// The entry point of a thread started by ThreadStart().
+	typedef void (*ThreadStartRoutine)(void *state);
+
 	// Gets the ID of the current thread.
 	inline ThreadId GetCurrentThread()
 	{
@@ -45,6 +49,26 @@ namespace os
 		return true;
 	}
 
+	// Gets the number of logical processors available to the process.
+	// Always returns at least 1.
+	inline uint32_t GetProcessorCount()
+	{
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return info.dwNumberOfProcessors > 0 ? (uint32_t)info.dwNumberOfProcessors : 1;
+	}
+
+	// Starts a new native thread, which calls the specified function and
+	// terminates when the function returns. The thread is not known to the
+	// VM, and must not run managed code.
+	// Returns:
+	//   True if the thread was started; otherwise, false.
+	bool ThreadStart(NativeThread *thread, ThreadStartRoutine routine, void *state);
+
+	// Waits for a thread started by ThreadStart() to terminate, and then
+	// releases the resources associated with it.
+	void ThreadJoin(NativeThread *thread);
+
 	// Attempts to initialize a critical section. The spin count
 	// may be ignored on some platforms. Returns true if successful;
 	// otherwise, false.
@@ -1,5 +1,6 @@
 #include "def.h"
 #include "../../unicode/utf8encoder.h"
+#include <new>
 
 // Implementations of various functions from the Windows-specific header files.
 // The sort of functions we want to discourage the compiler from inlining.
@@ -141,6 +142,49 @@ namespace os
 		return true;
 	}
 
+	struct ThreadStartData_
+	{
+		ThreadStartRoutine routine;
+		void *state;
+	};
+
+	DWORD WINAPI ThreadStartTrampoline_(LPVOID param)
+	{
+		ThreadStartData_ data = *reinterpret_cast<ThreadStartData_*>(param);
+		delete reinterpret_cast<ThreadStartData_*>(param);
+
+		data.routine(data.state);
+		return 0;
+	}
+
+	bool ThreadStart(NativeThread *thread, ThreadStartRoutine routine, void *state)
+	{
+		// The start routine has the wrong signature for CreateThread, so the
+		// new thread starts in a trampoline, which receives the routine and
+		// its state on the heap.
+		ThreadStartData_ *data = new(std::nothrow) ThreadStartData_;
+		if (data == nullptr)
+			return false;
+		data->routine = routine;
+		data->state = state;
+
+		HANDLE handle = ::CreateThread(nullptr, 0, ThreadStartTrampoline_, data, 0, nullptr);
+		if (handle == nullptr)
+		{
+			delete data;
+			return false;
+		}
+
+		*thread = handle;
+		return true;
+	}
+
+	void ThreadJoin(NativeThread *thread)
+	{
+		::WaitForSingleObject(*thread, INFINITE);
+		::CloseHandle(*thread);
+	}
+
 } // namespace os
 
 } // namespace ovum
@@ -25,4 +25,38 @@ void SpinLock::SpinWait()
 	}
 }
 
+uint32_t SeqLock::WaitForWriter() const
+{
+	int spinCountLeft = MAX_COUNT_BEFORE_YIELDING;
+	while (true)
+	{
+		uint32_t seq = sequence.load(std::memory_order_acquire);
+		if ((seq & 1) == 0)
+			return seq;
+
+		if (spinCountLeft != 0)
+			spinCountLeft--;
+		else
+			// See SpinLock::SpinWait() for why we yield.
+			os::Yield();
+	}
+}
+
+void SeqLock::SpinWaitForWrite()
+{
+	int spinCountLeft = MAX_COUNT_BEFORE_YIELDING;
+	while (true)
+	{
+		uint32_t seq = sequence.load(std::memory_order_relaxed);
+		if ((seq & 1) == 0 &&
+			sequence.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire))
+			return;
+
+		if (spinCountLeft != 0)
+			spinCountLeft--;
+		else
+			os::Yield();
+	}
+}
+
 } // namespace ovum
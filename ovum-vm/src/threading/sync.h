@@ -161,4 +161,82 @@ private:
 	OVUM_NOINLINE void SpinWait();
 };
 
+// SeqLock (sequence lock) protects small amounts of data that are read much
+// more often than they are written. Writers exclude each other much like with
+// a SpinLock, but readers never write to the lock: a reader remembers the
+// sequence number, copies the data, and then checks that the sequence number
+// has not changed. If it has, a writer got in the way, and the reader tries
+// again. Hence, uncontested reads cost no more than two ordinary loads.
+//
+// The sequence number is odd while a writer holds the lock.
+//
+// Readers must copy the data into a local before doing anything with it, as
+// the copy may be torn until EndRead() returns true. A typical read looks like
+// this:
+//
+//   uint32_t seq;
+//   do
+//   {
+//     seq = lock.BeginRead();
+//     copy = data;
+//   } while (!lock.EndRead(seq));
+//
+// Like spinlocks, seqlocks are NOT recursive, and writers should only hold
+// the lock for a very short amount of time.
+class SeqLock
+{
+public:
+	inline SeqLock() : sequence(0)
+	{ }
+
+	// Begins a read, and returns the sequence number to pass to EndRead().
+	// If a writer currently holds the lock, waits for it to leave.
+	inline uint32_t BeginRead() const
+	{
+		uint32_t seq = sequence.load(std::memory_order_acquire);
+		if (seq & 1)
+			seq = WaitForWriter();
+		return seq;
+	}
+
+	// Ends a read. If the return value is false, the data was modified during
+	// the read, and must be read again.
+	inline bool EndRead(uint32_t seq) const
+	{
+		// Keep the reads of the protected data from moving past the check.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return sequence.load(std::memory_order_relaxed) == seq;
+	}
+
+	// Enters the lock for writing. If another writer holds the lock, the thread
+	// will spin until it becomes available.
+	inline void EnterWrite()
+	{
+		uint32_t seq = sequence.load(std::memory_order_relaxed);
+		if ((seq & 1) != 0 ||
+			!sequence.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire))
+			SpinWaitForWrite();
+		// Readers must see the odd sequence number before any of the writes.
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	// Leaves the lock after writing, enabling other writers to enter it.
+	inline void LeaveWrite()
+	{
+		sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+private:
+	OVUM_DISABLE_COPY_AND_ASSIGN(SeqLock);
+
+	// The total number of times to spin before yielding
+	static const int MAX_COUNT_BEFORE_YIELDING = 100;
+
+	std::atomic<uint32_t> sequence;
+
+	OVUM_NOINLINE uint32_t WaitForWriter() const;
+
+	OVUM_NOINLINE void SpinWaitForWrite();
+};
+
 } // namespace ovum
@@ -21,6 +21,13 @@ public:
 		return this->capacity;
 	}
 
+	// Gets a pointer to the buffer's contents, which are not null-terminated.
+	// The pointer is invalidated when anything is appended to the buffer.
+	inline const ovchar_t *GetDataPointer() const
+	{
+		return this->data;
+	}
+
 	size_t SetCapacity(size_t newCapacity);
 
 	void Append(ovchar_t ch);
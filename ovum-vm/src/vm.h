@@ -16,28 +16,40 @@
 namespace ovum
 {
 
+class BackgroundInitializer;
 class Field;
+class FinalizerThread;
 class GC;
 class GCObject;
 class GlobalMember;
+class Jit;
+class JitCode;
+class JitHelpers;
 class LiveObjectFinder;
+class MarkWorker;
 class Member;
 class Method;
+class MethodCache;
 class MethodInitException;
 class MethodInitializer;
 class MethodOverload;
 class Module;
+class ModuleFile;
+class ModuleLoadException;
 class ModulePool;
 class ModuleReader;
 class MovedObjectUpdater;
 template<class Visitor>
 class ObjectGraphWalker;
+class ParallelMarker;
 class PartiallyOpenedModulesList;
 class PathName;
+class Profiler;
 class Property;
 class RefSignaturePool;
 template<class Visitor>
 class RootSetWalker;
+class Sampler;
 class StackFrame;
 class StackManager;
 class StackTraceFormatter;
@@ -71,6 +83,7 @@ namespace instr
 	class Instruction;
 	class MethodBuffer;
 	class MethodBuilder;
+	struct PointerArgument;
 } // namespace ovum::instr
 
 } // namespace ovum
@@ -110,4 +123,9 @@ namespace ovum
 	// type to ovum::Box:
 	template<class T, class Del = std::default_delete<T>>
 	using Box = std::unique_ptr<T, Del>;
+
+	// The version of the VM, as (major << 16) | minor. Files that the VM writes
+	// for its own use, such as method cache files, are only read back by the
+	// same version of the VM.
+	static const uint32_t VM_VERSION = 0x00010000;
 }